@@ -45,6 +45,16 @@ namespace Pu
 	constexpr uint32 FontAtlasHOffset = 2;
 	/* Defines the vertical offset used within font atlases between glyphs (lower values mean less memory but more chance of corruption). */
 	constexpr uint32 FontAtlasVOffset = 2;
+	/* Defines the amount of codepoints (starting at zero) that fonts can look up directly, glyphs outside of this range use a hashed lookup. */
+	constexpr uint32 FontDirectLookupSize = 0x800;
+	/* Defines whether rasterized font atlases should be stored on disk and loaded from there on subsequent loads. */
+	constexpr bool FontAtlasCaching = true;
+	/* Defines the directory in which the cached font atlases are stored. */
+	constexpr const wchar_t *FontAtlasCacheDirectory = L"FontCache\\";
+	/* Defines the amount of glyphs rasterized by a single task when creating a font atlas (zero means rasterizing on the loading thread). */
+	constexpr size_t FontRasterizationChunkSize = 256;
+	/* Defines whether the reflected interface of SPIR-V shaders should be stored next to the shader and loaded from there on subsequent loads. */
+	constexpr bool ShaderReflectionCaching = true;
 	/* Defines whether to log a fatal exception on Vulkan validation errors instead of just logging it. */
 	constexpr bool VulkanRaiseOnError = true;
 	/* Defines whether ImGui should be available. */
@@ -53,22 +63,66 @@ namespace Pu
 	constexpr size_t MaxDebugRendererObjects = 0x2000;
 	/* Defines whether to log warnings about wasted GPU memory due to allignment or minimum buffer sizes. */
 	constexpr bool LogWastedMemory = false;
+	/* Defines whether buffers and images should be placed in shared device memory blocks instead of allocating their own memory. */
+	constexpr bool DeviceMemorySubAllocation = true;
+	/* Defines the size (in bytes) of a shared device memory block, resources larger than half a block get their own memory. */
+	constexpr uint64 DeviceMemoryBlockSize = 0x4000000;
+	/* Defines the size (in bytes) of the persistently mapped upload ring used by the asset loader, larger uploads get their own staging buffer. */
+	constexpr size_t StagingRingSize = 0x2000000;
 	/* Defines the amount of lines that should be used to draw a single ellipse in an ellipsoid. */
 	constexpr uint32 EllipsiodDivs = 12;
 	/* Defines the maximum number of iterations the GJK algorithm is allowed to perform before terminating. */
 	constexpr uint8 MaxIterationsGJK = 20;
+	/* Defines the maximum number of iterations the EPA algorithm is allowed to perform before terminating. */
+	constexpr uint8 MaxIterationsEPA = 32;
+	/* Defines the distance at which the EPA algorithm considers the polytope to be fully expanded. */
+	constexpr float PhysicsEPATolerance = 0.0001f;
 	/* Defines the amount of expansion kinematic objects should get in broadphase. */
 	constexpr float KinematicExpansion = 1.0f;
+	/* Defines the maximum amount of steps a continuous collision sweep is allowed to take before giving up. */
+	constexpr uint32 PhysicsMaxCCDSteps = 16;
 	/* Defines the amount of time (in seconds) that physics debuggers are visually shown. */
 	constexpr float PhysicsDebuggingTTL = 2.0f;
 	/* Defines whether the profiling should be global (false) or system local (true). */
 	constexpr bool ProfileWorldSystems = true;
 	/* Defines whether the physics system is allowed to use sleep mode. */
 	constexpr bool PhysicsAllowSleeping = false;
+	/* Defines the amount of substeps all objects in a simulation island need to be resting before the island is put to sleep. */
+	constexpr uint16 PhysicsIslandSleepSteps = 30;
 	/* Defines the tolerance for a physics object to be considered rolling instead of sliding. */
 	constexpr float PhysicsRollingTolerance = 0.5f;
 	/* Defines the beta factor used to stabalize the position correction. */
 	constexpr float PhysicsBaumgarteFactor = 0.02f;
+	/* Defines the amount of AVX lanes (of eight objects) that a single physics task processes. */
+	constexpr size_t PhysicsChunkSize = 512;
+	/* Defines the minimum amount of contacts that a single solver task processes, islands are never split over multiple tasks. */
+	constexpr uint32 PhysicsSolverJobSize = 256;
+	/* Defines the timestep (in seconds) used by the physical world when it's running in determinism mode. */
+	constexpr float PhysicsFixedTimestep = 1.0f / 60.0f;
+	/* Defines the amount of spatial queries that a single physics task processes. */
+	constexpr size_t PhysicsQueryChunkSize = 32;
+	/* Defines the maximum amount of conservative advancement steps a sphere sweep query takes before it samples the rest of its path. */
+	constexpr uint32 PhysicsMaxSweepSteps = 256;
+	/* Defines the amount of bisection steps used to refine the time of impact of a sphere sweep query. */
+	constexpr uint32 PhysicsSweepRefinements = 8;
+	/* Defines the minimum amount of instanced draws recorded by a single secondary command buffer, fewer draws are recorded inline. */
+	constexpr size_t RenderBatchesPerJob = 64;
+	/* Defines the width (in pixels) of the software depth buffer used for occlusion culling, this must be a multiple of 8. */
+	constexpr uint32 OcclusionBufferWidth = 256;
+	/* Defines the height (in pixels) of the software depth buffer used for occlusion culling. */
+	constexpr uint32 OcclusionBufferHeight = 128;
+	/* Defines the maximum amount of detail levels used by a model, meshes of coarser levels are added to the coarsest level. */
+	constexpr uint32 MaxLodLevels = 4;
+	/* Defines the projected geometric error (in pixels) that is allowed before a finer level of detail is used. */
+	constexpr float LodErrorThreshold = 1.0f;
+	/* Defines the relative band around the level of detail switch distances in which an object keeps its previous level. */
+	constexpr float LodHysteresis = 0.1f;
+	/* Defines the projected radius (in pixels) below which a point light is drawn with the coarse light volume. */
+	constexpr float PointLightCoarseRadius = 8.0f;
+	/* Defines the amount of divisions per face of the coarse light volume used for point lights with a small projected radius. */
+	constexpr uint32 PointLightCoarseDivs = 2;
+	/* Defines the maximum amount of off screen point lights that are drawn to merge two instanced point light draws. */
+	constexpr uint32 PointLightMaxRunGap = 4;
 	/* Defines whether to log a message when an asset gets added or deleted. */
 	constexpr bool AssetCacheLogging = false;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "Graphics/Text/Font.h"
 #include "Graphics/Models/Model.h"
 #include "Graphics/Models/ShapeType.h"
+#include "Graphics/Resources/StagingRing.h"
 
 namespace Pu
 {
@@ -45,12 +46,13 @@ namespace Pu
 		void InitializeModel(_In_ Model &model, _In_ const wstring &path, _In_ const DeferredRenderer &deferred, _In_ const LightProbeRenderer *probes);
 		/* Creates a model with one mesh of the specified shape. */
 		void CreateModel(_In_ Model &model, _In_ ShapeType shape, _In_ const DeferredRenderer &deferred, _In_opt_ const LightProbeRenderer *probes);
-		/* Stages the contents of the source buffer into the destination buffer and deletes the source buffer once completed. */
+		/* Stages the contents of the source buffer into the destination buffer through the staging ring and deletes the source buffer once completed. */
 		void StageBuffer(_In_ StagingBuffer &source, _In_ Buffer &destination, _In_ PipelineStageFlags dstStage, _In_ AccessFlags access, _In_ const wstring &name);
 
 	private:
 		AssetCache &cache;
 		LogicalDevice &device;
 		Queue &transferQueue, &graphicsQueue;
+		StagingRing staging;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include "Core/Collections/Vector.h"
+#include "Core/Math/Constants.h"
+
+namespace Pu
+{
+	/*
+	Defines a FIFO ring allocator over an abstract range of [0, capacity).
+	Allocations are grouped into regions that are committed with a tag (like a submission index),
+	the memory of a region is released once its tag has been reached. Allocations never wrap around the end of the range.
+	*/
+	class RingAllocator
+	{
+	public:
+		/* Initializes a new instance of a ring allocator with a specific capacity. */
+		RingAllocator(_In_ uint64 capacity);
+		/* Copy constructor. */
+		RingAllocator(_In_ const RingAllocator&) = default;
+		/* Move constructor. */
+		RingAllocator(_In_ RingAllocator&&) = default;
+
+		/* Copy assignment. */
+		_Check_return_ RingAllocator& operator =(_In_ const RingAllocator&) = default;
+		/* Move assignment. */
+		_Check_return_ RingAllocator& operator =(_In_ RingAllocator&&) = default;
+
+		/* Allocates a range of the specified size with a specific (power of two) alignment in the open region, returns whether the range could be allocated. */
+		_Check_return_ bool Allocate(_In_ uint64 size, _In_ uint64 alignment, _Out_ uint64 &offset);
+		/* Closes the open region and marks it with the specified tag, tags should be increasing. */
+		void Commit(_In_ uint64 tag);
+		/* Releases all committed regions that have a tag lower than or equal to the specified tag. */
+		void Release(_In_ uint64 tag);
+		/* Releases all regions, including the open region. */
+		void Reset(void);
+
+		/* Gets the size of the range managed by the allocator. */
+		_Check_return_ inline uint64 GetCapacity(void) const
+		{
+			return capacity;
+		}
+
+		/* Gets the amount of space in use by the open and committed regions (including padding). */
+		_Check_return_ inline uint64 GetUsedSize(void) const
+		{
+			return used;
+		}
+
+		/* Gets the amount of space that is not in use. */
+		_Check_return_ inline uint64 GetFreeSize(void) const
+		{
+			return capacity - used;
+		}
+
+		/* Gets the amount of space used by the open region. */
+		_Check_return_ inline uint64 GetOpenSize(void) const
+		{
+			return open;
+		}
+
+		/* Gets the amount of committed regions that have not been released yet. */
+		_Check_return_ inline uint32 GetPendingRegionCount(void) const
+		{
+			return static_cast<uint32>(regions.size());
+		}
+
+		/* Gets whether no space is in use. */
+		_Check_return_ inline bool IsEmpty(void) const
+		{
+			return !used;
+		}
+
+	private:
+		struct Region
+		{
+			uint64 End;
+			uint64 Size;
+			uint64 Tag;
+		};
+
+		uint64 capacity, head, tail;
+		uint64 used, open;
+		vector<Region> regions;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+#include "Core/Collections/Vector.h"
+#include "Core/Math/Basics.h"
+
+namespace Pu
+{
+	/*
+	Defines a two-level segregated fit allocator over an abstract range of [0, capacity).
+	The allocator only does the bookkeeping, so it can manage any linear resource (like device memory).
+	Both allocating and freeing are done in constant time.
+	*/
+	class TLSFAllocator
+	{
+	public:
+		/* Defines the handle that is returned if an allocation failed. */
+		static constexpr uint32 InvalidHandle = ~0u;
+
+		/* Initializes a new instance of a TLSF allocator with a specific capacity. */
+		TLSFAllocator(_In_ uint64 capacity);
+		/* Copy constructor. */
+		TLSFAllocator(_In_ const TLSFAllocator&) = default;
+		/* Move constructor. */
+		TLSFAllocator(_In_ TLSFAllocator&&) = default;
+
+		/* Copy assignment. */
+		_Check_return_ TLSFAllocator& operator =(_In_ const TLSFAllocator&) = default;
+		/* Move assignment. */
+		_Check_return_ TLSFAllocator& operator =(_In_ TLSFAllocator&&) = default;
+
+		/* Allocates a range of the specified size with a specific (power of two) alignment, returns InvalidHandle if no range could be found. */
+		_Check_return_ uint32 Allocate(_In_ uint64 size, _In_ uint64 alignment, _Out_ uint64 &offset);
+		/* Releases the range allocated with the specified handle. */
+		void Free(_In_ uint32 handle);
+		/* Releases all allocated ranges. */
+		void Reset(void);
+		/* Gets the size of the largest range that can be allocated. */
+		_Check_return_ uint64 GetLargestFreeRange(void) const;
+		/* Gets how fragmented the free space is, zero means that all free space is one range and one means that it's scattered. */
+		_Check_return_ float GetFragmentation(void) const;
+
+		/* Gets the size of the range managed by the allocator. */
+		_Check_return_ inline uint64 GetCapacity(void) const
+		{
+			return capacity;
+		}
+
+		/* Gets the amount of allocated space (including alignment padding). */
+		_Check_return_ inline uint64 GetUsedSize(void) const
+		{
+			return used;
+		}
+
+		/* Gets the amount of space that is not allocated. */
+		_Check_return_ inline uint64 GetFreeSize(void) const
+		{
+			return capacity - used;
+		}
+
+		/* Gets the amount of active allocations. */
+		_Check_return_ inline uint32 GetAllocationCount(void) const
+		{
+			return allocations;
+		}
+
+		/* Gets the amount of separate free ranges. */
+		_Check_return_ inline uint32 GetFreeRangeCount(void) const
+		{
+			return freeRanges;
+		}
+
+		/* Gets whether no ranges are allocated. */
+		_Check_return_ inline bool IsEmpty(void) const
+		{
+			return !allocations;
+		}
+
+	private:
+		static constexpr uint32 SecondLevelLog2 = 4;
+		static constexpr uint32 SecondLevelCount = 1u << SecondLevelLog2;
+		static constexpr uint32 FirstLevelCount = 64 - SecondLevelLog2 + 1;
+
+		/* Defines either an allocated or a free range, the physical links are ordered by offset. */
+		struct Block
+		{
+			uint64 Offset, Size;
+			uint32 PrevPhysical, NextPhysical;
+			uint32 PrevFree, NextFree;
+			bool Free;
+		};
+
+		uint64 capacity, used;
+		uint32 allocations, freeRanges;
+
+		uint64 firstLevel;
+		uint32 secondLevel[FirstLevelCount];
+		uint32 heads[FirstLevelCount][SecondLevelCount];
+
+		vector<Block> blocks;
+		vector<uint32> unusedBlocks;
+
+		static void GetLevels(uint64 size, uint32 &fl, uint32 &sl);
+		uint32 FindFree(uint64 size) const;
+		void InsertFree(uint32 idx);
+		void RemoveFree(uint32 idx);
+		uint32 CreateBlock(uint64 offset, uint64 size, uint32 prev, uint32 next);
+		void ReleaseBlock(uint32 idx);
+	};
+}
\ No newline at end of file
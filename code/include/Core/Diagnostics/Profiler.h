@@ -45,6 +45,10 @@ namespace Pu
 		static void SetTargetFrameTime(_In_ float fps);
 		/* Sets the smoothing interval (in seconds). */
 		static void SetInterval(_In_ float value);
+		/* Gets the total time (in microseconds) recorded for the specified CPU category since the last clear (on all processors). */
+		_Check_return_ static int64 GetTime(_In_ const string &category);
+		/* Clears the times recorded for all CPU categories, this is useful when the profiler is never visualized or saved. */
+		static void Clear(void);
 
 		/* Starts or adds to the recording of a debug specific piece of code. */
 		static void BeginDebug(void)
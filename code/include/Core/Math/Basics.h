@@ -505,4 +505,12 @@ namespace std
 	{
 		return hash_combine(hash, std::hash<hashable_t>{}(other));
 	}
+
+	/* Adds the specified bytes to a FNV-1a hash, unlike std::hash this is stable between runs so it can be used for cache keys. */
+	_Check_return_ inline uint64_t hash_fnv1a(_In_ const void *data, _In_ size_t size, _In_opt_ uint64_t hash = 0xCBF29CE484222325ull)
+	{
+		const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+		return hash;
+	}
 }
\ No newline at end of file
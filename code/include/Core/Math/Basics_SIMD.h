@@ -39,9 +39,21 @@ namespace Pu
 		return reinterpret_cast<ofloat*>(_aligned_recalloc(block, count, sizeof(ofloat) * count, sizeof(ofloat)));
 	}
 
+	/* Realoctes the specified area of memory (for packed integers). */
+	_Check_return_ static inline int256* _mm256_realloc_si256(_In_ int256 *block, _In_ size_t count)
+	{
+		return reinterpret_cast<int256*>(_aligned_realloc(block, sizeof(int256) * count, sizeof(int256)));
+	}
+
 	/* Deallocates the specifie area of memory. */
 	static inline void _mm256_free_ps(_In_ ofloat *block)
 	{
 		_aligned_free(block);
 	}
+
+	/* Deallocates the specifie area of memory (for packed integers). */
+	static inline void _mm256_free_si256(_In_ int256 *block)
+	{
+		_aligned_free(block);
+	}
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "Graphics/Color.h"
+#include "Core/Collections/Vector.h"
 #include "Graphics/Vulkan/VulkanObjects.h"
 
 namespace Pu
@@ -44,6 +45,8 @@ namespace Pu
 		void SetHeightAndNormal(_In_ uint32 x, _In_ uint32 y, _In_ float height, _In_ Vector3 normal);
 		/* Generates normals for every point on the heightmap. */
 		void CalculateNormals(_In_ float displacement);
+		/* Generates the min/max pyramid used for fast rejection and raycasts, this needs to be called again after the heights change. */
+		void CalculateBounds(void);
 		/* Gets whether the specified location is on the heightmap. */
 		_Check_return_ bool Contains(_In_ uint32 x, _In_ uint32 y) const;
 		/* Gets whether the specified interpolated location is on the heightmap. */
@@ -66,6 +69,12 @@ namespace Pu
 		_Check_return_ bool TryGetNormal(_In_ Vector2 pos, _Out_ Vector3 &normal) const;
 		/* Attempts to get the height and normal from an interpolated point on the map. */
 		_Check_return_ bool TryGetHeightAndNormal(_In_ Vector2 pos, _Out_ float &height, _Out_ Vector3 &normal) const;
+		/* Attempts to get the heights and normals from eight interpolated points on the map, returns a mask of the valid points. */
+		_Check_return_ ofloat TryGetHeightAndNormal(_In_ ofloat x, _In_ ofloat y, _Out_ ofloat &height, _Out_ ofloat &nx, _Out_ ofloat &ny, _Out_ ofloat &nz) const;
+		/* Gets a conservative range of the heights within the specified area (infinite if the bounds haven't been calculated). */
+		void GetHeightRange(_In_ Vector2 lower, _In_ Vector2 upper, _Out_ float &low, _Out_ float &high) const;
+		/* Gets the distance on the ray at which it intersects the heightmap, if it doesn't intersect; the value is negative. */
+		_Check_return_ float Raycast(_In_ Vector3 p, _In_ Vector3 d) const;
 		/* Renders the heightmap to the debug renderer. */
 		void Visualize(_In_ DebugRenderer &renderer, _In_ Vector3 offset, _In_ Color color) const;
 
@@ -76,15 +85,25 @@ namespace Pu
 		}
 
 	private:
+		struct MipLevel
+		{
+			uint32 Offset;
+			uint32 Width;
+			uint32 Height;
+		};
+
 		float *data;
 		Vector3 *normals;
 		uint32 width, height;
 		uint32 boundX, boundY;
 		Vector2 patchSize, iPatchSize;
+		vector<Vector2> bounds;
+		vector<MipLevel> levels;
 
 		void TransformPosition(Vector2 input, uint32 &px, uint32 &py, float &x, float &y) const;
 		float QueryHeight(uint32 apx, uint32 apy, uint32 bpx, uint32 bpy, uint32 cpx, uint32 cpy, float t, float s) const;
 		Vector3 QueryNormal(uint32 apx, uint32 apy, uint32 bpx, uint32 bpy, uint32 cpx, uint32 cpy, float t, float s) const;
+		float RaycastPatch(Vector3 p, Vector3 d, uint32 x, uint32 y) const;
 		void Alloc(bool allocNormals);
 		void Copy(const HeightMap &other);
 		void Free(void);
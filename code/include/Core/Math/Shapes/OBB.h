@@ -69,4 +69,18 @@ namespace Pu
 			return Extent.Z * 2.0f;
 		}
 	};
+
+	/* Defines the GJK support function for an oriented bounding box. */
+	_Check_return_ inline Vector3 gjk_support_obb(_In_ Vector3 dir, _In_ const void *userParam)
+	{
+		const OBB *obb = reinterpret_cast<const OBB*>(userParam);
+		const Vector3 x = obb->GetRight();
+		const Vector3 y = obb->GetUp();
+		const Vector3 z = obb->GetForward();
+
+		return obb->Center +
+			x * (dot(dir, x) >= 0.0f ? obb->Extent.X : -obb->Extent.X) +
+			y * (dot(dir, y) >= 0.0f ? obb->Extent.Y : -obb->Extent.Y) +
+			z * (dot(dir, z) >= 0.0f ? obb->Extent.Z : -obb->Extent.Z);
+	}
 }
\ No newline at end of file
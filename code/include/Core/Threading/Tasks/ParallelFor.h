@@ -0,0 +1,60 @@
+#pragma once
+#include "Core/Threading/Tasks/Scheduler.h"
+#include "Core/Math/Basics.h"
+
+namespace Pu
+{
+	/* Defines a task that executes a single chunk of a parallel for loop. */
+	template <typename kernel_t>
+	class ParallelForTask
+		: public Task
+	{
+	public:
+		/* Initializes a new instance of a parallel for chunk task. */
+		ParallelForTask(_In_ const kernel_t &kernel, _In_ size_t start, _In_ size_t end, _In_ std::atomic_size_t &remaining)
+			: Task("Parallel For"), kernel(kernel), start(start), end(end), remaining(remaining)
+		{}
+
+		/* Executes the kernel over the range of the chunk. */
+		_Check_return_ Result Execute(void) final
+		{
+			kernel(start, end);
+
+			/* The caller is allowed to return as soon as this is decremented, so it has to be the last use of the shared state. */
+			--remaining;
+			return Result::AutoDelete();
+		}
+
+	private:
+		const kernel_t &kernel;
+		size_t start, end;
+		std::atomic_size_t &remaining;
+	};
+
+	/*
+	Executes the specified kernel (void(size_t start, size_t end)) over the range [0, count) in chunks of the specified size.
+	The calling thread executes the first chunk and helps the scheduler until all chunks are done,
+	so this can only be called from a thread that was not created by the scheduler.
+	*/
+	template <typename kernel_t>
+	void ParallelFor(_In_ size_t count, _In_ size_t chunkSize, _In_ const kernel_t &kernel)
+	{
+		/* Just execute the kernel inline if there is no work to split or no one to split it with. */
+		if (count <= chunkSize || !TaskScheduler::GetThreadCount())
+		{
+			kernel(0, count);
+			return;
+		}
+
+		const size_t chunks = (count + chunkSize - 1) / chunkSize;
+		std::atomic_size_t remaining{ chunks - 1 };
+
+		for (size_t i = 1; i < chunks; i++)
+		{
+			TaskScheduler::Spawn(*new ParallelForTask<kernel_t>(kernel, i * chunkSize, min(count, (i + 1) * chunkSize), remaining));
+		}
+
+		kernel(0, chunkSize);
+		while (remaining.load()) TaskScheduler::Help();
+	}
+}
\ No newline at end of file
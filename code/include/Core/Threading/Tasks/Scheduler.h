@@ -25,6 +25,8 @@ namespace Pu
 		static void StopWait(void);
 		/* Attempts to steal a task from a queue and executes that task (can only be called from a thread not created from the scheduler). */
 		static void Help(void);
+		/* Gets the amount of worker threads used by the scheduler. */
+		_Check_return_ static size_t GetThreadCount(void);
 
 	private:
 		static void ThreadMain(size_t idx);
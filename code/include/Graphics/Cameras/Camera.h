@@ -80,6 +80,12 @@ namespace Pu
 			return Orientation;
 		}
 
+		/* Gets the size (in pixels) of the viewport that the camera renders to. */
+		_Check_return_ inline Vector2 GetViewportSize(void) const
+		{
+			return wndSize;
+		}
+
 		/* Gets the exposure of the camera. */
 		_Check_return_ inline float GetExposure(void) const
 		{
@@ -8,13 +8,18 @@
 #include "Graphics/Platform/GameWindow.h"
 #include "Graphics/Textures/DepthBuffer.h"
 #include "Graphics/VertexLayouts/ColoredVertex3D.h"
+#include <atomic>
 
 namespace Pu
 {
 	class DynamicBuffer;
 	class ProfilerChain;
 
-	/* Defines an obect used to render debug shapes. */
+	/*
+	Defines an obect used to render debug shapes.
+	Shapes can be added from any thread (including scheduler workers) without locking,
+	but they must not be added while the debug renderer is rendering.
+	*/
 	class DebugRenderer
 	{
 	public:
@@ -28,6 +33,12 @@ namespace Pu
 		_Check_return_ DebugRenderer& operator =(_In_ const DebugRenderer&) = delete;
 		_Check_return_ DebugRenderer& operator =(_In_ DebugRenderer&&) = delete;
 
+		/* Gets the amount of shapes that were dropped during the last render because the buffer was full. */
+		_Check_return_ inline uint32 GetDroppedCount(void) const
+		{
+			return lastDropped;
+		}
+
 		/* Adds a single line to the debug renderer. */
 		void AddLine(_In_ const Line &line, _In_ Color color);
 		/* Adds a single line to the debug renderer queue. */
@@ -80,18 +91,16 @@ namespace Pu
 
 		DynamicBuffer *buffer;
 		const DepthBuffer *depthBuffer;
-		uint32 cntLine, cntArrow, cntBox, cntEllipsoid, cntHemisphere;
-
-#ifdef _DEBUG
-		mutable uint32 culled;
-#endif
+		std::atomic<uint32> counts[5];
+		std::atomic<uint32> dropped;
+		uint32 lastDropped;
 
 		float lineWidth;
 		uint32 invalidated;
 		bool dynamicLineWidth, thrown;
 
-		bool CheckCapacity(uint32 list, uint32 addition) const;
-		void AddLineInternal(Vector3 start, Vector3 end, Color color);
+		VertexLayout* Reserve(uint32 list, uint32 amount);
+		static void WriteLine(VertexLayout *mem, Vector3 start, Vector3 end, Color color);
 		void InitializeRenderpass(Renderpass&);
 		void InitializePipeline(Renderpass&);
 		void CreatePipeline(void);
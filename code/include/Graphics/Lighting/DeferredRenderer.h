@@ -50,7 +50,7 @@ namespace Pu
 		/* Checks whether the deferred renderer is ready for use. */
 		_Check_return_ inline bool IsUsable(void) const
 		{
-			return renderpass->IsLoaded() && lightVolumes->Count();
+			return renderpass->IsLoaded() && lightVolumes->Count() && coarseLightVolumes->Count();
 		}
 
 		/* Gets the renderpass associated with this deferred renderer. */
@@ -104,23 +104,36 @@ namespace Pu
 		/* Queries the configurable properties again from the run time configuration and updates the renderer accordingly. */
 		void UpdateConfigurableProperties(void);
 
+		/* Gets whether the geometry subpasses can be recorded into secondary command buffers. */
+		_Check_return_ bool SupportsSecondaryRecording(void) const;
+
 		/* Performs needed resource transitions. */
 		void InitializeResources(_In_ CommandBuffer &cmdBuffer, _In_ const Camera &camera);
 		/* Begins the specified subpass (order should be preserved). */
 		void Begin(_In_ uint32 subpass);
+		/* Begins the specified static geometry subpass, whose contents can only be recorded in secondary command buffers (order should be preserved). */
+		void BeginSecondary(_In_ uint32 subpass);
+		/* Executes the specified secondary command buffer in the active secondary subpass. */
+		void Execute(_In_ const CommandBuffer &secondary);
 		/* End the deferred rendering pipeline. */
 		void End(void);
 
 		/* Renders the specified terrain piece to the G-Buffer. */
 		void Render(_In_ const TerrainChunk &chunk);
-		/* Renders the specified model to the G-Buffer. */
-		void Render(_In_ const Model &model, _In_ const Matrix &transform);
+		/* Renders the specified instances (model matrices) of a level of detail of the model to the G-Buffer, returns the amount of draw calls issued. */
+		_Check_return_ uint32 Render(_In_ const Model &model, _In_ uint32 lod, _In_ const DynamicBuffer &instances, _In_ uint32 firstInstance, _In_ uint32 instanceCount);
+		/* Encodes the pipeline and camera binds needed at the start of a secondary command buffer of the specified static geometry subpass. */
+		void Encode(_In_ CommandList &list, _In_ uint32 subpass) const;
+		/* Encodes the specified instances of a level of detail of the model to the command list, returns the amount of draw calls encoded. */
+		_Check_return_ uint32 Encode(_In_ CommandList &list, _In_ uint32 subpass, _In_ const Model &model, _In_ uint32 lod, _In_ const DynamicBuffer &instances, _In_ uint32 firstInstance, _In_ uint32 instanceCount) const;
+		/* Records the command list into a secondary command buffer for the specified subpass (can be called from any thread after InitializeResources). */
+		void RecordSecondary(_Inout_ CommandBuffer &cmdBuffer, _In_ uint32 subpass, _In_ const CommandList &list) const;
 		/* Render the specified model to the G-Buffer. */
 		void Render(_In_ const Model &model, _In_ const Matrix &transform, _In_ uint32 keyFrame1, _In_ uint32 keyFrame2, _In_ float blending);
 		/* Renders the specified direction light onto the scene. */
 		void Render(_In_ const DirectionalLight &light);
-		/* Renders the specified point lights onto the scene. */
-		void Render(_In_ const PointLightPool &lights);
+		/* Renders the specified range of point lights onto the scene, small lights can use the coarse light volume. */
+		void Render(_In_ const PointLightPool &lights, _In_ uint32 firstLight, _In_ uint32 lightCount, _In_ bool coarse);
 
 		/* Sets the skybox to use. */
 		void SetSkybox(_In_ const TextureCube &texture);
@@ -140,12 +153,14 @@ namespace Pu
 
 		DescriptorPool *descPoolInput;
 		DescriptorSetGroup *descSetInput;
-		MeshCollection *lightVolumes;
+		DescriptorSet *descSetSkybox;
+		MeshCollection *lightVolumes, *coarseLightVolumes;
 		const TextureCube *skybox;
 
 		CommandBuffer *curCmd;
 		const Camera *curCam;
-		bool renderpassStarted;
+		CommandList inlineList;
+		bool renderpassStarted, secondaryActive, coarseVolumeBound;
 		int32 activeSubpass;
 
 		PolygonMode polygonMode;
@@ -154,11 +169,13 @@ namespace Pu
 		ProfilerChain *timer;
 #ifdef _DEBUG
 		QueryChain *stats;
+		QueryPipelineStatisticFlags statFlags;
 #endif
 
-		void EndSubpass(uint32 newSubpass, uint32 uActiveSubpass);
+		void EndSubpass(uint32 newSubpass, uint32 uActiveSubpass, SubpassContents contents);
 		void DoSkybox(void);
 		void DoTonemap(void);
+		void BindLightVolume(bool coarse);
 		void OnSwapchainRecreated(const GameWindow&, const SwapchainReCreatedEventArgs &args);
 		void InitializeRenderpass(Renderpass&);
 		void FinalizeRenderpass(Renderpass&);
@@ -0,0 +1,109 @@
+#pragma once
+#include "Config.h"
+#include "Core/Math/Matrix.h"
+#include "Core/Math/Shapes/Frustum.h"
+#include "Core/Collections/Vector.h"
+
+namespace Pu
+{
+	class OcclusionBuffer;
+
+	/* Defines a contiguous range of point lights that can be drawn with a single instanced draw. */
+	struct PointLightRun
+	{
+		/* The index of the first light in the range. */
+		uint32 First;
+		/* The amount of lights in the range. */
+		uint32 Count;
+	};
+
+	/*
+	Defines a persistent SoA copy of the point light volumes that is used to cull the lights on the CPU.
+	Lights are tested against the view frustum and (optionally) an occlusion buffer, the remaining lights are bucketed by their projected radius.
+	The result is a list of contiguous light ranges per bucket, so the lights can be drawn directly from a persistent instance buffer.
+	This object doesn't use any graphics resources, so it can be used without a device.
+	*/
+	class PointLightCuller
+	{
+	public:
+		/* Defines the result of culling a single light. */
+		enum class State : uint8
+		{
+			/* The light volume is outside of the view frustum. */
+			Outside,
+			/* The light volume is hidden behind an occluder. */
+			Occluded,
+			/* The light should be drawn with the full light volume. */
+			Volume,
+			/* The light should be drawn with the coarse light volume. */
+			Coarse
+		};
+
+		/* Initializes a new instance of a point light culler with a specific coarse radius (in pixels). */
+		PointLightCuller(_In_ float coarseRadius);
+		PointLightCuller(_In_ const PointLightCuller&) = delete;
+		/* Move constructor. */
+		PointLightCuller(_In_ PointLightCuller &&value) = default;
+
+		_Check_return_ PointLightCuller& operator =(_In_ const PointLightCuller&) = delete;
+		/* Move assignment. */
+		_Check_return_ PointLightCuller& operator =(_In_ PointLightCuller &&other) = default;
+
+		/* Gets the amount of lights in the culler. */
+		_Check_return_ inline uint32 GetCount(void) const
+		{
+			return static_cast<uint32>(x.size());
+		}
+
+		/* Gets the state of the specified light during the last cull. */
+		_Check_return_ inline State GetState(_In_ uint32 idx) const
+		{
+			return states[idx];
+		}
+
+		/* Gets the ranges of lights that should be drawn with the full light volume. */
+		_Check_return_ inline const vector<PointLightRun>& GetVolumeRuns(void) const
+		{
+			return volumeRuns;
+		}
+
+		/* Gets the ranges of lights that should be drawn with the coarse light volume. */
+		_Check_return_ inline const vector<PointLightRun>& GetCoarseRuns(void) const
+		{
+			return coarseRuns;
+		}
+
+		/* Gets the amount of lights that were visible during the last cull. */
+		_Check_return_ inline uint32 GetVisibleCount(void) const
+		{
+			return visibleCount;
+		}
+
+		/* Gets the amount of lights that were hidden by occluders during the last cull. */
+		_Check_return_ inline uint32 GetOccludedCount(void) const
+		{
+			return occludedCount;
+		}
+
+		/* Adds a light with the specified (world space) bounding sphere. */
+		void Add(_In_ Vector3 position, _In_ float radius);
+		/* Updates the bounding sphere of the specified light. */
+		void Set(_In_ uint32 idx, _In_ Vector3 position, _In_ float radius);
+		/* Removes the specified light, this moves all the lights after it down by one. */
+		void RemoveAt(_In_ uint32 idx);
+		/* Removes all lights, this doesn't release the memory. */
+		void Clear(void);
+		/* Culls all lights, the viewport height is the height (in pixels) of the render target. */
+		void Cull(_In_ const Frustum &frustum, _In_ Vector3 camera, _In_ const Matrix &projection, _In_ float viewportHeight, _In_opt_ const OcclusionBuffer *occlusion);
+
+	private:
+		float coarseRadius;
+		uint32 visibleCount, occludedCount;
+
+		vector<float> x, y, z, r;
+		vector<State> states;
+		vector<PointLightRun> volumeRuns, coarseRuns;
+
+		void BuildRuns(State bucket, vector<PointLightRun> &runs) const;
+	};
+}
\ No newline at end of file
@@ -4,7 +4,10 @@
 
 namespace Pu
 {
-	/* Defines a instance pool used to render multiple point lights at once. */
+	/*
+	Defines a instance pool used to render multiple point lights at once.
+	The lights persist in the pool between frames, only the range of lights that changed since the last update is uploaded.
+	*/
 	class PointLightPool
 		: public DynamicBuffer
 	{
@@ -31,10 +34,18 @@ namespace Pu
 			return static_cast<uint32>(buffer.size());
 		}
 
+		/* Gets the light at the specified index. */
+		_Check_return_ inline const PointLight& GetLight(_In_ uint32 idx) const
+		{
+			return buffer[idx];
+		}
+
 		/* Clears the host buffer of point lights. */
 		inline void Clear(void)
 		{
 			buffer.clear();
+			dirtyStart = 0;
+			dirtyEnd = 0;
 		}
 
 		/* Calculates the radius of the point light volume based on the specified parameters and the cutoff point. */
@@ -46,13 +57,19 @@ namespace Pu
 		void AddLight(_In_ Vector3 position, _In_ Color color, _In_ float intensity, _In_ float falloffLinear, _In_ float falloffQuadratic);
 		/* Adds a new pre-calculated with to the pool. */
 		void AddLight(_In_ const PointLight &light);
-		/* Updates the point light pool if needed. */
+		/* Replaces the light at the specified index. */
+		void SetLight(_In_ uint32 idx, _In_ const PointLight &light);
+		/* Removes the light at the specified index, this moves all the lights after it down by one. */
+		void RemoveLight(_In_ uint32 idx);
+		/* Updates the lights that changed since the last update if needed. */
 		virtual void Update(_In_ CommandBuffer &cmdBuffer) override;
-		/* Forces the host light buffer to update the GPU buffer. */
+		/* Copies the lights that changed since the last update to the host memory of the GPU buffer. */
 		void StageLightBuffer(void);
 
 	private:
-		bool isDirty;
+		uint32 dirtyStart, dirtyEnd;
 		vector<PointLight> buffer;
+
+		void MarkDirty(uint32 start, uint32 end);
 	};
 }
\ No newline at end of file
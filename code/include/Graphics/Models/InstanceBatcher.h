@@ -0,0 +1,71 @@
+#pragma once
+#include "Core/Math/Matrix.h"
+#include "Core/Collections/Vector.h"
+
+namespace Pu
+{
+	/* Defines a single instanced draw created by an instance batcher. */
+	struct InstanceBatch
+	{
+		/* The subpass in which the instances should be rendered. */
+		uint32 Subpass;
+		/* The user defined identifier of the model of the instances. */
+		uint32 Model;
+		/* The level of detail of the model that should be rendered. */
+		uint32 Lod;
+		/* The index of the first instance transform in the packed transforms. */
+		uint32 FirstInstance;
+		/* The amount of instances in this batch. */
+		uint32 InstanceCount;
+	};
+
+	/*
+	Defines a helper that groups objects into instanced draws.
+	Objects are sorted on subpass, model and level of detail, materials are owned by the model so they're implicitly grouped as well.
+	This object doesn't use any graphics resources, so it can be used without a device.
+	*/
+	class InstanceBatcher
+	{
+	public:
+		/* Initializes an empty instance of an instance batcher. */
+		InstanceBatcher(void) = default;
+		InstanceBatcher(_In_ const InstanceBatcher&) = delete;
+		/* Move constructor. */
+		InstanceBatcher(_In_ InstanceBatcher &&value) = default;
+
+		_Check_return_ InstanceBatcher& operator =(_In_ const InstanceBatcher&) = delete;
+		/* Move assignment. */
+		_Check_return_ InstanceBatcher& operator =(_In_ InstanceBatcher &&other) = default;
+
+		/* Gets the batches created by the last pack. */
+		_Check_return_ inline const vector<InstanceBatch>& GetBatches(void) const
+		{
+			return batches;
+		}
+
+		/* Gets the instance transforms, in batch order, created by the last pack. */
+		_Check_return_ inline const vector<Matrix>& GetTransforms(void) const
+		{
+			return transforms;
+		}
+
+		/* Gets the amount of instances added since the last clear. */
+		_Check_return_ inline uint32 GetInstanceCount(void) const
+		{
+			return static_cast<uint32>(keys.size());
+		}
+
+		/* Removes all the instances and batches, this doesn't release the memory. */
+		void Clear(void);
+		/* Adds an instance of the specified model (at a specific level of detail), in the specified subpass, to the batcher. */
+		void Add(_In_ uint32 subpass, _In_ uint32 model, _In_ const Matrix &transform, _In_opt_ uint32 lod = 0);
+		/* Sorts the instances and packs them into batches that never cross a multiple of the specified page size. */
+		void Pack(_In_ uint32 pageSize);
+
+	private:
+		vector<std::pair<uint64, uint32>> keys;
+		vector<Matrix> input;
+		vector<Matrix> transforms;
+		vector<InstanceBatch> batches;
+	};
+}
\ No newline at end of file
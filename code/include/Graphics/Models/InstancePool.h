@@ -0,0 +1,40 @@
+#pragma once
+#include "Graphics/Resources/DynamicBuffer.h"
+#include "Core/Math/Matrix.h"
+
+namespace Pu
+{
+	/* Defines a instance pool used to render multiple instances of a model at once. */
+	class InstancePool
+		: public DynamicBuffer
+	{
+	public:
+		/* Initializes a new instance of an instance pool with a specific maximum amount of instances. */
+		InstancePool(_In_ LogicalDevice &device, _In_ uint32 maxInstances);
+		InstancePool(_In_ const InstancePool&) = delete;
+		/* Move constructor. */
+		InstancePool(_In_ InstancePool &&value) = default;
+
+		_Check_return_ InstancePool& operator =(_In_ const InstancePool&) = delete;
+		/* Move assignment. */
+		_Check_return_ InstancePool& operator =(_In_ InstancePool &&other) = default;
+
+		/* Gets the maximum amount of instances that can be stored in this pool. */
+		_Check_return_ inline uint32 GetCapacity(void) const
+		{
+			return capacity;
+		}
+
+		/* Gets the amount of instances currently in this pool. */
+		_Check_return_ inline uint32 GetInstanceCount(void) const
+		{
+			return count;
+		}
+
+		/* Copies the specified transforms to the staging buffer of this pool. */
+		void Stage(_In_ const Matrix *transforms, _In_ uint32 instanceCount);
+
+	private:
+		uint32 capacity, count;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+#include "Config.h"
+#include "Core/Math/Matrix.h"
+#include "Core/Collections/Vector.h"
+
+namespace Pu
+{
+	/*
+	Defines a helper that selects the level of detail of objects by their projected screen space error.
+	Every level has a geometric error, a coarser level is used as soon as that error projects to fewer pixels than the threshold.
+	The previous level of an object widens the switch distance of the coarser levels and narrows that of the finer levels,
+	this hysteresis band stops objects from popping between two levels when they're close to the switch distance.
+	This object doesn't use any graphics resources, so it can be used without a device.
+	*/
+	class LodSelector
+	{
+	public:
+		/* Initializes a new instance of a level of detail selector with a specific error threshold (in pixels) and hysteresis band. */
+		LodSelector(_In_ float threshold, _In_ float hysteresis);
+		LodSelector(_In_ const LodSelector&) = delete;
+		/* Move constructor. */
+		LodSelector(_In_ LodSelector &&value) = default;
+
+		_Check_return_ LodSelector& operator =(_In_ const LodSelector&) = delete;
+		/* Move assignment. */
+		_Check_return_ LodSelector& operator =(_In_ LodSelector &&other) = default;
+
+		/* Gets the amount of objects added since the last clear. */
+		_Check_return_ inline uint32 GetCount(void) const
+		{
+			return static_cast<uint32>(x.size());
+		}
+
+		/* Gets the level of detail selected for the specified object during the last selection. */
+		_Check_return_ inline uint32 GetLevel(_In_ uint32 idx) const
+		{
+			return levels[idx];
+		}
+
+		/* Sets the camera used to project the errors, the viewport height is the height (in pixels) of the render target. */
+		void SetCamera(_In_ Vector3 position, _In_ const Matrix &projection, _In_ float viewportHeight);
+		/* Removes all objects, this doesn't release the memory. */
+		void Clear(void);
+		/* Adds an object with a (world space) bounding sphere, the object space errors of its levels, its world scale and its previous level. */
+		void Add(_In_ Vector3 center, _In_ float radius, _In_ const vector<float> &errors, _In_ float scale, _In_ uint32 previous);
+		/* Selects the level of detail of all the added objects. */
+		void Select(void);
+
+	private:
+		float threshold, hysteresis;
+		Vector3 camera;
+		float projScale;
+
+		vector<float> x, y, z, r;
+		vector<float> errors[MaxLodLevels - 1];
+		vector<uint32> previous;
+		vector<uint32> levels;
+	};
+}
\ No newline at end of file
@@ -33,6 +33,8 @@ namespace Pu
 
 		/* Draws the mesh a specified amount of times. */
 		void Draw(_In_ CommandBuffer &cmdBuffer, _In_ uint32 firstInstance, _In_ uint32 instanceCount) const;
+		/* Encodes a draw of the mesh a specified amount of times into the command list. */
+		void Draw(_In_ CommandList &list, _In_ uint32 firstInstance, _In_ uint32 instanceCount) const;
 		/* Creates the indirect drawing parameters for a specified amount of instances. */
 		_Check_return_ DrawIndirectCommand Indirect(_In_ uint32 instanceCount) const;
 
@@ -39,6 +39,24 @@ namespace Pu
 			return meshes;
 		}
 
+		/* Gets the amount of detail levels of this model. */
+		_Check_return_ inline uint32 GetLevelCount(void) const
+		{
+			return static_cast<uint32>(lods.size());
+		}
+
+		/* Gets the indices of the meshes that are rendered at the specified level of detail. */
+		_Check_return_ inline const vector<uint32>& GetLevel(_In_ uint32 lod) const
+		{
+			return lods.at(lod);
+		}
+
+		/* Gets the estimated (object space) geometric error of every level of detail, these are ordered from fine to coarse. */
+		_Check_return_ inline const vector<float>& GetLevelErrors(void) const
+		{
+			return lodErrors;
+		}
+
 		/* Gets the material at the specified index. */
 		_Check_return_ inline const Material& GetMaterial(_In_ uint32 idx) const
 		{
@@ -72,7 +90,10 @@ namespace Pu
 
 		MeshCollection meshes;
 		vector<PumNode> nodes;
+		vector<vector<uint32>> lods;
+		vector<float> lodErrors;
 
+		void SetLevels(const vector<PumMesh> *geometry);
 		void AllocPools(const DeferredRenderer &deferred, const LightProbeRenderer *probes, size_t basicCount, size_t advancedCount);
 		void Finalize(CommandBuffer &cmdBuffer, const DeferredRenderer &deferred, const LightProbeRenderer *probes, const PuMData &data);
 		void Finalize(CommandBuffer &cmdBuffer, const DeferredRenderer &deferred, const LightProbeRenderer *probes);
@@ -0,0 +1,116 @@
+#pragma once
+#include "Core/Collections/Vector.h"
+#include "Graphics/Vulkan/VulkanGlobals.h"
+#include "Graphics/Vulkan/VulkanEnums.h"
+
+namespace Pu
+{
+	class Buffer;
+	class DescriptorSet;
+	class GraphicsPipeline;
+	class DescriptorSetGroup;
+
+	/* Defines the types of commands that can be stored in a command list. */
+	enum class CommandType : uint8
+	{
+		/* Binds a graphics pipeline. */
+		BindPipeline,
+		/* Binds a single descriptor set to the active graphics pipeline. */
+		BindDescriptor,
+		/* Binds the descriptor sets of a group for a specific subpass to the active graphics pipeline. */
+		BindDescriptors,
+		/* Binds a vertex buffer to a specific binding. */
+		BindVertexBuffer,
+		/* Binds an index buffer. */
+		BindIndexBuffer,
+		/* Draws non-indexed vertices. */
+		Draw,
+		/* Draws indexed vertices. */
+		DrawIndexed
+	};
+
+	/* Defines a single command stored in a command list. */
+	struct EncodedCommand
+	{
+		/* The type of the command. */
+		CommandType Type;
+		/* The graphics pipeline that is bound or used as the layout for descriptors. */
+		const GraphicsPipeline *Gfx;
+		/* The resource used by the command, the type depends on the command type. */
+		union
+		{
+			const DescriptorSet *Set;
+			const DescriptorSetGroup *Group;
+			const Buffer *Data;
+		};
+		/* The offset into the buffer for buffer bind commands. */
+		DeviceSize Offset;
+		/* The integer arguments of the command (binding, index type, subpass or draw arguments). */
+		uint32 Args[5];
+	};
+
+	/*
+	Defines a CPU-side list of encoded graphics commands.
+	The list only stores the commands, so it can be built and validated without a logical device.
+	The commands are replayed into a command buffer with CommandBuffer::Append.
+	*/
+	class CommandList
+	{
+	public:
+		/* Initializes an empty instance of a command list. */
+		CommandList(void) = default;
+		/* Copy constructor. */
+		CommandList(_In_ const CommandList&) = default;
+		/* Move constructor. */
+		CommandList(_In_ CommandList&&) = default;
+
+		/* Copy assignment. */
+		_Check_return_ CommandList& operator =(_In_ const CommandList&) = default;
+		/* Move assignment. */
+		_Check_return_ CommandList& operator =(_In_ CommandList&&) = default;
+
+		/* Gets the encoded commands. */
+		_Check_return_ inline const vector<EncodedCommand>& GetCommands(void) const
+		{
+			return commands;
+		}
+
+		/* Gets the amount of commands in this list. */
+		_Check_return_ inline size_t size(void) const
+		{
+			return commands.size();
+		}
+
+		/* Gets the amount of draw commands in this list. */
+		_Check_return_ inline uint32 GetDrawCount(void) const
+		{
+			return draws;
+		}
+
+		/* Removes all commands from the list, this doesn't release the memory. */
+		void Clear(void);
+		/* Appends a graphics pipeline bind command. */
+		void BindGraphicsPipeline(_In_ const GraphicsPipeline &pipeline);
+		/* Appends a descriptor set bind command for the last bound pipeline. */
+		void BindGraphicsDescriptor(_In_ const DescriptorSet &descriptor);
+		/* Appends a bind command for all the descriptor sets of the specified subpass for the last bound pipeline. */
+		void BindGraphicsDescriptors(_In_ uint32 subpassIdx, _In_ const DescriptorSetGroup &descriptors);
+		/* Appends a vertex buffer bind command. */
+		void BindVertexBuffer(_In_ uint32 binding, _In_ const Buffer &buffer, _In_ DeviceSize offset);
+		/* Appends an index buffer bind command. */
+		void BindIndexBuffer(_In_ IndexType type, _In_ const Buffer &buffer, _In_ DeviceSize offset);
+		/* Appends a draw command. */
+		void Draw(_In_ uint32 vertexCount, _In_ uint32 instanceCount, _In_ uint32 firstVertex, _In_ uint32 firstInstance);
+		/* Appends an indexed draw command. */
+		void Draw(_In_ uint32 indexCount, _In_ uint32 instanceCount, _In_ uint32 firstIndex, _In_ uint32 firstInstance, _In_ int32 vertexOffset);
+		/* Checks whether the commands in this list can be replayed into a command buffer that has no state bound. */
+		_Check_return_ bool Validate(void) const;
+
+	private:
+		vector<EncodedCommand> commands;
+		const GraphicsPipeline *gfx = nullptr;
+		uint32 draws = 0;
+
+		EncodedCommand& Add(CommandType type);
+	};
+}
\ No newline at end of file
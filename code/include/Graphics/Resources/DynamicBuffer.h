@@ -27,6 +27,8 @@ namespace Pu
 
 		/* Updates the dynamic buffer if needed. */
 		virtual void Update(_In_ CommandBuffer &cmdBuffer);
+		/* Updates only the specified range (in bytes) of the dynamic buffer if needed. */
+		void Update(_In_ CommandBuffer &cmdBuffer, _In_ DeviceSize offset, _In_ DeviceSize range);
 		/* Starts the process of transfering data from the CPU to this buffer. */
 		virtual void BeginMemoryTransfer(void) override;
 		/* Gets the host mapped memory pointer. */
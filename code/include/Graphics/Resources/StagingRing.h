@@ -0,0 +1,94 @@
+#pragma once
+#include <mutex>
+#include "StagingBuffer.h"
+#include "Graphics/Vulkan/CommandPool.h"
+#include "Graphics/Diagnostics/ProfilerChain.h"
+#include "Core/Collections/RingAllocator.h"
+
+namespace Pu
+{
+	class Queue;
+	class Image;
+
+	/*
+	Defines a persistently mapped ring of upload memory.
+	Uploads are copied into the ring and the copy commands are batched until the ring is flushed,
+	all pending copies are then submitted as a single command buffer and the ring memory is reused once its fence is signaled.
+	*/
+	class StagingRing
+	{
+	public:
+		/* Initializes a new instance of a staging ring that submits to the specified queue. */
+		StagingRing(_In_ LogicalDevice &device, _In_ Queue &queue, _In_ size_t size);
+		StagingRing(_In_ const StagingRing&) = delete;
+		StagingRing(_In_ StagingRing&&) = delete;
+		/* Waits for all submitted uploads and releases the ring. */
+		~StagingRing(void);
+
+		_Check_return_ StagingRing& operator =(_In_ const StagingRing&) = delete;
+		_Check_return_ StagingRing& operator =(_In_ StagingRing&&) = delete;
+
+		/* Gets the size (in bytes) of the ring, larger uploads use their own staging buffer. */
+		_Check_return_ inline size_t GetCapacity(void) const
+		{
+			return static_cast<size_t>(ring.GetCapacity());
+		}
+
+		/* Queues an upload of the specified data to the destination buffer and returns the submission that will contain the upload. */
+		_Check_return_ uint64 Stage(_In_ const void *data, _In_ size_t size, _In_ Buffer &destination, _In_ DeviceSize offset, _In_ PipelineStageFlags dstStage, _In_ AccessFlags access);
+		/* Queues a copy of the entire source buffer to the destination buffer and returns the submission that will contain the copy, the source is deleted once the copy has completed. */
+		_Check_return_ uint64 Stage(_In_ StagingBuffer *source, _In_ Buffer &destination, _In_ PipelineStageFlags dstStage, _In_ AccessFlags access);
+		/* Queues an upload of the specified data to the first mip level of the destination image and returns the submission that will contain the upload, the image is left as a transfer destination. */
+		_Check_return_ uint64 Stage(_In_ const void *data, _In_ size_t size, _In_ Image &destination, _In_ uint32 arrayLayer);
+		/* Submits all queued uploads as a single command buffer. */
+		void Flush(void);
+		/* Gets whether the specified submission has completed, this flushes the ring if the submission is still being batched. */
+		_Check_return_ bool IsCompleted(_In_ uint64 submission);
+		/* Releases the ring memory of all completed submissions. */
+		void Update(void);
+
+	private:
+		struct BufferUpload
+		{
+			const Buffer *Source;
+			Buffer *Destination;
+			BufferCopy Region;
+			PipelineStageFlags Stage;
+			AccessFlags Access;
+		};
+
+		struct ImageUpload
+		{
+			const Buffer *Source;
+			Image *Destination;
+			BufferImageCopy Region;
+		};
+
+		struct Submission
+		{
+			CommandBuffer CmdBuffer;
+			ProfilerChain Timer;
+			vector<StagingBuffer*> Sources;
+			uint64 Index;
+
+			Submission(CommandBuffer &&cmdBuffer, LogicalDevice &device);
+		};
+
+		LogicalDevice &device;
+		Queue &queue;
+		StagingBuffer buffer;
+		CommandPool pool;
+		RingAllocator ring;
+		std::mutex lock;
+
+		vector<BufferUpload> bufferUploads;
+		vector<ImageUpload> imageUploads;
+		vector<StagingBuffer*> sources;
+		vector<Submission*> submissions;
+		uint64 current, completed;
+
+		const Buffer& Reserve(const void *data, size_t size, uint64 alignment, uint64 &offset);
+		void FlushInternal(void);
+		void UpdateInternal(bool wait);
+	};
+}
\ No newline at end of file
@@ -2,11 +2,14 @@
 #include "Glyph.h"
 #include "CodeChart.h"
 #include "Graphics/Textures/Texture2D.h"
+#include <unordered_map>
 
 struct stbtt_fontinfo;
 
 namespace Pu
 {
+	class FileReader;
+
 	/* Defines a font with a with a specific size. */
 	class Font
 		: public Asset
@@ -33,6 +36,8 @@ namespace Pu
 		_Check_return_ Vector2 MeasureString(_In_ const ustring &str) const;
 		/* Gets the glyph info of the specified character (or the default if it's not available in the font). */
 		_Check_return_ const Glyph& GetGlyph(_In_ char32 key) const;
+		/* Loads only the glyph metrics from the specified file, the font can then be used to measure text but not to render it. */
+		void LoadMetrics(_In_ const wstring &path);
 
 		/* Gets the offset between lines. */
 		_Check_return_ inline int32 GetLineSpace(void) const
@@ -67,14 +72,25 @@ namespace Pu
 
 		CodeChart codeChart;
 		vector<Glyph> glyphs;
+		vector<uint16> directLut;
+		std::unordered_map<char32, uint16> sparseLut;
+		std::unordered_map<uint64, float> kerning;
 		size_t defaultGlyphIndex;
 		int32 lineSpace;
 		float size;
+		uint64 cacheKey;
 		
 		float GetScale(void) const;
 		void Load(const wstring &path);
+		uint64 GetFileHash(const wstring &path) const;
 		Vector2 LoadGlyphInfo(void);
-		void StageAtlas(Vector2 atlasSize, byte *dst);
+		void BuildGlyphLookup(void);
+		void BuildKerningTable(void);
+		void RasterizeGlyphs(size_t start, size_t end, Vector2 atlasSize, byte *dst) const;
+		void FinalizeGlyphs(Vector2 atlasSize);
+		wstring GetCachePath(void) const;
+		bool LoadCache(FileReader &reader, Vector2 &atlasSize);
+		void StoreCache(Vector2 atlasSize, const byte *atlas) const;
 		void Destroy();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include "Core/Collections/Vector.h"
+#include "Core/Math/Basics.h"
+
+namespace Pu
+{
+	/*
+	Defines a rectangle packer that uses the bottom-left skyline heuristic.
+	The width of the area is fixed, the height grows as rectangles are added.
+	*/
+	class SkylinePacker
+	{
+	public:
+		/* Initializes a new instance of a skyline packer with a specific width. */
+		SkylinePacker(_In_ uint32 width);
+		/* Copy constructor. */
+		SkylinePacker(_In_ const SkylinePacker&) = default;
+		/* Move constructor. */
+		SkylinePacker(_In_ SkylinePacker&&) = default;
+
+		/* Copy assignment. */
+		_Check_return_ SkylinePacker& operator =(_In_ const SkylinePacker&) = default;
+		/* Move assignment. */
+		_Check_return_ SkylinePacker& operator =(_In_ SkylinePacker&&) = default;
+
+		/* Adds a rectangle with the specified size, returns false if the rectangle is wider than the area. */
+		_Check_return_ bool Pack(_In_ uint32 w, _In_ uint32 h, _Out_ uint32 &x, _Out_ uint32 &y);
+		/* Removes all rectangles from the area. */
+		void Clear(void);
+
+		/* Gets the width of the area. */
+		_Check_return_ inline uint32 GetWidth(void) const
+		{
+			return width;
+		}
+
+		/* Gets the height needed to contain all rectangles. */
+		_Check_return_ inline uint32 GetHeight(void) const
+		{
+			return height;
+		}
+
+	private:
+		/* Defines a horizontal segment of the skyline. */
+		struct Node
+		{
+			uint32 X, Y, Width;
+		};
+
+		uint32 width, height;
+		vector<Node> skyline;
+
+		bool Fits(size_t idx, uint32 w, uint32 &y) const;
+	};
+}
\ No newline at end of file
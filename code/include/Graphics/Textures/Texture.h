@@ -95,16 +95,15 @@ namespace Pu
 			virtual Result Execute(void) override;
 			virtual Result Continue(void) override;
 
-			inline StagingBuffer& GetStagingBuffer(void)
-			{
-				return *stagingBuffer;
-			}
+			/* Gets the loaded texels of the first mip level. */
+			_Check_return_ const void* GetData(void) const;
+			/* Gets the size (in bytes) of the loaded texels. */
+			_Check_return_ size_t GetSize(void) const;
 
 		private:
 			Texture &result;
 			ImageInformation info;
 			Task *child;
-			StagingBuffer *stagingBuffer;
 			wstring path;
 		};
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "LogicalDevice.h"
+#include "DeviceMemoryAllocator.h"
 #include "Content/Asset.h"
 
 namespace Pu
@@ -89,13 +90,13 @@ namespace Pu
 		mutable AccessFlags srcAccess;
 
 		size_t size, gpuSize;
-		DeviceMemoryHndl memoryHndl;
+		DeviceAllocation memory;
 		BufferHndl bufferHndl;
 		MemoryPropertyFlags memoryProperties;
 		uint32 memoryType;
 		byte *buffer;
 
-		void Map(size_t size, size_t offset);
+		void Map(size_t offset);
 		void UnMap(void);
 
 		void Create(const BufferCreateInfo &createInfo, MemoryPropertyFlags optional);
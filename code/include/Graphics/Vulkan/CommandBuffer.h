@@ -7,6 +7,8 @@
 #include "Framebuffer.h"
 #include "QueryPool.h"
 #include "Fence.h"
+#include "CommandStateTracker.h"
+#include "Graphics/Resources/CommandList.h"
 
 namespace Pu
 {
@@ -70,11 +72,15 @@ namespace Pu
 		_Check_return_ static uint32 GetBarrierCalls(void);
 		/* Gets the amount of shaders currently being used by Plutonium. */
 		_Check_return_ static uint32 GetShaderCalls(void);
+		/* Gets the amount of bind and push constant calls that were skipped because they wouldn't change the bound state. */
+		_Check_return_ static uint32 GetElidedCalls(void);
 		/* Resets all the command counters back to zero. */
 		static void ResetCounters(void);
 
 		/* Starts the recording on the command buffer. */
 		void Begin(void);
+		/* Starts the recording on a secondary command buffer that will be executed within the specified subpass. */
+		void Begin(_In_ const Renderpass &renderPass, _In_ uint32 subpass, _In_ const Framebuffer &framebuffer, _In_opt_ QueryPipelineStatisticFlags statistics = QueryPipelineStatisticFlags::None);
 		/* End the recording on the command buffer. */
 		void End(void);
 		/* Deallocates the command buffer from its parent pool. */
@@ -146,6 +152,10 @@ namespace Pu
 		void NextSubpass(_In_ SubpassContents contents);
 		/* Appends a render pass end command to the command buffer. */
 		void EndRenderPass(void);
+		/* Appends the commands of the secondary command buffer to the command buffer. */
+		void ExecuteCommands(_In_ const CommandBuffer &secondary);
+		/* Appends all the commands stored in the command list to the command buffer. */
+		void Append(_In_ const CommandList &list);
 		/* Appends a debug label to the command buffer (only active on debug). */
 		void AddLabel(_In_ const string &name, _In_ Color color);
 		/* Ends the last added label in the command buffer (only active on debug). */
@@ -184,6 +194,7 @@ namespace Pu
 		CommandPool *parent;
 		LogicalDevice *device;
 		CommandBufferHndl hndl;
+		CommandStateTracker tracker;
 
 		Fence *submitFence;
 		mutable State state;
@@ -24,7 +24,7 @@ namespace Pu
 		_Check_return_ CommandPool& operator =(_In_ CommandPool &&other);
 
 		/* Allocates a new command buffer from this pool. */
-		_Check_return_ CommandBuffer Allocate(void) const;
+		_Check_return_ CommandBuffer Allocate(_In_opt_ CommandBufferLevel level = CommandBufferLevel::Primary) const;
 
 	private:
 		friend class CommandBuffer;
@@ -0,0 +1,105 @@
+#pragma once
+#include "VulkanProcedres.h"
+
+namespace Pu
+{
+	/* Defines the Vulkan commands that are filtered by a command state tracker. */
+	struct CommandDispatchTable
+	{
+		/* The procedure used to bind pipelines. */
+		PFN_vkCmdBindPipeline BindPipeline;
+		/* The procedure used to bind vertex buffers. */
+		PFN_vkCmdBindVertexBuffers BindVertexBuffers;
+		/* The procedure used to bind index buffers. */
+		PFN_vkCmdBindIndexBuffer BindIndexBuffer;
+		/* The procedure used to bind descriptor sets. */
+		PFN_vkCmdBindDescriptorSets BindDescriptorSets;
+		/* The procedure used to update push constants. */
+		PFN_vkCmdPushConstants PushConstants;
+	};
+
+	/*
+	Defines a layer in front of the Vulkan bind and push commands that remembers the state bound to a command buffer.
+	Commands that wouldn't change the bound state are skipped instead of being forwarded to the dispatch table.
+	The tracker is conservative, any state it cannot prove to be equal is always rebound.
+	*/
+	class CommandStateTracker
+	{
+	public:
+		/* Initializes an empty instance of a command state tracker. */
+		CommandStateTracker(void);
+		/* Initializes a new instance of a command state tracker that forwards to the specified procedures. */
+		CommandStateTracker(_In_ const CommandDispatchTable &dispatch);
+		/* Copy constructor. */
+		CommandStateTracker(_In_ const CommandStateTracker&) = default;
+		/* Move constructor. */
+		CommandStateTracker(_In_ CommandStateTracker&&) = default;
+
+		/* Copy assignment. */
+		_Check_return_ CommandStateTracker& operator =(_In_ const CommandStateTracker&) = default;
+		/* Move assignment. */
+		_Check_return_ CommandStateTracker& operator =(_In_ CommandStateTracker&&) = default;
+
+		/* Gets the amount of commands that were forwarded to the dispatch table. */
+		_Check_return_ inline uint32 GetIssuedCount(void) const
+		{
+			return issued;
+		}
+
+		/* Gets the amount of redundant commands that were skipped. */
+		_Check_return_ inline uint32 GetElidedCount(void) const
+		{
+			return elided;
+		}
+
+		/* Resets the issued and elided counters back to zero. */
+		inline void ResetCounters(void)
+		{
+			issued = 0;
+			elided = 0;
+		}
+
+		/* Forgets all bound state, this must be called whenever Vulkan makes the command buffer state undefined. */
+		void Invalidate(void);
+		/* Binds the pipeline to the specified bind point, returns whether the command was issued. */
+		bool BindPipeline(_In_ CommandBufferHndl cmdBuffer, _In_ PipelineBindPoint bindPoint, _In_ PipelineHndl pipeline);
+		/* Binds the vertex buffer to the specified binding, returns whether the command was issued. */
+		bool BindVertexBuffer(_In_ CommandBufferHndl cmdBuffer, _In_ uint32 binding, _In_ BufferHndl buffer, _In_ DeviceSize offset);
+		/* Binds the index buffer, returns whether the command was issued. */
+		bool BindIndexBuffer(_In_ CommandBufferHndl cmdBuffer, _In_ BufferHndl buffer, _In_ DeviceSize offset, _In_ IndexType type);
+		/* Binds the descriptor set to the specified set index, returns whether the command was issued. */
+		bool BindDescriptorSet(_In_ CommandBufferHndl cmdBuffer, _In_ PipelineBindPoint bindPoint, _In_ PipelineLayoutHndl layout, _In_ uint32 set, _In_ DescriptorSetHndl descriptor);
+		/* Updates the push constants in the specified range, returns whether the command was issued. */
+		bool PushConstants(_In_ CommandBufferHndl cmdBuffer, _In_ PipelineLayoutHndl layout, _In_ ShaderStageFlags stage, _In_ uint32 offset, _In_ uint32 size, _In_ const void *values);
+
+	private:
+		/* The amount of pipeline bind points that are tracked, other bind points are always issued. */
+		static constexpr uint32 TrackedBindPoints = 2;
+		/* The amount of vertex buffer bindings that are tracked, higher bindings are always issued. */
+		static constexpr uint32 TrackedVertexBindings = 16;
+		/* The amount of descriptor sets (per bind point) that are tracked, higher sets are always issued. */
+		static constexpr uint32 TrackedDescriptorSets = 8;
+		/* The amount of push constant bytes that are tracked (the minimum supported size). */
+		static constexpr uint32 TrackedPushConstantSize = 128;
+
+		CommandDispatchTable dispatch;
+		uint32 issued, elided;
+
+		PipelineHndl pipelines[TrackedBindPoints];
+		PipelineLayoutHndl setLayouts[TrackedBindPoints];
+		DescriptorSetHndl sets[TrackedBindPoints][TrackedDescriptorSets];
+
+		BufferHndl vertexBuffers[TrackedVertexBindings];
+		DeviceSize vertexOffsets[TrackedVertexBindings];
+		BufferHndl indexBuffer;
+		DeviceSize indexOffset;
+		IndexType indexType;
+
+		PipelineLayoutHndl pushLayout;
+		ShaderStageFlags pushStages[TrackedPushConstantSize];
+		byte pushData[TrackedPushConstantSize];
+
+		bool Elide(void);
+		bool Issue(void);
+	};
+}
\ No newline at end of file
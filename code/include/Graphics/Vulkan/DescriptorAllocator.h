@@ -0,0 +1,113 @@
+#pragma once
+#include <unordered_map>
+#include "VulkanProcedres.h"
+
+namespace Pu
+{
+	/* Defines the Vulkan commands that are used by a descriptor allocator. */
+	struct DescriptorDispatchTable
+	{
+		/* The logical device that owns the descriptor pools. */
+		DeviceHndl Device;
+		/* The procedure used to create descriptor pools. */
+		PFN_vkCreateDescriptorPool CreateDescriptorPool;
+		/* The procedure used to destroy descriptor pools. */
+		PFN_vkDestroyDescriptorPool DestroyDescriptorPool;
+		/* The procedure used to recycle all sets of a descriptor pool. */
+		PFN_vkResetDescriptorPool ResetDescriptorPool;
+		/* The procedure used to allocate descriptor sets. */
+		PFN_vkAllocateDescriptorSets AllocateDescriptorSets;
+		/* The procedure used to free individual descriptor sets. */
+		PFN_vkFreeDescriptorSets FreeDescriptorSets;
+	};
+
+	/*
+	Defines a growable allocator for Vulkan descriptor sets.
+	Descriptor pools are chained whenever the current pool is exhausted, so callers don't have to know their capacity up front.
+	Transient sets are allocated from per frame pools that are recycled as a whole,
+	immutable sets can be cached by the resources they bind.
+	*/
+	class DescriptorAllocator
+	{
+	public:
+		/* Initializes a new instance of a descriptor allocator that creates pools of the specified size for a specific amount of frames. */
+		DescriptorAllocator(_In_ const DescriptorDispatchTable &dispatch, _In_ const vector<DescriptorPoolSize> &sizes, _In_ uint32 setsPerPool, _In_ uint32 frames);
+		DescriptorAllocator(_In_ const DescriptorAllocator&) = delete;
+		/* Move constructor. */
+		DescriptorAllocator(_In_ DescriptorAllocator &&value);
+		/* Destroys all the descriptor pools, this implicitly frees all sets. */
+		~DescriptorAllocator(void)
+		{
+			Destroy();
+		}
+
+		_Check_return_ DescriptorAllocator& operator =(_In_ const DescriptorAllocator&) = delete;
+		/* Move assignment. */
+		_Check_return_ DescriptorAllocator& operator =(_In_ DescriptorAllocator &&other);
+
+		/* Allocates a persistent descriptor set and returns the index of the pool it was allocated from. */
+		_Check_return_ uint32 Allocate(_In_ DescriptorSetLayoutHndl layout, _Out_ DescriptorSetHndl *result);
+		/* Frees a persistent descriptor set that was allocated from the specified pool. */
+		void Free(_In_ uint32 pool, _In_ DescriptorSetHndl set);
+		/* Allocates a descriptor set that is only valid until the current frame is started again. */
+		_Check_return_ DescriptorSetHndl AllocateTransient(_In_ DescriptorSetLayoutHndl layout);
+		/* Gets the cached descriptor set that binds the specified resources, returns whether the set was just allocated and still needs to be written. */
+		_Check_return_ bool AllocateCached(_In_ DescriptorSetLayoutHndl layout, _In_ const vector<uint64> &resources, _Out_ DescriptorSetHndl *result);
+		/* Starts a new frame, this recycles all transient sets that were allocated the last time the frame was used. */
+		void BeginFrame(_In_ uint32 frame);
+		/* Recycles all persistent and cached descriptor sets. */
+		void Reset(void);
+
+		/* Gets the amount of descriptor pools that are used for persistent and cached sets. */
+		_Check_return_ inline uint32 GetPoolCount(void) const
+		{
+			return static_cast<uint32>(pools.size());
+		}
+
+		/* Gets the amount of descriptor pools that are used for transient sets (over all frames). */
+		_Check_return_ uint32 GetTransientPoolCount(void) const;
+
+		/* Gets the amount of descriptor sets that are currently cached. */
+		_Check_return_ inline uint32 GetCachedSetCount(void) const
+		{
+			return static_cast<uint32>(cache.size());
+		}
+
+	private:
+		struct CacheKey
+		{
+			DescriptorSetLayoutHndl Layout;
+			vector<uint64> Resources;
+
+			bool operator ==(const CacheKey &other) const;
+		};
+
+		struct CacheKeyHasher
+		{
+			size_t operator ()(const CacheKey &key) const;
+		};
+
+		struct Frame
+		{
+			vector<DescriptorPoolHndl> Pools;
+			uint32 Active;
+		};
+
+		DescriptorDispatchTable dispatch;
+		vector<DescriptorPoolSize> sizes;
+		uint32 setsPerPool;
+
+		vector<DescriptorPoolHndl> pools;
+		vector<bool> available;
+		vector<uint32> open;
+		vector<Frame> frames;
+		uint32 frame;
+		std::unordered_map<CacheKey, DescriptorSetHndl, CacheKeyHasher> cache;
+
+		DescriptorPoolHndl CreatePool(DescriptorPoolCreateFlags flags);
+		bool TryAllocate(DescriptorPoolHndl pool, DescriptorSetLayoutHndl layout, DescriptorSetHndl *result);
+		void Destroy(void);
+
+		static void ThrowInvalidAlloc(void);
+	};
+}
\ No newline at end of file
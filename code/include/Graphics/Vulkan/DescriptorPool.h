@@ -1,11 +1,18 @@
 #pragma once
 #include "Shaders/Renderpass.h"
+#include "DescriptorAllocator.h"
 
 namespace Pu
 {
 	class DynamicBuffer;
 
-	/* Defines an allocation pool for Vulkan descriptors. */
+	/*
+	Defines an allocation pool for Vulkan descriptors.
+	The maximum set count is only used as the size of the underlying Vulkan pools, new pools are chained if they're exhausted.
+	The uniform buffer memory is chained in the same way, every uniform buffer has space for the maximum set count.
+	Offsets returned by the pool span all chained uniform buffers, so the stage event receives contiguous memory.
+	Sets without uniform blocks can also be cached by the resources they bind, these are only released when the pool is reset.
+	*/
 	class DescriptorPool
 	{
 	public:
@@ -52,18 +59,29 @@ namespace Pu
 		{
 			uint64 Id;
 			DeviceSize Offset;
-			vector<DescriptorSetHndl> spaces;
+			uint32 Max;
+			vector<uint32> spaces;
 
 			SetInfo(uint32 subpass, uint32 set, uint32 max, DeviceSize offset);
 
 			inline uint32 GetMaxSets(void) const
 			{
-				return static_cast<uint32>(spaces.size());
+				return Max;
 			}
+
+			void AddSpaces(uint32 page);
+		};
+
+		struct Allocation
+		{
+			uint32 Pool;
+			uint32 Info;
+			uint32 Space;
 		};
 
-		DescriptorPoolHndl hndl;
-		DynamicBuffer *buffer;
+		DescriptorAllocator *allocator;
+		vector<DynamicBuffer*> buffers;
+		vector<byte> staging;
 		LogicalDevice *device;
 		std::mutex lock;
 
@@ -75,13 +93,18 @@ namespace Pu
 
 		uint32 maxSets;
 		DeviceSize stride;
+		DeviceSize pageSize;
 		bool firstUpdate;
 		vector<DescriptorPoolSize> sizes;
 		vector<SetInfo> sets;
+		std::unordered_map<DescriptorSetHndl, Allocation> allocations;
 
 		void AddSetInternal(uint32 subpass, uint32 set, uint32 max, const DescriptorSetLayout &layout);
 		DeviceSize Alloc(uint32 subpass, const DescriptorSetLayout &layout, DescriptorSetHndl *result);
+		bool AllocCached(uint32 subpass, const DescriptorSetLayout &layout, const vector<uint64> &resources, DescriptorSetHndl *result);
 		void Free(DescriptorSetHndl set);
+		DynamicBuffer& GetBuffer(DeviceSize &offset) const;
+		void AddPage(void);
 		void Create(void);
 		void Destroy(void);
 
@@ -10,6 +10,8 @@ namespace Pu
 	public:
 		/* Initializes a new instance of a descriptor set from a specific pool. */
 		DescriptorSet(_In_ DescriptorPool &pool, _In_ uint32 subpass, _In_ const DescriptorSetLayout &setLayout);
+		/* Initializes a new instance of a descriptor set that is shared by all sets that bind the same resources (the resources must outlive the pool or its next reset). */
+		DescriptorSet(_In_ DescriptorPool &pool, _In_ uint32 subpass, _In_ const DescriptorSetLayout &setLayout, _In_ const vector<uint64> &resources);
 		DescriptorSet(_In_ const DescriptorSet&) = delete;
 		/* Move constructor. */
 		DescriptorSet(_In_ DescriptorSet &&value);
@@ -36,6 +38,12 @@ namespace Pu
 		/* Free's the descriptor set from its parent pool. */
 		void Free(void);
 
+		/* Gets whether the descriptors still have to be written, this is only false for cached sets that were already in use. */
+		_Check_return_ inline bool NeedsWrite(void) const
+		{
+			return needsWrite;
+		}
+
 	protected:
 		/* Copies the block data to the CPU staging buffer. */
 		virtual void Stage(_In_ byte* /*destination*/) {};
@@ -47,6 +55,8 @@ namespace Pu
 		uint32 set;
 		DeviceSize baseOffset;
 		bool subscribe;
+		bool cached;
+		bool needsWrite;
 
 		void StageInternal(DescriptorPool&, byte *destination);
 		void Destroy(void);
@@ -22,6 +22,9 @@ namespace Pu
 		/* Move assignment. */
 		_Check_return_ DescriptorSetBase& operator =(_In_ DescriptorSetBase &&other) = default;
 
+		/* Adds the handles of the specified texture to the resources of a cached descriptor set. */
+		static void AddResource(_In_ vector<uint64> &resources, _In_ const Texture &texture);
+
 	protected:
 		/* Defines the parent descriptor pool. */
 		DescriptorPool *Pool;
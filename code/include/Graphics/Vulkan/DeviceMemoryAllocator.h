@@ -0,0 +1,119 @@
+#pragma once
+#include <mutex>
+#include "VulkanProcedres.h"
+#include "Core/Collections/TLSFAllocator.h"
+
+namespace Pu
+{
+	class LogicalDevice;
+
+	/* Defines a range of device memory that is owned by a single resource. */
+	struct DeviceAllocation
+	{
+		/* The device memory object that contains the range. */
+		DeviceMemoryHndl Memory;
+		/* The offset (in bytes) of the range within the memory object. */
+		DeviceSize Offset;
+		/* The size (in bytes) of the range. */
+		DeviceSize Size;
+		/* The host address of the range or nullptr if the memory is not host visible. */
+		byte *HostMemory;
+		/* The index of the memory type of the memory object. */
+		uint32 MemoryType;
+		/* The index of the block that contains the range (or InvalidHandle for dedicated allocations). */
+		uint32 Block;
+		/* The handle of the range within the block. */
+		uint32 Range;
+
+		/* Initializes an empty instance of a device allocation. */
+		DeviceAllocation(void)
+			: Memory(nullptr), Offset(0), Size(0), HostMemory(nullptr),
+			MemoryType(0), Block(TLSFAllocator::InvalidHandle), Range(TLSFAllocator::InvalidHandle)
+		{}
+
+		/* Gets whether the allocation has its own memory object. */
+		_Check_return_ inline bool IsDedicated(void) const
+		{
+			return Block == TLSFAllocator::InvalidHandle;
+		}
+	};
+
+	/* Defines the usage statistics of a device memory allocator. */
+	struct DeviceMemoryStatistics
+	{
+		/* The amount of shared memory blocks. */
+		uint32 Blocks;
+		/* The amount of resources placed in the shared blocks. */
+		uint32 Allocations;
+		/* The amount of resources that have their own memory object. */
+		uint32 DedicatedAllocations;
+		/* The amount of separate free ranges within the blocks. */
+		uint32 FreeRanges;
+		/* The total size (in bytes) of the blocks. */
+		DeviceSize Reserved;
+		/* The amount of bytes used by resources within the blocks. */
+		DeviceSize Used;
+		/* The size (in bytes) of the largest free range within a block. */
+		DeviceSize LargestFreeRange;
+		/* The amount of free space that is not part of the largest free range of its block [0, 1]. */
+		float Fragmentation;
+	};
+
+	/*
+	Defines an allocator that places resources in large device memory blocks, instead of giving every resource its own memory object.
+	Every memory type has its own blocks, buffers and images are never placed in the same block so the buffer image granularity can be ignored.
+	Host visible blocks are persistently mapped, because a memory object can't be mapped more than once.
+	*/
+	class DeviceMemoryAllocator
+	{
+	public:
+		/* Initializes a new instance of a device memory allocator for the specified device. */
+		DeviceMemoryAllocator(_In_ LogicalDevice &device);
+		DeviceMemoryAllocator(_In_ const DeviceMemoryAllocator&) = delete;
+		DeviceMemoryAllocator(_In_ DeviceMemoryAllocator&&) = delete;
+		/* Releases all device memory blocks. */
+		~DeviceMemoryAllocator(void)
+		{
+			Destroy();
+		}
+
+		_Check_return_ DeviceMemoryAllocator& operator =(_In_ const DeviceMemoryAllocator&) = delete;
+		_Check_return_ DeviceMemoryAllocator& operator =(_In_ DeviceMemoryAllocator&&) = delete;
+
+		/* Allocates memory for a resource with the specified requirements, linear should be set for buffers and linear images. */
+		_Check_return_ DeviceAllocation Allocate(_In_ const MemoryRequirements &requirements, _In_ uint32 memoryType, _In_ bool linear, _In_ bool dedicated);
+		/* Releases the specified allocation. */
+		void Free(_In_ const DeviceAllocation &allocation);
+		/* Gets the range that needs to be flushed for the specified part of the allocation. */
+		_Check_return_ MappedMemoryRange GetFlushRange(_In_ const DeviceAllocation &allocation, _In_ DeviceSize offset, _In_ DeviceSize size) const;
+		/* Gets the current usage statistics of the allocator. */
+		_Check_return_ DeviceMemoryStatistics GetStatistics(void) const;
+
+	private:
+		friend class LogicalDevice;
+
+		/* Defines a single device memory object that is shared by multiple resources. */
+		struct Block
+		{
+			DeviceMemoryHndl Memory;
+			byte *HostMemory;
+			TLSFAllocator Ranges;
+			bool Linear;
+
+			Block(DeviceMemoryHndl memory, byte *hostMemory, bool linear);
+		};
+
+		LogicalDevice *device;
+		DeviceSize atomSize;
+		mutable std::mutex lock;
+
+		vector<Block> blocks[MaxMemoryTypes];
+		uint32 dedicatedAllocations;
+
+		bool IsHostVisible(uint32 memoryType) const;
+		bool IsHostCoherent(uint32 memoryType) const;
+		DeviceMemoryHndl AllocateMemory(DeviceSize size, uint32 memoryType, byte *&hostMemory);
+		void FreeMemory(DeviceMemoryHndl memory);
+		void Destroy(void);
+	};
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "LogicalDevice.h"
+#include "DeviceMemoryAllocator.h"
 #include "Content/Asset.h"
 
 namespace Pu
@@ -135,7 +136,7 @@ namespace Pu
 
 		LogicalDevice *parent;
 		ImageHndl imageHndl;
-		DeviceMemoryHndl memoryHndl;
+		DeviceAllocation memory;
 
 		ImageType type;
 		Format format;
@@ -7,6 +7,7 @@
 namespace Pu
 {
 	class PhysicalDevice;
+	class DeviceMemoryAllocator;
 
 	/* Defines a Vulkan logical device. */
 	class LogicalDevice
@@ -79,6 +80,12 @@ namespace Pu
 			VK_VALIDATE(vkDeviceWaitIdle(hndl), PFN_vkDeviceWaitIdle);
 		}
 
+		/* Gets the allocator used for the device memory of buffers and images. */
+		_Check_return_ inline DeviceMemoryAllocator& GetMemoryAllocator(void)
+		{
+			return *allocator;
+		}
+
 		/* Gets whether a specific device extension is enabled. */
 		_Check_return_ inline bool IsExtensionEnabled(_In_ const char *extension)
 		{
@@ -114,9 +121,11 @@ namespace Pu
 		friend class PipelineCache;
 		friend class Pipeline;
 		friend class RenderDoc;
+		friend class DeviceMemoryAllocator;
 
 		PhysicalDevice *parent;
 		DeviceHndl hndl;
+		DeviceMemoryAllocator *allocator;
 		std::map<uint32, vector<Queue>> queues;
 		uint32 graphicsQueueFamily, computeQueueFamily, transferQueueFamily;
 		vector<const char*> enabledExtensions;
@@ -157,6 +166,7 @@ namespace Pu
 		PFN_vkCmdPushConstants vkCmdPushConstants;
 		PFN_vkCmdSetLineWidth vkCmdSetLineWidth;
 		PFN_vkCmdNextSubpass vkCmdNextSubpass;
+		PFN_vkCmdExecuteCommands vkCmdExecuteCommands;
 		PFN_vkCmdBeginQuery vkCmdBeginQuery;
 		PFN_vkCmdEndQuery vkCmdEndQuery;
 		PFN_vkCmdBlitImage vkCmdBlitImage;
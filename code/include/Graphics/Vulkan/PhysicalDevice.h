@@ -178,6 +178,7 @@ namespace Pu
 	private:
 		friend class VulkanInstance;
 		friend class LogicalDevice;
+		friend class DeviceMemoryAllocator;
 		friend class Surface;
 		friend class Buffer;
 		friend class Image;
@@ -26,6 +26,12 @@ namespace Pu
 			: MemberOffset(offset)
 		{}
 
+		/* Gets whether no decorations are present. */
+		_Check_return_ inline bool IsEmpty(void) const
+		{
+			return Flags.empty() && Numbers.empty();
+		}
+
 		/* Gets whether the specified SPIR-V decoration is present. */
 		inline bool Contains(_In_ spv::Decoration key) const
 		{
@@ -33,6 +33,12 @@ namespace Pu
 			return std::make_tuple(major, minor);
 		}
 
+		/* Gets the upper bound of all the ID's used in the module. */
+		_Check_return_ inline size_t GetBound(void) const
+		{
+			return bound;
+		}
+
 		/* Checks if another word can be read from the stream. */
 		_Check_return_ inline bool CanReadWord(void) const
 		{
@@ -61,8 +61,6 @@ namespace Pu
 		friend class Renderpass;
 		friend class Pipeline;
 
-		using DecoratePair = std::pair<spv::Id, spv::Word>;
-
 		class LoadTask
 			: public Task
 		{
@@ -87,18 +85,23 @@ namespace Pu
 		vector<FieldInfo> fields;
 		vector<SpecializationConstant> specializationConstants;
 
-		std::map<spv::Id, string> names;
-		std::map<spv::Id, vector<string>> memberNames;
-		std::map<spv::Id, spv::Id> typedefs;
-		std::map<spv::Id, FieldType> types;
-		std::map<spv::Id, vector<spv::Id>> structs;
-		std::map<DecoratePair, Decoration> decorations;
-		std::map<spv::Id, double> constants;
+		vector<string> names;
+		vector<vector<string>> memberNames;
+		vector<spv::Id> typedefs;
+		vector<FieldType> types;
+		vector<vector<spv::Id>> structs;
+		vector<Decoration> decorations;
+		vector<vector<Decoration>> memberDecorations;
+		vector<double> constants;
 		vector<std::tuple<spv::Id, spv::Id, spv::StorageClass>> variables;
 
 		void Load(const wstring &path, bool viaLoader);
 		void Create(SPIRVReader &reader);
-		void SetFieldInfo(const wchar_t *name);
+		void Reflect(SPIRVReader &reader);
+		uint32 SetFieldInfo(const wchar_t *name);
+		void CheckInputAttachments(const wchar_t *name, uint32 inputAttachments) const;
+		bool LoadReflection(const wstring &path, uint64 key, const wchar_t *name);
+		void StoreReflection(const wstring &path, uint64 key, uint32 inputAttachments) const;
 		void HandleVariable(spv::Id id, spv::Id typeId, spv::StorageClass storage);
 		void HandleModule(SPIRVReader &reader, spv::Op opCode, size_t wordCnt);
 		void HandleName(SPIRVReader &reader);
@@ -119,6 +119,7 @@ namespace Pu
 	EXT_INSTANCE_PROC(vkCmdPushConstants);
 	EXT_INSTANCE_PROC(vkCmdSetLineWidth);
 	EXT_INSTANCE_PROC(vkCmdNextSubpass);
+	EXT_INSTANCE_PROC(vkCmdExecuteCommands);
 	EXT_INSTANCE_PROC(vkQueueWaitIdle);
 	EXT_INSTANCE_PROC(vkCmdBeginQuery);
 	EXT_INSTANCE_PROC(vkCmdEndQuery);
@@ -1063,9 +1063,9 @@ namespace Pu
 		{}
 
 		/* Initializes a new instance of the command buffer allocation info object. */
-		CommandBufferAllocateInfo(_In_ CommandPoolHndl commandPool, _In_ uint32 count)
+		CommandBufferAllocateInfo(_In_ CommandPoolHndl commandPool, _In_ uint32 count, _In_opt_ CommandBufferLevel level = CommandBufferLevel::Primary)
 			: Type(StructureType::CommandBufferAllocateInfo), Next(nullptr),
-			CommandPool(commandPool), Level(CommandBufferLevel::Primary), CommandBufferCount(count)
+			CommandPool(commandPool), Level(level), CommandBufferCount(count)
 		{}
 	};
 
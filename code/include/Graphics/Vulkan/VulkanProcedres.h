@@ -108,6 +108,7 @@ namespace Pu
 	using PFN_vkCmdPushConstants = void(VKAPI_PTR)(_In_ CommandBufferHndl commandBuffer, _In_ PipelineLayoutHndl layout, _In_ ShaderStageFlags stageFlags, _In_ uint32 offset, _In_ uint32 size, _In_ const void *values);
 	using PFN_vkCmdSetLineWidth = void(VKAPI_PTR)(_In_ CommandBufferHndl commandBuffer, _In_ float lineWidth);
 	using PFN_vkCmdNextSubpass = void(VKAPI_PTR)(_In_ CommandBufferHndl commandBuffer, _In_ SubpassContents contents);
+	using PFN_vkCmdExecuteCommands = void(VKAPI_PTR)(_In_ CommandBufferHndl commandBuffer, _In_ uint32 commandBufferCount, _In_ const CommandBufferHndl *commandBuffers);
 	using PFN_vkQueueWaitIdle = _Check_return_ VkApiResult(VKAPI_PTR)(_In_ QueueHndl queue);
 	using PFN_vkCmdBeginQuery = void(VKAPI_PTR)(_In_ CommandBufferHndl commandBuffer, _In_ QueryPoolHndl queryPool, _In_ uint32 query, _In_ QueryControlFlags flags);
 	using PFN_vkCmdEndQuery = void(VKAPI_PTR)(_In_ CommandBufferHndl commandBuffer, _In_ QueryPoolHndl queryPool, _In_ uint32 query);
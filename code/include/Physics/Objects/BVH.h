@@ -7,11 +7,18 @@
 namespace Pu
 {
 	class DebugRenderer;
+	class BinaryWriter;
+	class BinaryReader;
 
 	/* Defines a dynamic BVH used for physics. */
 	class BVH
 	{
 	public:
+		/* Defines a function that is called for every object found by a query, returning false stops the query. */
+		using Visitor_t = _Check_return_ bool(*)(_In_ PhysicsHandle hobj, _In_ void *userParam);
+		/* Defines a function that returns the distance from the query point to the object (negative if the object should be skipped). */
+		using Distance_t = _Check_return_ float(*)(_In_ PhysicsHandle hobj, _In_ const void *userParam);
+
 		/* Initializes an empty instance of a BVH. */
 		BVH(void);
 		/* Copy constructor. */
@@ -40,11 +47,19 @@ namespace Pu
 		void Boxcast(_In_ const AABB &box, _Inout_ vector<PhysicsHandle> &result) const;
 		/* Gets the objects that intersect with the specified frustum. */
 		void Frustumcast(_In_ const Frustum &frustum, _Inout_ vector<PhysicsHandle> &result) const;
+		/* Calls the visitor for every object that overlaps with the specified bounding box, without allocating any memory. */
+		void Boxcast(_In_ const AABB &box, _In_ Visitor_t visitor, _In_ void *userParam) const;
+		/* Gets the (at most) k objects closest to the specified point, sorted from near to far, without allocating any memory; returns the amount of objects found. */
+		_Check_return_ size_t Nearest(_In_ Vector3 p, _In_ float maxDistance, _In_ Distance_t distance, _In_ const void *userParam, _Out_writes_to_(k, return) PhysicsHandle *result, _Out_writes_to_(k, return) float *distances, _In_ size_t k) const;
 
 		/* Gets the cost of the internal branches of the BVH. */
 		_Check_return_ float GetTreeCost(void) const;
 		/* Gets the relative efficiency of the tree. */
 		_Check_return_ float GetEfficiency(void) const;
+		/* Writes the entire tree to the specified writer. */
+		void Snapshot(_Inout_ BinaryWriter &writer) const;
+		/* Replaces this tree with the one stored in the specified reader. */
+		void Restore(_Inout_ BinaryReader &reader);
 
 #ifdef _DEBUG
 		/* 
@@ -56,6 +71,12 @@ namespace Pu
 		void Visualize(_In_ DebugRenderer &renderer) const;
 #endif
 
+		/* Gets a value that changes every time an object is added to or removed from the BVH. */
+		_Check_return_ inline uint32 GetVersion(void) const
+		{
+			return version;
+		}
+
 		/* Gets the amount of leaf nodes in this BVH. */
 		_Check_return_ inline uint16 GetLeafCount(void) const
 		{
@@ -76,6 +97,7 @@ namespace Pu
 		uint16 count;
 		uint16 capacity;
 		uint16 root;
+		uint32 version;
 
 #ifdef _DEBUG
 		mutable uint32 displayDepth;
@@ -84,6 +106,7 @@ namespace Pu
 		void Refit(uint16 start);
 		uint16 Balance(uint16 idx);
 		uint16 BestSibling(uint16 node) const;
+		void AddLeaves(uint16 idx, vector<PhysicsHandle> &result) const;
 
 		uint16 AllocBranch(void);
 		uint16 AllocLeaf(PhysicsHandle hobj, const AABB &box);
@@ -31,21 +31,25 @@ namespace Pu
 		PhysicsHandle Properties;
 		/* Specifies the collider used by the object. */
 		Collider Collider;
+		/* Specifies whether fast moving (kinematic) objects should use continuous collision detection to prevent tunneling. */
+		bool ContinuousCollision;
+		/* Specifies the layer bits of the object, used to filter spatial queries. */
+		uint32 Layer;
 
 		/* Initializes an empty instance of a physical object. */
 		PhysicalObject(void)
-			: Properties(PhysicsNullHandle), Scale(1.0f)
+			: Properties(PhysicsNullHandle), Scale(1.0f), ContinuousCollision(false), Layer(1)
 		{}
 
 		/* Initializes a new instance of a physical object without a collider. */
 		PhysicalObject(_In_ Vector3 pos, _In_ Quaternion orien)
-			: P(pos), Theta(orien), Scale(1.0f), Properties(PhysicsNullHandle)
+			: P(pos), Theta(orien), Scale(1.0f), Properties(PhysicsNullHandle), ContinuousCollision(false), Layer(1)
 		{}
 
 		/* Initializes a new instance of a physical object. */
 		PhysicalObject(_In_ Vector3 pos, _In_ Quaternion orien, const Pu::Collider &collider)
 			: P(pos), Theta(orien), Scale(1.0f), Properties(PhysicsNullHandle),
-			Collider(collider)
+			Collider(collider), ContinuousCollision(false), Layer(1)
 		{}
 	};
 }
\ No newline at end of file
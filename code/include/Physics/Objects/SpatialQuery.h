@@ -0,0 +1,95 @@
+#pragma once
+#include "PhysicsHandle.h"
+#include "Core/Math/Shapes/Sphere.h"
+#include "Core/Math/Shapes/OBB.h"
+
+namespace Pu
+{
+	/* Defines the filter that objects need to pass in order to be returned by a spatial query. */
+	struct QueryFilter
+	{
+	public:
+		/* Specifies the layers that the query should include. */
+		uint32 Mask;
+		/* Specifies an object that should be excluded from the query (usually the object performing the query). */
+		PhysicsHandle Ignore;
+
+		/* Initializes a new instance of a filter that accepts every object. */
+		QueryFilter(void)
+			: Mask(~0u), Ignore(PhysicsNullHandle)
+		{}
+
+		/* Initializes a new instance of a query filter. */
+		QueryFilter(_In_ uint32 mask, _In_opt_ PhysicsHandle ignore = PhysicsNullHandle)
+			: Mask(mask), Ignore(ignore)
+		{}
+	};
+
+	/* Defines the types of spatial queries. */
+	enum class QueryType : uint8
+	{
+		/* Finds all objects that overlap with a sphere. */
+		OverlapSphere,
+		/* Finds all objects that overlap with an oriented bounding box. */
+		OverlapOBB,
+		/* Finds the first object hit by a sphere moving along a path. */
+		SweepSphere,
+		/* Finds the objects closest to a point. */
+		Nearest
+	};
+
+	/*
+	Defines a single spatial query that can be executed by the physical world.
+	The result buffers are owned by the caller, so executing a query never allocates memory.
+	*/
+	struct SpatialQuery
+	{
+	public:
+		/* Specifies the type of query. */
+		QueryType Type;
+		/* Specifies the filter applied to the objects found. */
+		QueryFilter Filter;
+		/* Specifies the sphere used by sphere queries (only the center is used for nearest queries). */
+		Sphere QuerySphere;
+		/* Specifies the oriented bounding box used by box queries. */
+		OBB QueryBox;
+		/* Specifies the path of the sphere for sweep queries. */
+		Vector3 Displacement;
+		/* Specifies the maximum search distance for nearest queries. */
+		float MaxDistance;
+		/* Specifies the buffer that receives the objects found. */
+		PhysicsHandle *Result;
+		/* Specifies the buffer that receives the distance to the objects found (nearest queries only). */
+		float *Distances;
+		/* Specifies the amount of elements that fit in the result buffers. */
+		size_t Capacity;
+		/* Receives the amount of objects written to the result buffers. */
+		size_t Count;
+		/* Receives the fraction of the displacement at which the first object was hit (sweep queries only). */
+		float Time;
+
+		/* Initializes a new instance of a sphere overlap query. */
+		SpatialQuery(_In_ Sphere sphere, _In_ const QueryFilter &filter, _Out_writes_to_(capacity, Count) PhysicsHandle *result, _In_ size_t capacity)
+			: Type(QueryType::OverlapSphere), Filter(filter), QuerySphere(sphere), MaxDistance(0.0f),
+			Result(result), Distances(nullptr), Capacity(capacity), Count(0), Time(0.0f)
+		{}
+
+		/* Initializes a new instance of an oriented bounding box overlap query. */
+		SpatialQuery(_In_ const OBB &obb, _In_ const QueryFilter &filter, _Out_writes_to_(capacity, Count) PhysicsHandle *result, _In_ size_t capacity)
+			: Type(QueryType::OverlapOBB), Filter(filter), QueryBox(obb), MaxDistance(0.0f),
+			Result(result), Distances(nullptr), Capacity(capacity), Count(0), Time(0.0f)
+		{}
+
+		/* Initializes a new instance of a sphere sweep query (the result buffer only needs space for a single object). */
+		SpatialQuery(_In_ Sphere sphere, _In_ Vector3 displacement, _In_ const QueryFilter &filter, _Out_ PhysicsHandle *result)
+			: Type(QueryType::SweepSphere), Filter(filter), QuerySphere(sphere), Displacement(displacement), MaxDistance(0.0f),
+			Result(result), Distances(nullptr), Capacity(1), Count(0), Time(0.0f)
+		{}
+
+		/* Initializes a new instance of a k-nearest query (k is the capacity of the result buffers). */
+		SpatialQuery(_In_ Vector3 p, _In_ float maxDistance, _In_ const QueryFilter &filter, _Out_writes_to_(k, Count) PhysicsHandle *result, _Out_writes_to_(k, Count) float *distances, _In_ size_t k)
+			: Type(QueryType::Nearest), Filter(filter), QuerySphere(p, 0.0f), MaxDistance(maxDistance),
+			Result(result), Distances(distances), Capacity(k), Count(0), Time(0.0f)
+		{}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+#include "Core/Math/Constants.h"
+
+namespace Pu
+{
+	/* Defines the ways two material coefficients can be combined into a single contact coefficient. */
+	enum class CombineMode : uint8
+	{
+		/* Uses the average of both coefficients. */
+		Average,
+		/* Uses the smallest of both coefficients. */
+		Minimum,
+		/* Uses the largest of both coefficients. */
+		Maximum,
+		/* Uses the product of both coefficients. */
+		Multiply,
+		/* Uses the square root of the product of both coefficients. */
+		GeometricMean
+	};
+}
\ No newline at end of file
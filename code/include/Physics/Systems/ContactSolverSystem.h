@@ -1,8 +1,7 @@
 #pragma once
-#include <map>
 #include "Physics/Objects/PhysicsHandle.h"
-#include "Physics/Properties/MechanicalProperties.h"
 #include "Core/Math/Matrix3.h"
+#include "Core/Collections/Vector.h"
 
 #ifdef _DEBUG
 #include "Core/Time.h"
@@ -30,9 +29,9 @@ namespace Pu
 		_Check_return_ ContactSolverSystem& operator =(_In_ const ContactSolverSystem &other) = delete;
 		_Check_return_ ContactSolverSystem& operator =(_In_ ContactSolverSystem &&other) = delete;
 
-		/* Adds a single item to the solver system, returns the index. */
-		void AddItem(_In_ PhysicsHandle handle, _In_ const Matrix3 &iMoI, _In_ float imass, _In_ const MechanicalProperties &props);
-		/* Removes the item at the specified index. */
+		/* Adds a single item to the solver system, the parameters are stored at the lookup id of the public handle. */
+		void AddItem(_In_ PhysicsHandle handle, _In_ const Matrix3 &iMoI, _In_ float imass, _In_ PhysicsHandle material);
+		/* Removes the item with the specified public handle. */
 		void RemoveItem(_In_ PhysicsHandle handle);
 		/* Solves all the collision events currently stored in the system and adds the impulses to the movement system. */
 		void SolveConstriants(_In_ ofloat dt);
@@ -43,17 +42,34 @@ namespace Pu
 #endif
 
 	private:
+		/* Defines a range of contacts (of one or more islands) that is solved by a single task. */
+		struct SolverJob
+		{
+			/* The index of the first contact in the island contact list. */
+			uint32 First;
+			/* The amount of contacts in the job. */
+			uint32 Count;
+			/* The first (AVX aligned) index in the solver buffers. */
+			uint32 Slot;
+		};
+
 		PhysicalWorld *world;
-		size_t capacity;
+		size_t capacity, lanes;
+		vector<SolverJob> jobs;
 
-		std::map<PhysicsHandle, Matrix3> imoi;
-		std::map<PhysicsHandle, float> imass;
-		std::map<PhysicsHandle, MechanicalProperties> coefficients;
+		vector<Matrix3> imoi;
+		vector<float> imass;
+		vector<int32> materials;
 
-		ofloat *cor1;
-		ofloat *cor2;
-		ofloat *cof1;
-		ofloat *cof2;
+		int256 *pairs;
+		ofloat *nx;
+		ofloat *ny;
+		ofloat *nz;
+		ofloat *cx;
+		ofloat *cy;
+		ofloat *cz;
+		ofloat *sd;
+		ofloat *em;
 		ofloat *px1;
 		ofloat *py1;
 		ofloat *pz1;
@@ -112,9 +128,10 @@ namespace Pu
 		mutable vector<TimedForce> appliedForces;
 #endif
 
+		void CreateJobs(void);
 		void EnsureBufferSize(void);
-		void FillBuffers(void);
-		void VectorSolve(ofloat dt);
+		void FillBuffers(const SolverJob &job);
+		void VectorSolve(ofloat dt, const SolverJob &job);
 		void ApplyImpulses(void);
 		void Destroy(void);
 	};
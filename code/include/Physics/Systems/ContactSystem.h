@@ -5,6 +5,7 @@
 #include "Core/Math/Shapes/AABB.h"
 #include "Core/Collections/simd_vector.h"
 #include "Physics/Objects/PhysicsHandle.h"
+#include "Physics/Objects/SpatialQuery.h"
 #include "Physics/Properties/CollisionShapes.h"
 
 #ifdef _DEBUG
@@ -15,6 +16,28 @@ namespace Pu
 {
 	class PhysicalWorld;
 	class DebugRenderer;
+	class BinaryWriter;
+	class BinaryReader;
+	class HeightMap;
+
+	/* Defines a world space copy of a collider, used to test spatial queries without access to the world. */
+	struct QueryCollider
+	{
+		/* Specifies the object that owns the collider. */
+		PhysicsHandle Handle;
+		/* Specifies the type of collider. */
+		CollisionShapes Type;
+		/* Specifies the broadphase, used for colliders without a narrow phase. */
+		AABB Bounds;
+		/* Specifies the world space collider of sphere colliders. */
+		Sphere Ball;
+		/* Specifies the world space collider of OBB colliders. */
+		OBB Box;
+		/* Specifies the height map of height map colliders (this references the world, so it's only valid while holding the world lock). */
+		const HeightMap *Terrain;
+		/* Specifies the world space offset of the height map. */
+		Vector3 Offset;
+	};
 
 	/* Defines a system used to detect collisions. */
 	class ContactSystem
@@ -65,17 +88,33 @@ namespace Pu
 		_Check_return_ static uint32 GetNarrowPhaseChecks(void);
 		/* Gets the amount of collisions registered since the last reset call. */
 		_Check_return_ static uint32 GetCollisionsCount(void);
+		/* Gets the amount of continuous collision sweeps performed since the last reset call. */
+		_Check_return_ static uint32 GetCCDSweeps(void);
 		/* Resets the profiling counters. */
 		static void ResetCounters(void);
 
 		/* Adds a new collider to the constraint system. */
-		void AddItem(_In_ PhysicsHandle handle, _In_ const AABB &bb, _In_ CollisionShapes type, _In_ const float *collider);
+		void AddItem(_In_ PhysicsHandle handle, _In_ const AABB &bb, _In_ CollisionShapes type, _In_ const float *collider, _In_ bool ccd, _In_ uint32 layer);
 		/* Removes the specified item from the constraint system. */
 		void RemoveItem(_In_ PhysicsHandle handle);
-		/* Checks whether any of the kinematic objects have collided with anything in the scene. */
-		void Check(void);
+		/* Checks whether any of the kinematic objects have collided with anything in the scene (or will collide during this step if they use CCD). */
+		void Check(_In_ float dt);
+		/* Gets whether the specified object passes the specified query filter. */
+		_Check_return_ bool Passes(_In_ PhysicsHandle hobj, _In_ const QueryFilter &filter) const;
+		/* Gets a world space copy of the collider of the specified object. */
+		_Check_return_ QueryCollider GetCollider(_In_ PhysicsHandle hobj) const;
+		/* Gets whether the specified collider overlaps with the specified (world space) sphere. */
+		_Check_return_ static bool Overlaps(_In_ const QueryCollider &collider, _In_ Sphere sphere);
+		/* Gets whether the specified collider overlaps with the specified (world space) oriented bounding box. */
+		_Check_return_ static bool Overlaps(_In_ const QueryCollider &collider, _In_ const OBB &obb);
+		/* Gets the distance from the specified point to the specified collider. */
+		_Check_return_ static float GetDistance(_In_ const QueryCollider &collider, _In_ Vector3 p);
 		/* Calls the OnTriggerHit event for all trigger hit events. */
 		void ProcessTriggers(void);
+		/* Writes the cached broadphase to the specified writer. */
+		void Snapshot(_Inout_ BinaryWriter &writer) const;
+		/* Restores the cached broadphase from the specified reader. */
+		void Restore(_Inout_ BinaryReader &reader);
 
 #ifdef _DEBUG
 		/* Visualizes the colliders in the world. */
@@ -87,30 +126,54 @@ namespace Pu
 	private:
 		using CollisionChecker_t = void(ContactSystem::*)(PhysicsHandle hfirst, PhysicsHandle hsecond);
 
+		struct CCDSweep
+		{
+			PhysicsHandle Handle;
+			uint16 Index;
+			uint32 Steps;
+			uint32 Remaining;
+			Vector3 Step;
+			uint32 FirstHit;
+			uint32 HitCount;
+		};
+
 		std::map<uint16, CollisionChecker_t> checkers;
 		PhysicalWorld *world;
-		SAT sat;
 
 		vector<AABB> rawBroadPhase;
+		vector<bool> ccd;
+		vector<PhysicsHandle> ccdCandidates;
+		vector<uint32> contactCounts;
+		vector<CCDSweep> sweeps;
+		vector<PhysicsHandle> sweepHits;
 		std::map<PhysicsHandle, std::pair<CollisionShapes, float*>> rawNarrowPhase;
+		vector<uint32> layers;
 
-		std::map<PhysicsHandle, AABB> cachedBroadPhase;
-		vector<size_t> readdCache;
+		vector<PhysicsHandle> cachedHandles;
+		vector<AABB> cachedBroadPhase;
 		vector<PhysicsHandle> broadPhaseCache;
 		vector<PhysicsHandlePair> hitTriggers;
+		vector<PhysicsHandlePair> heightmapQueries;
+		vector<PhysicsHandlePair> boxQueries;
+		vector<Vector3> boxContacts;
 
 #ifdef _DEBUG
 		mutable bool visualizeContacts;
 		mutable vector<std::pair<pu_clock::time_point, Vector3>> contacts;
 #endif
 
+		_Check_return_ size_t IndexOf(PhysicsHandle hobj) const;
+		void Sweep(float dt);
+		void CountContacts(size_t first);
 		void TestGeneric(PhysicsHandle hfirst, PhysicsHandle hsecond);
 		void TestSphereSphere(PhysicsHandle hfirst, PhysicsHandle hsecond);
 		void TestAABBSphere(PhysicsHandle haabb, PhysicsHandle hsphere);
-		void TestHeightmapSphere(PhysicsHandle hmap, PhysicsHandle hsphere);
+		void QueueHeightmapSphere(PhysicsHandle hmap, PhysicsHandle hsphere);
+		void TestHeightmapSpheres(void);
 		void TestSphereOBB(PhysicsHandle hsphere, PhysicsHandle hobb);
-		void TestAABBOBB(PhysicsHandle haabb, PhysicsHandle hobb);
-		void TestOBBOBB(PhysicsHandle hfirst, PhysicsHandle hsecond);
+		void QueueBoxes(PhysicsHandle hfirst, PhysicsHandle hobb);
+		void TestBoxes(void);
+		void ProcessBatches(void);
 		void AddManifold(PhysicsHandle hfirst, PhysicsHandle hsecond, Vector3 pos, Vector3 normal, float depth, float mul);
 		void SetGenericCheckers(void);
 		void Destroy(void);
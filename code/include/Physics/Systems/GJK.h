@@ -1,9 +1,23 @@
 #pragma once
 #include "Core/Math/Vector3.h"
+#include "Core/Collections/Vector.h"
 
 namespace Pu
 {
-	/* Defines a handler object for the Gilbert-Johnson-Keerthi distance algorithm. */
+	/* Defines the information that is kept between GJK calls on the same pair of shapes, used to warm start the next call. */
+	struct GJKCache
+	{
+	public:
+		/* Specifies the last search direction (the separating axis if the shapes didn't intersect). */
+		Vector3 Direction;
+
+		/* Initializes an empty instance of a GJK cache. */
+		GJKCache(void)
+			: Direction(Vector3::Left())
+		{}
+	};
+
+	/* Defines a handler object for the Gilbert-Johnson-Keerthi distance algorithm and the Expanding Polytope Algorithm. */
 	class GJK
 	{
 	public:
@@ -17,25 +31,71 @@ namespace Pu
 		_Check_return_ static uint32 GetCallCount(void);
 		/* Gets the average iterations that GJK took since the last reset. */
 		_Check_return_ static uint32 GetAverageIterations(void);
+		/* Gets the amount of EPA calls that occured since the last reset. */
+		_Check_return_ static uint32 GetEPACallCount(void);
+		/* Gets the average iterations that EPA took since the last reset. */
+		_Check_return_ static uint32 GetAverageEPAIterations(void);
 		/* Resets the GJK call counter. */
 		static void ResetCounters(void);
 
 		/* Runs a generic version of the GJK algorithm for the two specified shapes and their support functions; returning whether the two shapes intersect. */
 		_Check_return_ bool Run(_In_ const void *shape1, _In_ const void *shape2, _In_ Support_t support1, _In_ Support_t support2);
+		/* Runs a warm started version of the GJK algorithm, the cache is updated for the next call on the same pair. */
+		_Check_return_ bool Run(_In_ const void *shape1, _In_ const void *shape2, _In_ Support_t support1, _In_ Support_t support2, _Inout_ GJKCache &cache);
+		/* Calculates the penetration depth, axis and contact points of the last (intersecting) GJK call using EPA. */
+		void GetContact(_In_ const void *shape1, _In_ const void *shape2, _In_ Support_t support1, _In_ Support_t support2);
+
+		/* Gets the axis of intersection (from the first to the second shape) for the last EPA call. */
+		_Check_return_ inline Vector3 GetIntersectionAxis(void) const
+		{
+			return n;
+		}
+
+		/* Gets the intersection depth for the last EPA call. */
+		_Check_return_ inline float GetIntersectionDepth(void) const
+		{
+			return depth;
+		}
+
+		/* Gets the deepest point on the first shape for the last EPA call. */
+		_Check_return_ inline Vector3 GetContact1(void) const
+		{
+			return contact1;
+		}
+
+		/* Gets the deepest point on the second shape for the last EPA call. */
+		_Check_return_ inline Vector3 GetContact2(void) const
+		{
+			return contact2;
+		}
 
 	private:
+		struct SupportPoint
+		{
+			/* The point on the Minkowski difference. */
+			Vector3 P;
+			/* The point on the first shape. */
+			Vector3 A;
+		};
+
 		uint8 iteration;
-		float lastSqrDist;
 		Vector3 supportDir;
 		
 		uint8 dimension;
-		Vector3 simplex[4];
-		float barycentricCoords[4];
-
-		int RunInternal(const void *shape1, const void *shape2, Support_t support1, Support_t support2);
-		void NormalizeBarycentricCoords(void);
-		void NearestLine(void);
-		void NearestTriangle(void);
-		void NearestTetrahedron(void);
+		SupportPoint simplex[4];
+
+		Vector3 n, contact1, contact2;
+		float depth;
+		vector<SupportPoint> polytope;
+		vector<uint32> faces;
+		vector<std::pair<uint32, uint32>> edges;
+
+		static SupportPoint Support(const void *shape1, const void *shape2, Support_t support1, Support_t support2, Vector3 dir);
+
+		bool RunInternal(const void *shape1, const void *shape2, Support_t support1, Support_t support2, Vector3 dir);
+		bool NearestLine(void);
+		bool NearestTriangle(void);
+		bool NearestTetrahedron(void);
+		void AddEdge(uint32 a, uint32 b);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include "Core/Collections/vector.h"
+#include "Physics/Objects/PhysicsHandle.h"
+
+namespace Pu
+{
+	class PhysicalWorld;
+	class BinaryWriter;
+	class BinaryReader;
+
+	/*
+	Defines a system that groups kinematic objects into simulation islands.
+	An island is a set of kinematic objects that are (indirectly) touching each other,
+	static objects never join islands as that would merge everything resting on the same floor.
+	Islands sleep and wake as a single unit and can be solved independently from one another.
+	*/
+	class IslandSystem
+	{
+	public:
+		/* Initializes a new instance of an island system. */
+		IslandSystem(_In_ PhysicalWorld &world);
+		IslandSystem(_In_ const IslandSystem&) = delete;
+		/* Move constructor. */
+		IslandSystem(_In_ IslandSystem &&value) = default;
+
+		_Check_return_ IslandSystem& operator =(_In_ const IslandSystem&) = delete;
+		/* Move assignment. */
+		_Check_return_ IslandSystem& operator =(_In_ IslandSystem &&other) = default;
+
+		/* Gets the amount of islands found during the last build. */
+		_Check_return_ inline size_t GetIslandCount(void) const
+		{
+			return offsets.size() - (offsets.size() != 0);
+		}
+
+		/* Gets the amount of islands that are currently sleeping. */
+		_Check_return_ inline size_t GetSleepingIslandCount(void) const
+		{
+			return sleepingIslands;
+		}
+
+		/* Gets the contact indices (into the ContactSystem buffers) of all islands, grouped per island. */
+		_Check_return_ inline const vector<uint32>& GetContacts(void) const
+		{
+			return contacts;
+		}
+
+		/* Gets the contact indices (into the ContactSystem buffers) of the specified island. */
+		_Check_return_ inline const uint32* GetContacts(_In_ size_t island, _Out_ size_t &count) const
+		{
+			count = offsets[island + 1] - offsets[island];
+			return contacts.data() + offsets[island];
+		}
+
+		/* Adds a single kinematic item to the island system. */
+		void AddItem(void);
+		/* Removes the kinematic item at the specified index, waking its island. */
+		void RemoveItem(_In_ PhysicsHandle handle);
+		/* Builds the islands from the current contacts, waking any sleeping island that is touched by an awake object. */
+		void Build(void);
+		/* Puts any island to sleep of which all members have been resting for long enough. */
+		void TrySleep(void);
+		/* Writes the sleeping state of all islands to the specified writer. */
+		void Snapshot(_Inout_ BinaryWriter &writer) const;
+		/* Restores the sleeping state of all islands from the specified reader. */
+		void Restore(_Inout_ BinaryReader &reader);
+
+	private:
+		PhysicalWorld *world;
+
+		vector<uint32> parents;
+		vector<uint32> sleepIslands;
+		vector<uint16> restSteps;
+		vector<bool> awake;
+
+		vector<uint32> contacts;
+		vector<uint32> offsets;
+		vector<uint32> lut;
+		size_t sleepingIslands;
+
+		uint32 Find(uint32 idx);
+		void Union(uint32 idx1, uint32 idx2);
+	};
+}
\ No newline at end of file
@@ -3,15 +3,20 @@
 #include "Core/Collections/vector.h"
 #include "Physics/Objects/PhysicsHandle.h"
 #include "Physics/Properties/PhysicalProperties.h"
+#include "Physics/Properties/CombineMode.h"
 
 namespace Pu
 {
-	/* Defines an object used to query and store material properties. */
+	/*
+	Defines an object used to query and store material properties.
+	The combined contact coefficients of every material pair are precomputed into an N*N table,
+	so the solver can gather them by pair index instead of combining them per contact.
+	*/
 	class MaterialDatabase
 	{
 	public:
 		/* Initializes a new instance of a material database. */
-		MaterialDatabase(void) = default;
+		MaterialDatabase(void);
 		MaterialDatabase(_In_ const MaterialDatabase&) = delete;
 		/* Move constructor. */
 		MaterialDatabase(_In_ MaterialDatabase &&value) = default;
@@ -27,15 +32,43 @@ namespace Pu
 			return materials[physics_get_lookup_id(id) - 1];
 		}
 
-		/* Adds a new material to the database and returns its identifier */
-		inline PhysicsHandle Add(_In_ const PhysicalProperties &properties)
+		/* Gets the amount of materials in the database (the width of the combined coefficient tables). */
+		_Check_return_ inline size_t GetMaterialCount(void) const
+		{
+			return materials.size();
+		}
+
+		/* Gets the row (or column) of the specified material in the combined coefficient tables. */
+		_Check_return_ inline int32 GetMaterialIndex(_In_ PhysicsHandle id) const
+		{
+			assert(physics_get_type(id) == PhysicsType::Material);
+			return static_cast<int32>(physics_get_lookup_id(id) - 1);
+		}
+
+		/* Gets the combined coefficients of restitution (indexed by pair index). */
+		_Check_return_ inline const float* GetRestitutionTable(void) const
+		{
+			return restitution.data();
+		}
+
+		/* Gets the combined coefficients of kinetic friction (indexed by pair index). */
+		_Check_return_ inline const float* GetFrictionTable(void) const
 		{
-			/* Material handles start at one, becasue all zeros is the null handle. */
-			materials.emplace_back(properties);
-			return create_physics_handle(PhysicsType::Material, materials.size());
+			return friction.data();
 		}
 
+		/* Adds a new material to the database and returns its identifier */
+		_Check_return_ PhysicsHandle Add(_In_ const PhysicalProperties &properties);
+		/* Sets the modes used to combine the coefficients of two materials. */
+		void SetCombineModes(_In_ CombineMode restitutionMode, _In_ CombineMode frictionMode);
+
 	private:
 		vector<PhysicalProperties> materials;
+		vector<float> restitution;
+		vector<float> friction;
+		CombineMode modeCoR;
+		CombineMode modeCoF;
+
+		void Rebuild(void);
 	};
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 
 namespace Pu
 {
+	class BinaryWriter;
+	class BinaryReader;
+
 	/* Defines a system that handles the integration of position. */
 	class MovementSystem
 	{
@@ -39,6 +42,19 @@ namespace Pu
 			return sleep.get(idx) == 0.0f;
 		}
 
+		/* Gets whether the specified object was moving slower than the sleep epsilon during the last sleep check. */
+		_Check_return_ inline bool IsResting(_In_ size_t idx) const
+		{
+			return rest.get(idx) == 0.0f;
+		}
+
+		/* Gets the indices of the objects that have moved out of their expanded AABB during the last integration. */
+		_Check_return_ inline const uint32* GetMovedObjects(_Out_ size_t &count) const
+		{
+			count = movedCnt;
+			return moved.data();
+		}
+
 		/* Gets the amount of static objects currently in the movement system. */
 		_Check_return_ inline size_t GetStaticObjectCount(void) const
 		{
@@ -47,6 +63,8 @@ namespace Pu
 
 		/* Adds a specific offset to the specified object. */
 		void AddOffset(_In_ size_t idx, _In_ Vector3 offset);
+		/* Marks that the specified object was already moved to its time of impact (0-1) during this step, so only the remaining part of the step is integrated. */
+		void SetTimeOfImpact(_In_ size_t idx, _In_ float toi);
 		/* Adds a specific linear and angular force to the specific object. */
 		void AddForce(_In_ size_t idx, _In_ float x, _In_ float y, _In_ float z, _In_ float pitch, _In_ float yaw, _In_ float roll);
 		/* Adds a single kinematic item to the movement system, return the index. */
@@ -55,12 +73,8 @@ namespace Pu
 		_Check_return_ size_t AddItem(_In_ const Matrix &transform);
 		/* Removes the item at the specified index. */
 		void RemoveItem(_In_ PhysicsHandle handle);
-		/* Adds the gravitational force to the objects. */
-		void ApplyGravity(_In_ ofloat dt);
-		/* Adds the aerodynamic drag force to the objects. */
-		void ApplyDrag(_In_ ofloat dt);
-		/* Adds the linear and angular velocity to the objects position. */
-		void Integrate(_In_ ofloat dt);
+		/* Adds the linear and angular velocity to the objects position, marks the resting objects and applies the world forces for the next step. */
+		void Integrate(_In_ ofloat dt, _In_ ofloat epsilon);
 		/* Creates a transformation matrix for the specified object. */
 		_Check_return_ Matrix GetTransform(_In_ PhysicsHandle handle) const;
 		/* Gets the position of the specified object. */
@@ -69,12 +83,18 @@ namespace Pu
 		_Check_return_ Vector3 GetVelocity(_In_ size_t idx) const;
 		/* Gets the angular velocity of the specified object. */
 		_Check_return_ Vector3 GetAngularVelocity(_In_ size_t idx) const;
-		/* Gets the indices of the objects that have moved out of their expanded AABB. */
-		void CheckDistance(_Out_ vector<size_t> &result) const;
-		/* Sets the sleep bit for any object with a velocity magnitude smaller than the specified epsilon. */
-		void TrySleep(_In_ ofloat epsilon);
+		/* Puts the specified object to sleep, clearing its velocities. */
+		void Sleep(_In_ size_t idx);
+		/* Wakes the specified object. */
+		void Wake(_In_ size_t idx);
 		/* Gets the amount of kinematic objects that are currently in sleep mode. */
 		_Check_return_ size_t GetSleepingCount(void) const;
+		/* Gets the amount of memory (in bytes) used to store the state of all objects, the padding of the last AVX type is included. */
+		_Check_return_ size_t GetMemoryUsage(void) const;
+		/* Writes the state of all kinematic objects to the specified writer. */
+		void Snapshot(_Inout_ BinaryWriter &writer) const;
+		/* Restores the state of all kinematic objects from the specified reader. */
+		void Restore(_Inout_ BinaryReader &reader);
 
 	private:
 		avxf_vector cod;
@@ -95,14 +115,15 @@ namespace Pu
 
 		vector<Matrix> transforms;
 		vector<Vector3> scales;
-		mutable avxf_vector qx;
-		mutable avxf_vector qy;
-		mutable avxf_vector qz;
+		avxf_vector qx;
+		avxf_vector qy;
+		avxf_vector qz;
 
 		avxf_vector vx;
 		avxf_vector vy;
 		avxf_vector vz;
 		avxf_vector sleep;
+		avxf_vector rest;
 
 		avxf_vector ti;
 		avxf_vector tj;
@@ -112,5 +133,13 @@ namespace Pu
 		avxf_vector wp;
 		avxf_vector wy;
 		avxf_vector wr;
+
+		vector<std::pair<uint32, float>> impacts;
+		vector<uint32> moved;
+		vector<uint32> lanes;
+		vector<uint32> chunkCounts;
+		size_t movedCnt;
+
+		uint32 IntegrateChunk(size_t start, size_t end, ofloat dt, ofloat epsilon);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+#include "Core/Math/Shapes/AABB.h"
+#include "Core/Math/Matrix.h"
+#include "Core/Collections/Vector.h"
+
+namespace Pu
+{
+	/* Defines the CPU side geometry of an object that can hide other objects from view. */
+	struct Occluder
+	{
+		/* The positions of the vertices (in model space). */
+		vector<Vector3> Vertices;
+		/* The vertex indices of the triangles. */
+		vector<uint16> Indices;
+	};
+
+	/*
+	Defines a low resolution software depth buffer used for occlusion culling.
+	Designated occluders are rasterized on the CPU, after which bounding boxes can be tested against the resulting depth.
+	All the tests are conservative, so an object is never reported as hidden if any part of it might be visible.
+	*/
+	class OcclusionBuffer
+	{
+	public:
+		/* Initializes a new instance of an occlusion buffer with the specified size (the width must be a multiple of 8). */
+		OcclusionBuffer(_In_ uint32 width, _In_ uint32 height);
+		OcclusionBuffer(_In_ const OcclusionBuffer&) = delete;
+		/* Move constructor. */
+		OcclusionBuffer(_In_ OcclusionBuffer &&value) = default;
+
+		_Check_return_ OcclusionBuffer& operator =(_In_ const OcclusionBuffer&) = delete;
+		/* Move assignment. */
+		_Check_return_ OcclusionBuffer& operator =(_In_ OcclusionBuffer &&other) = default;
+
+		/* Gets the width of the depth buffer. */
+		_Check_return_ inline uint32 GetWidth(void) const
+		{
+			return width;
+		}
+
+		/* Gets the height of the depth buffer. */
+		_Check_return_ inline uint32 GetHeight(void) const
+		{
+			return height;
+		}
+
+		/* Gets the depth buffer (row-major, smaller values are closer to the camera). */
+		_Check_return_ inline const float* GetDepth(void) const
+		{
+			return depth.data();
+		}
+
+		/* Gets the amount of occluder triangles that were added since the last clear. */
+		_Check_return_ inline size_t GetTriangleCount(void) const
+		{
+			return triangles.size();
+		}
+
+		/* Removes all occluders and resets the depth buffer to the far plane, using the specified view projection for the next frame. */
+		void Clear(_In_ const Matrix &viewProjection);
+		/* Adds the specified occluder (with the specified model matrix) to the buffer, it's only drawn when the buffer is rasterized. */
+		void Add(_In_ const Occluder &occluder, _In_ const Matrix &transform);
+		/* Rasterizes all added occluders, this can only be called from a thread that was not created by the scheduler. */
+		void Rasterize(void);
+		/* Gets whether any part of the specified (world space) bounding box might be visible. */
+		_Check_return_ bool IsVisible(_In_ const AABB &box) const;
+
+	private:
+		/* Defines a triangle in screen space, the Z component stores the depth. */
+		struct Triangle
+		{
+			Vector3 A, B, C;
+		};
+
+		uint32 width, height;
+		uint32 tilesX, tilesY;
+		Matrix vp;
+
+		vector<float> depth;
+		vector<Triangle> triangles;
+		vector<vector<uint32>> bins;
+		vector<Vector4> projected;
+
+		void RasterizeTile(uint32 tile);
+		void RasterizeTriangle(const Triangle &triangle, uint32 minX, uint32 minY, uint32 maxX, uint32 maxY);
+	};
+}
\ No newline at end of file
@@ -3,8 +3,10 @@
 #include "System.h"
 #include "Physics/Objects/BVH.h"
 #include "Physics/Objects/PhysicalObject.h"
+#include "Physics/Objects/SpatialQuery.h"
 #include "Graphics/Lighting/DeferredRenderer.h"
 #include "Physics/Properties/PhysicalProperties.h"
+#include "Physics/Properties/CombineMode.h"
 
 namespace Pu
 {
@@ -12,7 +14,12 @@ namespace Pu
 	class MovementSystem;
 	class ContactSystem;
 	class ContactSolverSystem;
+	class IslandSystem;
 	class RenderingSystem;
+	class BinaryWriter;
+	class BinaryReader;
+	struct Occluder;
+	struct QueryCollider;
 
 	/* Defines the main entry point for all physics related code. */
 	class PhysicalWorld final
@@ -21,7 +28,14 @@ namespace Pu
 	public:
 		/* Defines the amount of update sub-steps. */
 		uint32 Substeps;
+		/* 
+		Defines whether the world should run in determinism mode.
+		In this mode the world is always stepped with a fixed timestep, so an identical input stream produces identical state.
+		*/
+		bool Deterministic;
 
+		/* Initializes a new instance of a headless physical world system (the visual representation of added objects is ignored and lights cannot be added). */
+		PhysicalWorld(void);
 		/* Initializes a new instance of a physical world system. */
 		PhysicalWorld(_In_ DeferredRenderer &renderer);
 		PhysicalWorld(_In_ const PhysicalWorld&) = delete;
@@ -43,22 +57,50 @@ namespace Pu
 		_Check_return_ PhysicsHandle AddStatic(_In_ const PhysicalObject &obj, _In_ const Model &model, _In_ uint32 subpass);
 		/* Adds a new kinematic object to this world, with the specified parameters. */
 		_Check_return_ PhysicsHandle AddKinematic(_In_ const PhysicalObject &obj, _In_ const Model &model, _In_ uint32 subpass);
+		/* Adds a new static object without a visual representation to this world. */
+		_Check_return_ PhysicsHandle AddStatic(_In_ const PhysicalObject &obj);
+		/* Adds a new kinematic object without a visual representation to this world. */
+		_Check_return_ PhysicsHandle AddKinematic(_In_ const PhysicalObject &obj);
 		/* Adds the specified material to this world. */
 		_Check_return_ PhysicsHandle AddMaterial(_In_ const PhysicalProperties &prop);
+		/* Sets the modes used to combine the restitution and friction coefficients of two materials. */
+		void SetCombineModes(_In_ CombineMode restitution, _In_ CombineMode friction);
 		/* Adds the specified directional light to this world. */
 		_Check_return_ PhysicsHandle AddLight(_In_ const DirectionalLight &light);
 		/* Adds the specified point light to this world. */
 		_Check_return_ PhysicsHandle AddLight(_In_ const PointLight &light);
+		/* Replaces the specified point light in this world. */
+		void UpdateLight(_In_ PhysicsHandle handle, _In_ const PointLight &light);
+		/* Uses the specified geometry (in model space) to hide other objects behind the specified object, the occluder must stay alive while the object exists. */
+		void AddOccluder(_In_ PhysicsHandle handle, _In_ const Occluder &occluder);
 		/* Sets the gravitational constant. */
 		void SetGravity(_In_ Vector3 g);
 		/* Removes the specified object or material from this world. */
 		void Destroy(_In_ PhysicsHandle handle);
 		/* Gets the transform of the specified object. */
 		_Check_return_ Matrix GetTransform(_In_ PhysicsHandle handle) const;
+		/* Gets the object hit by the specified ray (null if no object was hit). */
+		_Check_return_ PhysicsHandle Raycast(_In_ Vector3 p, _In_ Vector3 d) const;
+		/* Gets the objects that overlap with the specified sphere, returns the amount of objects written to the result buffer. */
+		_Check_return_ size_t Overlap(_In_ Sphere sphere, _In_ const QueryFilter &filter, _Out_writes_to_(capacity, return) PhysicsHandle *result, _In_ size_t capacity) const;
+		/* Gets the objects that overlap with the specified oriented bounding box, returns the amount of objects written to the result buffer. */
+		_Check_return_ size_t Overlap(_In_ const OBB &obb, _In_ const QueryFilter &filter, _Out_writes_to_(capacity, return) PhysicsHandle *result, _In_ size_t capacity) const;
+		/* Sweeps the specified sphere along the displacement, returns the first object hit (null if nothing was hit) and the fraction of the displacement at which it was hit. */
+		_Check_return_ PhysicsHandle Sweep(_In_ Sphere sphere, _In_ Vector3 displacement, _In_ const QueryFilter &filter, _Out_ float &time) const;
+		/* Gets the (at most) k objects closest to the specified point (sorted from near to far), returns the amount of objects found. */
+		_Check_return_ size_t Nearest(_In_ Vector3 p, _In_ float maxDistance, _In_ const QueryFilter &filter, _Out_writes_to_(k, return) PhysicsHandle *result, _Out_writes_to_(k, return) float *distances, _In_ size_t k) const;
+		/* Executes a batch of spatial queries, big batches are spread over the task scheduler (only call this from a thread not owned by the scheduler). */
+		void Query(_Inout_updates_(count) SpatialQuery *queries, _In_ size_t count) const;
 		/* Renders the physical world. */
 		void Render(_In_ const Camera &camera, _In_ CommandBuffer &cmdBuffer);
 		/* Allows the user to visualize the physical world. */
 		void Visualize(_In_ DebugRenderer &dbgRenderer, _In_ Vector3 camPos) const;
+		/* Advances the physical world by a single fixed timestep, this can be used to re-simulate after restoring a snapshot. */
+		void Step(void);
+		/* Appends the current simulation state to the specified writer, reset and reuse the same writer to avoid allocations when taking a snapshot every step. */
+		void Snapshot(_Inout_ BinaryWriter &writer) const;
+		/* Restores the simulation state from the specified reader, the world must contain the same objects as when the snapshot was taken. */
+		void Restore(_Inout_ BinaryReader &reader);
 
 	protected:
 		/* Updates the physical world. */
@@ -67,16 +109,19 @@ namespace Pu
 	private:
 		friend class ContactSolverSystem;
 		friend class ContactSystem;
+		friend class IslandSystem;
 
 		MaterialDatabase *db;
 		MovementSystem *sysMove;
 		ContactSystem *sysCnst;
 		ContactSolverSystem *sysSolv;
+		IslandSystem *sysIsland;
 		RenderingSystem *sysRender;
 		BVH searchTree;
 
 		mutable std::mutex lock;
 		vector<PhysicsHandle> handleLut;
+		float accumulator;
 
 #ifdef _DEBUG
 		mutable bool showBvh1, showBvh2;
@@ -94,6 +139,8 @@ namespace Pu
 		PhysicsHandle QueryInternalHandle(PhysicsHandle handle) const;
 		uint16 QueryInternalIndex(PhysicsHandle handle) const;
 		void ValidateHandle(PhysicsHandle handle) const;
+		void Simulate(float dt);
+		void QueryInternal(SpatialQuery &query, vector<QueryCollider> *candidates) const;
 		PhysicsHandle AddInternal(const PhysicalObject &obj, PhysicsType type);
 		PhysicsHandle AllocPublicHandle(PhysicsType type, size_t idx);
 		void DestroyInternal(PhysicsHandle hpublic, PhysicsHandle hinternal);
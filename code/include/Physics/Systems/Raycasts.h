@@ -25,7 +25,8 @@ namespace Pu
 			(box.UpperBound.X - p.X) * rd.X,
 			(box.LowerBound.Y - p.Y) * rd.Y,
 			(box.UpperBound.Y - p.Y) * rd.Y,
-			(box.LowerBound.Z - p.Z) * rd.Z
+			(box.LowerBound.Z - p.Z) * rd.Z,
+			(box.UpperBound.Z - p.Z) * rd.Z
 		};
 
 		const float mi = max(max(min(t[0], t[1]), min(t[2], t[3])), min(t[4], t[5]));
@@ -34,4 +35,29 @@ namespace Pu
 		if (ma < 0.0f || mi > ma) return -1.0f;
 		return mi < 0.0f ? ma : mi;
 	}
+
+	/*
+	Gets the distance on the ray at which the ray intersects with the triangle (a, b, c), if it doesn't intersect; the value is negative.
+	Note that the ray is specified as it's starting position (p) and its direction (d).
+	*/
+	_Check_return_ inline float raycast(_In_ Vector3 p, _In_ Vector3 d, _In_ Vector3 a, _In_ Vector3 b, _In_ Vector3 c)
+	{
+		/* Moller-Trumbore intersection. */
+		const Vector3 e1 = b - a;
+		const Vector3 e2 = c - a;
+		const Vector3 h = cross(d, e2);
+		const float det = dot(e1, h);
+		if (nrlyeql(det, 0.0f)) return -1.0f;
+
+		const float idet = recip(det);
+		const Vector3 s = p - a;
+		const float u = dot(s, h) * idet;
+		if (u < 0.0f || u > 1.0f) return -1.0f;
+
+		const Vector3 q = cross(s, e1);
+		const float v = dot(d, q) * idet;
+		if (v < 0.0f || u + v > 1.0f) return -1.0f;
+
+		return dot(e2, q) * idet;
+	}
 }
\ No newline at end of file
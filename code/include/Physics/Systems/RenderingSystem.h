@@ -2,6 +2,12 @@
 #include "Physics/Objects/BVH.h"
 #include "Physics/Objects/PhysicsHandle.h"
 #include "Graphics/Lighting/DeferredRenderer.h"
+#include "Graphics/Models/InstanceBatcher.h"
+#include "Graphics/Models/LodSelector.h"
+#include "Graphics/Models/InstancePool.h"
+#include "Graphics/Vulkan/CommandPool.h"
+#include "Physics/Systems/OcclusionBuffer.h"
+#include "Graphics/Lighting/PointLightCuller.h"
 
 namespace Pu
 {
@@ -34,9 +40,13 @@ namespace Pu
 		_Check_return_ PhysicsHandle Add(_In_ const PointLight &light);
 		/* Adds a directional light to the renderer. */
 		_Check_return_ PhysicsHandle Add(_In_ const DirectionalLight &light);
+		/* Uses the specified geometry of the object to hide other objects behind it. */
+		void AddOccluder(_In_ PhysicsHandle handle, _In_ const Occluder &occluder);
 
 		/* Renders the current physical world state to the renderer. */
 		void Render(_In_ const BVH &bvh, _In_ const Camera &camera, _In_ CommandBuffer &cmdBuffer);
+		/* Replaces the specified point light, this only uploads the changed light. */
+		void Update(_In_ PhysicsHandle handle, _In_ const PointLight &light);
 		/* Removes the specified object from the renderer. */
 		void Remove(_In_ PhysicsHandle handle);
 
@@ -46,27 +56,116 @@ namespace Pu
 			return visualTree;
 		}
 
+		/* Gets the amount of static geometry draw calls issued during the last render. */
+		_Check_return_ inline uint32 GetDrawCallCount(void) const
+		{
+			return drawCalls;
+		}
+
+		/* Gets the amount of static geometry instances rendered during the last render. */
+		_Check_return_ inline uint32 GetRenderedInstanceCount(void) const
+		{
+			return batcher.GetInstanceCount();
+		}
+
+		/* Gets the amount of static geometry instances that were hidden by occluders during the last render. */
+		_Check_return_ inline uint32 GetOccludedInstanceCount(void) const
+		{
+			return occludedCount;
+		}
+
+		/* Gets the amount of static geometry instances that were rendered at a reduced level of detail during the last render. */
+		_Check_return_ inline uint32 GetReducedInstanceCount(void) const
+		{
+			return reducedCount;
+		}
+
+		/* Gets the amount of point lights rendered during the last render. */
+		_Check_return_ inline uint32 GetRenderedLightCount(void) const
+		{
+			return lightCuller.GetVisibleCount();
+		}
+
+		/* Gets the amount of point lights that were hidden by occluders during the last render. */
+		_Check_return_ inline uint32 GetOccludedLightCount(void) const
+		{
+			return lightCuller.GetOccludedCount();
+		}
+
+		/* Gets the software depth buffer used for occlusion culling. */
+		_Check_return_ inline const OcclusionBuffer& GetOcclusionBuffer(void) const
+		{
+			return occlusion;
+		}
+
 	private:
+		/* Defines a range of batches that is recorded into a single secondary command buffer. */
+		struct RecordJob
+		{
+			uint32 Subpass;
+			uint32 FirstBatch;
+			uint32 BatchCount;
+			uint32 DrawCalls;
+		};
+
+		/* Defines the result of a frustum cast, this is reused as long as the camera, tree and lookup don't change. */
+		struct VisibilityCache
+		{
+			const BVH *Tree = nullptr;
+			Frustum Clip;
+			uint32 TreeVersion = 0;
+			uint32 LutVersion = ~0u;
+			vector<PhysicsHandle> Cast;
+			vector<PhysicsHandlePair> Handles;
+			vector<uint32> Lods;
+			vector<std::pair<PhysicsHandle, uint32>> History;
+		};
+
 		const PhysicalWorld *world;
 		DeferredRenderer *renderer;
 		std::map<PhysicsHandle, PhysicsHandle> handleLut;
+		uint32 lutVersion;
 
 		BVH visualTree;
 		vector<PointLightPool*> pntLightPools;
+		vector<InstancePool*> instancePools;
+		InstanceBatcher batcher;
+		uint32 drawCalls;
+
+		OcclusionBuffer occlusion;
+		vector<std::pair<PhysicsHandle, const Occluder*>> occluders;
+		uint32 occludedCount;
+		PointLightCuller lightCuller;
+		LodSelector lodSelector;
+		vector<std::pair<uint32, Matrix>> visibleStatic;
+		uint32 reducedCount;
+
+		vector<CommandPool*> cmdPools;
+		std::map<const CommandBuffer*, vector<CommandBuffer>> secondaries;
+		vector<CommandList> jobLists;
+		vector<RecordJob> jobs;
+		size_t batchCursor, jobCursor;
+		const CommandBuffer *primary;
 
 		vector<const DirectionalLight*> dirLights;
 		vector<const TerrainChunk*> terrains;
 		vector<std::pair<const Model*, uint32>> models;
 		vector<PointLight> pntLights;
 
-		mutable vector<PhysicsHandle> cacheCast;
-		mutable vector<PhysicsHandlePair> cacheHandles;
+		VisibilityCache physicsCache;
 		mutable vector<std::pair<PhysicsHandle, const Asset*>> loadingAssets;
 
 		void CheckLoadingAssets(void);
 		PhysicsHandle AllocLightHandle(uint32 subpass);
 		void AddHandleToLuT(PhysicsHandle handle, size_t idx, uint32 subpass);
-		void UpdateCaches(const BVH &bvh, const Camera &cam);
+		void UpdateCache(const BVH &bvh, const Camera &cam, VisibilityCache &cache);
+		void RasterizeOccluders(const Camera &cam);
+		void StageInstances(CommandBuffer &cmdBuffer);
+		void RenderBatch(const InstanceBatch &batch);
+		void RecordSecondaries(void);
+		void RecordSecondary(size_t idx);
+		void FlushBatches(uint32 subpass);
+		void RenderPointLights(const vector<PointLightRun> &runs, bool coarse);
 		void Destroy(void);
 	};
 }
\ No newline at end of file
@@ -9,8 +9,10 @@ namespace Pu
 	class SAT
 	{
 	public:
-		/* Gets the amount of SAT calls that occured since the last reset. */
+		/* Gets the amount of SAT calls (pairs) that occured since the last reset. */
 		_Check_return_ static uint32 GetCallCount(void);
+		/* Gets the amount of batched SAT calls that occured since the last reset. */
+		_Check_return_ static uint32 GetBatchCount(void);
 		/* Resets the SAT call counter. */
 		static void ResetCounter(void);
 
@@ -22,6 +24,10 @@ namespace Pu
 		_Check_return_ const vector<Vector3>& GetContacts(_In_ const AABB &aabb, _In_ const OBB &obb);
 		/* Gets the contact points for the last collision [1, 4]. */
 		_Check_return_ const vector<Vector3>& GetContacts(_In_ const OBB &obb1, _In_ const OBB &obb2);
+		/* Performs SAT on up to eight pairs of oriented bounding boxes at once, returning a mask of the intersecting pairs, the axes and depths are only set for the intersecting pairs. */
+		_Check_return_ static uint32 Run(_In_ const OBB *first, _In_ const OBB *second, _In_ uint32 count, _Out_ Vector3 *normals, _Out_ float *depths);
+		/* Adds the contact points [1, 4] of the specified collision to the result buffer. */
+		static void GetContacts(_In_ const OBB &obb1, _In_ const OBB &obb2, _In_ Vector3 axis, _In_ float depth, _Inout_ vector<Vector3> &result);
 
 		/* Gets the axis of intersection for the last SAT call. */
 		_Check_return_ inline Vector3 GetIntersectionAxis(void) const
@@ -37,8 +43,6 @@ namespace Pu
 		
 	private:
 		Vector3 c1[8], c2[8];
-		Line l1[16], l2[16];
-		Plane p1[6], p2[6];
 		Vector3 axes[15];
 
 		Vector3 n;
@@ -52,7 +56,7 @@ namespace Pu
 		static void FillBuffer(Vector3 *buffer, Vector3 *axes, const AABB &aabb);
 		static void FillBuffer(Vector3 *buffer, Vector3 *axes, const OBB &obb);
 
-		void TransformAndCull(Vector3 p);
+		static void TransformAndCull(vector<Vector3> &result, size_t start, Vector3 axis, Vector3 p);
 		bool RunInternal(void);
 	};
 }
\ No newline at end of file
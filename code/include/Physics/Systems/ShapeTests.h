@@ -75,6 +75,88 @@ namespace Pu
 		return halfspace(plane, sphere.Center) >= -sphere.Radius;
 	}
 
+	/* Defines the 6 planes of a frustum as AVX streams, this allows 8 bounding boxes to be tested against it at once. */
+	struct AVX_FRUSTUM
+	{
+		/* The normals of the planes. */
+		ofloat NX[6], NY[6], NZ[6];
+		/* The absolute normals of the planes. */
+		ofloat AX[6], AY[6], AZ[6];
+		/* The distances of the planes to the origin. */
+		ofloat D[6];
+	};
+
+	/* Initializes the specified AVX frustum from the specified frustum. */
+	inline void _mm256_set1_frustum(_Out_ AVX_FRUSTUM &result, _In_ const Frustum &frustum)
+	{
+		for (uint8 i = 0; i < 6; i++)
+		{
+			const Plane &plane = frustum.Planes[i];
+			result.NX[i] = _mm256_set1_ps(plane.N.X);
+			result.NY[i] = _mm256_set1_ps(plane.N.Y);
+			result.NZ[i] = _mm256_set1_ps(plane.N.Z);
+			result.AX[i] = _mm256_set1_ps(fabsf(plane.N.X));
+			result.AY[i] = _mm256_set1_ps(fabsf(plane.N.Y));
+			result.AZ[i] = _mm256_set1_ps(fabsf(plane.N.Z));
+			result.D[i] = _mm256_set1_ps(plane.D);
+		}
+	}
+
+	/*
+	Gets which of the 8 specified axis aligned bounding boxes intersect with the specified frustum (uses AVX).
+	The boxes are passed as streams of their lower and upper bounds, the result has a bit set for every box that intersects.
+	The bits set in inside indicate the boxes that are fully inside of the frustum.
+	*/
+	_Check_return_ inline uint32 intersects(_In_ const AVX_FRUSTUM &frustum, _In_ const AVX_VEC3_UNION &lower, _In_ const AVX_VEC3_UNION &upper, _Out_ uint32 &inside)
+	{
+		const ofloat zero = _mm256_setzero_ps();
+		const ofloat half = _mm256_set1_ps(0.5f);
+
+		/* Convert the bounds to a center and half extent, so no corner has to be selected per plane. */
+		const ofloat cx = _mm256_mul_ps(_mm256_add_ps(lower.X8, upper.X8), half);
+		const ofloat cy = _mm256_mul_ps(_mm256_add_ps(lower.Y8, upper.Y8), half);
+		const ofloat cz = _mm256_mul_ps(_mm256_add_ps(lower.Z8, upper.Z8), half);
+		const ofloat ex = _mm256_mul_ps(_mm256_sub_ps(upper.X8, lower.X8), half);
+		const ofloat ey = _mm256_mul_ps(_mm256_sub_ps(upper.Y8, lower.Y8), half);
+		const ofloat ez = _mm256_mul_ps(_mm256_sub_ps(upper.Z8, lower.Z8), half);
+
+		/*
+		The distance from the corner closest to the front of the plane is the distance of the center plus the projected extent.
+		If that corner is behind any plane, the box is outside; if the furthest corner is in front of all planes, it's inside.
+		*/
+		ofloat outside = zero;
+		ofloat in = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+		for (uint8 i = 0; i < 6; i++)
+		{
+			const ofloat d = _mm256_add_ps(_mm256_dot_v3(frustum.NX[i], frustum.NY[i], frustum.NZ[i], cx, cy, cz), frustum.D[i]);
+			const ofloat r = _mm256_dot_v3(frustum.AX[i], frustum.AY[i], frustum.AZ[i], ex, ey, ez);
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_LT_OQ));
+			in = _mm256_and_ps(in, _mm256_cmp_ps(_mm256_sub_ps(d, r), zero, _CMP_GE_OQ));
+		}
+
+		inside = static_cast<uint32>(_mm256_movemask_ps(in));
+		return ~static_cast<uint32>(_mm256_movemask_ps(outside)) & 0xFF;
+	}
+
+	/*
+	Gets which of the 8 specified spheres intersect with the specified frustum (uses AVX).
+	The spheres are passed as streams of their centers and radii, the result has a bit set for every sphere that intersects.
+	*/
+	_Check_return_ inline uint32 intersects(_In_ const AVX_FRUSTUM &frustum, _In_ ofloat cx, _In_ ofloat cy, _In_ ofloat cz, _In_ ofloat radius)
+	{
+		const ofloat nr = _mm256_sub_ps(_mm256_setzero_ps(), radius);
+
+		/* A sphere is outside if its center is further than its radius behind any plane. */
+		ofloat outside = _mm256_setzero_ps();
+		for (uint8 i = 0; i < 6; i++)
+		{
+			const ofloat d = _mm256_add_ps(_mm256_dot_v3(frustum.NX[i], frustum.NY[i], frustum.NZ[i], cx, cy, cz), frustum.D[i]);
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, nr, _CMP_LT_OQ));
+		}
+
+		return ~static_cast<uint32>(_mm256_movemask_ps(outside)) & 0xFF;
+	}
+
 	/* Gets whether the specified sphere intersects with the specified frustum. */
 	_Check_return_ inline bool intersects(_In_ const Frustum &frustum, _In_ Sphere sphere)
 	{
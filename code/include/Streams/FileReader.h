@@ -29,6 +29,8 @@ namespace Pu
 		_Check_return_ static wstring GetCurrentDirectory(void);
 		/* Checks whether the specified file exists. */
 		_Check_return_ static bool FileExists(_In_ const wstring &path);
+		/* Gets the last time (in file system ticks) the specified file was written to, or zero if the file doesn't exist. */
+		_Check_return_ static int64 GetLastWriteTime(_In_ const wstring &path);
 
 		/* Gets whether the stream can be used. */
 		_Check_return_ inline bool IsOpen(void) const
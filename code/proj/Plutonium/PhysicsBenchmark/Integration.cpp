@@ -0,0 +1,64 @@
+#include "Integration.h"
+#include <Physics/Systems/MovementSystem.h>
+#include <Core/Diagnostics/Stopwatch.h>
+#include <random>
+
+using namespace Pu;
+
+/*
+The physical world uses 16-bit handles, so the kernel is run on the movement system directly to test the body counts that don't fit in the world.
+All bodies are kept awake with a zero sleep epsilon and receive random velocities, so every lane is streamed each frame.
+The bytes per body are the size of all the lanes that the kernel touches divided by the amount of bodies.
+*/
+string RunIntegration(uint32 frames, uint32 warmup)
+{
+	std::mt19937 rng{ 0x5EED };
+	std::uniform_real_distribution<float> position{ -100.0f, 100.0f };
+	std::uniform_real_distribution<float> velocity{ -5.0f, 5.0f };
+
+	constexpr float sdt = 1.0f / 60.0f;
+	const ofloat dt8 = _mm256_set1_ps(sdt);
+	const ofloat epsilon = _mm256_setzero_ps();
+
+	string json;
+	for (const size_t count : IntegrationBodyCounts)
+	{
+		MovementSystem system;
+		for (size_t i = 0; i < count; i++)
+		{
+			const Vector3 p{ position(rng), position(rng), position(rng) };
+			const Vector3 v{ velocity(rng), velocity(rng), velocity(rng) };
+			const Vector3 omega{ velocity(rng), velocity(rng), velocity(rng) };
+			(void)system.AddItem(p, v, Quaternion{}, omega, Vector3(1.0f), 0.1f, 1.0f, Matrix3{});
+		}
+
+		int64 time = 0, worst = 0;
+		for (uint32 i = 0; i < warmup + frames; i++)
+		{
+			const Stopwatch timer = Stopwatch::StartNew();
+			system.Integrate(dt8, epsilon);
+			const int64 elapsed = timer.Microseconds();
+
+			if (i >= warmup)
+			{
+				time += elapsed;
+				if (elapsed > worst) worst = elapsed;
+			}
+		}
+
+		const double n = static_cast<double>(frames);
+		const double bytes = static_cast<double>(system.GetMemoryUsage());
+		if (json.length()) json += ",\n";
+		json += "\t{\n\t\t\"scene\": \"integrate\"";
+		json += ",\n\t\t\"bodies\": " + string::from(static_cast<uint64>(count));
+		json += ",\n\t\t\"frames\": " + string::from(frames);
+		json += ",\n\t\t\"integrate_us\": " + string::from(time / n);
+		json += ",\n\t\t\"worst_us\": " + string::from(worst);
+		json += ",\n\t\t\"ns_per_body\": " + string::from(time * 1000.0 / (n * count));
+		json += ",\n\t\t\"bytes_per_body\": " + string::from(bytes / count);
+		json += ",\n\t\t\"bandwidth_gb_per_s\": " + string::from(time ? bytes * n / (time * 1000.0) : 0.0);
+		json += "\n\t}";
+	}
+
+	return json;
+}
\ No newline at end of file
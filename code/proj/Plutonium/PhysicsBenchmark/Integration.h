@@ -0,0 +1,8 @@
+#pragma once
+#include <Core/String.h>
+
+/* Defines the body counts used by the integration benchmark, these exceed the maximum amount of bodies the physical world can hold. */
+constexpr size_t IntegrationBodyCounts[] = { 10000, 100000, 1000000 };
+
+/* Runs the integration kernel directly on the movement system and returns the results as JSON objects (one per body count). */
+Pu::string RunIntegration(Pu::uint32 frames, Pu::uint32 warmup);
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "Scenes.h"
+#include "Snapshot.h"
+#include "Integration.h"
+#include <Physics/Systems/ContactSystem.h>
+#include <Core/Diagnostics/Profiler.h>
+#include <Core/Threading/Tasks/Scheduler.h>
+#include <Streams/FileWriter.h>
+#include <random>
+
+using namespace Pu;
+
+/* Defines the profiler categories used by the physics systems. */
+const char *CATEGORIES[] = { "BVH Update", "Broadphase", "Narrowphase", "Heightmap", "Boxes", "CCD", "Islands", "Solver", "Movement" };
+
+/* Defines the canonical benchmark scenes. */
+const Scene SCENES[] =
+{
+	{ "pyramid", CreatePyramid, 0 },
+	{ "sphere_rain", CreateSphereRain, 0 },
+	{ "sleeping_bodies", CreateSleepingBodies, 0 },
+	{ "raycast_storm", CreateRaycastTargets, 10000 }
+};
+
+struct BenchmarkArgs
+{
+	string Output;
+	string Scene;
+	uint32 Frames = 600;
+	uint32 Warmup = 60;
+	bool Help = false;
+};
+
+void logHelp(void)
+{
+	Log::Message(
+		"Usage: PhysicsBenchmark [option]...\n\n"
+		"Options:\n"
+		"--help				Displays this message.\n"
+		"-o <path>			Specifies the output file (the results are written to stdout by default).\n"
+		"-s <name>			Only runs the specified scene (pyramid, sphere_rain, sleeping_bodies, raycast_storm, snapshot or integrate).\n"
+		"-f <frames>		Specifies the amount of measured frames per scene (600 by default).\n"
+		"-w <frames>		Specifies the amount of unmeasured warmup frames per scene (60 by default).");
+}
+
+int initCmdLineArgs(const vector<string> &args, BenchmarkArgs &result)
+{
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		const string &cur = args[i];
+		const bool notLast = i + 1 < args.size();
+
+		if (cur == "--help")				// Help output.
+		{
+			result.Help = true;
+		}
+		else if (cur == "-o" && notLast)	// Output path.
+		{
+			result.Output = args[++i];
+		}
+		else if (cur == "-s" && notLast)	// Scene filter.
+		{
+			result.Scene = args[++i];
+		}
+		else if (cur == "-f" && notLast)	// Measured frames.
+		{
+			result.Frames = static_cast<uint32>(strtoul(args[++i].c_str(), nullptr, 10));
+		}
+		else if (cur == "-w" && notLast)	// Warmup frames.
+		{
+			result.Warmup = static_cast<uint32>(strtoul(args[++i].c_str(), nullptr, 10));
+		}
+		else
+		{
+			Log::Error("'%s' is not recognized as a valid command line argument (or is missing its value)!", cur.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!result.Frames)
+	{
+		Log::Error("The amount of measured frames must be greater than zero!");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/*
+Every scene is run in its own deterministic world, so the results are only affected by the code and the machine.
+
+create world and scene
+step world for warmup frames
+reset profiler and counters
+foreach frame
+	step world (and raycast)
+	accumulate counters
+report average times per frame and total counters
+*/
+string runScene(const Scene &scene, const BenchmarkArgs &args)
+{
+	PhysicalWorld world;
+	world.Deterministic = true;
+
+	PhysicalProperties material;
+	material.Density = 1.0f;
+	material.Mechanical.CoR = 0.2f;
+	material.Mechanical.CoFs = 1.15f;
+	material.Mechanical.CoFk = 1.4f;
+	material.Mechanical.CoFr = 0.001f;
+	const size_t bodies = scene.Create(world, world.AddMaterial(material));
+
+	for (uint32 i = 0; i < args.Warmup; i++) world.Step();
+	Profiler::Clear();
+	ContactSystem::ResetCounters();
+	SAT::ResetCounter();
+
+	/* The rays are generated with a fixed seed, so every run shoots the same rays. */
+	std::mt19937 rng{ 0x5EED };
+	std::uniform_real_distribution<float> offset{ -128.0f, 128.0f };
+	std::uniform_real_distribution<float> tilt{ -0.25f, 0.25f };
+
+	uint64 collisions = 0, checks = 0, sweeps = 0, sat = 0, hits = 0;
+	int64 stepTime = 0, rayTime = 0;
+
+	for (uint32 i = 0; i < args.Frames; i++)
+	{
+		Stopwatch timer = Stopwatch::StartNew();
+		world.Step();
+		stepTime += timer.Microseconds();
+
+		if (scene.Raycasts)
+		{
+			timer.Restart();
+			for (uint32 j = 0; j < scene.Raycasts; j++)
+			{
+				const Vector3 p{ offset(rng), 50.0f, offset(rng) };
+				hits += world.Raycast(p, normalize(tilt(rng), -1.0f, tilt(rng))) != PhysicsNullHandle;
+			}
+
+			rayTime += timer.Microseconds();
+		}
+
+		/* The static counters are 32-bit, so accumulate them every frame. */
+		collisions += ContactSystem::GetCollisionsCount();
+		checks += ContactSystem::GetNarrowPhaseChecks();
+		sweeps += ContactSystem::GetCCDSweeps();
+		sat += SAT::GetCallCount();
+		ContactSystem::ResetCounters();
+		SAT::ResetCounter();
+	}
+
+	/* All the times are reported as the average per frame in microseconds. */
+	const double frames = static_cast<double>(args.Frames);
+	string result = "\t{\n\t\t\"scene\": \"";
+	result += scene.Name;
+	result += "\",\n\t\t\"bodies\": " + string::from(static_cast<uint64>(bodies));
+	result += ",\n\t\t\"frames\": " + string::from(args.Frames);
+	result += ",\n\t\t\"step_us\": " + string::from(stepTime / frames);
+	result += ",\n\t\t\"raycast_us\": " + string::from(rayTime / frames);
+	result += ",\n\t\t\"systems_us\": {";
+
+	for (size_t i = 0; i < ARRAYSIZE(CATEGORIES); i++)
+	{
+		result += i ? ",\n\t\t\t\"" : "\n\t\t\t\"";
+		result += CATEGORIES[i];
+		result += "\": " + string::from(Profiler::GetTime(CATEGORIES[i]) / frames);
+	}
+
+	result += "\n\t\t},\n\t\t\"collisions\": " + string::from(collisions);
+	result += ",\n\t\t\"narrowphase_checks\": " + string::from(checks);
+	result += ",\n\t\t\"ccd_sweeps\": " + string::from(sweeps);
+	result += ",\n\t\t\"sat_calls\": " + string::from(sat);
+	result += ",\n\t\t\"raycast_hits\": " + string::from(hits);
+	result += "\n\t}";
+	return result;
+}
+
+int run(const vector<string> &args)
+{
+	BenchmarkArgs finalArgs;
+	if (initCmdLineArgs(args, finalArgs) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (finalArgs.Help)
+	{
+		logHelp();
+		return EXIT_SUCCESS;
+	}
+
+	string json = "[\n";
+	bool first = true;
+
+	for (const Scene &scene : SCENES)
+	{
+		if (finalArgs.Scene.length() && finalArgs.Scene != scene.Name) continue;
+
+		if (!first) json += ",\n";
+		json += runScene(scene, finalArgs);
+		first = false;
+	}
+
+	/* The snapshot benchmark measures the rollback cost instead of the step time, so it's not a regular scene. */
+	if (!finalArgs.Scene.length() || finalArgs.Scene == "snapshot")
+	{
+		if (!first) json += ",\n";
+		json += RunSnapshot(finalArgs.Frames, finalArgs.Warmup);
+		first = false;
+	}
+
+	/* The integration benchmark runs on more bodies than the physical world can hold, so it's not a regular scene. */
+	if (!finalArgs.Scene.length() || finalArgs.Scene == "integrate")
+	{
+		if (!first) json += ",\n";
+		json += RunIntegration(finalArgs.Frames, finalArgs.Warmup);
+		first = false;
+	}
+
+	if (first)
+	{
+		Log::Error("Unknown scene '%s'!", finalArgs.Scene.c_str());
+		return EXIT_FAILURE;
+	}
+
+	json += "\n]\n";
+	if (finalArgs.Output.length())
+	{
+		FileWriter writer{ finalArgs.Output.toWide() };
+		writer.Write(json);
+	}
+	else fputs(json.c_str(), stdout);
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		/* The benchmark never creates a window or Vulkan device, so it can run on machines without a GPU. */
+		TaskScheduler::Start();
+		Log::SetDetails(LogDetails::Type);
+
+		vector<string> args;
+		args.reserve(argc);
+
+		/* Skip the exe identity. */
+		for (int i = 1; i < argc; i++) args.emplace_back(argv[i]);
+		const int code = run(args);
+
+		TaskScheduler::StopWait();
+		return code;
+	}
+	catch (...)
+	{
+		/* Make sure that CI sees a failed state instead of a crash. */
+		return EXIT_FAILURE;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "Scenes.h"
+#include <Core/Math/HeightMap.h>
+
+using namespace Pu;
+
+/* The handles and the BVH use 16-bit indices, so the world can never contain more than this amount of bodies. */
+constexpr size_t MaxBodies = 30000;
+
+static PhysicalObject create_body(Vector3 pos, const Collider &collider, PhysicsHandle material, float mass, Matrix3 moi)
+{
+	PhysicalObject result{ pos, Quaternion{}, collider };
+	result.Properties = material;
+	result.State.Volume = 1.0f;
+	result.State.Mass = mass;
+	result.State.Cd = 0.5f;
+	result.MoI = moi;
+	return result;
+}
+
+static void add_floor(PhysicalWorld &world, PhysicsHandle material, float halfSize)
+{
+	const Collider collider{ AABB(Vector3(-halfSize, -1.0f, -halfSize), Vector3(halfSize, 0.0f, halfSize)), CollisionShapes::None, nullptr };
+	(void)world.AddStatic(create_body(Vector3(), collider, material, 1.0f, Matrix3()));
+}
+
+size_t CreatePyramid(PhysicalWorld & world, PhysicsHandle material)
+{
+	constexpr uint32 layers = 20;
+	constexpr float size = 1.0f;
+	add_floor(world, material, 50.0f);
+
+	OBB box{ Vector3(), Vector3(size * 0.5f), Quaternion() };
+	const Matrix3 moi = Matrix3::CreateScalar(sqr(size) / 6.0f);
+	size_t result = 0;
+
+	/* Every layer has one less box than the one below it, the boxes are placed slightly apart to avoid initial penetration. */
+	for (uint32 y = 0; y < layers; y++)
+	{
+		const uint32 cnt = layers - y;
+		const float start = -0.5f * (cnt - 1) * size * 1.01f;
+
+		for (uint32 x = 0; x < cnt; x++)
+		{
+			const Vector3 pos{ start + x * size * 1.01f, (y + 0.5f) * size * 1.001f, 0.0f };
+			(void)world.AddKinematic(create_body(pos, Collider{ box }, material, 1.0f, moi));
+			++result;
+		}
+	}
+
+	return result;
+}
+
+size_t CreateSphereRain(PhysicalWorld & world, PhysicsHandle material)
+{
+	constexpr uint32 dimensions = 128;
+	constexpr uint32 drops = 4096;
+	constexpr float scale = 1.0f;
+	constexpr float extent = (dimensions - 1) * scale;
+
+	/* Create a rolling heightmap, the bounds are calculated by the contact system. */
+	HeightMap heightmap{ dimensions, scale, true };
+	for (uint32 y = 0; y < dimensions; y++)
+	{
+		for (uint32 x = 0; x < dimensions; x++)
+		{
+			heightmap.SetHeight(x, y, 2.0f + sinf(x * 0.2f) + cosf(y * 0.15f));
+		}
+	}
+
+	heightmap.CalculateNormals(1.0f);
+	const Collider terrain{ AABB(Vector3(0.0f, 0.0f, 0.0f), Vector3(extent, 4.0f, extent)), CollisionShapes::HeightMap, &heightmap };
+	(void)world.AddStatic(create_body(Vector3(), terrain, material, 1.0f, Matrix3()));
+
+	/* Drop the spheres in a grid with increasing heights, so they don't all hit the ground at the same time. */
+	Sphere sphere{ Vector3(), 0.5f };
+	const Matrix3 moi = Matrix3::CreateScalar(0.4f * sqr(sphere.Radius));
+	const uint32 side = static_cast<uint32>(sqrtf(static_cast<float>(drops)));
+	const float spacing = extent / side;
+
+	for (uint32 i = 0; i < drops; i++)
+	{
+		const Vector3 pos{ (i % side + 0.5f) * spacing, 8.0f + (i / side) * 0.25f, (i / side + 0.5f) * spacing };
+		(void)world.AddKinematic(create_body(pos, Collider{ sphere }, material, 1.0f, moi));
+	}
+
+	return drops;
+}
+
+size_t CreateSleepingBodies(PhysicalWorld & world, PhysicsHandle material)
+{
+	const uint32 side = static_cast<uint32>(sqrtf(static_cast<float>(MaxBodies - 1)));
+	constexpr float spacing = 2.0f;
+	add_floor(world, material, side * spacing * 0.5f + 1.0f);
+
+	/* Place the spheres on the floor with space in between, so every sphere is its own island. */
+	Sphere sphere{ Vector3(), 0.5f };
+	const Matrix3 moi = Matrix3::CreateScalar(0.4f * sqr(sphere.Radius));
+	const float start = -0.5f * (side - 1) * spacing;
+
+	for (uint32 y = 0; y < side; y++)
+	{
+		for (uint32 x = 0; x < side; x++)
+		{
+			const Vector3 pos{ start + x * spacing, sphere.Radius, start + y * spacing };
+			(void)world.AddKinematic(create_body(pos, Collider{ sphere }, material, 1.0f, moi));
+		}
+	}
+
+	return side * side;
+}
+
+size_t CreateRaycastTargets(PhysicalWorld & world, PhysicsHandle material)
+{
+	constexpr uint32 side = 64;
+	constexpr float spacing = 4.0f;
+
+	/* Place the targets in a layered grid, the rays are shot from above. */
+	Sphere sphere{ Vector3(), 1.0f };
+	const Matrix3 moi = Matrix3::CreateScalar(0.4f * sqr(sphere.Radius));
+	const float start = -0.5f * (side - 1) * spacing;
+
+	for (uint32 y = 0; y < side; y++)
+	{
+		for (uint32 x = 0; x < side; x++)
+		{
+			const Vector3 pos{ start + x * spacing, ((x + y) & 0x3) * spacing, start + y * spacing };
+			(void)world.AddStatic(create_body(pos, Collider{ sphere }, material, 1.0f, moi));
+		}
+	}
+
+	return side * side;
+}
\ No newline at end of file
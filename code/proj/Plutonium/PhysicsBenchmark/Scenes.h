@@ -0,0 +1,22 @@
+#pragma once
+#include <Physics/Systems/PhysicalWorld.h>
+
+/* Defines a canonical benchmark scene. */
+struct Scene
+{
+	/* Specifies the name used to select and report the scene. */
+	const char *Name;
+	/* Specifies the function used to populate the world, returns the amount of bodies added. */
+	size_t(*Create)(Pu::PhysicalWorld &world, Pu::PhysicsHandle material);
+	/* Specifies the amount of raycasts that should be performed every frame. */
+	Pu::uint32 Raycasts;
+};
+
+/* Creates a pyramid of boxes resting on a static floor. */
+size_t CreatePyramid(Pu::PhysicalWorld &world, Pu::PhysicsHandle material);
+/* Creates a rain of spheres falling onto a heightmap. */
+size_t CreateSphereRain(Pu::PhysicalWorld &world, Pu::PhysicsHandle material);
+/* Creates a large amount of spheres resting on a static floor, these will fall asleep during warmup. */
+size_t CreateSleepingBodies(Pu::PhysicalWorld &world, Pu::PhysicsHandle material);
+/* Creates a field of static spheres used as raycast targets. */
+size_t CreateRaycastTargets(Pu::PhysicalWorld &world, Pu::PhysicsHandle material);
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "Snapshot.h"
+#include <Physics/Systems/PhysicalWorld.h>
+#include <Streams/BinaryWriter.h>
+#include <Streams/BinaryReader.h>
+#include <Core/Diagnostics/Stopwatch.h>
+
+using namespace Pu;
+
+/*
+The boxes are placed in columns of two on a static floor, so the snapshot contains moving bodies and persistent contacts.
+Every frame takes a snapshot, steps the world and restores it again, so the world is rolled back just like during rollback netcode.
+*/
+string RunSnapshot(uint32 frames, uint32 warmup)
+{
+	PhysicalWorld world;
+	world.Deterministic = true;
+
+	PhysicalProperties properties;
+	properties.Density = 1.0f;
+	properties.Mechanical.CoR = 0.2f;
+	properties.Mechanical.CoFs = 1.15f;
+	properties.Mechanical.CoFk = 1.4f;
+	properties.Mechanical.CoFr = 0.001f;
+	const PhysicsHandle material = world.AddMaterial(properties);
+
+	const uint32 side = static_cast<uint32>(sqrtf(SnapshotBodies * 0.5f));
+	constexpr float spacing = 1.5f;
+	const float half = side * spacing * 0.5f + 1.0f;
+	(void)world.AddStatic(PhysicalObject{ Vector3(), Quaternion{}, Collider{ AABB(Vector3(-half, -1.0f, -half), Vector3(half, 0.0f, half)), CollisionShapes::None, nullptr } });
+
+	OBB box{ Vector3(), Vector3(0.5f), Quaternion() };
+	const float start = -0.5f * (side - 1) * spacing;
+	size_t bodies = 0;
+
+	for (uint32 i = 0; i < side * side * 2; i++)
+	{
+		const uint32 column = i >> 1;
+		PhysicalObject obj{ Vector3(start + (column % side) * spacing, 0.5f + (i & 1) * 1.01f, start + (column / side) * spacing), Quaternion{}, Collider{ box } };
+		obj.Properties = material;
+		obj.State.Volume = 1.0f;
+		obj.State.Mass = 1.0f;
+		obj.State.Cd = 0.5f;
+		obj.MoI = Matrix3::CreateScalar(1.0f / 6.0f);
+		(void)world.AddKinematic(obj);
+		++bodies;
+	}
+
+	for (uint32 i = 0; i < warmup; i++) world.Step();
+
+	/* The writer is reused, so only the first snapshot has to grow the buffer. */
+	BinaryWriter writer;
+	int64 snapshotTime = 0, restoreTime = 0;
+
+	for (uint32 i = 0; i < frames; i++)
+	{
+		writer.Reset();
+		Stopwatch timer = Stopwatch::StartNew();
+		world.Snapshot(writer);
+		snapshotTime += timer.Microseconds();
+
+		world.Step();
+
+		BinaryReader reader{ writer.GetData(), writer.GetSize() };
+		timer.Restart();
+		world.Restore(reader);
+		restoreTime += timer.Microseconds();
+	}
+
+	const double n = static_cast<double>(frames);
+	string json = "\t{\n\t\t\"scene\": \"snapshot\"";
+	json += ",\n\t\t\"bodies\": " + string::from(static_cast<uint64>(bodies));
+	json += ",\n\t\t\"frames\": " + string::from(frames);
+	json += ",\n\t\t\"snapshot_bytes\": " + string::from(static_cast<uint64>(writer.GetSize()));
+	json += ",\n\t\t\"snapshot_us\": " + string::from(snapshotTime / n);
+	json += ",\n\t\t\"restore_us\": " + string::from(restoreTime / n);
+	json += "\n\t}";
+	return json;
+}
\ No newline at end of file
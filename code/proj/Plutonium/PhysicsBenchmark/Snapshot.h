@@ -0,0 +1,8 @@
+#pragma once
+#include <Core/String.h>
+
+/* Defines the amount of kinematic bodies used by the snapshot test. */
+constexpr size_t SnapshotBodies = 10000;
+
+/* Runs the physics snapshot and restore benchmark and returns the results as a JSON object. */
+Pu::string RunSnapshot(Pu::uint32 frames, Pu::uint32 warmup);
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "Culling.h"
+#include <Physics/Objects/BVH.h>
+#include <Physics/Systems/ShapeTests.h>
+#include <Physics/Systems/OcclusionBuffer.h>
+#include <Config.h>
+#include <Core/Diagnostics/Stopwatch.h>
+#include <random>
+
+using namespace Pu;
+
+/* The BVH uses 16-bit node indices, so it can't store all the objects of the flat tests. */
+constexpr size_t CullingTreeObjects = 30000;
+/* Defines the amount of walls used as occluders, these are placed in rings around the camera. */
+constexpr size_t OcclusionWalls = 64;
+
+/*
+The flat tests compare the scalar test against the AVX test over the same boxes.
+The tree test uses the AVX test internally and measures the benefit of early accepting fully visible branches.
+
+generate random boxes (in AoS and SoA form)
+foreach frame
+	rotate the camera
+	test all boxes one at a time
+	test all boxes 8 at a time
+	cast the tree
+report average times per frame
+*/
+string RunCulling(uint32 frames, uint32 warmup)
+{
+	std::mt19937 rng{ 0x5EED };
+	std::uniform_real_distribution<float> position{ -500.0f, 500.0f };
+	std::uniform_real_distribution<float> size{ 0.5f, 4.0f };
+
+	const size_t packets = (CullingObjects + 7) >> 3;
+	vector<AABB> boxes;
+	vector<AVX_VEC3_UNION> lowers(packets), uppers(packets);
+	BVH tree;
+
+	for (size_t i = 0; i < CullingObjects; i++)
+	{
+		const Vector3 lower{ position(rng), position(rng), position(rng) };
+		const AABB box{ lower, lower + Vector3(size(rng), size(rng), size(rng)) };
+
+		boxes.emplace_back(box);
+		_mm256_seti_v3(lowers[i >> 3], box.LowerBound.X, box.LowerBound.Y, box.LowerBound.Z, i & 0x7);
+		_mm256_seti_v3(uppers[i >> 3], box.UpperBound.X, box.UpperBound.Y, box.UpperBound.Z, i & 0x7);
+		if (i < CullingTreeObjects) tree.Insert(create_physics_handle(PhysicsType::Static, i), box);
+	}
+
+	const Matrix proj = Matrix::CreatePerspective(PI4, 16.0f / 9.0f, 0.1f, 1000.0f);
+	const uint32 tail = 0xFF >> ((8 - (CullingObjects & 0x7)) & 0x7);
+
+	vector<PhysicsHandle> result;
+	uint64 scalarVisible = 0, avxVisible = 0, treeVisible = 0;
+	int64 scalarTime = 0, avxTime = 0, treeTime = 0;
+
+	for (uint32 i = 0; i < warmup + frames; i++)
+	{
+		/* Slowly rotate the camera around the center of the boxes, so the visible set changes every frame. */
+		const float theta = i * 0.01f;
+		const Frustum frustum{ proj * Matrix::CreateLookIn(Vector3(), Vector3(cosf(theta), 0.0f, sinf(theta)), Vector3::Up()) };
+		const bool measure = i >= warmup;
+
+		Stopwatch timer = Stopwatch::StartNew();
+		uint64 visible = 0;
+		for (const AABB &box : boxes) visible += intersects(frustum, box);
+
+		if (measure)
+		{
+			scalarTime += timer.Microseconds();
+			scalarVisible += visible;
+		}
+
+		timer.Restart();
+		AVX_FRUSTUM planes;
+		_mm256_set1_frustum(planes, frustum);
+		visible = 0;
+
+		for (size_t j = 0; j < packets; j++)
+		{
+			uint32 inside;
+			const uint32 hits = intersects(planes, lowers[j], uppers[j], inside);
+			visible += _mm_popcnt_u32(j == packets - 1 ? hits & tail : hits);
+		}
+
+		if (measure)
+		{
+			avxTime += timer.Microseconds();
+			avxVisible += visible;
+		}
+
+		timer.Restart();
+		result.clear();
+		tree.Frustumcast(frustum, result);
+
+		if (measure)
+		{
+			treeTime += timer.Microseconds();
+			treeVisible += result.size();
+		}
+	}
+
+	/* The visible counts are reported as an average, these should match between the scalar and AVX tests. */
+	const double n = static_cast<double>(frames);
+	string json = "\t{\n\t\t\"scene\": \"frustum_cull\"";
+	json += ",\n\t\t\"bodies\": " + string::from(static_cast<uint64>(CullingObjects));
+	json += ",\n\t\t\"tree_bodies\": " + string::from(static_cast<uint64>(CullingTreeObjects));
+	json += ",\n\t\t\"frames\": " + string::from(frames);
+	json += ",\n\t\t\"scalar_us\": " + string::from(scalarTime / n);
+	json += ",\n\t\t\"avx_us\": " + string::from(avxTime / n);
+	json += ",\n\t\t\"tree_us\": " + string::from(treeTime / n);
+	json += ",\n\t\t\"scalar_visible\": " + string::from(scalarVisible / n);
+	json += ",\n\t\t\"avx_visible\": " + string::from(avxVisible / n);
+	json += ",\n\t\t\"tree_visible\": " + string::from(treeVisible / n);
+	json += "\n\t}";
+	return json;
+}
+
+/*
+The occlusion scene mimics a dense interior, the camera is surrounded by walls with the boxes behind them.
+
+generate walls and random boxes
+foreach frame
+	rotate the camera
+	rasterize all walls
+	test all boxes against the depth buffer
+report average times per frame
+*/
+string RunOcclusion(uint32 frames, uint32 warmup)
+{
+	std::mt19937 rng{ 0x5EED };
+	std::uniform_real_distribution<float> position{ -500.0f, 500.0f };
+	std::uniform_real_distribution<float> size{ 0.5f, 4.0f };
+
+	vector<AABB> boxes;
+	for (size_t i = 0; i < CullingObjects; i++)
+	{
+		const Vector3 lower{ position(rng), position(rng), position(rng) };
+		boxes.emplace_back(lower, lower + Vector3(size(rng), size(rng), size(rng)));
+	}
+
+	/* Every wall is a quad that faces the center, the walls are placed in two rings that leave small gaps. */
+	Occluder wall;
+	wall.Vertices = { Vector3(-24.0f, -50.0f, 0.0f), Vector3(24.0f, -50.0f, 0.0f), Vector3(24.0f, 50.0f, 0.0f), Vector3(-24.0f, 50.0f, 0.0f) };
+	wall.Indices = { 0, 1, 2, 0, 2, 3 };
+
+	vector<Matrix> walls;
+	for (size_t i = 0; i < OcclusionWalls; i++)
+	{
+		const float theta = TAU * (i >> 1) / (OcclusionWalls >> 1);
+		const float distance = i & 1 ? 200.0f : 100.0f;
+		walls.emplace_back(Matrix::CreateTranslation(Vector3(sinf(theta), 0.0f, cosf(theta)) * distance) * Matrix::CreateRotation(theta, Vector3::Up()));
+	}
+
+	const Matrix proj = Matrix::CreatePerspective(PI4, 16.0f / 9.0f, 0.1f, 1000.0f);
+	OcclusionBuffer buffer{ OcclusionBufferWidth, OcclusionBufferHeight };
+
+	uint64 visible = 0, triangles = 0;
+	int64 rasterTime = 0, testTime = 0;
+
+	for (uint32 i = 0; i < warmup + frames; i++)
+	{
+		const float theta = i * 0.01f;
+		const Matrix vp = proj * Matrix::CreateLookIn(Vector3(), Vector3(cosf(theta), 0.0f, sinf(theta)), Vector3::Up());
+		const bool measure = i >= warmup;
+
+		Stopwatch timer = Stopwatch::StartNew();
+		buffer.Clear(vp);
+		for (const Matrix &transform : walls) buffer.Add(wall, transform);
+		buffer.Rasterize();
+
+		if (measure)
+		{
+			rasterTime += timer.Microseconds();
+			triangles += buffer.GetTriangleCount();
+		}
+
+		timer.Restart();
+		uint64 cnt = 0;
+		for (const AABB &box : boxes) cnt += buffer.IsVisible(box);
+
+		if (measure)
+		{
+			testTime += timer.Microseconds();
+			visible += cnt;
+		}
+	}
+
+	const double n = static_cast<double>(frames);
+	string json = "\t{\n\t\t\"scene\": \"occlusion_cull\"";
+	json += ",\n\t\t\"bodies\": " + string::from(static_cast<uint64>(CullingObjects));
+	json += ",\n\t\t\"frames\": " + string::from(frames);
+	json += ",\n\t\t\"resolution\": \"" + string::from(OcclusionBufferWidth) + "x" + string::from(OcclusionBufferHeight) + "\"";
+	json += ",\n\t\t\"rasterize_us\": " + string::from(rasterTime / n);
+	json += ",\n\t\t\"test_us\": " + string::from(testTime / n);
+	json += ",\n\t\t\"occluder_triangles\": " + string::from(triangles / n);
+	json += ",\n\t\t\"visible\": " + string::from(visible / n);
+	json += "\n\t}";
+	return json;
+}
\ No newline at end of file
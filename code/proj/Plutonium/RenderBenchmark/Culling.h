@@ -0,0 +1,10 @@
+#pragma once
+#include <Core/String.h>
+
+/* Defines the amount of bounding boxes used by the flat culling tests. */
+constexpr size_t CullingObjects = 100000;
+
+/* Runs the frustum culling benchmark and returns the results as a JSON object. */
+Pu::string RunCulling(Pu::uint32 frames, Pu::uint32 warmup);
+/* Runs the occlusion culling benchmark and returns the results as a JSON object. */
+Pu::string RunOcclusion(Pu::uint32 frames, Pu::uint32 warmup);
\ No newline at end of file
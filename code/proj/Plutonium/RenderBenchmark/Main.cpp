@@ -0,0 +1,152 @@
+#include "Culling.h"
+#include "Memory.h"
+#include "Text.h"
+#include <Core/Threading/Tasks/Scheduler.h>
+#include <Streams/FileWriter.h>
+
+using namespace Pu;
+
+/* Defines a single rendering or memory benchmark. */
+struct Benchmark
+{
+	const char *Name;
+	string(*Run)(uint32 frames, uint32 warmup);
+};
+
+/* Defines the canonical benchmarks. */
+const Benchmark BENCHMARKS[] =
+{
+	{ "frustum_cull", RunCulling },
+	{ "occlusion_cull", RunOcclusion },
+	{ "sub_allocation", RunSubAllocation },
+	{ "staging_ring", RunStagingRing },
+	{ "measure_string", RunMeasureString }
+};
+
+struct BenchmarkArgs
+{
+	string Output;
+	string Scene;
+	uint32 Frames = 600;
+	uint32 Warmup = 60;
+	bool Help = false;
+};
+
+void logHelp(void)
+{
+	Log::Message(
+		"Usage: RenderBenchmark [option]...\n\n"
+		"Options:\n"
+		"--help				Displays this message.\n"
+		"-o <path>			Specifies the output file (the results are written to stdout by default).\n"
+		"-s <name>			Only runs the specified scene (frustum_cull, occlusion_cull, sub_allocation, staging_ring or measure_string).\n"
+		"-f <frames>		Specifies the amount of measured frames per scene (600 by default).\n"
+		"-w <frames>		Specifies the amount of unmeasured warmup frames per scene (60 by default).");
+}
+
+int initCmdLineArgs(const vector<string> &args, BenchmarkArgs &result)
+{
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		const string &cur = args[i];
+		const bool notLast = i + 1 < args.size();
+
+		if (cur == "--help")				// Help output.
+		{
+			result.Help = true;
+		}
+		else if (cur == "-o" && notLast)	// Output path.
+		{
+			result.Output = args[++i];
+		}
+		else if (cur == "-s" && notLast)	// Scene filter.
+		{
+			result.Scene = args[++i];
+		}
+		else if (cur == "-f" && notLast)	// Measured frames.
+		{
+			result.Frames = static_cast<uint32>(strtoul(args[++i].c_str(), nullptr, 10));
+		}
+		else if (cur == "-w" && notLast)	// Warmup frames.
+		{
+			result.Warmup = static_cast<uint32>(strtoul(args[++i].c_str(), nullptr, 10));
+		}
+		else
+		{
+			Log::Error("'%s' is not recognized as a valid command line argument (or is missing its value)!", cur.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!result.Frames)
+	{
+		Log::Error("The amount of measured frames must be greater than zero!");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int run(const vector<string> &args)
+{
+	BenchmarkArgs finalArgs;
+	if (initCmdLineArgs(args, finalArgs) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (finalArgs.Help)
+	{
+		logHelp();
+		return EXIT_SUCCESS;
+	}
+
+	string json = "[\n";
+	bool first = true;
+
+	for (const Benchmark &benchmark : BENCHMARKS)
+	{
+		if (finalArgs.Scene.length() && finalArgs.Scene != benchmark.Name) continue;
+
+		if (!first) json += ",\n";
+		json += benchmark.Run(finalArgs.Frames, finalArgs.Warmup);
+		first = false;
+	}
+
+	if (first)
+	{
+		Log::Error("Unknown scene '%s'!", finalArgs.Scene.c_str());
+		return EXIT_FAILURE;
+	}
+
+	json += "\n]\n";
+	if (finalArgs.Output.length())
+	{
+		FileWriter writer{ finalArgs.Output.toWide() };
+		writer.Write(json);
+	}
+	else fputs(json.c_str(), stdout);
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		/* The benchmarks only test the CPU side of the renderer, so it can run on machines without a GPU. */
+		TaskScheduler::Start();
+		Log::SetDetails(LogDetails::Type);
+
+		vector<string> args;
+		args.reserve(argc);
+
+		/* Skip the exe identity. */
+		for (int i = 1; i < argc; i++) args.emplace_back(argv[i]);
+		const int code = run(args);
+
+		TaskScheduler::StopWait();
+		return code;
+	}
+	catch (...)
+	{
+		/* Make sure that CI sees a failed state instead of a crash. */
+		return EXIT_FAILURE;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "Memory.h"
+#include <Core/Collections/TLSFAllocator.h>
+#include <Core/Collections/RingAllocator.h>
+#include <Core/Diagnostics/Stopwatch.h>
+#include <Config.h>
+#include <random>
+#include <algorithm>
+
+using namespace Pu;
+
+/*
+The allocator core doesn't know about Vulkan, so the device memory pattern is simulated over a single block.
+Every frame allocates a mix of small (uniform buffer like) and large (texture like) ranges
+and frees a random half of the live ranges, so the block slowly fragments like a long running scene.
+*/
+string RunSubAllocation(uint32 frames, uint32 warmup)
+{
+	std::mt19937 rng{ 0x5EED };
+	std::uniform_int_distribution<uint32> smallSize{ 64, 4096 };
+	std::uniform_int_distribution<uint32> largeSize{ 0x10000, 0x100000 };
+	std::uniform_int_distribution<uint32> alignment{ 4, 12 };
+
+	TLSFAllocator allocator{ DeviceMemoryBlockSize };
+	vector<uint32> live;
+	live.reserve(SubAllocationsPerFrame * 2);
+
+	uint64 failed = 0, allocations = 0;
+	int64 allocTime = 0, freeTime = 0;
+	double fragmentation = 0.0, freeRanges = 0.0;
+
+	for (uint32 i = 0; i < warmup + frames; i++)
+	{
+		/* Generate the requests up front so only the allocator is measured. */
+		uint64 sizes[SubAllocationsPerFrame], alignments[SubAllocationsPerFrame];
+		for (size_t j = 0; j < SubAllocationsPerFrame; j++)
+		{
+			sizes[j] = (j & 63) ? smallSize(rng) : largeSize(rng);
+			alignments[j] = 1ull << alignment(rng);
+		}
+
+		Stopwatch timer = Stopwatch::StartNew();
+		uint32 misses = 0;
+		for (size_t j = 0; j < SubAllocationsPerFrame; j++)
+		{
+			uint64 offset;
+			const uint32 handle = allocator.Allocate(sizes[j], alignments[j], offset);
+			if (handle != TLSFAllocator::InvalidHandle) live.emplace_back(handle);
+			else ++misses;
+		}
+
+		const int64 allocElapsed = timer.Microseconds();
+		std::shuffle(live.begin(), live.end(), rng);
+		const size_t keep = live.size() >> 1;
+
+		timer.Restart();
+		for (size_t j = keep; j < live.size(); j++) allocator.Free(live[j]);
+		const int64 freeElapsed = timer.Microseconds();
+		live.resize(keep);
+
+		if (i >= warmup)
+		{
+			allocTime += allocElapsed;
+			freeTime += freeElapsed;
+			failed += misses;
+			allocations += SubAllocationsPerFrame;
+			fragmentation += allocator.GetFragmentation();
+			freeRanges += allocator.GetFreeRangeCount();
+		}
+	}
+
+	const double n = static_cast<double>(frames);
+	string json = "\t{\n\t\t\"scene\": \"sub_allocation\"";
+	json += ",\n\t\t\"frames\": " + string::from(frames);
+	json += ",\n\t\t\"block_size\": " + string::from(static_cast<uint64>(DeviceMemoryBlockSize));
+	json += ",\n\t\t\"alloc_us\": " + string::from(allocTime / n);
+	json += ",\n\t\t\"free_us\": " + string::from(freeTime / n);
+	json += ",\n\t\t\"failed_allocations\": " + string::from(failed);
+	json += ",\n\t\t\"total_allocations\": " + string::from(allocations);
+	json += ",\n\t\t\"free_ranges\": " + string::from(freeRanges / n);
+	json += ",\n\t\t\"fragmentation\": " + string::from(fragmentation / n);
+	json += "\n\t}";
+	return json;
+}
+
+/*
+The staging ring is simulated with a fixed GPU latency,
+a batch is submitted every frame and its memory is released a few frames later (like a fence being signaled).
+The uploads are mostly small (uniform and mesh data) with an occasional texture sized upload.
+*/
+string RunStagingRing(uint32 frames, uint32 warmup)
+{
+	constexpr uint64 latency = 3;
+
+	std::mt19937 rng{ 0x5EED };
+	std::uniform_int_distribution<uint32> smallSize{ 256, 0x10000 };
+	std::uniform_int_distribution<uint32> largeSize{ 0x100000, 0x400000 };
+
+	RingAllocator ring{ StagingRingSize };
+	uint64 staged = 0, stalls = 0, peak = 0;
+	int64 time = 0;
+
+	for (uint32 i = 0; i < warmup + frames; i++)
+	{
+		uint64 sizes[StagingUploadsPerFrame];
+		for (size_t j = 0; j < StagingUploadsPerFrame; j++) sizes[j] = (j & 127) ? smallSize(rng) : largeSize(rng);
+
+		Stopwatch timer = Stopwatch::StartNew();
+		uint64 bytes = 0, misses = 0;
+		for (size_t j = 0; j < StagingUploadsPerFrame; j++)
+		{
+			/* A full ring would wait for the oldest batch, so release everything that was submitted before this frame. */
+			uint64 offset;
+			if (!ring.Allocate(sizes[j], 16, offset))
+			{
+				++misses;
+				ring.Release(i);
+				if (!ring.Allocate(sizes[j], 16, offset)) continue;
+			}
+
+			bytes += sizes[j];
+		}
+
+		ring.Commit(i + 1);
+		if (i + 1 > latency) ring.Release(i + 1 - latency);
+		const int64 elapsed = timer.Microseconds();
+
+		if (i >= warmup)
+		{
+			time += elapsed;
+			staged += bytes;
+			stalls += misses;
+			if (ring.GetUsedSize() > peak) peak = ring.GetUsedSize();
+		}
+	}
+
+	const double n = static_cast<double>(frames);
+	string json = "\t{\n\t\t\"scene\": \"staging_ring\"";
+	json += ",\n\t\t\"frames\": " + string::from(frames);
+	json += ",\n\t\t\"ring_size\": " + string::from(static_cast<uint64>(StagingRingSize));
+	json += ",\n\t\t\"stage_us\": " + string::from(time / n);
+	json += ",\n\t\t\"staged_mb_per_frame\": " + string::from(staged / n / 1048576.0);
+	json += ",\n\t\t\"throughput_gb_per_s\": " + string::from(time ? staged / (time * 1000.0) : 0.0);
+	json += ",\n\t\t\"stalls\": " + string::from(stalls);
+	json += ",\n\t\t\"peak_usage\": " + string::from(peak);
+	json += "\n\t}";
+	return json;
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#include <Core/String.h>
+
+/* Defines the amount of ranges that are allocated and freed every frame by the sub-allocation test. */
+constexpr size_t SubAllocationsPerFrame = 4096;
+
+/* Defines the amount of uploads that are staged every frame by the staging ring test. */
+constexpr size_t StagingUploadsPerFrame = 1024;
+
+/* Runs the device memory sub-allocation benchmark and returns the results as a JSON object. */
+Pu::string RunSubAllocation(Pu::uint32 frames, Pu::uint32 warmup);
+/* Runs the staging ring bookkeeping benchmark and returns the results as a JSON object. */
+Pu::string RunStagingRing(Pu::uint32 frames, Pu::uint32 warmup);
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "Text.h"
+#include <Graphics/Text/Font.h>
+#include <Core/Diagnostics/Stopwatch.h>
+#include <random>
+
+using namespace Pu;
+
+/*
+Only the glyph metrics of the font are loaded, so the test doesn't need a device.
+The strings are mostly ASCII (direct lookup) with some punctuation and symbols above the direct range (hashed lookup) mixed in,
+the kerning is looked up for every pair of characters, so this matches the cost of laying out UI text.
+*/
+string RunMeasureString(uint32 frames, uint32 warmup)
+{
+	constexpr char32 sparse[] = { U'\x2013', U'\x2014', U'\x2018', U'\x2019', U'\x201C', U'\x201D', U'\x2026', U'\x20AC' };
+
+	Font font{ 24.0f, CodeChart(0x0020, 0x007E) + CodeChart(0x2010, 0x2030) + CodeChart(0x20AC, 0x20AC) };
+	font.LoadMetrics(L"../assets/fonts/OpenSans-Regular.ttf");
+
+	std::mt19937 rng{ 0x5EED };
+	std::uniform_int_distribution<uint32> length{ 8, 64 };
+	std::uniform_int_distribution<uint32> ascii{ 0x20, 0x7E };
+	std::uniform_int_distribution<uint32> kind{ 0, 31 };
+
+	vector<ustring> strings(MeasuredStringsPerFrame);
+	uint64 characters = 0;
+	for (ustring &str : strings)
+	{
+		const uint32 count = length(rng);
+		for (uint32 i = 0; i < count; i++)
+		{
+			const uint32 k = kind(rng);
+			if (k < 2) str += sparse[rng() % std::size(sparse)];
+			else if (k < 3) str += U'\n';
+			else str += static_cast<char32>(ascii(rng));
+		}
+
+		characters += count;
+	}
+
+	int64 time = 0;
+	float checksum = 0.0f;
+	for (uint32 i = 0; i < warmup + frames; i++)
+	{
+		const Stopwatch timer = Stopwatch::StartNew();
+		for (const ustring &str : strings) checksum += font.MeasureString(str).X;
+		const int64 elapsed = timer.Microseconds();
+
+		if (i >= warmup) time += elapsed;
+	}
+
+	const double n = static_cast<double>(frames);
+	string json = "\t{\n\t\t\"scene\": \"measure_string\"";
+	json += ",\n\t\t\"frames\": " + string::from(frames);
+	json += ",\n\t\t\"strings\": " + string::from(static_cast<uint64>(MeasuredStringsPerFrame));
+	json += ",\n\t\t\"measure_us\": " + string::from(time / n);
+	json += ",\n\t\t\"ns_per_char\": " + string::from(time * 1000.0 / (n * characters));
+	json += ",\n\t\t\"mchars_per_s\": " + string::from(time ? characters * n / time : 0.0);
+	json += ",\n\t\t\"checksum\": " + string::from(checksum);
+	json += "\n\t}";
+	return json;
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+#include <Core/String.h>
+
+/* Defines the amount of strings that are measured every frame by the text measuring test. */
+constexpr size_t MeasuredStringsPerFrame = 2048;
+
+/* Runs the font string measuring benchmark and returns the results as a JSON object. */
+Pu::string RunMeasureString(Pu::uint32 frames, Pu::uint32 warmup);
\ No newline at end of file
@@ -24,6 +24,7 @@ void TestGame::EnableFeatures(const PhysicalDeviceFeatures & supported, Physical
 	enabeled.FillModeNonSolid = supported.FillModeNonSolid;					// Easy wireframe mode
 	enabeled.SamplerAnisotropy = supported.SamplerAnisotropy;				// Textures are loaded with 4 anisotropy by default
 	enabeled.PipelineStatisticsQuery = supported.PipelineStatisticsQuery;	// Nice for performance testing, but optional
+	enabeled.InheritedQueries = supported.InheritedQueries;				// Needed to record geometry in parallel on debug mode
 
 	extensions.emplace_back("VK_EXT_line_rasterization");					// Smoother debug lines.
 }
@@ -0,0 +1,65 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Graphics/Resources/CommandList.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(CommandList)
+	{
+	public:
+		TEST_METHOD(EncodeArguments)
+		{
+			Pu::CommandList list;
+			list.BindGraphicsPipeline(*Fake<Pu::GraphicsPipeline>(1));
+			list.BindVertexBuffer(1, *Fake<Pu::Buffer>(2), 64);
+			list.BindIndexBuffer(Pu::IndexType::UInt32, *Fake<Pu::Buffer>(3), 128);
+			list.Draw(36, 4, 6, 8, -2);
+
+			Assert::AreEqual(size_t(4), list.size(), L"Command list contains an incorrect amount of commands!");
+			Assert::AreEqual(1u, list.GetDrawCount(), L"Command list did not count the draw command!");
+
+			const Pu::vector<Pu::EncodedCommand> &cmds = list.GetCommands();
+			Assert::IsTrue(cmds[1].Type == Pu::CommandType::BindVertexBuffer, L"Vertex buffer bind has an incorrect type!");
+			Assert::AreEqual(1u, cmds[1].Args[0], L"Vertex buffer bind has an incorrect binding!");
+			Assert::AreEqual(64ull, cmds[1].Offset, L"Vertex buffer bind has an incorrect offset!");
+			Assert::IsTrue(cmds[3].Type == Pu::CommandType::DrawIndexed, L"Indexed draw has an incorrect type!");
+			Assert::AreEqual(-2, static_cast<int>(cmds[3].Args[4]), L"Indexed draw has an incorrect vertex offset!");
+			Assert::IsTrue(cmds[3].Gfx == Fake<Pu::GraphicsPipeline>(1), L"Draw did not store the active pipeline!");
+		}
+
+		TEST_METHOD(ValidateSelfContained)
+		{
+			Pu::CommandList list;
+			list.BindGraphicsPipeline(*Fake<Pu::GraphicsPipeline>(1));
+			list.BindGraphicsDescriptor(*Fake<Pu::DescriptorSet>(2));
+			list.BindVertexBuffer(0, *Fake<Pu::Buffer>(3), 0);
+			list.Draw(3, 1, 0, 0);
+
+			Assert::IsTrue(list.Validate(), L"Self contained command list did not pass validation!");
+		}
+
+		TEST_METHOD(ValidateMissingState)
+		{
+			Pu::CommandList list;
+			list.BindVertexBuffer(0, *Fake<Pu::Buffer>(1), 0);
+			list.Draw(3, 1, 0, 0);
+			Assert::IsFalse(list.Validate(), L"Draw without a pipeline passed validation!");
+
+			list.Clear();
+			list.BindGraphicsPipeline(*Fake<Pu::GraphicsPipeline>(1));
+			list.BindVertexBuffer(0, *Fake<Pu::Buffer>(1), 0);
+			list.Draw(3, 1, 0, 0, 0);
+			Assert::IsFalse(list.Validate(), L"Indexed draw without an index buffer passed validation!");
+		}
+
+	private:
+		/* The command list never dereferences its resources, so fake addresses can be used without a device. */
+		template <typename resource_t>
+		static const resource_t* Fake(uintptr_t id)
+		{
+			return reinterpret_cast<const resource_t*>(id * 0x10);
+		}
+	};
+}
\ No newline at end of file
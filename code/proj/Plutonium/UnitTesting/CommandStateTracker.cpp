@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Graphics/Vulkan/CommandStateTracker.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(CommandStateTracker)
+	{
+	public:
+		TEST_METHOD(ElideRedundantBinds)
+		{
+			Pu::CommandStateTracker tracker{ MockDispatch() };
+			calls = 0;
+
+			Assert::IsTrue(tracker.BindPipeline(nullptr, Pu::PipelineBindPoint::Graphics, Fake(1)), L"First pipeline bind was not issued!");
+			Assert::IsFalse(tracker.BindPipeline(nullptr, Pu::PipelineBindPoint::Graphics, Fake(1)), L"Redundant pipeline bind was issued!");
+			Assert::IsTrue(tracker.BindPipeline(nullptr, Pu::PipelineBindPoint::Compute, Fake(1)), L"Pipeline bind on different bind point was elided!");
+			Assert::IsTrue(tracker.BindVertexBuffer(nullptr, 0, Fake(2), 0), L"First vertex buffer bind was not issued!");
+			Assert::IsFalse(tracker.BindVertexBuffer(nullptr, 0, Fake(2), 0), L"Redundant vertex buffer bind was issued!");
+			Assert::IsTrue(tracker.BindVertexBuffer(nullptr, 0, Fake(2), 64), L"Vertex buffer bind with different offset was elided!");
+			Assert::IsTrue(tracker.BindIndexBuffer(nullptr, Fake(3), 0, Pu::IndexType::UInt16), L"First index buffer bind was not issued!");
+			Assert::IsTrue(tracker.BindIndexBuffer(nullptr, Fake(3), 0, Pu::IndexType::UInt32), L"Index buffer bind with different type was elided!");
+
+			Assert::AreEqual(6u, calls, L"Mock dispatch table received an incorrect amount of calls!");
+			Assert::AreEqual(6u, tracker.GetIssuedCount(), L"Tracker counted an incorrect amount of issued commands!");
+			Assert::AreEqual(2u, tracker.GetElidedCount(), L"Tracker counted an incorrect amount of elided commands!");
+
+			tracker.Invalidate();
+			Assert::IsTrue(tracker.BindPipeline(nullptr, Pu::PipelineBindPoint::Graphics, Fake(1)), L"Pipeline bind after invalidate was elided!");
+		}
+
+		TEST_METHOD(DescriptorLayoutChange)
+		{
+			Pu::CommandStateTracker tracker{ MockDispatch() };
+			calls = 0;
+
+			Assert::IsTrue(tracker.BindDescriptorSet(nullptr, Pu::PipelineBindPoint::Graphics, Fake(1), 0, Fake(2)), L"First descriptor bind was not issued!");
+			Assert::IsTrue(tracker.BindDescriptorSet(nullptr, Pu::PipelineBindPoint::Graphics, Fake(1), 1, Fake(3)), L"Descriptor bind to different set was elided!");
+			Assert::IsFalse(tracker.BindDescriptorSet(nullptr, Pu::PipelineBindPoint::Graphics, Fake(1), 0, Fake(2)), L"Redundant descriptor bind was issued!");
+			Assert::IsTrue(tracker.BindDescriptorSet(nullptr, Pu::PipelineBindPoint::Graphics, Fake(4), 0, Fake(2)), L"Descriptor bind with different layout was elided!");
+			Assert::IsTrue(tracker.BindDescriptorSet(nullptr, Pu::PipelineBindPoint::Graphics, Fake(4), 1, Fake(3)), L"Descriptor set disturbed by layout change was elided!");
+			Assert::AreEqual(4u, calls, L"Mock dispatch table received an incorrect amount of calls!");
+		}
+
+		TEST_METHOD(UntrackedBindPoint)
+		{
+			Pu::CommandStateTracker tracker{ MockDispatch() };
+			const Pu::PipelineBindPoint point = static_cast<Pu::PipelineBindPoint>(1000165000);
+			calls = 0;
+
+			Assert::IsTrue(tracker.BindPipeline(nullptr, point, Fake(1)), L"First untracked pipeline bind was not issued!");
+			Assert::IsTrue(tracker.BindPipeline(nullptr, point, Fake(1)), L"Untracked pipeline bind was elided!");
+			Assert::IsTrue(tracker.BindDescriptorSet(nullptr, point, Fake(2), 0, Fake(3)), L"First untracked descriptor bind was not issued!");
+			Assert::IsTrue(tracker.BindDescriptorSet(nullptr, point, Fake(2), 0, Fake(3)), L"Untracked descriptor bind was elided!");
+			Assert::AreEqual(4u, calls, L"Mock dispatch table received an incorrect amount of calls!");
+		}
+
+		TEST_METHOD(PushConstantRanges)
+		{
+			Pu::CommandStateTracker tracker{ MockDispatch() };
+			const float a[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+			const float b[4] = { 1.0f, 2.0f, 3.0f, 5.0f };
+			calls = 0;
+
+			Assert::IsTrue(tracker.PushConstants(nullptr, Fake(1), Pu::ShaderStageFlags::Vertex, 0, sizeof(a), a), L"First push was not issued!");
+			Assert::IsTrue(tracker.PushConstants(nullptr, Fake(1), Pu::ShaderStageFlags::Fragment, 16, sizeof(b), b), L"Push to different range was not issued!");
+			Assert::IsFalse(tracker.PushConstants(nullptr, Fake(1), Pu::ShaderStageFlags::Vertex, 0, sizeof(a), a), L"Redundant push was issued!");
+			Assert::IsFalse(tracker.PushConstants(nullptr, Fake(1), Pu::ShaderStageFlags::Vertex, 4, sizeof(float), a + 1), L"Redundant sub range push was issued!");
+			Assert::IsTrue(tracker.PushConstants(nullptr, Fake(1), Pu::ShaderStageFlags::Vertex, 0, sizeof(b), b), L"Push with different values was elided!");
+			Assert::IsTrue(tracker.PushConstants(nullptr, Fake(1), Pu::ShaderStageFlags::Fragment, 0, sizeof(b), b), L"Push with different stage was elided!");
+			Assert::IsTrue(tracker.PushConstants(nullptr, Fake(2), Pu::ShaderStageFlags::Fragment, 0, sizeof(b), b), L"Push with different layout was elided!");
+			Assert::IsTrue(tracker.PushConstants(nullptr, Fake(2), Pu::ShaderStageFlags::Vertex, 256, sizeof(a), a), L"First untracked push was not issued!");
+			Assert::IsTrue(tracker.PushConstants(nullptr, Fake(2), Pu::ShaderStageFlags::Vertex, 256, sizeof(a), a), L"Untracked push was elided!");
+			Assert::AreEqual(7u, calls, L"Mock dispatch table received an incorrect amount of calls!");
+		}
+
+	private:
+		static inline Pu::uint32 calls = 0;
+
+		/* The tracker never dereferences its handles, so fake addresses can be used without a device. */
+		static void* Fake(uintptr_t id)
+		{
+			return reinterpret_cast<void*>(id * 0x10);
+		}
+
+		/* The mock procedures only count how many commands actually reached the dispatch table. */
+		static Pu::CommandDispatchTable MockDispatch(void)
+		{
+			Pu::CommandDispatchTable result;
+			result.BindPipeline = [](Pu::CommandBufferHndl, Pu::PipelineBindPoint, Pu::PipelineHndl) { ++calls; };
+			result.BindVertexBuffers = [](Pu::CommandBufferHndl, Pu::uint32, Pu::uint32, const Pu::BufferHndl*, const Pu::DeviceSize*) { ++calls; };
+			result.BindIndexBuffer = [](Pu::CommandBufferHndl, Pu::BufferHndl, Pu::DeviceSize, Pu::IndexType) { ++calls; };
+			result.BindDescriptorSets = [](Pu::CommandBufferHndl, Pu::PipelineBindPoint, Pu::PipelineLayoutHndl, Pu::uint32, Pu::uint32, const Pu::DescriptorSetHndl*, Pu::uint32, const Pu::uint32*) { ++calls; };
+			result.PushConstants = [](Pu::CommandBufferHndl, Pu::PipelineLayoutHndl, Pu::ShaderStageFlags, Pu::uint32, Pu::uint32, const void*) { ++calls; };
+			return result;
+		}
+	};
+}
\ No newline at end of file
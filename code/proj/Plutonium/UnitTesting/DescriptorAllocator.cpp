@@ -0,0 +1,149 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Graphics/Vulkan/DescriptorAllocator.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(DescriptorAllocator)
+	{
+	public:
+		TEST_METHOD(ChainOnExhaustion)
+		{
+			pools.clear();
+			Pu::DescriptorAllocator allocator{ MockDispatch(), {}, 4, 1 };
+
+			Pu::vector<Pu::uint32> owners;
+			Pu::vector<Pu::DescriptorSetHndl> sets;
+			for (Pu::uint32 i = 0; i < 10; i++)
+			{
+				Pu::DescriptorSetHndl set;
+				owners.emplace_back(allocator.Allocate(Fake(1), &set));
+				sets.emplace_back(set);
+			}
+
+			Assert::AreEqual(3u, allocator.GetPoolCount(), L"Exhausted pools were not chained!");
+			Assert::AreEqual(0u, owners[3], L"Set was not allocated from the first pool!");
+			Assert::AreEqual(2u, owners[9], L"Set was not allocated from the last pool!");
+
+			/* Freeing a set from an exhausted pool should make that pool available again. */
+			allocator.Free(owners[1], sets[1]);
+			allocator.Free(owners[2], sets[2]);
+
+			Pu::DescriptorSetHndl set;
+			Assert::AreEqual(0u, allocator.Allocate(Fake(1), &set), L"Freed space was not reused!");
+			Assert::AreEqual(0u, allocator.Allocate(Fake(1), &set), L"Freed space was not reused!");
+			Assert::AreEqual(2u, allocator.Allocate(Fake(1), &set), L"Allocation did not continue in the last pool!");
+			Assert::AreEqual(3u, allocator.GetPoolCount(), L"Pool was chained while there was still space!");
+		}
+
+		TEST_METHOD(ResetReusesPools)
+		{
+			pools.clear();
+			Pu::DescriptorAllocator allocator{ MockDispatch(), {}, 4, 1 };
+
+			Pu::DescriptorSetHndl set;
+			for (Pu::uint32 i = 0; i < 8; i++) static_cast<void>(allocator.Allocate(Fake(1), &set));
+			allocator.Reset();
+			for (Pu::uint32 i = 0; i < 8; i++) static_cast<void>(allocator.Allocate(Fake(1), &set));
+
+			Assert::AreEqual(2u, allocator.GetPoolCount(), L"Pools were chained after a reset!");
+		}
+
+		TEST_METHOD(TransientFrames)
+		{
+			pools.clear();
+			Pu::DescriptorAllocator allocator{ MockDispatch(), {}, 8, 2 };
+
+			for (Pu::uint32 frame = 0; frame < 6; frame++)
+			{
+				allocator.BeginFrame(frame);
+				for (Pu::uint32 i = 0; i < 20; i++) static_cast<void>(allocator.AllocateTransient(Fake(1)));
+			}
+
+			/* Every frame needs 3 pools, these should be recycled instead of chaining new pools every frame. */
+			Assert::AreEqual(6u, allocator.GetTransientPoolCount(), L"Transient pools were not recycled!");
+			Assert::AreEqual(0u, allocator.GetPoolCount(), L"Transient sets were allocated from persistent pools!");
+		}
+
+		TEST_METHOD(CachedSets)
+		{
+			pools.clear();
+			Pu::DescriptorAllocator allocator{ MockDispatch(), {}, 4, 1 };
+			Pu::DescriptorSetHndl a, b, c;
+
+			Assert::IsTrue(allocator.AllocateCached(Fake(1), { 1, 2 }, &a), L"First cached set was not allocated!");
+			Assert::IsFalse(allocator.AllocateCached(Fake(1), { 1, 2 }, &b), L"Cached set was allocated twice!");
+			Assert::IsTrue(a == b, L"Cache returned a different set for the same resources!");
+			Assert::IsTrue(allocator.AllocateCached(Fake(1), { 2, 1 }, &c), L"Set with different resources was returned from the cache!");
+			Assert::IsTrue(allocator.AllocateCached(Fake(2), { 1, 2 }, &c), L"Set with a different layout was returned from the cache!");
+			Assert::AreEqual(3u, allocator.GetCachedSetCount(), L"Cache contains an incorrect amount of sets!");
+
+			allocator.Reset();
+			Assert::AreEqual(0u, allocator.GetCachedSetCount(), L"Cache was not cleared on reset!");
+			Assert::IsTrue(allocator.AllocateCached(Fake(1), { 1, 2 }, &a), L"Cached set survived a reset!");
+		}
+
+	private:
+		struct MockPool
+		{
+			Pu::uint32 Used;
+			Pu::uint32 Max;
+		};
+
+		static inline Pu::vector<MockPool> pools;
+		static inline Pu::uint64 setCounter = 0;
+
+		/* The allocator never dereferences its handles, so fake addresses can be used without a device. */
+		static void* Fake(uintptr_t id)
+		{
+			return reinterpret_cast<void*>(id * 0x10);
+		}
+
+		/* The mock pools only keep track of how many sets are allocated from them, pool handles are their index plus one. */
+		static Pu::DescriptorDispatchTable MockDispatch(void)
+		{
+			Pu::DescriptorDispatchTable result;
+			result.Device = nullptr;
+
+			result.CreateDescriptorPool = [](Pu::DeviceHndl, const Pu::DescriptorPoolCreateInfo *info, const Pu::AllocationCallbacks*, Pu::DescriptorPoolHndl *pool)
+			{
+				pools.emplace_back(MockPool{ 0, info->MaxSets });
+				*pool = reinterpret_cast<Pu::DescriptorPoolHndl>(pools.size());
+				return Pu::VkApiResult::Success;
+			};
+
+			result.DestroyDescriptorPool = [](Pu::DeviceHndl, Pu::DescriptorPoolHndl, const Pu::AllocationCallbacks*) {};
+
+			result.ResetDescriptorPool = [](Pu::DeviceHndl, Pu::DescriptorPoolHndl pool, Pu::uint32)
+			{
+				Get(pool).Used = 0;
+				return Pu::VkApiResult::Success;
+			};
+
+			result.AllocateDescriptorSets = [](Pu::DeviceHndl, const Pu::DescriptorSetAllocateInfo *info, Pu::DescriptorSetHndl *sets)
+			{
+				MockPool &pool = Get(info->DescriptorPool);
+				if (pool.Used >= pool.Max) return Pu::VkApiResult::OutOfPoolMemory;
+
+				++pool.Used;
+				*sets = reinterpret_cast<Pu::DescriptorSetHndl>(++setCounter);
+				return Pu::VkApiResult::Success;
+			};
+
+			result.FreeDescriptorSets = [](Pu::DeviceHndl, Pu::DescriptorPoolHndl pool, Pu::uint32 count, const Pu::DescriptorSetHndl*)
+			{
+				Get(pool).Used -= count;
+				return Pu::VkApiResult::Success;
+			};
+
+			return result;
+		}
+
+		static MockPool& Get(Pu::DescriptorPoolHndl hndl)
+		{
+			return pools[reinterpret_cast<uintptr_t>(hndl) - 1];
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Graphics/Text/Font.h>
+#include <Streams/FileReader.h>
+#include <stb/stb/stb_truetype.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(FontLookup)
+	{
+	public:
+		TEST_METHOD(DirectAndSparseGlyphs)
+		{
+			/* The general punctuation and currency symbols are above the direct range, so they end up in the hash map. */
+			Pu::Font font{ FontSize, GetCodeChart() };
+			font.LoadMetrics(FontPath);
+			const stbtt_fontinfo info = GetReference();
+			Assert::IsTrue(U'\x2013' >= Pu::FontDirectLookupSize, L"Test characters are not outside of the direct range!");
+
+			const Pu::char32 fallback = font.GetGlyph(U'?').Key;
+			for (Pu::char32 key : GetCodeChart())
+			{
+				const Pu::char32 expected = stbtt_FindGlyphIndex(&info, static_cast<int>(key)) ? key : fallback;
+				Assert::AreEqual(static_cast<Pu::uint32>(expected), static_cast<Pu::uint32>(font.GetGlyph(key).Key), L"Loaded character returned the wrong glyph!");
+			}
+
+			/* Characters that weren't loaded should return the default glyph, both in and outside of the direct range. */
+			Assert::AreEqual(static_cast<Pu::uint32>(fallback), static_cast<Pu::uint32>(font.GetGlyph(U'\x100').Key), L"Unloaded direct character didn't return the default glyph!");
+			Assert::AreEqual(static_cast<Pu::uint32>(fallback), static_cast<Pu::uint32>(font.GetGlyph(U'\x3042').Key), L"Unloaded sparse character didn't return the default glyph!");
+		}
+
+		TEST_METHOD(KerningMatchesReference)
+		{
+			Pu::Font font{ FontSize, GetCodeChart() };
+			font.LoadMetrics(FontPath);
+			const stbtt_fontinfo info = GetReference();
+			const float scale = stbtt_ScaleForMappingEmToPixels(&info, FontSize);
+
+			size_t kerned = 0;
+			for (Pu::char32 first : GetCodeChart())
+			{
+				if (!stbtt_FindGlyphIndex(&info, static_cast<int>(first))) continue;
+				for (Pu::char32 second : GetCodeChart())
+				{
+					if (!stbtt_FindGlyphIndex(&info, static_cast<int>(second))) continue;
+
+					const float expected = stbtt_GetCodepointKernAdvance(&info, static_cast<int>(first), static_cast<int>(second)) * scale;
+					Assert::AreEqual(expected, font.GetKerning(first, second), 0.0001f, L"Kerning differs from stb_truetype!");
+					if (expected != 0.0f) ++kerned;
+				}
+			}
+
+			/* Make sure the test font actually has a kerning table, otherwise the test is meaningless. */
+			Assert::IsTrue(kerned > 0, L"Test font has no kerning pairs!");
+		}
+
+	private:
+		static constexpr float FontSize = 24.0f;
+		static inline const Pu::wstring FontPath = L"../assets/fonts/OpenSans-Regular.ttf";
+		static inline Pu::string data;
+
+		static Pu::CodeChart GetCodeChart(void)
+		{
+			return Pu::CodeChart(0x0020, 0x007E) + Pu::CodeChart(0x2010, 0x2030) + Pu::CodeChart(0x20AC, 0x20AC);
+		}
+
+		static stbtt_fontinfo GetReference(void)
+		{
+			Pu::FileReader reader{ FontPath };
+			data = reader.ReadToEnd();
+
+			stbtt_fontinfo result;
+			stbtt_InitFont(&result, reinterpret_cast<unsigned char*>(data.data()), 0);
+			return result;
+		}
+	};
+}
\ No newline at end of file
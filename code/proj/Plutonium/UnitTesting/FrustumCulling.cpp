@@ -0,0 +1,86 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Physics/Objects/BVH.h>
+#include <Physics/Systems/ShapeTests.h>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(FrustumCulling)
+	{
+	public:
+		TEST_METHOD(BatchMatchesScalar)
+		{
+			const Pu::Frustum frustum = CreateFrustum();
+			Pu::AVX_FRUSTUM planes;
+			Pu::_mm256_set1_frustum(planes, frustum);
+
+			std::mt19937 rng{ 0x5EED };
+			for (size_t i = 0; i < 128; i++)
+			{
+				Pu::AABB boxes[8];
+				Pu::AVX_VEC3_UNION lower, upper;
+				for (size_t j = 0; j < 8; j++)
+				{
+					boxes[j] = CreateBox(rng);
+					Pu::_mm256_seti_v3(lower, boxes[j].LowerBound.X, boxes[j].LowerBound.Y, boxes[j].LowerBound.Z, j);
+					Pu::_mm256_seti_v3(upper, boxes[j].UpperBound.X, boxes[j].UpperBound.Y, boxes[j].UpperBound.Z, j);
+				}
+
+				uint32_t inside;
+				const uint32_t hits = Pu::intersects(planes, lower, upper, inside);
+				Assert::AreEqual(0u, inside & ~hits, L"Box was marked as inside, but not as intersecting!");
+
+				for (size_t j = 0; j < 8; j++)
+				{
+					Assert::AreEqual(Pu::intersects(frustum, boxes[j]), (hits & (1u << j)) != 0, L"AVX frustum test differs from the scalar test!");
+				}
+			}
+		}
+
+		TEST_METHOD(TreeMatchesBruteForce)
+		{
+			const Pu::Frustum frustum = CreateFrustum();
+			std::mt19937 rng{ 0x5EED };
+			Pu::BVH tree;
+			Pu::vector<Pu::PhysicsHandle> expected;
+
+			for (size_t i = 0; i < 1000; i++)
+			{
+				const Pu::AABB box = CreateBox(rng);
+				const Pu::PhysicsHandle handle = Pu::create_physics_handle(Pu::PhysicsType::Static, i);
+
+				tree.Insert(handle, box);
+				if (Pu::intersects(frustum, box)) expected.emplace_back(handle);
+			}
+
+			Pu::vector<Pu::PhysicsHandle> result;
+			tree.Frustumcast(frustum, result);
+
+			/* Fully visible branches are accepted early, but that should never change the result. */
+			Assert::AreEqual(expected.size(), result.size(), L"Frustum cast returned an incorrect amount of objects!");
+			for (const Pu::PhysicsHandle handle : result)
+			{
+				Assert::IsTrue(expected.contains(handle), L"Frustum cast returned an object that is not in the frustum!");
+			}
+		}
+
+	private:
+		static Pu::Frustum CreateFrustum(void)
+		{
+			const Pu::Matrix proj = Pu::Matrix::CreatePerspective(Pu::PI4, 1.0f, 0.1f, 100.0f);
+			return Pu::Frustum{ proj * Pu::Matrix::CreateLookIn(Pu::Vector3(), Pu::Vector3::Forward(), Pu::Vector3::Up()) };
+		}
+
+		static Pu::AABB CreateBox(std::mt19937 &rng)
+		{
+			std::uniform_real_distribution<float> position{ -100.0f, 100.0f };
+			std::uniform_real_distribution<float> size{ 0.5f, 10.0f };
+
+			const Pu::Vector3 lower{ position(rng), position(rng), position(rng) };
+			return Pu::AABB{ lower, lower + Pu::Vector3(size(rng), size(rng), size(rng)) };
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Graphics/Models/InstanceBatcher.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(InstanceBatcher)
+	{
+	public:
+		TEST_METHOD(SortOnSubpassAndModel)
+		{
+			Pu::InstanceBatcher batcher;
+			batcher.Add(2, 0, Pu::Matrix::CreateTranslation(0.0f, 0.0f, 0.0f));
+			batcher.Add(1, 1, Pu::Matrix::CreateTranslation(1.0f, 0.0f, 0.0f));
+			batcher.Add(1, 0, Pu::Matrix::CreateTranslation(2.0f, 0.0f, 0.0f));
+			batcher.Add(1, 1, Pu::Matrix::CreateTranslation(3.0f, 0.0f, 0.0f));
+			batcher.Pack(16);
+
+			const Pu::vector<Pu::InstanceBatch> &batches = batcher.GetBatches();
+			Assert::AreEqual(size_t(3), batches.size(), L"Instances were not grouped into the correct amount of batches!");
+			AssertBatch(batches[0], 1, 0, 0, 1);
+			AssertBatch(batches[1], 1, 1, 1, 2);
+			AssertBatch(batches[2], 2, 0, 3, 1);
+
+			/* The transforms should be in batch order, with the input order as a tie breaker. */
+			const Pu::vector<Pu::Matrix> &transforms = batcher.GetTransforms();
+			Assert::AreEqual(2.0f, transforms[0].GetTranslation().X, L"Transform was not packed in the correct order!");
+			Assert::AreEqual(1.0f, transforms[1].GetTranslation().X, L"Transform was not packed in the correct order!");
+			Assert::AreEqual(3.0f, transforms[2].GetTranslation().X, L"Transform was not packed in the correct order!");
+			Assert::AreEqual(0.0f, transforms[3].GetTranslation().X, L"Transform was not packed in the correct order!");
+		}
+
+		TEST_METHOD(SplitOnPageBoundary)
+		{
+			Pu::InstanceBatcher batcher;
+			for (uint32_t i = 0; i < 3; i++) batcher.Add(1, 0, Pu::Matrix());
+			for (uint32_t i = 0; i < 6; i++) batcher.Add(1, 1, Pu::Matrix());
+			batcher.Pack(4);
+
+			/* The second model starts at index 3, so it has to be split at index 4 and 8. */
+			const Pu::vector<Pu::InstanceBatch> &batches = batcher.GetBatches();
+			Assert::AreEqual(size_t(4), batches.size(), L"Batches were not split on the page boundaries!");
+			AssertBatch(batches[0], 1, 0, 0, 3);
+			AssertBatch(batches[1], 1, 1, 3, 1);
+			AssertBatch(batches[2], 1, 1, 4, 4);
+			AssertBatch(batches[3], 1, 1, 8, 1);
+		}
+
+		TEST_METHOD(SplitOnLevelOfDetail)
+		{
+			Pu::InstanceBatcher batcher;
+			batcher.Add(1, 1, Pu::Matrix(), 2);
+			batcher.Add(1, 0, Pu::Matrix(), 1);
+			batcher.Add(1, 1, Pu::Matrix(), 0);
+			batcher.Add(1, 1, Pu::Matrix(), 2);
+			batcher.Pack(16);
+
+			/* The levels of a model are adjacent, so the vertex buffer of the model only has to be bound once. */
+			const Pu::vector<Pu::InstanceBatch> &batches = batcher.GetBatches();
+			Assert::AreEqual(size_t(3), batches.size(), L"Instances with different levels of detail were not split!");
+			AssertBatch(batches[0], 1, 0, 0, 1);
+			AssertBatch(batches[1], 1, 1, 1, 1);
+			AssertBatch(batches[2], 1, 1, 2, 2);
+			Assert::AreEqual(1u, batches[0].Lod, L"Batch has an incorrect level of detail!");
+			Assert::AreEqual(0u, batches[1].Lod, L"Batch has an incorrect level of detail!");
+			Assert::AreEqual(2u, batches[2].Lod, L"Batch has an incorrect level of detail!");
+		}
+
+		TEST_METHOD(ClearReusesBatcher)
+		{
+			Pu::InstanceBatcher batcher;
+			batcher.Add(1, 0, Pu::Matrix());
+			batcher.Pack(4);
+			batcher.Clear();
+			batcher.Pack(4);
+
+			Assert::AreEqual(0u, batcher.GetInstanceCount(), L"Instances were not cleared!");
+			Assert::IsTrue(batcher.GetBatches().empty(), L"Batches were not cleared!");
+		}
+
+	private:
+		static void AssertBatch(const Pu::InstanceBatch &batch, uint32_t subpass, uint32_t model, uint32_t first, uint32_t count)
+		{
+			Assert::AreEqual(subpass, batch.Subpass, L"Batch has an incorrect subpass!");
+			Assert::AreEqual(model, batch.Model, L"Batch has an incorrect model!");
+			Assert::AreEqual(first, batch.FirstInstance, L"Batch has an incorrect first instance!");
+			Assert::AreEqual(count, batch.InstanceCount, L"Batch has an incorrect instance count!");
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Graphics/Models/LodSelector.h>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(LodSelector)
+	{
+	public:
+		TEST_METHOD(SelectByDistance)
+		{
+			/* With a projection scale of 100 pixels and a threshold of 1 pixel, an error of 0.1 switches at a distance of 10. */
+			Pu::LodSelector selector{ 1.0f, 0.0f };
+			selector.SetCamera(Pu::Vector3(), CreateProjection(), 200.0f);
+
+			const Pu::vector<float> errors = { 0.0f, 0.1f, 0.5f };
+			selector.Add(Pu::Vector3(0.0f, 0.0f, 5.0f), 0.0f, errors, 1.0f, 0);
+			selector.Add(Pu::Vector3(0.0f, 0.0f, 20.0f), 0.0f, errors, 1.0f, 0);
+			selector.Add(Pu::Vector3(0.0f, 0.0f, 1000.0f), 0.0f, errors, 1.0f, 0);
+			selector.Add(Pu::Vector3(0.0f, 0.0f, 1000.0f), 995.0f, errors, 1.0f, 0);
+			selector.Add(Pu::Vector3(0.0f, 0.0f, 20.0f), 0.0f, errors, 4.0f, 0);
+			selector.Select();
+
+			Assert::AreEqual(0u, selector.GetLevel(0), L"Nearby object did not use the finest level!");
+			Assert::AreEqual(1u, selector.GetLevel(1), L"Object past the first switch distance did not use the second level!");
+			Assert::AreEqual(2u, selector.GetLevel(2), L"Distant object selected a level that the model doesn't have!");
+			Assert::AreEqual(0u, selector.GetLevel(3), L"Distance was not measured to the bounding sphere!");
+			Assert::AreEqual(0u, selector.GetLevel(4), L"Errors were not scaled by the object scale!");
+		}
+
+		TEST_METHOD(Hysteresis)
+		{
+			Pu::LodSelector selector{ 1.0f, 0.1f };
+			selector.SetCamera(Pu::Vector3(), CreateProjection(), 200.0f);
+
+			/* The switch distance is 10, so the band is [9, 11). */
+			const Pu::vector<float> errors = { 0.0f, 0.1f };
+			selector.Add(Pu::Vector3(0.0f, 0.0f, 10.5f), 0.0f, errors, 1.0f, 0);
+			selector.Add(Pu::Vector3(0.0f, 0.0f, 10.5f), 0.0f, errors, 1.0f, 1);
+			selector.Add(Pu::Vector3(0.0f, 0.0f, 9.5f), 0.0f, errors, 1.0f, 1);
+			selector.Add(Pu::Vector3(0.0f, 0.0f, 8.5f), 0.0f, errors, 1.0f, 1);
+			selector.Add(Pu::Vector3(0.0f, 0.0f, 11.5f), 0.0f, errors, 1.0f, 0);
+			selector.Select();
+
+			Assert::AreEqual(0u, selector.GetLevel(0), L"Object switched to a coarser level within the hysteresis band!");
+			Assert::AreEqual(1u, selector.GetLevel(1), L"Object did not keep its level within the hysteresis band!");
+			Assert::AreEqual(1u, selector.GetLevel(2), L"Object switched to a finer level within the hysteresis band!");
+			Assert::AreEqual(0u, selector.GetLevel(3), L"Object did not switch to a finer level outside the hysteresis band!");
+			Assert::AreEqual(1u, selector.GetLevel(4), L"Object did not switch to a coarser level outside the hysteresis band!");
+		}
+
+		TEST_METHOD(BatchMatchesScalar)
+		{
+			std::mt19937 rng{ 0x5EED };
+			std::uniform_real_distribution<float> position{ -200.0f, 200.0f };
+			std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+			Pu::LodSelector selector{ LodThreshold, LodBand };
+			const Pu::Vector3 camera{ 1.0f, 2.0f, 3.0f };
+			selector.SetCamera(camera, CreateProjection(), 200.0f);
+
+			/* Use an amount that doesn't fill the last AVX lane, so the padding is tested as well. */
+			Pu::vector<Object> objects;
+			for (size_t i = 0; i < 1003; i++)
+			{
+				Object obj{ Pu::Vector3(position(rng), position(rng), position(rng)), unit(rng) * 5.0f, 0.5f + unit(rng) * 2.0f, static_cast<Pu::uint32>(rng() % Pu::MaxLodLevels) };
+
+				/* The errors should increase, but not every object has all the levels. */
+				const size_t levels = 1 + rng() % Pu::MaxLodLevels;
+				obj.Errors.emplace_back(0.0f);
+				for (size_t j = 1; j < levels; j++) obj.Errors.emplace_back(obj.Errors.back() + unit(rng));
+
+				selector.Add(obj.Center, obj.Radius, obj.Errors, obj.Scale, obj.Previous);
+				objects.emplace_back(std::move(obj));
+			}
+
+			selector.Select();
+			Assert::AreEqual(1003u, selector.GetCount(), L"Padding was not removed after the selection!");
+
+			for (Pu::uint32 i = 0; i < objects.size(); i++)
+			{
+				const Object &obj = objects[i];
+				const float d = Pu::max(0.0f, (obj.Center - camera).Length() - obj.Radius);
+
+				Pu::uint32 expected = 0;
+				for (Pu::uint32 j = 1; j < obj.Errors.size(); j++)
+				{
+					const float band = j > obj.Previous ? 1.0f + LodBand : 1.0f - LodBand;
+					expected += d >= obj.Errors[j] * obj.Scale * (100.0f / LodThreshold) * band;
+				}
+
+				Assert::AreEqual(expected, selector.GetLevel(i), L"AVX level selection differs from the scalar selection!");
+			}
+		}
+
+	private:
+		static constexpr float LodThreshold = 2.0f;
+		static constexpr float LodBand = 0.15f;
+
+		struct Object
+		{
+			Pu::Vector3 Center;
+			float Radius;
+			float Scale;
+			Pu::uint32 Previous;
+			Pu::vector<float> Errors;
+		};
+
+		/* Creates a projection with a vertical focal length of one, so the projection scale is half the viewport height. */
+		static Pu::Matrix CreateProjection(void)
+		{
+			return Pu::Matrix::CreatePerspective(Pu::PI2, 1.0f, 0.1f, 1000.0f);
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Physics/Systems/OcclusionBuffer.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(OcclusionBuffer)
+	{
+	public:
+		TEST_METHOD(MatchesReferenceDepth)
+		{
+			Pu::OcclusionBuffer buffer{ 64, 32 };
+			const Pu::Matrix vp = CreateViewProjection();
+			const Pu::Occluder wall = CreateWall(10.0f);
+
+			buffer.Clear(vp);
+			buffer.Add(wall, Pu::Matrix());
+			buffer.Rasterize();
+
+			/* The wall faces the camera and covers the entire screen, so every pixel should have the depth of the wall. */
+			const Pu::Vector4 clip = vp * Pu::Vector4(Pu::Vector3::Forward() * 10.0f, 1.0f);
+			const float expected = clip.Z / clip.W;
+			const float *depth = buffer.GetDepth();
+
+			for (size_t i = 0; i < 64 * 32; i++)
+			{
+				Assert::AreEqual(expected, depth[i], 0.0001f, L"Rasterized depth differs from the reference depth!");
+			}
+		}
+
+		TEST_METHOD(HideBehindOccluder)
+		{
+			Pu::OcclusionBuffer buffer{ 64, 32 };
+			const Pu::Occluder wall = CreateWall(10.0f);
+
+			buffer.Clear(CreateViewProjection());
+			buffer.Add(wall, Pu::Matrix());
+			buffer.Rasterize();
+
+			Assert::IsFalse(buffer.IsVisible(CreateBox(20.0f)), L"Box behind the occluder is visible!");
+			Assert::IsTrue(buffer.IsVisible(CreateBox(5.0f)), L"Box in front of the occluder is hidden!");
+			Assert::IsTrue(buffer.IsVisible(CreateBox(0.0f)), L"Box that crosses the near plane is hidden!");
+		}
+
+		TEST_METHOD(EmptyBufferIsConservative)
+		{
+			Pu::OcclusionBuffer buffer{ 64, 32 };
+			buffer.Clear(CreateViewProjection());
+			buffer.Rasterize();
+
+			Assert::IsTrue(buffer.IsVisible(CreateBox(20.0f)), L"Box is hidden without any occluders!");
+			Assert::IsFalse(buffer.IsVisible(CreateBox(-20.0f)), L"Box behind the camera is visible!");
+		}
+
+	private:
+		static Pu::Matrix CreateViewProjection(void)
+		{
+			const Pu::Matrix proj = Pu::Matrix::CreatePerspective(Pu::PI4, 2.0f, 0.1f, 100.0f);
+			return proj * Pu::Matrix::CreateLookIn(Pu::Vector3(), Pu::Vector3::Forward(), Pu::Vector3::Up());
+		}
+
+		static Pu::Occluder CreateWall(float distance)
+		{
+			const Pu::Vector3 center = Pu::Vector3::Forward() * distance;
+			const Pu::Vector3 right = Pu::Vector3::Right() * 100.0f;
+			const Pu::Vector3 up = Pu::Vector3::Up() * 100.0f;
+
+			Pu::Occluder result;
+			result.Vertices = { center - right - up, center + right - up, center + right + up, center - right + up };
+			result.Indices = { 0, 1, 2, 0, 2, 3 };
+			return result;
+		}
+
+		static Pu::AABB CreateBox(float distance)
+		{
+			const Pu::Vector3 center = Pu::Vector3::Forward() * distance;
+			return Pu::AABB{ center - Pu::Vector3(1.0f), center + Pu::Vector3(1.0f) };
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Physics/Systems/PhysicalWorld.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(PhysicsQueries)
+	{
+	public:
+		TEST_METHOD(SweepHitsThinObject)
+		{
+			Pu::PhysicalWorld world;
+			Pu::PhysicalProperties properties;
+			properties.Density = 1.0f;
+			const Pu::PhysicsHandle material = world.AddMaterial(properties);
+
+			/* The path is far longer than the maximum amount of sweep steps times the radius, so fixed steps would skip the wall. */
+			const Pu::Collider wall{ Pu::AABB(Pu::Vector3(899.995f, -10.0f, -10.0f), Pu::Vector3(900.005f, 10.0f, 10.0f)), Pu::CollisionShapes::None, nullptr };
+			Pu::PhysicalObject obj{ Pu::Vector3(), Pu::Quaternion{}, wall };
+			obj.Properties = material;
+			obj.State.Mass = 1.0f;
+			obj.MoI = Pu::Matrix3::CreateScalar(1.0f);
+			const Pu::PhysicsHandle hwall = world.AddStatic(obj);
+			world.Step();
+
+			float time;
+			const Pu::PhysicsHandle hit = world.Sweep(Pu::Sphere{ Pu::Vector3(), 0.1f }, Pu::Vector3(1000.0f, 0.0f, 0.0f), Pu::QueryFilter{}, time);
+
+			Assert::IsTrue(hit == hwall, L"Sweep passed through a thin object!");
+			Assert::AreEqual(0.899895f, time, 0.0001f, L"Sweep returned an incorrect time of impact!");
+		}
+	};
+}
\ No newline at end of file
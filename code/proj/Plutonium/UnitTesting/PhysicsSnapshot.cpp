@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Physics/Systems/PhysicalWorld.h>
+#include <Streams/BinaryWriter.h>
+#include <Streams/BinaryReader.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(PhysicsSnapshot)
+	{
+	public:
+		TEST_METHOD(RestoreIsDeterministic)
+		{
+			Pu::PhysicalWorld world;
+			Pu::vector<Pu::PhysicsHandle> bodies;
+			CreateScene(world, bodies);
+			for (size_t i = 0; i < 30; i++) world.Step();
+
+			/* Simulate past the snapshot, this is the reference that the restored world should match. */
+			Pu::BinaryWriter writer;
+			world.Snapshot(writer);
+			for (size_t i = 0; i < 60; i++) world.Step();
+			const Pu::vector<Pu::Matrix> expected = GetTransforms(world, bodies);
+
+			Pu::BinaryReader reader{ writer.GetData(), writer.GetSize() };
+			world.Restore(reader);
+			for (size_t i = 0; i < 60; i++) world.Step();
+			const Pu::vector<Pu::Matrix> actual = GetTransforms(world, bodies);
+
+			for (size_t i = 0; i < bodies.size(); i++)
+			{
+				Assert::IsTrue(memcmp(&expected[i], &actual[i], sizeof(Pu::Matrix)) == 0, L"Restored simulation diverged from the original!");
+			}
+		}
+
+		TEST_METHOD(SnapshotIsStable)
+		{
+			Pu::PhysicalWorld world;
+			Pu::vector<Pu::PhysicsHandle> bodies;
+			CreateScene(world, bodies);
+			for (size_t i = 0; i < 30; i++) world.Step();
+
+			/* A snapshot of a restored world should be byte for byte the same, this includes any padding. */
+			Pu::BinaryWriter first;
+			world.Snapshot(first);
+
+			Pu::BinaryReader reader{ first.GetData(), first.GetSize() };
+			world.Restore(reader);
+
+			Pu::BinaryWriter second;
+			world.Snapshot(second);
+
+			Assert::AreEqual(first.GetSize(), second.GetSize(), L"Snapshot size changed after a restore!");
+			Assert::IsTrue(memcmp(first.GetData(), second.GetData(), first.GetSize()) == 0, L"Snapshot contents changed after a restore!");
+		}
+
+	private:
+		/* Creates a small stack of boxes and spheres that are still moving and touching eachother when the snapshot is taken. */
+		static void CreateScene(Pu::PhysicalWorld &world, Pu::vector<Pu::PhysicsHandle> &bodies)
+		{
+			world.Deterministic = true;
+
+			Pu::PhysicalProperties properties;
+			properties.Density = 1.0f;
+			properties.Mechanical.CoR = 0.2f;
+			properties.Mechanical.CoFs = 1.15f;
+			properties.Mechanical.CoFk = 1.4f;
+			properties.Mechanical.CoFr = 0.001f;
+			const Pu::PhysicsHandle material = world.AddMaterial(properties);
+
+			const Pu::Collider floor{ Pu::AABB(Pu::Vector3(-20.0f, -1.0f, -20.0f), Pu::Vector3(20.0f, 0.0f, 20.0f)), Pu::CollisionShapes::None, nullptr };
+			(void)world.AddStatic(CreateBody(Pu::Vector3(), floor, material));
+
+			Pu::OBB box{ Pu::Vector3(), Pu::Vector3(0.5f), Pu::Quaternion() };
+			Pu::Sphere sphere{ Pu::Vector3(), 0.5f };
+			for (size_t i = 0; i < 32; i++)
+			{
+				const Pu::Vector3 pos{ (i & 3) * 1.01f, 0.5f + (i >> 2) * 1.1f, (i & 1) * 0.25f };
+				bodies.emplace_back(world.AddKinematic(CreateBody(pos, i & 1 ? Pu::Collider{ sphere } : Pu::Collider{ box }, material)));
+			}
+		}
+
+		static Pu::PhysicalObject CreateBody(Pu::Vector3 pos, const Pu::Collider &collider, Pu::PhysicsHandle material)
+		{
+			Pu::PhysicalObject result{ pos, Pu::Quaternion{}, collider };
+			result.Properties = material;
+			result.State.Volume = 1.0f;
+			result.State.Mass = 1.0f;
+			result.State.Cd = 0.5f;
+			result.MoI = Pu::Matrix3::CreateScalar(1.0f / 6.0f);
+			return result;
+		}
+
+		static Pu::vector<Pu::Matrix> GetTransforms(const Pu::PhysicalWorld &world, const Pu::vector<Pu::PhysicsHandle> &bodies)
+		{
+			Pu::vector<Pu::Matrix> result;
+			for (const Pu::PhysicsHandle hobj : bodies) result.emplace_back(world.GetTransform(hobj));
+			return result;
+		}
+	};
+}
\ No newline at end of file
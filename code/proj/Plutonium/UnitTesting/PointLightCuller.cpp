@@ -0,0 +1,134 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Graphics/Lighting/PointLightCuller.h>
+#include <Physics/Systems/ShapeTests.h>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(PointLightCuller)
+	{
+	public:
+		TEST_METHOD(BucketByProjectedRadius)
+		{
+			/* With a projection scale of 100 pixels and a coarse radius of 8 pixels, a light of radius 1 becomes coarse past a distance of 12.5. */
+			Pu::PointLightCuller culler{ 8.0f };
+			culler.Add(Pu::Vector3(0.0f, 0.0f, 10.0f), 1.0f);
+			culler.Add(Pu::Vector3(0.0f, 0.0f, 20.0f), 1.0f);
+			culler.Add(Pu::Vector3(0.0f, 0.0f, -10.0f), 1.0f);
+			culler.Add(Pu::Vector3(0.0f, 0.0f, 0.5f), 1.0f);
+			culler.Add(Pu::Vector3(0.0f, 0.0f, 200.0f), 1.0f);
+			culler.Cull(CreateFrustum(), Pu::Vector3(), CreateProjection(), 200.0f, nullptr);
+
+			AssertState(culler, 0, Pu::PointLightCuller::State::Volume, L"Nearby light did not use the full volume!");
+			AssertState(culler, 1, Pu::PointLightCuller::State::Coarse, L"Distant light did not use the coarse volume!");
+			AssertState(culler, 2, Pu::PointLightCuller::State::Outside, L"Light behind the camera was not culled!");
+			AssertState(culler, 3, Pu::PointLightCuller::State::Volume, L"Light around the camera did not use the full volume!");
+			AssertState(culler, 4, Pu::PointLightCuller::State::Outside, L"Light past the far plane was not culled!");
+			Assert::AreEqual(3u, culler.GetVisibleCount(), L"Incorrect amount of visible lights!");
+		}
+
+		TEST_METHOD(MergeRunsOverCulledLights)
+		{
+			Pu::PointLightCuller culler{ 8.0f };
+			AddLights(culler, { Full, Behind, Full, Small, Full, Behind, Behind, Behind, Behind, Behind, Full });
+			culler.Cull(CreateFrustum(), Pu::Vector3(), CreateProjection(), 200.0f, nullptr);
+
+			/* The first culled light can be drawn as part of the run, the second gap is too large to be merged. */
+			const Pu::vector<Pu::PointLightRun> &volumes = culler.GetVolumeRuns();
+			Assert::AreEqual(size_t(3), volumes.size(), L"Lights were not merged into the correct amount of runs!");
+			AssertRun(volumes[0], 0, 3);
+			AssertRun(volumes[1], 4, 1);
+			AssertRun(volumes[2], 10, 1);
+
+			/* A light of the other bucket always ends the run. */
+			const Pu::vector<Pu::PointLightRun> &coarse = culler.GetCoarseRuns();
+			Assert::AreEqual(size_t(1), coarse.size(), L"Coarse lights were not merged into the correct amount of runs!");
+			AssertRun(coarse[0], 3, 1);
+		}
+
+		TEST_METHOD(RemoveShiftsLights)
+		{
+			Pu::PointLightCuller culler{ 8.0f };
+			AddLights(culler, { Full, Behind, Small });
+			culler.RemoveAt(1);
+			culler.Set(0, Pu::Vector3(0.0f, 0.0f, -10.0f), 1.0f);
+			culler.Cull(CreateFrustum(), Pu::Vector3(), CreateProjection(), 200.0f, nullptr);
+
+			Assert::AreEqual(2u, culler.GetCount(), L"Light was not removed!");
+			AssertState(culler, 0, Pu::PointLightCuller::State::Outside, L"Light was not updated!");
+			AssertState(culler, 1, Pu::PointLightCuller::State::Coarse, L"Lights were not shifted after the removal!");
+			Assert::IsTrue(culler.GetVolumeRuns().empty(), L"Culled lights were added to a run!");
+		}
+
+		TEST_METHOD(BatchMatchesScalar)
+		{
+			std::mt19937 rng{ 0x5EED };
+			std::uniform_real_distribution<float> position{ -100.0f, 100.0f };
+			std::uniform_real_distribution<float> radius{ 0.1f, 10.0f };
+
+			const Pu::Frustum frustum = CreateFrustum();
+			Pu::PointLightCuller culler{ 8.0f };
+
+			/* Use an amount that doesn't fill the last AVX lane, so the padding is tested as well. */
+			Pu::vector<Pu::Sphere> lights;
+			for (size_t i = 0; i < 1003; i++)
+			{
+				lights.emplace_back(Pu::Vector3(position(rng), position(rng), position(rng)), radius(rng));
+				culler.Add(lights.back().Center, lights.back().Radius);
+			}
+
+			culler.Cull(frustum, Pu::Vector3(), CreateProjection(), 200.0f, nullptr);
+			Assert::AreEqual(1003u, culler.GetCount(), L"Padding was not removed after the cull!");
+
+			for (Pu::uint32 i = 0; i < lights.size(); i++)
+			{
+				const Pu::Sphere &light = lights[i];
+
+				Pu::PointLightCuller::State expected = Pu::PointLightCuller::State::Outside;
+				if (Pu::intersects(frustum, light))
+				{
+					const bool small = light.Radius * 100.0f < 8.0f * light.Center.Length();
+					expected = small ? Pu::PointLightCuller::State::Coarse : Pu::PointLightCuller::State::Volume;
+				}
+
+				AssertState(culler, i, expected, L"AVX light culling differs from the scalar culling!");
+			}
+		}
+
+	private:
+		static constexpr float Full = 10.0f;
+		static constexpr float Small = 20.0f;
+		static constexpr float Behind = -10.0f;
+
+		/* Adds a light of radius one at the specified depths. */
+		static void AddLights(Pu::PointLightCuller &culler, std::initializer_list<float> depths)
+		{
+			for (const float depth : depths) culler.Add(Pu::Vector3(0.0f, 0.0f, depth), 1.0f);
+		}
+
+		/* Creates a projection with a vertical focal length of one, so the projection scale is half the viewport height. */
+		static Pu::Matrix CreateProjection(void)
+		{
+			return Pu::Matrix::CreatePerspective(Pu::PI2, 1.0f, 0.1f, 100.0f);
+		}
+
+		static Pu::Frustum CreateFrustum(void)
+		{
+			return Pu::Frustum{ CreateProjection() * Pu::Matrix::CreateLookIn(Pu::Vector3(), Pu::Vector3::Forward(), Pu::Vector3::Up()) };
+		}
+
+		static void AssertState(const Pu::PointLightCuller &culler, Pu::uint32 idx, Pu::PointLightCuller::State expected, const wchar_t *message)
+		{
+			Assert::AreEqual(static_cast<int>(expected), static_cast<int>(culler.GetState(idx)), message);
+		}
+
+		static void AssertRun(const Pu::PointLightRun &run, uint32_t first, uint32_t count)
+		{
+			Assert::AreEqual(first, run.First, L"Run has an incorrect first light!");
+			Assert::AreEqual(count, run.Count, L"Run has an incorrect light count!");
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Core/Collections/RingAllocator.h>
+#include <random>
+#include <deque>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(RingAllocator)
+	{
+	public:
+		TEST_METHOD(WrapAround)
+		{
+			Pu::RingAllocator ring{ 100 };
+			Pu::uint64 offset;
+
+			Assert::IsTrue(ring.Allocate(40, 1, offset), L"First allocation failed!");
+			ring.Commit(1);
+			Assert::IsTrue(ring.Allocate(40, 1, offset), L"Second allocation failed!");
+			Assert::AreEqual(Pu::uint64(40), offset, L"Second allocation was not placed after the first!");
+			ring.Commit(2);
+
+			/* The range doesn't fit at the end and the start is still in use by the first region. */
+			Assert::IsFalse(ring.Allocate(30, 1, offset), L"Allocation overlaps a pending region!");
+
+			ring.Release(1);
+			Assert::IsTrue(ring.Allocate(30, 1, offset), L"Allocation failed after the first region was released!");
+			Assert::AreEqual(Pu::uint64(0), offset, L"Allocation was not wrapped to the start of the ring!");
+			Assert::AreEqual(Pu::uint64(90), ring.GetUsedSize(), L"Skipped space at the end of the ring is not in use!");
+
+			ring.Commit(3);
+			ring.Release(3);
+			Assert::IsTrue(ring.IsEmpty(), L"Ring is not empty after releasing all regions!");
+			Assert::AreEqual(0u, ring.GetPendingRegionCount(), L"Released regions are still pending!");
+		}
+
+		TEST_METHOD(RandomSubmissions)
+		{
+			std::mt19937_64 rng{ 0x5EED };
+
+			for (size_t round = 0; round < 16; round++)
+			{
+				const Pu::uint64 capacity = 1 + rng() % 100000;
+				Pu::RingAllocator ring{ capacity };
+
+				Pu::vector<Range> live;
+				std::deque<Pu::uint64> pending;
+				Pu::uint64 tag = 1;
+
+				for (size_t i = 0; i < 20000; i++)
+				{
+					const size_t op = rng() % 10;
+					if (op < 6)
+					{
+						const Pu::uint64 size = 1 + rng() % (capacity / 4 + 1);
+						const Pu::uint64 alignment = Pu::uint64(1) << (rng() % 6);
+
+						Pu::uint64 offset;
+						if (!ring.Allocate(size, alignment, offset)) continue;
+
+						Assert::AreEqual(Pu::uint64(0), offset % alignment, L"Range is not aligned!");
+						Assert::IsTrue(offset + size <= capacity, L"Range exceeds the capacity!");
+						for (const Range &cur : live)
+						{
+							Assert::IsTrue(offset >= cur.Offset + cur.Size || cur.Offset >= offset + size, L"Range overlaps a range that is still in use!");
+						}
+
+						live.emplace_back(Range{ offset, size, tag });
+					}
+					else if (op < 8)
+					{
+						ring.Commit(tag);
+						pending.emplace_back(tag++);
+					}
+					else if (pending.size())
+					{
+						/* Submissions complete in order, so the oldest tag is released first. */
+						const Pu::uint64 completed = pending.front();
+						pending.pop_front();
+						ring.Release(completed);
+						live.removeAll([completed](const Range &cur) { return cur.Tag <= completed; });
+					}
+				}
+
+				ring.Commit(tag);
+				ring.Release(tag);
+				Assert::IsTrue(ring.IsEmpty(), L"Ring is not empty after releasing all regions!");
+
+				Pu::uint64 offset;
+				Assert::IsTrue(ring.Allocate(capacity, 1, offset), L"Allocation of the entire capacity failed on an empty ring!");
+			}
+		}
+
+	private:
+		struct Range
+		{
+			Pu::uint64 Offset;
+			Pu::uint64 Size;
+			Pu::uint64 Tag;
+		};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Graphics/Textures/SkylinePacker.h>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(SkylinePacker)
+	{
+	public:
+		TEST_METHOD(FillsEqualSquares)
+		{
+			Pu::SkylinePacker packer{ 4 };
+			Pu::uint32 x, y;
+
+			for (Pu::uint32 i = 0; i < 4; i++)
+			{
+				Assert::IsTrue(packer.Pack(2, 2, x, y), L"Unable to pack square that fits in the area!");
+				Assert::AreEqual((i & 1) * 2, x, L"Square was not placed next to the previous one!");
+				Assert::AreEqual((i >> 1) * 2, y, L"Square was not placed on the lowest skyline!");
+			}
+
+			Assert::AreEqual(4u, packer.GetHeight(), L"Packed height is incorrect!");
+			Assert::IsFalse(packer.Pack(5, 1, x, y), L"Rectangle wider than the area was packed!");
+		}
+
+		TEST_METHOD(NoOverlap)
+		{
+			struct Rect
+			{
+				Pu::uint32 X, Y, W, H;
+			};
+
+			std::mt19937 rng{ 0x5EED };
+			std::uniform_int_distribution<Pu::uint32> width{ 1, 24 };
+			std::uniform_int_distribution<Pu::uint32> height{ 1, 32 };
+
+			Pu::SkylinePacker packer{ 256 };
+			Pu::vector<Rect> rects;
+
+			for (size_t i = 0; i < 1000; i++)
+			{
+				Rect cur{ 0, 0, width(rng), height(rng) };
+				Assert::IsTrue(packer.Pack(cur.W, cur.H, cur.X, cur.Y), L"Unable to pack rectangle that fits in the area!");
+				Assert::IsTrue(cur.X + cur.W <= packer.GetWidth(), L"Rectangle was packed outside of the area!");
+				Assert::IsTrue(cur.Y + cur.H <= packer.GetHeight(), L"Packed height doesn't contain the rectangle!");
+				rects.emplace_back(cur);
+			}
+
+			for (size_t i = 0; i < rects.size(); i++)
+			{
+				for (size_t j = i + 1; j < rects.size(); j++)
+				{
+					const Rect &a = rects[i], &b = rects[j];
+					const bool overlap = a.X < b.X + b.W && b.X < a.X + a.W && a.Y < b.Y + b.H && b.Y < a.Y + a.H;
+					Assert::IsFalse(overlap, L"Packed rectangles overlap!");
+				}
+			}
+		}
+	};
+}
\ No newline at end of file
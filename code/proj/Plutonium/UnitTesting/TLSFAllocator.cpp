@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <Core/Collections/TLSFAllocator.h>
+#include <random>
+#include <map>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTesting
+{
+	TEST_CLASS(TLSFAllocator)
+	{
+	public:
+		TEST_METHOD(RandomAllocations)
+		{
+			std::mt19937_64 rng{ 0x5EED };
+
+			for (size_t round = 0; round < 8; round++)
+			{
+				const Pu::uint64 capacity = 1 + rng() % (1 << 24);
+				Pu::TLSFAllocator allocator{ capacity };
+
+				/* The live ranges are sorted by offset so overlap only has to be checked against the neighbours. */
+				std::map<Pu::uint64, std::pair<Pu::uint64, Pu::uint32>> live;
+				Pu::uint64 used = 0;
+
+				for (size_t i = 0; i < 10000; i++)
+				{
+					if (rng() % 3 || live.empty())
+					{
+						const Pu::uint64 size = 1 + rng() % (rng() % 2 ? 64 : 65536);
+						const Pu::uint64 alignment = Pu::uint64(1) << (rng() % 9);
+
+						Pu::uint64 offset;
+						const Pu::uint32 handle = allocator.Allocate(size, alignment, offset);
+						if (handle == Pu::TLSFAllocator::InvalidHandle) continue;
+
+						Assert::AreEqual(Pu::uint64(0), offset % alignment, L"Range is not aligned!");
+						Assert::IsTrue(offset + size <= capacity, L"Range exceeds the capacity!");
+
+						const auto next = live.lower_bound(offset);
+						Assert::IsTrue(next == live.end() || next->first >= offset + size, L"Range overlaps the next range!");
+						Assert::IsTrue(next == live.begin() || std::prev(next)->first + std::prev(next)->second.first <= offset, L"Range overlaps the previous range!");
+
+						live.emplace(offset, std::make_pair(size, handle));
+						used += size;
+					}
+					else
+					{
+						auto it = live.begin();
+						std::advance(it, rng() % live.size());
+						allocator.Free(it->second.second);
+						used -= it->second.first;
+						live.erase(it);
+					}
+
+					Assert::AreEqual(used, allocator.GetUsedSize(), L"Used size doesn't match the live ranges!");
+				}
+
+				Assert::AreEqual(static_cast<Pu::uint32>(live.size()), allocator.GetAllocationCount(), L"Allocation count doesn't match the live ranges!");
+				for (const auto &[offset, range] : live) allocator.Free(range.second);
+
+				Assert::AreEqual(1u, allocator.GetFreeRangeCount(), L"Free ranges were not coalesced!");
+				Assert::AreEqual(capacity, allocator.GetLargestFreeRange(), L"Largest free range is not the entire capacity!");
+			}
+		}
+
+		TEST_METHOD(ExactFit)
+		{
+			Pu::TLSFAllocator allocator{ 1000 };
+			Pu::uint64 first, second;
+
+			Assert::AreNotEqual(Pu::TLSFAllocator::InvalidHandle, allocator.Allocate(1000, 1, first), L"Allocation of the entire capacity failed!");
+			Assert::AreEqual(Pu::TLSFAllocator::InvalidHandle, allocator.Allocate(1, 1, second), L"Allocation succeeded on a full allocator!");
+
+			allocator.Reset();
+			const Pu::uint32 handle = allocator.Allocate(10, 1, first);
+			Assert::AreNotEqual(Pu::TLSFAllocator::InvalidHandle, allocator.Allocate(100, 256, second), L"Aligned allocation failed!");
+			Assert::AreEqual(Pu::uint64(256), second, L"Aligned allocation was not placed at the first aligned offset!");
+
+			/* The alignment padding is returned to the allocator, so the gap before the second range is free. */
+			allocator.Free(handle);
+			Assert::IsTrue(allocator.GetFragmentation() > 0.0f, L"Split free space is not reported as fragmented!");
+			Assert::AreEqual(2u, allocator.GetFreeRangeCount(), L"Free ranges around the aligned range are incorrect!");
+		}
+	};
+}
\ No newline at end of file
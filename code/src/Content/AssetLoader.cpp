@@ -5,12 +5,12 @@
 #include "Core/Threading/Tasks/Scheduler.h"
 #include "Graphics/Models/ShapeCreator.h"
 #include "Core/Diagnostics/Stopwatch.h"
-#include "Core/Diagnostics/Profiler.h"
 #include "Streams/FileReader.h"
 
 Pu::AssetLoader::AssetLoader(LogicalDevice & device, AssetCache & cache)
 	: cache(cache), device(device),
-	transferQueue(device.GetTransferQueue(0)), graphicsQueue(device.GetGraphicsQueue(0))
+	transferQueue(device.GetTransferQueue(0)), graphicsQueue(device.GetGraphicsQueue(0)),
+	staging(device, graphicsQueue, StagingRingSize)
 {}
 
 void Pu::AssetLoader::PopulateRenderpass(Renderpass & renderpass, const vector<vector<wstring>> & shaders)
@@ -120,7 +120,7 @@ void Pu::AssetLoader::InitializeTexture(Texture & texture, const wstring & path,
 	{
 	public:
 		StageTask(AssetLoader &parent, Texture &texture, const ImageInformation &info, const wstring &path)
-			: Task("Initialize Texture"), result(texture), parent(parent), staged(false), name(path.fileNameWithoutExtension())
+			: Task("Initialize Texture"), result(texture), parent(parent), submission(0), name(path.fileNameWithoutExtension())
 		{
 			child = new Texture::LoadTask(texture, info, path);
 			child->SetParent(*this);
@@ -137,10 +137,10 @@ void Pu::AssetLoader::InitializeTexture(Texture & texture, const wstring & path,
 		{
 			/*
 			There are two stages after the texels are loaded.
-			First we stage the image data by applying a copy all command to the transfer queue.
-			Secondly we delete the staging buffer and mark the texture as loaded.
+			First we copy the texels to the first mip level (0) through the staging ring.
+			Secondly we delete the loaded texels and mark the texture as loaded.
 			*/
-			if (staged)
+			if (submission)
 			{
 				parent.FinalizeTexture(result, std::move(name));
 				delete child;
@@ -148,17 +148,7 @@ void Pu::AssetLoader::InitializeTexture(Texture & texture, const wstring & path,
 			}
 			else
 			{
-				/* We allocate a new command buffer here to put less stress on the caller. */
-				cmdBuffer.Initialize(parent.device, parent.transferQueue.GetFamilyIndex());
-
-				/*  We start by staging the image from disk to the firt mip level (0). */
-				cmdBuffer.Begin();
-				cmdBuffer.MemoryBarrier(result, PipelineStageFlags::TopOfPipe, PipelineStageFlags::Transfer, ImageLayout::TransferDstOptimal, AccessFlags::TransferWrite, ImageSubresourceRange{ ImageAspectFlags::Color });
-				cmdBuffer.CopyEntireBuffer(child->GetStagingBuffer(), *result.Image);
-				cmdBuffer.End();
-
-				staged = true;
-				parent.transferQueue.Submit(cmdBuffer);
+				submission = parent.staging.Stage(child->GetData(), child->GetSize(), *result.Image, 0);
 				return Result::CustomWait();
 			}
 		}
@@ -166,17 +156,16 @@ void Pu::AssetLoader::InitializeTexture(Texture & texture, const wstring & path,
 	protected:
 		bool ShouldContinue(void) const final
 		{
-			/* The texture is done staging if the buffer can begin again. */
-			if (staged) return cmdBuffer.CanBegin();
+			/* The texture is done staging once the batch that contains it has completed. */
+			if (submission) return parent.staging.IsCompleted(submission);
 			return Task::ShouldContinue();
 		}
 
 	private:
 		Texture &result;
 		AssetLoader &parent;
-		SingleUseCommandBuffer cmdBuffer;
 		Texture::LoadTask *child;
-		bool staged;
+		uint64 submission;
 		wstring name;
 	};
 
@@ -192,7 +181,7 @@ void Pu::AssetLoader::InitializeTexture(Texture & texture, const vector<wstring>
 	{
 	public:
 		StageTask(AssetLoader &parent, Texture &texture, const ImageInformation &info, const vector<wstring> &paths, const wstring &name)
-			: Task("Initialize Texture Array"), result(texture), parent(parent), staged(false), name(name)
+			: Task("Initialize Texture Array"), result(texture), parent(parent), submission(0), name(name)
 		{
 			children.reserve(paths.size());
 			for (const wstring &path : paths)
@@ -213,10 +202,10 @@ void Pu::AssetLoader::InitializeTexture(Texture & texture, const vector<wstring>
 		{
 			/*
 			There are two stages after the texels are loaded.
-			First we stage the image data by applying a copy all command to the transfer queue.
-			Secondly we delete the staging buffers and mark the texture as loaded.
+			First we copy every face to its own array layer through the staging ring.
+			Secondly we delete the loaded texels and mark the texture as loaded.
 			*/
-			if (staged)
+			if (submission)
 			{
 				parent.FinalizeTexture(result, std::move(name));
 				for (const Texture::LoadTask *child : children) delete child;
@@ -224,28 +213,13 @@ void Pu::AssetLoader::InitializeTexture(Texture & texture, const vector<wstring>
 			}
 			else
 			{
-				/* We allocate a new command buffer here to put less stress on the caller. */
-				cmdBuffer.Initialize(parent.device, parent.transferQueue.GetFamilyIndex());
-
-				/*  Begin the command buffer and add the memory barrier to ensure a good layout. */
-				cmdBuffer.Begin();
-				ImageSubresourceRange range{ ImageAspectFlags::Color };
-				range.LayerCount = static_cast<uint32>(children.size());
-				cmdBuffer.MemoryBarrier(result, PipelineStageFlags::TopOfPipe, PipelineStageFlags::Transfer, ImageLayout::TransferDstOptimal, AccessFlags::TransferWrite, range);
-
-				/* Copy actual data and end the buffer. */
+				/* The faces might be split over multiple batches if the ring is full, but batches complete in order. */
 				uint32 face = 0;
-				for (Texture::LoadTask *child : children)
+				for (const Texture::LoadTask *child : children)
 				{
-					/* Each staging buffer hold one face from the cube map. */
-					BufferImageCopy region{ result.Image->GetExtent() };
-					region.ImageSubresource.BaseArrayLayer = face++;
-					cmdBuffer.CopyBuffer(child->GetStagingBuffer(), *result.Image, region);
+					submission = parent.staging.Stage(child->GetData(), child->GetSize(), *result.Image, face++);
 				}
-				cmdBuffer.End();
 
-				staged = true;
-				parent.transferQueue.Submit(cmdBuffer);
 				return Result::CustomWait();
 			}
 		}
@@ -253,18 +227,17 @@ void Pu::AssetLoader::InitializeTexture(Texture & texture, const vector<wstring>
 	protected:
 		bool ShouldContinue(void) const final
 		{
-			/* The texture is done staging if the buffer can begin again. */
-			if (staged) return cmdBuffer.CanBegin();
+			/* The texture is done staging once the batch that contains the last face has completed. */
+			if (submission) return parent.staging.IsCompleted(submission);
 			return Task::ShouldContinue();
 		}
 
 	private:
 		Texture &result;
 		AssetLoader &parent;
-		SingleUseCommandBuffer cmdBuffer;
 		vector<Texture::LoadTask*> children;
 		wstring name;
-		bool staged;
+		uint64 submission;
 	};
 
 	/* Simply create the task and spawn it. */
@@ -281,35 +254,13 @@ void Pu::AssetLoader::InitializeTexture(Texture & texture, const byte * data, si
 		StageTask(AssetLoader &parent, Texture &texture, const byte *data, size_t size, wstring &&id)
 			: Task("Load Raw Texture"), result(texture), parent(parent), id(std::move(id))
 		{
-			this->data = (byte*)malloc(size);
-			memcpy(this->data, data, size);
-			stagingBuffer = new StagingBuffer(parent.GetDevice(), size);
-		}
-
-		~StageTask()
-		{
-			delete stagingBuffer;
-			free(data);
+			/* The staging ring copies the data immediately, so the caller's data doesn't have to outlive this call. */
+			submission = parent.staging.Stage(data, size, *texture.Image, 0);
 		}
 
 		Result Execute(void) final
 		{
-			/* We allocate a new command buffer here to put less stress on the caller. */
-			cmdBuffer.Initialize(parent.device, parent.transferQueue.GetFamilyIndex());
-
-			/* Load the image data into the staging buffer. */
-			stagingBuffer->Load(data);
-
-			/*  Begin the command buffer and add the memory barrier to ensure a good layout. */
-			cmdBuffer.Begin();
-			cmdBuffer.MemoryBarrier(result, PipelineStageFlags::TopOfPipe, PipelineStageFlags::Transfer, ImageLayout::TransferDstOptimal, AccessFlags::TransferWrite, result.GetFullRange());
-
-			/* Copy actual data and end the buffer. */
-			cmdBuffer.CopyEntireBuffer(*stagingBuffer, *result.Image);
-			cmdBuffer.End();
-
-			/* Submit and wait for completion. */
-			parent.transferQueue.Submit(cmdBuffer);
+			/* Wait for the batch that contains the texels to complete. */
 			return Result::CustomWait();
 		}
 
@@ -323,16 +274,14 @@ void Pu::AssetLoader::InitializeTexture(Texture & texture, const byte * data, si
 	protected:
 		bool ShouldContinue(void) const final
 		{
-			/* The texture is done staging if the buffer can begin again. */
-			return cmdBuffer.CanBegin();
+			/* The texture is done staging once the batch that contains it has completed. */
+			return parent.staging.IsCompleted(submission);
 		}
 
 	private:
 		Texture &result;
 		AssetLoader &parent;
-		SingleUseCommandBuffer cmdBuffer;
-		StagingBuffer *stagingBuffer;
-		byte *data;
+		uint64 submission;
 		wstring id;
 	};
 
@@ -423,78 +372,132 @@ void Pu::AssetLoader::FinalizeTexture(Texture & texture, wstring && id)
 
 void Pu::AssetLoader::InitializeFont(Font & font, const wstring & path, Task & continuation)
 {
+	class RasterizeTask
+		: public Task
+	{
+	public:
+		RasterizeTask(Task &parent, const Font &font, size_t start, size_t end, Vector2 atlasSize, byte *dst)
+			: Task("Rasterize Glyphs", parent), font(font), start(start), end(end), atlasSize(atlasSize), dst(dst)
+		{}
+
+		Result Execute(void) final
+		{
+			font.RasterizeGlyphs(start, end, atlasSize, dst);
+			return Result::AutoDelete();
+		}
+
+	private:
+		const Font &font;
+		size_t start, end;
+		Vector2 atlasSize;
+		byte *dst;
+	};
+
 	class LoadTask
 		: public Task
 	{
 	public:
 		LoadTask(AssetLoader &parent, Font &font, const wstring &path, Task &continuation)
-			: Task("Stage Font"), result(font), parent(parent), path(path), continuation(continuation)
+			: Task("Stage Font"), result(font), parent(parent), path(path), continuation(continuation), submission(0), rasterizing(false)
 		{}
 
 		Result Execute(void) final
 		{
-			/* We allocate a new command buffer here to put less stress on the caller. */
-			cmdBuffer.Initialize(parent.device, parent.transferQueue.GetFamilyIndex());
-
-			/* Load the glyph information. */
 			result.Load(path);
-			const Vector2 imgSize = result.LoadGlyphInfo();
 
-			/* Create and populate the staging buffer. */
-			const size_t stagingBufferSize = static_cast<size_t>(imgSize.X) * static_cast<size_t>(imgSize.Y);
-			buffer = new StagingBuffer(parent.device, stagingBufferSize);
-			buffer->BeginMemoryTransfer();
-			result.StageAtlas(imgSize, reinterpret_cast<byte*>(buffer->GetHostMemory()));
-			buffer->EndMemoryTransfer();
+			/* A cached atlas can be staged directly, so it doesn't need to be rasterized. */
+			if constexpr (FontAtlasCaching)
+			{
+				FileReader reader{ result.GetCachePath(), false };
+				if (reader.IsOpen() && result.LoadCache(reader, imgSize))
+				{
+					const size_t size = static_cast<size_t>(imgSize.X) * static_cast<size_t>(imgSize.Y);
+					atlas.resize(size);
+					if (reader.Read(atlas.data(), 0, size) != size) Log::Error("Unable to read font atlas from cache '%ls'!", reader.GetFilePath().fileName().c_str());
 
-			/* Create the result image. */
-			const Extent3D extent(static_cast<uint32>(imgSize.X), static_cast<uint32>(imgSize.Y), 1);
-			ImageCreateInfo info(ImageType::Image2D, Format::R8_UNORM, extent, 1, 1, SampleCountFlags::Pixel1Bit, ImageUsageFlags::TransferDst | ImageUsageFlags::Sampled);
-			result.atlasImg = new Image(parent.device, info);
+					Stage();
+					return Result::CustomWait();
+				}
+			}
 
-			/* Make sure the atlas has the correct layout. */
-			cmdBuffer.Begin();
-			cmdBuffer.MemoryBarrier(*result.atlasImg,
-				PipelineStageFlags::TopOfPipe,
-				PipelineStageFlags::Transfer,
-				ImageLayout::TransferDstOptimal,
-				AccessFlags::TransferWrite,
-				result.atlasImg->GetFullRange(ImageAspectFlags::Color));
-
-			/* Copy actual data and end the buffer. */
-			cmdBuffer.CopyEntireBuffer(*buffer, *result.atlasImg);
-			cmdBuffer.End();
+			/* Load the glyph information and allocate the (cleared) atlas. */
+			imgSize = result.LoadGlyphInfo();
+			atlas.resize(static_cast<size_t>(imgSize.X) * static_cast<size_t>(imgSize.Y));
+
+			/* Large code charts are rasterized by child tasks, the glyphs never overlap so they can all write to the same atlas. */
+			const size_t glyphCount = result.glyphs.size();
+			if (FontRasterizationChunkSize && glyphCount > FontRasterizationChunkSize && TaskScheduler::GetThreadCount() > 1)
+			{
+				rasterizing = true;
+				for (size_t i = 0; i < glyphCount; i += FontRasterizationChunkSize)
+				{
+					TaskScheduler::Spawn(*new RasterizeTask(*this, result, i, min(glyphCount, i + FontRasterizationChunkSize), imgSize, atlas.data()));
+				}
 
-			parent.transferQueue.Submit(cmdBuffer);
+				return Result::CustomWait();
+			}
+
+			result.RasterizeGlyphs(0, glyphCount, imgSize, atlas.data());
+			CompleteAtlas();
 			return Result::CustomWait();
 		}
 
 		Result Continue(void) final
 		{
+			/* The rasterization tasks are done, so the atlas can be staged. */
+			if (rasterizing)
+			{
+				rasterizing = false;
+				CompleteAtlas();
+				return Result::CustomWait();
+			}
+
 			/* Mark both the image and the font as loaded, font will delete the atlas so just mark it as not loaded via the loader. */
 			wstring name = L"Atlas ";
 			name += path.fileNameWithoutExtension();
 			result.atlasImg->MarkAsLoaded(false, std::move(name));
 
-			/* Delete the staging buffer and this task. */
-			delete buffer;
+			/* Delete this task. */
 			return Result(&continuation, true, false);
 		}
 
 	protected:
 		bool ShouldContinue(void) const final
 		{
-			/* The texture is done staging if the buffer can begin again. */
-			return cmdBuffer.CanBegin();
+			/* The atlas is rasterized once all child tasks are done, the texture is done staging once the batch that contains it has completed. */
+			return rasterizing ? GetChildCount() < 1 : parent.staging.IsCompleted(submission);
 		}
 
 	private:
 		Font &result;
 		AssetLoader &parent;
 		Task &continuation;
-		SingleUseCommandBuffer cmdBuffer;
 		const wstring path;
-		StagingBuffer *buffer;
+		uint64 submission;
+		Vector2 imgSize;
+		vector<byte> atlas;
+		bool rasterizing;
+
+		void CompleteAtlas(void)
+		{
+			/* The cache has to store the final texture coordinates. */
+			result.FinalizeGlyphs(imgSize);
+			if constexpr (FontAtlasCaching) result.StoreCache(imgSize, atlas.data());
+			Stage();
+		}
+
+		void Stage(void)
+		{
+			/* Create the result image. */
+			const Extent3D extent(static_cast<uint32>(imgSize.X), static_cast<uint32>(imgSize.Y), 1);
+			ImageCreateInfo info(ImageType::Image2D, Format::R8_UNORM, extent, 1, 1, SampleCountFlags::Pixel1Bit, ImageUsageFlags::TransferDst | ImageUsageFlags::Sampled);
+			result.atlasImg = new Image(parent.device, info);
+
+			/* The staging ring copies the atlas immediately, so it's no longer needed on the CPU after this. */
+			submission = parent.staging.Stage(atlas.data(), atlas.size(), *result.atlasImg, 0);
+			atlas.clear();
+			atlas.shrink_to_fit();
+		}
 	};
 
 	/* Simply create the task and spawn it. */
@@ -517,6 +520,7 @@ void Pu::AssetLoader::InitializeModel(Model & model, const wstring & path, const
 			/* Initialize the model, loading the meshes. */
 			PuMData data = PuMData::MeshesOnly(parent.GetDevice(), path);
 			result.meshes.Initialize(parent.GetDevice(), data);
+			result.SetLevels(&data.Geometry);
 			result.nodes = std::move(data.Nodes);
 
 			/* Stage the vertex and index buffer to the GPU on the graphics queue. */
@@ -670,6 +674,7 @@ void Pu::AssetLoader::CreateModel(Model & model, ShapeType shape, const Deferred
 
 			/* Add the basic mesh to the model's list. */
 			result.meshes.Initialize(parent.GetDevice(), *src, vrtxSize, mesh);
+			result.SetLevels(nullptr);
 			parent.StageBuffer(*src, result.meshes.GetBuffer(), PipelineStageFlags::VertexInput, AccessFlags::VertexAttributeRead, L"Procedural Mesh");
 			return Result::CustomWait();
 		}
@@ -736,51 +741,36 @@ void Pu::AssetLoader::StageBuffer(StagingBuffer & source, Buffer & destination,
 	{
 	public:
 		StageTask(AssetLoader &parent, StagingBuffer &src, Buffer &dst, PipelineStageFlags dstStage, AccessFlags access, const wstring &name)
-			: Task("Stage Buffer"), parent(parent), source(&src), destination(dst), dstStage(dstStage), access(access), name(name), timer(parent.GetDevice(), "Staging", Color::Gray())
+			: Task("Stage Buffer"), parent(parent), source(&src), destination(dst), dstStage(dstStage), access(access), submission(0), name(name)
 		{}
 
 		Result Execute(void) final
 		{
-			/* We can use the faster GPU DMA engine (transfer queue) if this resource is just transfer related. */
-			Queue &queue = dstStage == PipelineStageFlags::Transfer ? parent.transferQueue : parent.graphicsQueue;
-			cmdBuffer.Initialize(parent.GetDevice(), queue.GetFamilyIndex());
-
-			/* We need to copy the entire staging buffer to the destination buffer and move the destination buffer to the correct access. */
-			cmdBuffer.Begin();
-			timer.RecordTimestamp(cmdBuffer, 0, PipelineStageFlags::Transfer);
-			cmdBuffer.CopyEntireBuffer(*source, destination);
-			cmdBuffer.MemoryBarrier(destination, PipelineStageFlags::Transfer, dstStage, access);
-			timer.RecordTimestamp(cmdBuffer, 0, PipelineStageFlags::Transfer);
-			cmdBuffer.End();
-
-			queue.Submit(cmdBuffer);
+			/* The copy is batched with the other uploads, the staging ring deletes the source once the copy has completed. */
+			submission = parent.staging.Stage(source, destination, dstStage, access);
 			return Result::CustomWait();
 		}
 
 		Result Continue(void) final
 		{
-			delete source;
 			destination.MarkAsLoaded(false, std::move(name));
-
-			Profiler::Add(timer, cmdBuffer, false);
 			return Result::AutoDelete();
 		}
 
 	protected:
 		bool ShouldContinue(void) const final
 		{
-			return cmdBuffer.CanBegin();
+			return parent.staging.IsCompleted(submission);
 		}
 
 	private:
 		AssetLoader &parent;
 		StagingBuffer *source;
 		Buffer &destination;
-		SingleUseCommandBuffer cmdBuffer;
 		PipelineStageFlags dstStage;
 		AccessFlags access;
+		uint64 submission;
 		wstring name;
-		ProfilerChain timer;
 	};
 
 	StageTask *task = new StageTask(*this, source, destination, dstStage, access, name);
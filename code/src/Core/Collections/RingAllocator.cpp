@@ -0,0 +1,88 @@
+#include "Core/Collections/RingAllocator.h"
+
+Pu::RingAllocator::RingAllocator(uint64 capacity)
+	: capacity(capacity)
+{
+	Reset();
+}
+
+/*
+The used space always starts at the tail and ends at the head.
+If the range doesn't fit between the head and the end of the ring,
+the space at the end is skipped and the range is placed at the start.
+
+if ring is not wrapped
+	place after head or wrap to start if it fits before tail
+else
+	place after head if it fits before tail
+*/
+bool Pu::RingAllocator::Allocate(uint64 size, uint64 alignment, uint64 & offset)
+{
+	if (!alignment) alignment = 1;
+	if (size > capacity) return false;
+
+	/* Restart at the beginning of the ring if it's empty, this keeps large allocations possible. */
+	if (!used) head = tail = 0;
+	else if (head == tail) return false;
+
+	const uint64 aligned = (head + alignment - 1) & ~(alignment - 1);
+	uint64 consumed;
+
+	if (head > tail || !used)
+	{
+		if (aligned + size <= capacity)
+		{
+			offset = aligned;
+			consumed = aligned + size - head;
+		}
+		else if (size <= tail)
+		{
+			/* The skipped space at the end is part of this region, so it's released together with it. */
+			offset = 0;
+			consumed = capacity - head + size;
+		}
+		else return false;
+	}
+	else if (aligned + size <= tail)
+	{
+		offset = aligned;
+		consumed = aligned + size - head;
+	}
+	else return false;
+
+	head = offset + size;
+	used += consumed;
+	open += consumed;
+	return true;
+}
+
+void Pu::RingAllocator::Commit(uint64 tag)
+{
+	/* Empty regions don't need to be tracked as they don't release anything. */
+	if (!open) return;
+
+	regions.emplace_back(Region{ head, open, tag });
+	open = 0;
+}
+
+void Pu::RingAllocator::Release(uint64 tag)
+{
+	/* The regions are committed in order, so we can stop at the first region that is still in use. */
+	size_t i = 0;
+	for (; i < regions.size() && regions[i].Tag <= tag; i++)
+	{
+		tail = regions[i].End;
+		used -= regions[i].Size;
+	}
+
+	if (i) regions.erase(regions.begin(), regions.begin() + i);
+}
+
+void Pu::RingAllocator::Reset(void)
+{
+	head = 0;
+	tail = 0;
+	used = 0;
+	open = 0;
+	regions.clear();
+}
\ No newline at end of file
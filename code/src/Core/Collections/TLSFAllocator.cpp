@@ -0,0 +1,257 @@
+#include "Core/Collections/TLSFAllocator.h"
+#include "Core/Diagnostics/Logging.h"
+#include <immintrin.h>
+
+Pu::TLSFAllocator::TLSFAllocator(uint64 capacity)
+	: capacity(capacity)
+{
+	Reset();
+}
+
+/*
+The free block is searched with the worst case alignment padding added to the size.
+The padding and the remaining tail are split off as new free blocks.
+
+find free block that fits size + alignment - 1
+split off padding in front
+split off remaining space at the end
+*/
+Pu::uint32 Pu::TLSFAllocator::Allocate(uint64 size, uint64 alignment, uint64 & offset)
+{
+	if (!size) size = 1;
+	if (!alignment) alignment = 1;
+
+	const uint32 idx = FindFree(size + alignment - 1);
+	if (idx == InvalidHandle) return InvalidHandle;
+	RemoveFree(idx);
+
+	/* Free blocks are always merged, so the neighbours of this block are never free. */
+	const uint64 aligned = (blocks[idx].Offset + alignment - 1) & ~(alignment - 1);
+	const uint64 padding = aligned - blocks[idx].Offset;
+	if (padding)
+	{
+		const uint32 front = CreateBlock(blocks[idx].Offset, padding, blocks[idx].PrevPhysical, idx);
+		if (blocks[front].PrevPhysical != InvalidHandle) blocks[blocks[front].PrevPhysical].NextPhysical = front;
+		blocks[idx].PrevPhysical = front;
+		blocks[idx].Offset = aligned;
+		blocks[idx].Size -= padding;
+		InsertFree(front);
+	}
+
+	if (blocks[idx].Size > size)
+	{
+		const uint32 back = CreateBlock(aligned + size, blocks[idx].Size - size, idx, blocks[idx].NextPhysical);
+		if (blocks[back].NextPhysical != InvalidHandle) blocks[blocks[back].NextPhysical].PrevPhysical = back;
+		blocks[idx].NextPhysical = back;
+		blocks[idx].Size = size;
+		InsertFree(back);
+	}
+
+	blocks[idx].Free = false;
+	used += size;
+	++allocations;
+
+	offset = aligned;
+	return idx;
+}
+
+void Pu::TLSFAllocator::Free(uint32 handle)
+{
+#ifdef _DEBUG
+	if (handle >= blocks.size() || blocks[handle].Free)
+	{
+		Log::Error("Attempting to free invalid TLSF allocation %u!", handle);
+		return;
+	}
+#endif
+
+	uint32 idx = handle;
+	used -= blocks[idx].Size;
+	--allocations;
+
+	/* Merge the block with the previous block if that one is free. */
+	const uint32 prev = blocks[idx].PrevPhysical;
+	if (prev != InvalidHandle && blocks[prev].Free)
+	{
+		RemoveFree(prev);
+		blocks[prev].Size += blocks[idx].Size;
+		blocks[prev].NextPhysical = blocks[idx].NextPhysical;
+		if (blocks[idx].NextPhysical != InvalidHandle) blocks[blocks[idx].NextPhysical].PrevPhysical = prev;
+
+		ReleaseBlock(idx);
+		idx = prev;
+	}
+
+	/* Merge the next block into this block if it's free. */
+	const uint32 next = blocks[idx].NextPhysical;
+	if (next != InvalidHandle && blocks[next].Free)
+	{
+		RemoveFree(next);
+		blocks[idx].Size += blocks[next].Size;
+		blocks[idx].NextPhysical = blocks[next].NextPhysical;
+		if (blocks[next].NextPhysical != InvalidHandle) blocks[blocks[next].NextPhysical].PrevPhysical = idx;
+
+		ReleaseBlock(next);
+	}
+
+	InsertFree(idx);
+}
+
+void Pu::TLSFAllocator::Reset(void)
+{
+	used = 0;
+	allocations = 0;
+	freeRanges = 0;
+	firstLevel = 0;
+	memset(secondLevel, 0, sizeof(secondLevel));
+	memset(heads, 0xFF, sizeof(heads));
+
+	blocks.clear();
+	unusedBlocks.clear();
+	if (capacity) InsertFree(CreateBlock(0, capacity, InvalidHandle, InvalidHandle));
+}
+
+Pu::uint64 Pu::TLSFAllocator::GetLargestFreeRange(void) const
+{
+	if (!firstLevel) return 0;
+
+	/* The largest block is in the highest list, but that list isn't sorted. */
+	const uint32 fl = 63 - static_cast<uint32>(_lzcnt_u64(firstLevel));
+	const uint32 sl = 31 - static_cast<uint32>(_lzcnt_u32(secondLevel[fl]));
+
+	uint64 result = 0;
+	for (uint32 i = heads[fl][sl]; i != InvalidHandle; i = blocks[i].NextFree) result = max(result, blocks[i].Size);
+	return result;
+}
+
+float Pu::TLSFAllocator::GetFragmentation(void) const
+{
+	const uint64 free = GetFreeSize();
+	return free ? 1.0f - static_cast<float>(static_cast<double>(GetLargestFreeRange()) / static_cast<double>(free)) : 0.0f;
+}
+
+/*
+The first level is the power of two of the size, the second level linearly subdivides that power of two.
+Sizes smaller than the second level count are all stored in the first list.
+*/
+void Pu::TLSFAllocator::GetLevels(uint64 size, uint32 & fl, uint32 & sl)
+{
+	if (size < SecondLevelCount)
+	{
+		fl = 0;
+		sl = static_cast<uint32>(size);
+	}
+	else
+	{
+		const uint32 msb = 63 - static_cast<uint32>(_lzcnt_u64(size));
+		fl = msb - SecondLevelLog2 + 1;
+		sl = static_cast<uint32>(size >> (msb - SecondLevelLog2)) - SecondLevelCount;
+	}
+}
+
+/*
+The size is rounded up to the next list, so every block in the found list is large enough.
+This can skip a fitting block in the list of the size itself (like an allocation of the full capacity),
+so that list is searched linearly if no larger list is available.
+*/
+Pu::uint32 Pu::TLSFAllocator::FindFree(uint64 size) const
+{
+	uint32 fl, sl;
+	GetLevels(size, fl, sl);
+
+	uint64 rounded = size;
+	if (size >= SecondLevelCount)
+	{
+		const uint32 msb = 63 - static_cast<uint32>(_lzcnt_u64(size));
+		const uint64 round = (1ull << (msb - SecondLevelLog2)) - 1;
+		rounded = size > ~0ull - round ? ~0ull : size + round;
+	}
+
+	uint32 rfl, rsl;
+	GetLevels(rounded, rfl, rsl);
+
+	/* Check for a large enough list in the same first level, otherwise use the smallest larger first level. */
+	uint32 slMap = secondLevel[rfl] & (~0u << rsl);
+	if (!slMap)
+	{
+		const uint64 flMap = rfl + 1 < 64 ? firstLevel & (~0ull << (rfl + 1)) : 0;
+		if (flMap)
+		{
+			rfl = static_cast<uint32>(_tzcnt_u64(flMap));
+			slMap = secondLevel[rfl];
+		}
+	}
+
+	if (slMap) return heads[rfl][_tzcnt_u32(slMap)];
+
+	for (uint32 i = heads[fl][sl]; i != InvalidHandle; i = blocks[i].NextFree)
+	{
+		if (blocks[i].Size >= size) return i;
+	}
+
+	return InvalidHandle;
+}
+
+void Pu::TLSFAllocator::InsertFree(uint32 idx)
+{
+	uint32 fl, sl;
+	Block &block = blocks[idx];
+	GetLevels(block.Size, fl, sl);
+
+	block.Free = true;
+	block.PrevFree = InvalidHandle;
+	block.NextFree = heads[fl][sl];
+	if (block.NextFree != InvalidHandle) blocks[block.NextFree].PrevFree = idx;
+
+	heads[fl][sl] = idx;
+	firstLevel |= 1ull << fl;
+	secondLevel[fl] |= 1u << sl;
+	++freeRanges;
+}
+
+void Pu::TLSFAllocator::RemoveFree(uint32 idx)
+{
+	uint32 fl, sl;
+	Block &block = blocks[idx];
+	GetLevels(block.Size, fl, sl);
+
+	if (block.PrevFree != InvalidHandle) blocks[block.PrevFree].NextFree = block.NextFree;
+	if (block.NextFree != InvalidHandle) blocks[block.NextFree].PrevFree = block.PrevFree;
+
+	/* Clear the bitmaps if this was the last block in the list. */
+	if (heads[fl][sl] == idx)
+	{
+		heads[fl][sl] = block.NextFree;
+		if (block.NextFree == InvalidHandle)
+		{
+			secondLevel[fl] &= ~(1u << sl);
+			if (!secondLevel[fl]) firstLevel &= ~(1ull << fl);
+		}
+	}
+
+	block.Free = false;
+	--freeRanges;
+}
+
+Pu::uint32 Pu::TLSFAllocator::CreateBlock(uint64 offset, uint64 size, uint32 prev, uint32 next)
+{
+	const Block block{ offset, size, prev, next, InvalidHandle, InvalidHandle, false };
+
+	/* Block indices are used as handles, so released blocks are reused instead of erased. */
+	if (unusedBlocks.size())
+	{
+		const uint32 result = unusedBlocks.back();
+		unusedBlocks.pop_back();
+		blocks[result] = block;
+		return result;
+	}
+
+	blocks.emplace_back(block);
+	return static_cast<uint32>(blocks.size() - 1);
+}
+
+void Pu::TLSFAllocator::ReleaseBlock(uint32 idx)
+{
+	blocks[idx].Free = false;
+	unusedBlocks.emplace_back(idx);
+}
\ No newline at end of file
@@ -123,6 +123,27 @@ void Pu::Profiler::SetInterval(float value)
 	lock.unlock();
 }
 
+Pu::int64 Pu::Profiler::GetTime(const string & category)
+{
+	int64 result = 0;
+
+	lock.lock();
+	for (const Section &section : GetInstance().cpuSections)
+	{
+		if (section.Category == category) result += section.Time;
+	}
+	lock.unlock();
+
+	return result;
+}
+
+void Pu::Profiler::Clear(void)
+{
+	lock.lock();
+	for (Section &section : GetInstance().cpuSections) section.Time = 0;
+	lock.unlock();
+}
+
 Pu::Profiler::Profiler(void)
 	: spacing(8.0f), length(0.05f), target(sec_to_ms(recip(60.0f))),
 	interval(1.0f), ticks(1)
@@ -247,6 +268,7 @@ void Pu::Profiler::VisualizeInternal(void)
 			ImGui::Text("Draw Calls:      %u", CommandBuffer::GetDrawCalls());
 			ImGui::Text("Dispatch Calls:  %u", CommandBuffer::GetDispatchCalls());
 			ImGui::Text("Bind Calls:      %u", CommandBuffer::GetBindCalls());
+			ImGui::Text("Elided Calls:    %u", CommandBuffer::GetElidedCalls());
 			ImGui::Text("Shaders Used:    %u", CommandBuffer::GetShaderCalls());
 			ImGui::Text("Transfers:       %u", CommandBuffer::GetTransferCalls());
 			ImGui::Text("Barriers:        %u", CommandBuffer::GetBarrierCalls());
@@ -1,5 +1,6 @@
 #include "Core/Math/HeightMap.h"
 #include "Core/Math/Interpolation.h"
+#include "Physics/Systems/Raycasts.h"
 #include "Core/Diagnostics/Logging.h"
 #include "Graphics/Diagnostics/DebugRenderer.h"
 
@@ -19,7 +20,8 @@ Pu::HeightMap::HeightMap(uint32 width, uint32 height, float scale, bool addNorma
 
 Pu::HeightMap::HeightMap(const HeightMap & value)
 	: width(value.width), height(value.height), patchSize(value.patchSize),
-	boundX(value.boundX), boundY(value.boundY), iPatchSize(value.iPatchSize)
+	boundX(value.boundX), boundY(value.boundY), iPatchSize(value.iPatchSize),
+	bounds(value.bounds), levels(value.levels)
 {
 	Alloc(value.normals);
 	Copy(value);
@@ -29,7 +31,8 @@ Pu::HeightMap::HeightMap(HeightMap && value)
 	: width(value.width), height(value.height),
 	patchSize(value.patchSize), iPatchSize(value.patchSize),
 	boundX(value.boundX), boundY(value.boundY),
-	data(value.data), normals(value.normals)
+	data(value.data), normals(value.normals),
+	bounds(std::move(value.bounds)), levels(std::move(value.levels))
 {
 	value.data = nullptr;
 	value.normals = nullptr;
@@ -45,6 +48,8 @@ Pu::HeightMap & Pu::HeightMap::operator=(const HeightMap & other)
 		boundY = other.boundY;
 		patchSize = other.patchSize;
 		iPatchSize = other.iPatchSize;
+		bounds = other.bounds;
+		levels = other.levels;
 
 		data = reinterpret_cast<float*>(realloc(data, width * height * sizeof(float)));
 		if (other.normals) normals = reinterpret_cast<Vector3*>(realloc(normals, width * height * sizeof(Vector3)));
@@ -66,6 +71,8 @@ Pu::HeightMap & Pu::HeightMap::operator=(HeightMap && other)
 		iPatchSize = other.iPatchSize;
 		data = other.data;
 		normals = other.normals;
+		bounds = std::move(other.bounds);
+		levels = std::move(other.levels);
 
 		other.data = nullptr;
 		other.normals = nullptr;
@@ -163,6 +170,60 @@ void Pu::HeightMap::CalculateNormals(float displacement)
 	}
 }
 
+/*
+The bounds are stored as a pyramid of min/max pairs.
+The first level stores the bounds of every patch (so four heights),
+every next level halves the dimensions until a single cell remains.
+*/
+void Pu::HeightMap::CalculateBounds(void)
+{
+	bounds.clear();
+	levels.clear();
+
+	/* The first level is created directly from the heights. */
+	uint32 w = boundX, h = boundY;
+	levels.emplace_back(MipLevel{ 0, w, h });
+	for (uint32 y = 0; y < h; y++)
+	{
+		for (uint32 x = 0; x < w; x++)
+		{
+			const float a = data[y * width + x];
+			const float b = data[y * width + x + 1];
+			const float c = data[(y + 1) * width + x];
+			const float d = data[(y + 1) * width + x + 1];
+			bounds.emplace_back(min(min(a, b), min(c, d)), max(max(a, b), max(c, d)));
+		}
+	}
+
+	/* Every next level combines four cells of the previous level (or less on the edges). */
+	while (w > 1 || h > 1)
+	{
+		const MipLevel prev = levels.back();
+		w = (w + 1) >> 1;
+		h = (h + 1) >> 1;
+		levels.emplace_back(MipLevel{ static_cast<uint32>(bounds.size()), w, h });
+
+		for (uint32 y = 0; y < h; y++)
+		{
+			for (uint32 x = 0; x < w; x++)
+			{
+				Vector2 cur{ maxv<float>(), -maxv<float>() };
+				for (uint32 cy = y << 1; cy < min((y << 1) + 2, prev.Height); cy++)
+				{
+					for (uint32 cx = x << 1; cx < min((x << 1) + 2, prev.Width); cx++)
+					{
+						const Vector2 child = bounds[prev.Offset + cy * prev.Width + cx];
+						cur.X = min(cur.X, child.X);
+						cur.Y = max(cur.Y, child.Y);
+					}
+				}
+
+				bounds.emplace_back(cur);
+			}
+		}
+	}
+}
+
 bool Pu::HeightMap::Contains(uint32 x, uint32 y) const
 {
 	return x < width && y < height;
@@ -320,6 +381,177 @@ bool Pu::HeightMap::TryGetHeightAndNormal(Vector2 pos, float & output, Vector3 &
 	return false;
 }
 
+/*
+This is the same barycentric interpolation as the scalar version, but both triangles are calculated branchless.
+
+Bottom-Left:	A = [x, y],		B = [x + 1, y],		t = 1 - u - v,	s = u
+Top-Right:		A = [x + 1, y],	B = [x + 1, y + 1],	t = 1 - v,		s = u + v - 1
+C is always [x, y + 1], so we only need three gathers per component.
+*/
+Pu::ofloat Pu::HeightMap::TryGetHeightAndNormal(ofloat x, ofloat y, ofloat & output, ofloat & nx, ofloat & ny, ofloat & nz) const
+{
+#ifdef _DEBUG
+	if (!normals) Log::Fatal("Cannot access normals (normals have not been calculated)!");
+#endif
+
+	const ofloat zero = _mm256_setzero_ps();
+	const ofloat one = _mm256_set1_ps(1.0f);
+
+	/* Convert the location into the patch position and the patch uv. */
+	const ofloat fx = _mm256_mul_ps(x, _mm256_set1_ps(iPatchSize.X));
+	const ofloat fy = _mm256_mul_ps(y, _mm256_set1_ps(iPatchSize.Y));
+	ofloat cx = _mm256_floor_ps(fx);
+	ofloat cy = _mm256_floor_ps(fy);
+	const ofloat u = _mm256_sub_ps(fx, cx);
+	const ofloat v = _mm256_sub_ps(fy, cy);
+
+	/* Only the points that are on the map are valid. */
+	const ofloat mask = _mm256_and_ps(
+		_mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_GE_OQ), _mm256_cmp_ps(y, zero, _CMP_GE_OQ)),
+		_mm256_and_ps(_mm256_cmp_ps(cx, _mm256_set1_ps(static_cast<float>(boundX)), _CMP_LT_OQ), _mm256_cmp_ps(cy, _mm256_set1_ps(static_cast<float>(boundY)), _CMP_LT_OQ)));
+
+	/* Clamp the patch position so the invalid points don't gather outside of the map. */
+	cx = _mm256_min_ps(_mm256_max_ps(cx, zero), _mm256_set1_ps(static_cast<float>(boundX - 1)));
+	cy = _mm256_min_ps(_mm256_max_ps(cy, zero), _mm256_set1_ps(static_cast<float>(boundY - 1)));
+	const int256 w = _mm256_set1_epi32(static_cast<int32>(width));
+	const int256 i00 = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(cy), w), _mm256_cvttps_epi32(cx));
+	const int256 i10 = _mm256_add_epi32(i00, _mm256_set1_epi32(1));
+	const int256 i11 = _mm256_add_epi32(i10, w);
+	const int256 ic = _mm256_add_epi32(i00, w);
+
+	/* Select the triangle and its barycentric weights. */
+	const ofloat tri = _mm256_cmp_ps(u, _mm256_sub_ps(one, v), _CMP_LE_OQ);
+	const int256 ia = _mm256_blendv_epi8(i10, i00, _mm256_castps_si256(tri));
+	const int256 ib = _mm256_blendv_epi8(i11, i10, _mm256_castps_si256(tri));
+	const ofloat wa = _mm256_blendv_ps(_mm256_sub_ps(one, v), _mm256_sub_ps(_mm256_sub_ps(one, u), v), tri);
+	const ofloat wb = _mm256_blendv_ps(_mm256_sub_ps(_mm256_add_ps(u, v), one), u, tri);
+	const ofloat wc = _mm256_sub_ps(_mm256_sub_ps(one, wa), wb);
+
+	/* Gather and interpolate the heights. */
+	output = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(data, ia, 4), wa), _mm256_add_ps(
+		_mm256_mul_ps(_mm256_i32gather_ps(data, ib, 4), wb), _mm256_mul_ps(_mm256_i32gather_ps(data, ic, 4), wc)));
+
+	/* The normals are stored as AoS, so scale the indices by the amount of components. */
+	const float *n = reinterpret_cast<const float*>(normals);
+	const int256 na = _mm256_add_epi32(ia, _mm256_add_epi32(ia, ia));
+	const int256 nb = _mm256_add_epi32(ib, _mm256_add_epi32(ib, ib));
+	const int256 nc = _mm256_add_epi32(ic, _mm256_add_epi32(ic, ic));
+
+	nx = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(n, na, 4), wa), _mm256_add_ps(
+		_mm256_mul_ps(_mm256_i32gather_ps(n, nb, 4), wb), _mm256_mul_ps(_mm256_i32gather_ps(n, nc, 4), wc)));
+	ny = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(n + 1, na, 4), wa), _mm256_add_ps(
+		_mm256_mul_ps(_mm256_i32gather_ps(n + 1, nb, 4), wb), _mm256_mul_ps(_mm256_i32gather_ps(n + 1, nc, 4), wc)));
+	nz = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(n + 2, na, 4), wa), _mm256_add_ps(
+		_mm256_mul_ps(_mm256_i32gather_ps(n + 2, nb, 4), wb), _mm256_mul_ps(_mm256_i32gather_ps(n + 2, nc, 4), wc)));
+
+	return mask;
+}
+
+void Pu::HeightMap::GetHeightRange(Vector2 lower, Vector2 upper, float & low, float & high) const
+{
+	/* We cannot give a range if the bounds haven't been calculated. */
+	if (levels.empty())
+	{
+		low = -maxv<float>();
+		high = maxv<float>();
+		return;
+	}
+
+	/* Get the patches (clamped to the map) that the area covers. */
+	uint32 x0 = min(upart(max(0.0f, lower.X) * iPatchSize.X), boundX - 1);
+	uint32 y0 = min(upart(max(0.0f, lower.Y) * iPatchSize.Y), boundY - 1);
+	uint32 x1 = min(upart(max(0.0f, upper.X) * iPatchSize.X), boundX - 1);
+	uint32 y1 = min(upart(max(0.0f, upper.Y) * iPatchSize.Y), boundY - 1);
+
+	/* Move up the pyramid until the area covers at most two by two cells. */
+	size_t level = 0;
+	while (x1 - x0 > 1 || y1 - y0 > 1)
+	{
+		x0 >>= 1;
+		y0 >>= 1;
+		x1 >>= 1;
+		y1 >>= 1;
+		++level;
+	}
+
+	low = maxv<float>();
+	high = -maxv<float>();
+	const MipLevel &mip = levels[level];
+	for (uint32 y = y0; y <= y1; y++)
+	{
+		for (uint32 x = x0; x <= x1; x++)
+		{
+			const Vector2 cur = bounds[mip.Offset + y * mip.Width + x];
+			low = min(low, cur.X);
+			high = max(high, cur.Y);
+		}
+	}
+}
+
+/*
+The raycast traverses the pyramid from the top down,
+only cells of which the bounding box is hit by the ray are checked further.
+At the first level the ray is tested against the two triangles of the patch.
+*/
+float Pu::HeightMap::Raycast(Vector3 p, Vector3 d) const
+{
+	if (levels.empty())
+	{
+		Log::Warning("Cannot raycast heightmap (bounds have not been calculated)!");
+		return -1.0f;
+	}
+
+	const Vector3 rd = recip(d);
+	float result = maxv<float>();
+
+	/* The stack stores the level (upper byte) and the location of the cell. */
+	vector<std::pair<uint32, uint32>> stack;
+	stack.emplace_back(static_cast<uint32>(levels.size() - 1) << 24, 0u);
+
+	while (stack.size())
+	{
+		const auto [lx, y] = stack.back();
+		stack.pop_back();
+
+		const uint32 level = lx >> 24;
+		const uint32 x = lx & 0xFFFFFF;
+		const MipLevel &mip = levels[level];
+		const Vector2 range = bounds[mip.Offset + y * mip.Width + x];
+
+		/* Create the bounding box of the cell, the edge cells might be smaller. */
+		const float sx = patchSize.X * (1u << level);
+		const float sy = patchSize.Y * (1u << level);
+		const AABB box
+		{
+			Vector3{ x * sx, range.X, y * sy },
+			Vector3{ min((x + 1) * sx, boundX * patchSize.X), range.Y, min((y + 1) * sy, boundY * patchSize.Y) }
+		};
+
+		/* Skip the cell if it's not hit or if it's further away than the current closest hit. */
+		const float t = raycast(p, rd, box);
+		if (t < 0.0f || t >= result) continue;
+
+		if (level)
+		{
+			const MipLevel &child = levels[level - 1];
+			for (uint32 cy = y << 1; cy < min((y << 1) + 2, child.Height); cy++)
+			{
+				for (uint32 cx = x << 1; cx < min((x << 1) + 2, child.Width); cx++)
+				{
+					stack.emplace_back((level - 1) << 24 | cx, cy);
+				}
+			}
+		}
+		else
+		{
+			const float hit = RaycastPatch(p, d, x, y);
+			if (hit >= 0.0f) result = min(result, hit);
+		}
+	}
+
+	return result < maxv<float>() ? result : -1.0f;
+}
+
 void Pu::HeightMap::Visualize(DebugRenderer & renderer, Vector3 offset, Color color) const
 {
 	Vector3 a;
@@ -372,6 +604,22 @@ Pu::Vector3 Pu::HeightMap::QueryNormal(uint32 apx, uint32 apy, uint32 bpx, uint3
 	return barycentric(GetNormal(apx, apy), GetNormal(bpx, bpy), GetNormal(cpx, cpy), t, s);
 }
 
+float Pu::HeightMap::RaycastPatch(Vector3 p, Vector3 d, uint32 x, uint32 y) const
+{
+	const Vector3 v00{ x * patchSize.X, data[y * width + x], y * patchSize.Y };
+	const Vector3 v10{ (x + 1) * patchSize.X, data[y * width + x + 1], y * patchSize.Y };
+	const Vector3 v01{ x * patchSize.X, data[(y + 1) * width + x], (y + 1) * patchSize.Y };
+	const Vector3 v11{ (x + 1) * patchSize.X, data[(y + 1) * width + x + 1], (y + 1) * patchSize.Y };
+
+	/* A patch consists of the bottom-left and top-right triangle. */
+	const float t1 = raycast(p, d, v00, v10, v01);
+	const float t2 = raycast(p, d, v10, v11, v01);
+
+	if (t1 < 0.0f) return t2;
+	if (t2 < 0.0f) return t1;
+	return min(t1, t2);
+}
+
 void Pu::HeightMap::Alloc(bool allocNormals)
 {
 	data = reinterpret_cast<float*>(malloc(width * height * sizeof(float)));
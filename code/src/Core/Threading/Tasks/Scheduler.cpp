@@ -57,6 +57,11 @@ void Pu::TaskScheduler::Help(void)
 	if (!ThreadTrySteal(maxv<size_t>())) PuThread::Pause();
 }
 
+size_t Pu::TaskScheduler::GetThreadCount(void)
+{
+	return threads.size();
+}
+
 void Pu::TaskScheduler::ThreadMain(size_t idx)
 {
 	PuThread::SetName(L"PuWrkr" + wstring::from(idx));
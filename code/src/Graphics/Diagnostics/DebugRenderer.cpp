@@ -6,17 +6,17 @@
 
 using namespace Pu;
 
-constexpr DeviceSize Line_START = 0;
-constexpr DeviceSize Arrow_START = MaxDebugRendererObjects;
-constexpr DeviceSize Box_START = MaxDebugRendererObjects << 1;
-constexpr DeviceSize Ellipsoid_START = MaxDebugRendererObjects * 3;
-constexpr DeviceSize Hemisphere_START = MaxDebugRendererObjects << 2;
-constexpr DeviceSize HOST_BUFFER_COUNT = MaxDebugRendererObjects * 5;
+/* The lists are stored after each other in the host buffer and use the mesh with the same index. */
+constexpr uint32 Line_LIST = 0;
+constexpr uint32 Arrow_LIST = 1;
+constexpr uint32 Box_LIST = 2;
+constexpr uint32 Ellipsoid_LIST = 3;
+constexpr uint32 Hemisphere_LIST = 4;
+constexpr uint32 LIST_COUNT = 5;
+constexpr DeviceSize HOST_BUFFER_COUNT = MaxDebugRendererObjects * LIST_COUNT;
 constexpr uint32 TRIG_BUFFER_SIZE = EllipsiodDivs << 1;
 
-#define GetOffset(list)					VertexLayout *mem = (reinterpret_cast<VertexLayout*>(buffer->GetHostMemory()) + ##list##_START + cnt##list)
-#define CapacityEarlyOut(amnt, list)	if (CheckCapacity(list, amnt)) return
-#define TryStart(amnt, list)			if (CheckCapacity(cnt##list, amnt)) { return; } GetOffset(list)
+#define TryStart(amnt, list)			VertexLayout *mem = Reserve(list##_LIST, amnt); if (!mem) return
 #define cpy_line(p, q)					*mem++ = (p); *mem++ = (q)
 
 class LoadDebugShapesTask
@@ -157,10 +157,7 @@ private:
 Pu::DebugRenderer::DebugRenderer(GameWindow & window, AssetFetcher & loader, const DepthBuffer * depthBuffer, float lineWidth)
 	: loader(loader), wnd(window), pipeline(nullptr), lineWidth(lineWidth),
 	depthBuffer(depthBuffer), thrown(false), invalidated(0), meshes(new MeshCollection()),
-	cntLine(0), cntArrow(0), cntBox(0), cntEllipsoid(0), cntHemisphere(0)
-#ifdef _DEBUG
-	, culled(0)
-#endif
+	counts{}, dropped(0), lastDropped(0)
 {
 	/* We need a dynamic buffer because the data will update every frame. */
 	buffer = new DynamicBuffer(window.GetDevice(), sizeof(VertexLayout) * HOST_BUFFER_COUNT, BufferUsageFlags::TransferDst | BufferUsageFlags::VertexBuffer);
@@ -200,51 +197,52 @@ void Pu::DebugRenderer::AddLine(const Line & line, Color color)
 
 void Pu::DebugRenderer::AddLine(Vector3 start, Vector3 end, Color color)
 {
-	CapacityEarlyOut(1, cntLine);
-	AddLineInternal(start, end, color);
+	TryStart(1, Line);
+	WriteLine(mem, start, end, color);
 }
 
+/* The curves reserve all their segments at once, so a curve is either fully drawn or fully dropped. */
 void Pu::DebugRenderer::AddBezier(Vector3 start, Vector3 control, Vector3 end, Color color, uint32 segments)
 {
-	CapacityEarlyOut(segments << 1, cntLine);
+	TryStart(segments, Line);
 
 	Vector3 a = start;
 	const float step = recip(static_cast<float>(segments));
 
-	for (float v = 0.0f; v < 1.0f; v += step)
+	for (uint32 i = 1; i <= segments; i++)
 	{
-		const Vector3 b = cubic(start, control, end, v);
-		AddLineInternal(a, b, color);
+		const Vector3 b = cubic(start, control, end, i * step);
+		WriteLine(mem++, a, b, color);
 		a = b;
 	}
 }
 
 void Pu::DebugRenderer::AddBezier(Vector3 start, Vector3 control1, Vector3 control2, Vector3 end, Color color, uint32 segments)
 {
-	CapacityEarlyOut(segments << 1, cntLine);
+	TryStart(segments, Line);
 
 	Vector3 a = start;
 	const float step = recip(static_cast<float>(segments));
 
-	for (float v = 0.0f; v < 1.0f; v += step)
+	for (uint32 i = 1; i <= segments; i++)
 	{
-		const Vector3 b = quadratic(start, control1, control2, end, v);
-		AddLineInternal(a, b, color);
+		const Vector3 b = quadratic(start, control1, control2, end, i * step);
+		WriteLine(mem++, a, b, color);
 		a = b;
 	}
 }
 
 void Pu::DebugRenderer::AddSpline(const Spline & spline, Color color, uint32 segments)
 {
-	CapacityEarlyOut(segments << 1, cntLine);
+	TryStart(segments, Line);
 
 	Vector3 a = spline.GetLocation(0.0f);
 	const float step = recip(static_cast<float>(segments));
 
-	for (float v = 0.0f; v < 1.0f; v += step)
+	for (uint32 i = 1; i <= segments; i++)
 	{
-		const Vector3 b = spline.GetLocation(v);
-		AddLineInternal(a, b, color);
+		const Vector3 b = spline.GetLocation(i * step);
+		WriteLine(mem++, a, b, color);
 		a = b;
 	}
 }
@@ -254,7 +252,6 @@ void Pu::DebugRenderer::AddArrow(Vector3 start, Vector3 direction, Color color,
 	TryStart(1, Arrow);
 	mem->mdl = Matrix::CreateWorld(start, Quaternion::Create(direction, tangent(direction)), length);
 	mem->clr = color;
-	++cntArrow;
 }
 
 void Pu::DebugRenderer::AddTransform(const Matrix & transform, float scale, Vector3 offset)
@@ -278,7 +275,6 @@ void Pu::DebugRenderer::AddBox(const AABB & box, Color color)
 	TryStart(1, Box);
 	mem->mdl = Matrix::CreateScaledTranslation(box.LowerBound, box.GetSize());
 	mem->clr = color;
-	++cntBox;
 }
 
 void Pu::DebugRenderer::AddBox(const AABB & box, const Matrix & transform, Color color)
@@ -286,7 +282,6 @@ void Pu::DebugRenderer::AddBox(const AABB & box, const Matrix & transform, Color
 	TryStart(1, Box);
 	mem->mdl = transform * Matrix::CreateScaledTranslation(box.LowerBound, box.GetSize());
 	mem->clr = color;
-	++cntBox;
 }
 
 void Pu::DebugRenderer::AddBox(const OBB & box, Color color)
@@ -294,7 +289,6 @@ void Pu::DebugRenderer::AddBox(const OBB & box, Color color)
 	TryStart(1, Box);
 	mem->mdl = Matrix::CreateWorld((box.Center - box.Orientation * box.Extent), box.Orientation, box.Extent * 2.0f);
 	mem->clr = color;
-	++cntBox;
 }
 
 void Pu::DebugRenderer::AddSphere(Sphere sphere, Color color)
@@ -312,57 +306,60 @@ void Pu::DebugRenderer::AddEllipsoid(Vector3 center, float xRadius, float yRadiu
 	TryStart(1, Ellipsoid);
 	mem->mdl = Matrix::CreateScaledTranslation(center, Vector3(xRadius, yRadius, zRadius));
 	mem->clr = color;
-	++cntEllipsoid;
 }
 
+/*
+The caps, the vertical lines and every ring are reserved separately.
+A full buffer only skips (and counts as dropped) the parts that don't fit, the other parts are still drawn.
+*/
 void Pu::DebugRenderer::AddCapsule(Vector3 center, float height, float radius, Color color)
 {
 	/* Caps. */
+	if (VertexLayout *mem = Reserve(Hemisphere_LIST, 2))
 	{
-		TryStart(2, Hemisphere);
-
 		mem->mdl = Matrix::CreateScaledTranslation(Vector3(center.X, center.Y + height * 0.5f, center.Z), radius);
 		mem++->clr = color;
 
 		mem->mdl = Matrix::CreateWorld(Vector3(center.X, center.Y - height * 0.5f, center.Z), Quaternion{ 0.0f, 1.0f, 0.0f, 0.0f }, radius);
 		mem->clr = color;
-
-		cntHemisphere += 2;
 	}
 
 	/* Cylinder. */
+	constexpr float delta = TAU / TRIG_BUFFER_SIZE;
+	if (VertexLayout *mem = Reserve(Line_LIST, TRIG_BUFFER_SIZE))
 	{
-		constexpr float delta = TAU / TRIG_BUFFER_SIZE;
-
-		for (float theta = 0.0f; theta < TAU; theta += delta)
+		for (uint32 i = 0; i < TRIG_BUFFER_SIZE; i++)
 		{
-			const float ct = cosf(theta);
-			const float st = sinf(theta);
+			const float ct = cosf(i * delta);
+			const float st = sinf(i * delta);
 			const Vector3 start = center + Vector3(ct * radius, height * 0.5f, st * radius);
 			const Vector3 end = center + Vector3(ct * radius, height * -0.5f, st * radius);
-			AddLineInternal(start, end, color);
+			WriteLine(mem++, start, end, color);
 		}
+	}
 
-		const float adder = radius / (TRIG_BUFFER_SIZE >> 3);
-		for (float h = height * -0.5f + adder; h < height * 0.5f - adder; h += adder)
+	const float adder = radius / (TRIG_BUFFER_SIZE >> 3);
+	for (float h = height * -0.5f + adder; h < height * 0.5f - adder; h += adder)
+	{
+		VertexLayout *mem = Reserve(Line_LIST, TRIG_BUFFER_SIZE);
+		if (!mem) continue;
+
+		Vector3 startP = center + Vector3(cosf((TRIG_BUFFER_SIZE - 1) * delta) * radius, h, sinf((TRIG_BUFFER_SIZE - 1) * delta) * radius);
+		for (uint32 i = 0; i < TRIG_BUFFER_SIZE; i++)
 		{
-			Vector3 startP = center + Vector3(cosf((TRIG_BUFFER_SIZE - 1) * delta) * radius, h, sinf((TRIG_BUFFER_SIZE - 1) * delta) * radius);
-			for (float theta = 0.0f; theta < TAU; theta += delta)
-			{
-				const float ct = cosf(theta);
-				const float st = sinf(theta);
+			const float ct = cosf(i * delta);
+			const float st = sinf(i * delta);
 
-				const Vector3 endP = center + Vector3(ct * radius, h, st * radius);
-				AddLineInternal(startP, endP, color);
-				startP = endP;
-			}
+			const Vector3 endP = center + Vector3(ct * radius, h, st * radius);
+			WriteLine(mem++, startP, endP, color);
+			startP = endP;
 		}
 	}
 }
 
 void Pu::DebugRenderer::AddFrustum(const Frustum & frustum, Color color)
 {
-	CapacityEarlyOut(24, cntLine);
+	TryStart(12, Line);
 
 	/* We calculate 8 corner points by intersecting the frustum bounds. */
 	const Vector3 nbl = Plane::IntersectionPoint(frustum.Near(), frustum.Left(), frustum.Bottom());
@@ -375,22 +372,22 @@ void Pu::DebugRenderer::AddFrustum(const Frustum & frustum, Color color)
 	const Vector3 ftl = Plane::IntersectionPoint(frustum.Far(), frustum.Left(), frustum.Top());
 
 	/* Near plane */
-	AddLineInternal(nbl, nbr, color);
-	AddLineInternal(nbl, ntl, color);
-	AddLineInternal(ntr, nbr, color);
-	AddLineInternal(ntr, ntl, color);
+	WriteLine(mem++, nbl, nbr, color);
+	WriteLine(mem++, nbl, ntl, color);
+	WriteLine(mem++, ntr, nbr, color);
+	WriteLine(mem++, ntr, ntl, color);
 
 	/* Far plane */
-	AddLineInternal(fbl, fbr, color);
-	AddLineInternal(fbl, ftl, color);
-	AddLineInternal(ftr, fbr, color);
-	AddLineInternal(ftr, ftl, color);
+	WriteLine(mem++, fbl, fbr, color);
+	WriteLine(mem++, fbl, ftl, color);
+	WriteLine(mem++, ftr, fbr, color);
+	WriteLine(mem++, ftr, ftl, color);
 
 	/* Inbetween lines */
-	AddLineInternal(nbl, fbl, color);
-	AddLineInternal(nbr, fbr, color);
-	AddLineInternal(ntl, ftl, color);
-	AddLineInternal(ntr, ftr, color);
+	WriteLine(mem++, nbl, fbl, color);
+	WriteLine(mem++, nbr, fbr, color);
+	WriteLine(mem++, ntl, ftl, color);
+	WriteLine(mem++, ntr, ftr, color);
 }
 
 void Pu::DebugRenderer::Render(CommandBuffer & cmdBuffer, const Camera & camera, bool clearBuffer)
@@ -401,7 +398,16 @@ void Pu::DebugRenderer::Render(CommandBuffer & cmdBuffer, const Camera & camera,
 		/* Only render if the pipeline is loaded. */
 		if (pipeline->IsUsable() && meshes->IsUsable())
 		{
-			if (!(cntLine | cntArrow | cntBox | cntEllipsoid | cntHemisphere)) return;
+			/* The counters never go past the capacity, so every counted instance was reserved by a shape. */
+			uint32 instances[LIST_COUNT];
+			uint32 total = 0;
+			for (uint32 i = 0; i < LIST_COUNT; i++)
+			{
+				instances[i] = counts[i].load(std::memory_order_acquire);
+				total += instances[i];
+			}
+
+			if (!total) return;
 
 			Profiler::Add(*query, cmdBuffer, true);
 			cmdBuffer.AddLabel("Debug Renderer", Color::CodGray());
@@ -423,11 +429,10 @@ void Pu::DebugRenderer::Render(CommandBuffer & cmdBuffer, const Camera & camera,
 			/* Render the debug lines. */
 			meshes->Bind(cmdBuffer, 0, 1);
 			cmdBuffer.BindVertexBuffer(1, *buffer, 0);
-			if (cntLine) meshes->GetMesh(0).Draw(cmdBuffer, Line_START, cntLine);
-			if (cntArrow) meshes->GetMesh(1).Draw(cmdBuffer, Arrow_START, cntArrow);
-			if (cntBox) meshes->GetMesh(2).Draw(cmdBuffer, Box_START, cntBox);
-			if (cntEllipsoid) meshes->GetMesh(3).Draw(cmdBuffer, Ellipsoid_START, cntEllipsoid);
-			if (cntHemisphere) meshes->GetMesh(4).Draw(cmdBuffer, Hemisphere_START, cntHemisphere);
+			for (uint32 i = 0; i < LIST_COUNT; i++)
+			{
+				if (instances[i]) meshes->GetMesh(i).Draw(cmdBuffer, static_cast<uint32>(i * MaxDebugRendererObjects), instances[i]);
+			}
 
 			/* End the renderpass. */
 			query->RecordTimestamp(cmdBuffer, 0, PipelineStageFlags::BottomOfPipe);
@@ -439,25 +444,16 @@ void Pu::DebugRenderer::Render(CommandBuffer & cmdBuffer, const Camera & camera,
 	/* Clear the buffer to make sure that we don't get shapes from previous calls in one draw batch. */
 	if (clearBuffer)
 	{
-		cntLine = 0;
-		cntArrow = 0;
-		cntBox = 0;
-		cntEllipsoid = 0;
-		cntHemisphere = 0;
+		for (std::atomic<uint32> &cur : counts) cur.store(0, std::memory_order_relaxed);
 	}
 
-	/* Log and warning if the user exceeds their limit once. */
-#ifdef _DEBUG
-	if (culled)
+	/* Log a warning if the user exceeds their limit once, the amount is always available through the counter. */
+	lastDropped = dropped.exchange(0, std::memory_order_relaxed);
+	if (lastDropped && !thrown)
 	{
-		if (!thrown)
-		{
-			thrown = true;
-			Log::Warning("Unable to render %u debug lines, consider upgrading the MaxDebugRendererVertices.", culled);
-		}
-		culled = 0;
+		thrown = true;
+		Log::Warning("Unable to render %u debug shapes, consider upgrading the MaxDebugRendererObjects.", lastDropped);
 	}
-#endif
 }
 
 #pragma warning(push)
@@ -483,21 +479,28 @@ void Pu::DebugRenderer::Reset(const DepthBuffer & depthBuffer)
 }
 #pragma warning(pop)
 
-bool Pu::DebugRenderer::CheckCapacity(uint32 list, uint32 addition) const
+/*
+Every thread reserves its range with a compare exchange, so the ranges never overlap.
+A reservation that doesn't fit is never added to the counter, this way the renderer never draws slots that weren't written.
+The shapes that didn't fit are counted as dropped.
+*/
+Pu::DebugRenderer::VertexLayout * Pu::DebugRenderer::Reserve(uint32 list, uint32 amount)
 {
-#ifdef _DEBUG
-	if (list + addition <= MaxDebugRendererObjects) return false;
-
-	culled += addition;
-	return true;
-#else
-	return list + addition > MaxDebugRendererObjects;
-#endif
+	uint32 start = counts[list].load(std::memory_order_relaxed);
+	do
+	{
+		if (start + amount > MaxDebugRendererObjects)
+		{
+			dropped.fetch_add(amount, std::memory_order_relaxed);
+			return nullptr;
+		}
+	} while (!counts[list].compare_exchange_weak(start, start + amount, std::memory_order_relaxed));
+
+	return reinterpret_cast<VertexLayout*>(buffer->GetHostMemory()) + list * MaxDebugRendererObjects + start;
 }
 
-void Pu::DebugRenderer::AddLineInternal(Vector3 start, Vector3 end, Color color)
+void Pu::DebugRenderer::WriteLine(VertexLayout * mem, Vector3 start, Vector3 end, Color color)
 {
-	GetOffset(Line);
 	/*
 	The model for the line is just two points ([0, 0, 0] and [0, 0, 1]).
 	This code effectively translates that line to start start position,
@@ -522,7 +525,6 @@ void Pu::DebugRenderer::AddLineInternal(Vector3 start, Vector3 end, Color color)
 		0.0f, 0.0f, 0.0f, 1.0f };
 
 	mem->clr = color;
-	++cntLine;
 }
 
 void Pu::DebugRenderer::InitializeRenderpass(Renderpass &)
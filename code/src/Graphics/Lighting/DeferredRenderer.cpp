@@ -47,15 +47,15 @@ class LightVolumeStageTask
 	: public Task
 {
 public:
-	LightVolumeStageTask(AssetFetcher &fetcher, MeshCollection &result)
-		: Task("Generate Light Volumes"), result(result), fetcher(fetcher)
+	LightVolumeStageTask(AssetFetcher &fetcher, MeshCollection &result, uint16 divisions)
+		: Task("Generate Light Volumes"), result(result), fetcher(fetcher), divisions(divisions)
 	{}
 
 	Result Execute(void) final
 	{
-		StagingBuffer *staging = new StagingBuffer(fetcher.GetDevice(), ShapeCreator::GetVolumeSphereBufferSize(EllipsiodDivs));
-		Mesh mesh = ShapeCreator::VolumeSphere(*staging, EllipsiodDivs);
-		result.Initialize(fetcher.GetDevice(), *staging, ShapeCreator::GetVolumeSphereVertexSize(EllipsiodDivs), std::move(mesh));
+		StagingBuffer *staging = new StagingBuffer(fetcher.GetDevice(), ShapeCreator::GetVolumeSphereBufferSize(divisions));
+		Mesh mesh = ShapeCreator::VolumeSphere(*staging, divisions);
+		result.Initialize(fetcher.GetDevice(), *staging, ShapeCreator::GetVolumeSphereVertexSize(divisions), std::move(mesh));
 
 		fetcher.GetLoader().StageBuffer(*staging, result.GetBuffer(), PipelineStageFlags::VertexInput, AccessFlags::VertexAttributeRead, L"Deferred Renderer Light Volumes");
 		return Result::AutoDelete();
@@ -64,6 +64,7 @@ public:
 private:
 	AssetFetcher &fetcher;
 	MeshCollection &result;
+	uint16 divisions;
 };
 
 /*
@@ -124,12 +125,13 @@ Pu::DeferredRenderer::DeferredRenderer(AssetFetcher & fetcher, GameWindow & wnd)
 	: wnd(&wnd), depthBuffer(nullptr), markNeeded(true), fetcher(&fetcher), skybox(nullptr),
 	gfxTerrain(nullptr), gfxGPassBasic(nullptr), gfxGPassAdv(nullptr), gfxDLight(nullptr),
 	gfxPLight(nullptr), gfxSkybox(nullptr), gfxTonePass(nullptr), curCmd(nullptr),
-	curCam(nullptr), descPoolInput(nullptr), descSetInput(nullptr), renderpassStarted(false),
-	activeSubpass(SubpassNone), lightVolumes(new MeshCollection())
+	curCam(nullptr), descPoolInput(nullptr), descSetInput(nullptr), descSetSkybox(nullptr), renderpassStarted(false),
+	secondaryActive(false), activeSubpass(SubpassNone), lightVolumes(new MeshCollection()),
+	coarseLightVolumes(new MeshCollection()), coarseVolumeBound(false)
 {
 #ifdef _DEBUG
 	/* Only add the tessellation flag if it's supported. */
-	QueryPipelineStatisticFlags statFlags = QueryPipelineStatisticFlags::VertexShaderInvocations | QueryPipelineStatisticFlags::FragmentShaderInvocations;
+	statFlags = QueryPipelineStatisticFlags::VertexShaderInvocations | QueryPipelineStatisticFlags::FragmentShaderInvocations;
 	if (GetDevice().GetPhysicalDevice().GetEnabledFeatures().TessellationShader) statFlags |= QueryPipelineStatisticFlags::TessellationEvaluationShaderInvocations;
 #endif
 
@@ -153,8 +155,10 @@ Pu::DeferredRenderer::DeferredRenderer(AssetFetcher & fetcher, GameWindow & wnd)
 	/* Load the first iteration of the renderpass (might be updated later) and fetch the sampler for the HDR buffer. */
 	CreateRenderpass(RuntimeConfig::QueryBool(L"TessellationEnabled"));
 
-	/* Create the light volumes. */
-	Task *task = new LightVolumeStageTask(fetcher, *lightVolumes);
+	/* Create the light volumes, small point lights use a volume with fewer triangles. */
+	Task *task = new LightVolumeStageTask(fetcher, *lightVolumes, EllipsiodDivs);
+	TaskScheduler::Spawn(*task);
+	task = new LightVolumeStageTask(fetcher, *coarseLightVolumes, PointLightCoarseDivs);
 	TaskScheduler::Spawn(*task);
 
 	timer = new ProfilerChain(wnd.GetDevice(), 5);
@@ -236,6 +240,16 @@ void Pu::DeferredRenderer::UpdateConfigurableProperties(void)
 	if (gfxTonePass) FinalizeTonePass();
 }
 
+bool Pu::DeferredRenderer::SupportsSecondaryRecording(void) const
+{
+#ifdef _DEBUG
+	/* The pipeline statistics query is active during the entire renderpass on debug mode, which secondary command buffers can only inherit if supported. */
+	return GetDevice().GetPhysicalDevice().GetEnabledFeatures().InheritedQueries;
+#else
+	return true;
+#endif
+}
+
 void Pu::DeferredRenderer::InitializeResources(CommandBuffer & cmdBuffer, const Camera & camera)
 {
 	/* Update the profiler and reset the queries. */
@@ -266,7 +280,13 @@ void Pu::DeferredRenderer::Begin(uint32 subpass)
 {
 	/* Early out if this subpass is already active. */
 	const uint32 uActiveSubpass = static_cast<uint32>(activeSubpass);
-	if (uActiveSubpass == subpass) return;
+	if (uActiveSubpass == subpass)
+	{
+#ifdef _DEBUG
+		if (secondaryActive) Log::Fatal("Cannot record inline commands in subpass %u, it was started for secondary command buffers!", subpass);
+#endif
+		return;
+	}
 
 	/* Check if the user is calling in the correct order on debug mode. */
 #ifdef _DEBUG
@@ -276,7 +296,7 @@ void Pu::DeferredRenderer::Begin(uint32 subpass)
 #endif
 
 	/* Finalize the old subpass. */
-	EndSubpass(subpass, uActiveSubpass);
+	EndSubpass(subpass, uActiveSubpass, SubpassContents::Inline);
 
 	/* Add a debug label on debug mode. */
 #ifdef _DEBUG
@@ -361,19 +381,40 @@ void Pu::DeferredRenderer::Begin(uint32 subpass)
 		return;
 	}
 
-	if (subpass == SubpassPointLight)
-	{
-		/* Bind the point light volume sphere to the first binding. */
-		const Mesh &sphere = lightVolumes->GetShape(0).second;
-		curCmd->BindVertexBuffer(0, lightVolumes->GetBuffer(), lightVolumes->GetViewOffset(sphere.GetVertexView()));
-		curCmd->BindIndexBuffer(sphere.GetIndexType(), lightVolumes->GetBuffer(), lightVolumes->GetViewOffset(sphere.GetIndexView()));
-	}
+	/* Bind the point light volume sphere to the first binding. */
+	if (subpass == SubpassPointLight) BindLightVolume(false);
 
 	/* A graphics pipeline should always be bound. */
 	curCmd->BindGraphicsPipeline(*curGfx);
 	activeSubpass = static_cast<int32>(subpass);
 }
 
+void Pu::DeferredRenderer::BeginSecondary(uint32 subpass)
+{
+	const uint32 uActiveSubpass = static_cast<uint32>(activeSubpass);
+	if (uActiveSubpass == subpass && secondaryActive) return;
+
+	/* A subpass can only have one type of contents and only the static geometry is recorded in parallel. */
+#ifdef _DEBUG
+	if (activeSubpass == SubpassNone) Log::Fatal("InitializeResources should be called before any BeginSecondary subpass call!");
+	if (static_cast<int32>(subpass) <= activeSubpass) Log::Fatal("Cannot begin secondary subpass %u after subpass %d!", subpass, activeSubpass);
+	if (subpass != SubpassBasicStaticGeometry && subpass != SubpassAdvancedStaticGeometry) Log::Fatal("Only the static geometry subpasses can be recorded in secondary command buffers!");
+#endif
+
+	/* The pipeline and descriptors are bound by the secondary command buffers themselves. */
+	EndSubpass(subpass, uActiveSubpass, SubpassContents::SecondaryCommandBuffers);
+	activeSubpass = static_cast<int32>(subpass);
+}
+
+void Pu::DeferredRenderer::Execute(const CommandBuffer & secondary)
+{
+#ifdef _DEBUG
+	if (!secondaryActive) Log::Fatal("Cannot execute secondary command buffer in inline subpass %d!", activeSubpass);
+#endif
+
+	curCmd->ExecuteCommands(secondary);
+}
+
 void Pu::DeferredRenderer::End(void)
 {
 	/* We should ignore this call if nothing was rendered. */
@@ -381,7 +422,7 @@ void Pu::DeferredRenderer::End(void)
 	const uint32 uActiveSubpass = static_cast<uint32>(activeSubpass);
 
 	/* End the current subpass on debug mode. */
-	EndSubpass(skybox ? SubpassSkybox : SubpassPostProcessing, activeSubpass);
+	EndSubpass(skybox ? SubpassSkybox : SubpassPostProcessing, activeSubpass, SubpassContents::Inline);
 
 	/* Attempt to do a skybox pass and do the post-processing pass. */
 	DoSkybox();
@@ -415,51 +456,87 @@ void Pu::DeferredRenderer::Render(const TerrainChunk & chunk)
 	}
 }
 
-void Pu::DeferredRenderer::Render(const Model & model, const Matrix & transform)
+Pu::uint32 Pu::DeferredRenderer::Render(const Model & model, uint32 lod, const DynamicBuffer & instances, uint32 firstInstance, uint32 instanceCount)
 {
-	const MeshCollection &meshes = model.GetMeshes();
+	/* The inline list is reused, so encoding only allocates when a model has more meshes than any before it. */
+	inlineList.Clear();
+	const uint32 result = Encode(inlineList, static_cast<uint32>(activeSubpass), model, lod, instances, firstInstance, instanceCount);
+	curCmd->Append(inlineList);
+	return result;
+}
 
-	/* Set the model matrix. */
-	const GraphicsPipeline &pipeline = *(activeSubpass == SubpassAdvancedStaticGeometry ? gfxGPassAdv : gfxGPassBasic);
-	curCmd->PushConstants(pipeline, ShaderStageFlags::Vertex, 0, sizeof(Matrix), transform.GetComponents());
+void Pu::DeferredRenderer::Encode(CommandList & list, uint32 subpass) const
+{
+	/* Both static geometry pipelines use the camera sets of the advanced subpass. */
+	list.BindGraphicsPipeline(*(subpass == SubpassAdvancedStaticGeometry ? gfxGPassAdv : gfxGPassBasic));
+	list.BindGraphicsDescriptors(SubpassAdvancedStaticGeometry, *curCam);
+}
+
+/*
+The objects are already culled by the rendering system, so the meshes are not culled individually.
+Every mesh is drawn once for all the instances, so the draw call count is independent of the instance count.
+Only the meshes of the requested level of detail are drawn, the rendering system selects the level per instance.
+*/
+Pu::uint32 Pu::DeferredRenderer::Encode(CommandList & list, uint32 subpass, const Model & model, uint32 lod, const DynamicBuffer & instances, uint32 firstInstance, uint32 instanceCount) const
+{
+	const MeshCollection &meshes = model.GetMeshes();
+	const GraphicsPipeline &pipeline = *(subpass == SubpassAdvancedStaticGeometry ? gfxGPassAdv : gfxGPassBasic);
+	list.BindVertexBuffer(1, instances, 0);
 
 	const uint32 requiredStride = pipeline.GetVertexStride(0);
 	uint32 oldMatIdx = MeshCollection::DefaultMaterialIdx;
 	uint32 oldVrtxView = Mesh::DefaultViewIdx;
 	uint32 oldIdxView = Mesh::DefaultViewIdx;
+	uint32 drawCalls = 0;
 
-	/* Try to render all the individual meshes. */
-	for (const auto &[matIdx, mesh] : meshes)
+	/* Try to render all the individual meshes of the level. */
+	for (const uint32 idx : model.GetLevel(lod))
 	{
-		/* Cull the mesh if any of the following conditions are met. */
+		const auto &[matIdx, mesh] = meshes.GetShape(idx);
+
+		/* Skip the mesh if any of the following conditions are met. */
 		if (matIdx == MeshCollection::DefaultMaterialIdx) continue;
 		if (mesh.GetStride() != requiredStride) continue;
-		if (curCam->Cull(mesh.GetBoundingBox(), transform)) continue;
 
 		/* Update the bound material if needed. */
 		if (matIdx != oldMatIdx)
 		{
 			oldMatIdx = matIdx;
-			curCmd->BindGraphicsDescriptor(pipeline, model.GetMaterial(matIdx));
+			list.BindGraphicsDescriptor(model.GetMaterial(matIdx));
 		}
 
 		/* Update the vertex binding if needed. */
 		if (mesh.GetVertexView() != oldVrtxView)
 		{
 			oldVrtxView = mesh.GetVertexView();
-			curCmd->BindVertexBuffer(0, meshes.GetBuffer(), meshes.GetViewOffset(oldVrtxView));
+			list.BindVertexBuffer(0, meshes.GetBuffer(), meshes.GetViewOffset(oldVrtxView));
 		}
 
 		/* Update the index binding if needed. */
 		if (mesh.GetIndexView() != oldIdxView)
 		{
 			oldIdxView = mesh.GetIndexView();
-			curCmd->BindIndexBuffer(mesh.GetIndexType(), meshes.GetBuffer(), meshes.GetViewOffset(oldIdxView));
+			list.BindIndexBuffer(mesh.GetIndexType(), meshes.GetBuffer(), meshes.GetViewOffset(oldIdxView));
 		}
 
-		/* Render the mesh. */
-		mesh.Draw(*curCmd, 0, 1);
+		/* Render all the instances of the mesh. */
+		mesh.Draw(list, firstInstance, instanceCount);
+		++drawCalls;
 	}
+
+	return drawCalls;
+}
+
+void Pu::DeferredRenderer::RecordSecondary(CommandBuffer & cmdBuffer, uint32 subpass, const CommandList & list) const
+{
+#ifdef _DEBUG
+	cmdBuffer.Begin(*renderpass, subpass, wnd->GetCurrentFramebuffer(*renderpass), statFlags);
+#else
+	cmdBuffer.Begin(*renderpass, subpass, wnd->GetCurrentFramebuffer(*renderpass));
+#endif
+
+	cmdBuffer.Append(list);
+	cmdBuffer.End();
 }
 
 void Pu::DeferredRenderer::Render(const Model & model, const Matrix & transform, uint32 keyFrame1, uint32 keyFrame2, float blending)
@@ -501,19 +578,32 @@ void Pu::DeferredRenderer::Render(const DirectionalLight & light)
 	curCmd->Draw(3, 1, 0, 0);
 }
 
-void Pu::DeferredRenderer::Render(const PointLightPool & lights)
+void Pu::DeferredRenderer::Render(const PointLightPool & lights, uint32 firstLight, uint32 lightCount, bool coarse)
 {
 	DBG_CHECK_SUBPASS(SubpassPointLight);
+
+	/* Both light volumes use the same pipeline, so only the volume mesh has to be swapped. */
+	if (coarse != coarseVolumeBound) BindLightVolume(coarse);
 	curCmd->BindVertexBuffer(1, lights, 0);
-	lightVolumes->GetShape(0).second.Draw(*curCmd, 0, lights.GetLightCount());
+	(coarse ? coarseLightVolumes : lightVolumes)->GetShape(0).second.Draw(*curCmd, firstLight, lightCount);
 }
 
 void Pu::DeferredRenderer::SetSkybox(const TextureCube & texture)
 {
-	if (descSetInput)
+	if (descPoolInput)
 	{
+		/*
+		The skybox set is cached by its texture, so switching back to a previous skybox doesn't allocate or write a set.
+		A set that might still be in flight is also never overwritten, as a different texture always gets a different set.
+		*/
+		vector<uint64> resources;
+		DescriptorSetBase::AddResource(resources, texture);
+		DescriptorSet *set = new DescriptorSet(*descPoolInput, SubpassSkybox, renderpass->GetSubpass(SubpassSkybox).GetSetLayout(1), resources);
+		if (set->NeedsWrite()) set->Write(renderpass->GetSubpass(SubpassSkybox).GetDescriptor("Skybox"), texture);
+
+		delete_s(descSetSkybox);
+		descSetSkybox = set;
 		skybox = &texture;
-		descSetInput->Write(SubpassSkybox, renderpass->GetSubpass(SubpassSkybox).GetDescriptor("Skybox"), texture);
 	}
 	else Log::Fatal("Cannot set skybox when deferred rendering is not yet finalized!");
 }
@@ -540,12 +630,17 @@ void Pu::DeferredRenderer::Visualize(void) const
 #endif
 }
 
-void Pu::DeferredRenderer::EndSubpass(uint32 newSubpass, uint32 uActiveSubpass)
+/*
+Subpasses that are started for secondary command buffers can only contain execute commands,
+so their debug labels are skipped and their timestamps are written just outside of the subpass.
+*/
+void Pu::DeferredRenderer::EndSubpass(uint32 newSubpass, uint32 uActiveSubpass, SubpassContents contents)
 {
 #ifndef _DEBUG
 	(void)uActiveSubpass;
 #endif
 
+	bool endGeometryTimer = false;
 	if (!renderpassStarted)
 	{
 		/* Begin the renderpass and begin the pipeline statistics recording. */
@@ -558,21 +653,25 @@ void Pu::DeferredRenderer::EndSubpass(uint32 newSubpass, uint32 uActiveSubpass)
 	}
 	else
 	{
+		if (!secondaryActive)
+		{
 #ifdef _DEBUG
-		/* End the previous subpass. */
-		curCmd->EndLabel();
+			/* End the previous subpass. */
+			curCmd->EndLabel();
 #endif
 
-		/* End the terrain timer if needed. */
-		if (uActiveSubpass == SubpassTerrain)
-		{
-			timer->RecordTimestamp(*curCmd, TerrainTimer, PipelineStageFlags::BottomOfPipe);
+			/* End the terrain timer if needed. */
+			if (uActiveSubpass == SubpassTerrain)
+			{
+				timer->RecordTimestamp(*curCmd, TerrainTimer, PipelineStageFlags::BottomOfPipe);
+			}
 		}
 
 		/* End the geometry timer if needed. */
 		if (is_geometry_subpass(uActiveSubpass) && !is_geometry_subpass(newSubpass))
 		{
-			timer->RecordTimestamp(*curCmd, GeometryTimer, PipelineStageFlags::BottomOfPipe);
+			if (secondaryActive) endGeometryTimer = true;
+			else timer->RecordTimestamp(*curCmd, GeometryTimer, PipelineStageFlags::BottomOfPipe);
 		}
 
 		/* End the lighting timer if needed. */
@@ -582,11 +681,21 @@ void Pu::DeferredRenderer::EndSubpass(uint32 newSubpass, uint32 uActiveSubpass)
 		}
 	}
 
-	/* Skip to the correct subpass. */
-	for (uint32 i = 0; i < newSubpass - max(0, activeSubpass); i++)
+	/* Start the geometry timer before entering the subpass if it can't be started from within. */
+	if (contents == SubpassContents::SecondaryCommandBuffers && !is_geometry_subpass(uActiveSubpass))
 	{
-		curCmd->NextSubpass(SubpassContents::Inline);
+		timer->RecordTimestamp(*curCmd, GeometryTimer, PipelineStageFlags::TopOfPipe);
 	}
+
+	/* Skip to the correct subpass, only the last subpass uses the requested contents. */
+	const uint32 transitions = newSubpass - max(0, activeSubpass);
+	for (uint32 i = 1; i <= transitions; i++)
+	{
+		curCmd->NextSubpass(i < transitions ? SubpassContents::Inline : contents);
+	}
+
+	if (endGeometryTimer) timer->RecordTimestamp(*curCmd, GeometryTimer, PipelineStageFlags::BottomOfPipe);
+	secondaryActive = contents == SubpassContents::SecondaryCommandBuffers;
 }
 
 void Pu::DeferredRenderer::DoSkybox(void)
@@ -598,7 +707,7 @@ void Pu::DeferredRenderer::DoSkybox(void)
 		timer->RecordTimestamp(*curCmd, SkyboxTimer, PipelineStageFlags::TopOfPipe);
 		curCmd->BindGraphicsPipeline(*gfxSkybox);
 		curCmd->BindGraphicsDescriptors(*gfxSkybox, SubpassSkybox, *curCam);
-		curCmd->BindGraphicsDescriptors(*gfxSkybox, SubpassSkybox, *descSetInput);
+		curCmd->BindGraphicsDescriptor(*gfxSkybox, *descSetSkybox);
 		curCmd->Draw(3, 1, 0, 0);
 		curCmd->EndLabel();
 		timer->RecordTimestamp(*curCmd, SkyboxTimer, PipelineStageFlags::BottomOfPipe);
@@ -619,6 +728,16 @@ void Pu::DeferredRenderer::DoTonemap(void)
 	timer->RecordTimestamp(*curCmd, PostTimer, PipelineStageFlags::BottomOfPipe);
 }
 
+void Pu::DeferredRenderer::BindLightVolume(bool coarse)
+{
+	const MeshCollection &volumes = coarse ? *coarseLightVolumes : *lightVolumes;
+	const Mesh &sphere = volumes.GetShape(0).second;
+
+	curCmd->BindVertexBuffer(0, volumes.GetBuffer(), volumes.GetViewOffset(sphere.GetVertexView()));
+	curCmd->BindIndexBuffer(sphere.GetIndexType(), volumes.GetBuffer(), volumes.GetViewOffset(sphere.GetIndexView()));
+	coarseVolumeBound = coarse;
+}
+
 void Pu::DeferredRenderer::OnSwapchainRecreated(const GameWindow&, const SwapchainReCreatedEventArgs & args)
 {
 	/* We can't ignore the event fully if the renderpass isn't loaded yet. */
@@ -682,6 +801,8 @@ void Pu::DeferredRenderer::InitializeRenderpass(Renderpass &)
 		gpass.CloneOutput("GBufferSpecular", 2);
 		gpass.CloneOutput("GBufferNormal", 3);
 
+		/* The model matrices are stored per instance in the second vertex binding. */
+		gpass.GetAttribute("InstanceModel").SetBinding(1);
 		gpass.GenerateAttributeOffsets();
 	}
 
@@ -696,6 +817,7 @@ void Pu::DeferredRenderer::InitializeRenderpass(Renderpass &)
 		gpass.CloneOutput("GBufferSpecular", 2);
 		gpass.CloneOutput("GBufferNormal", 3);
 
+		gpass.GetAttribute("InstanceModel").SetBinding(1);
 		gpass.GenerateAttributeOffsets();
 	}
 
@@ -805,16 +927,16 @@ void Pu::DeferredRenderer::FinalizeRenderpass(Renderpass &)
 		/* We only need to create the descriptor set for the input attachments once. */
 		descPoolInput = new DescriptorPool(*renderpass);
 		descPoolInput->AddSet(SubpassDirectionalLight, 1, 1);
-		descPoolInput->AddSet(SubpassSkybox, 1, 1);
+		descPoolInput->AddSet(SubpassSkybox, 1, 1); /* Only used to size the pool, the skybox sets are cached. */
 		descPoolInput->AddSet(SubpassPostProcessing, 1, 1);
 
 		descSetInput = new DescriptorSetGroup(*descPoolInput);
 		descSetInput->Add(SubpassDirectionalLight, renderpass->GetSubpass(SubpassDirectionalLight).GetSetLayout(1));
-		descSetInput->Add(SubpassSkybox, renderpass->GetSubpass(SubpassSkybox).GetSetLayout(1));
 		descSetInput->Add(SubpassPostProcessing, renderpass->GetSubpass(SubpassPostProcessing).GetSetLayout(1));
 
-		/* Write the input attachments to the descriptor set. */
+		/* Write the input attachments to the descriptor set and recreate the skybox set if the renderpass was recreated. */
 		WriteDescriptors();
+		if (skybox) SetSkybox(*skybox);
 	}
 
 	/* Create the graphics pipeline for the terrain pass. */
@@ -845,6 +967,7 @@ void Pu::DeferredRenderer::FinalizeRenderpass(Renderpass &)
 		gfxGPassBasic->SetTopology(PrimitiveTopology::TriangleList);
 		gfxGPassBasic->EnableDepthTest(true, CompareOp::LessOrEqual);
 		gfxGPassBasic->AddVertexBinding<Basic3D>(0);
+		gfxGPassBasic->AddVertexBinding<Matrix>(1, VertexInputRate::Instance);
 		gfxGPassBasic->Finalize();
 		gfxGPassBasic->SetDebugName("Deferred Renderer Basic Static");
 	}
@@ -856,6 +979,7 @@ void Pu::DeferredRenderer::FinalizeRenderpass(Renderpass &)
 		gfxGPassAdv->SetTopology(PrimitiveTopology::TriangleList);
 		gfxGPassAdv->EnableDepthTest(true, CompareOp::LessOrEqual);
 		gfxGPassAdv->AddVertexBinding<Advanced3D>(0);
+		gfxGPassAdv->AddVertexBinding<Matrix>(1, VertexInputRate::Instance);
 		gfxGPassAdv->Finalize();
 		gfxGPassAdv->SetDebugName("Deferred Renderer Advanced Static");
 	}
@@ -982,7 +1106,6 @@ void Pu::DeferredRenderer::WriteDescriptors(void)
 	descSetInput->Write(SubpassDirectionalLight, renderpass->GetSubpass(SubpassDirectionalLight).GetDescriptor("GBufferSpecular"), *reinterpret_cast<const TextureInput2D*>(textures[1]));
 	descSetInput->Write(SubpassDirectionalLight, renderpass->GetSubpass(SubpassDirectionalLight).GetDescriptor("GBufferNormal"), *reinterpret_cast<const TextureInput2D*>(textures[2]));
 	descSetInput->Write(SubpassDirectionalLight, renderpass->GetSubpass(SubpassDirectionalLight).GetDescriptor("GBufferDepth"), *depthBuffer);
-	if (skybox) descSetInput->Write(SubpassSkybox, renderpass->GetSubpass(SubpassSkybox).GetDescriptor("Skybox"), *skybox);
 	descSetInput->Write(SubpassPostProcessing, renderpass->GetSubpass(SubpassPostProcessing).GetDescriptor("HdrBuffer"), *textures[3]);
 }
 
@@ -1054,6 +1177,7 @@ void Pu::DeferredRenderer::DestroyPipelines(void)
 	delete_s(gfxSkybox);
 	delete_s(gfxTonePass);
 	delete_s(descSetInput);
+	delete_s(descSetSkybox);
 	delete_s(descPoolInput);
 }
 
@@ -1072,6 +1196,7 @@ void Pu::DeferredRenderer::Destroy(void)
 #endif
 
 	delete lightVolumes;
+	delete coarseLightVolumes;
 
 	/* Release the renderpass to the content manager and remove the event handler for window resizes. */
 	fetcher->Release(*hdrSampler);
@@ -83,9 +83,10 @@ void Pu::LightProbeRenderer::Render(CommandBuffer & cmdBuffer, const Model & mod
 	uint32 oldVrtxView = Mesh::DefaultViewIdx;
 	uint32 oldIdxView = Mesh::DefaultViewIdx;
 
-	/* Try to render all the individual meshes. */
-	for (const auto &[matIdx, mesh] : meshes)
+	/* Only render the meshes of the finest level, the coarser levels cover the same surfaces. */
+	for (const uint32 idx : model.GetLevel(0))
 	{
+		const auto &[matIdx, mesh] = meshes.GetShape(idx);
 		if (mesh.GetStride() != sizeof(Advanced3D)) continue;
 		if (matIdx == MeshCollection::DefaultMaterialIdx) continue;
 
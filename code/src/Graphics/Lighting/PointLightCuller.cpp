@@ -0,0 +1,167 @@
+#include "Graphics/Lighting/PointLightCuller.h"
+#include "Physics/Systems/ShapeTests.h"
+#include "Physics/Systems/OcclusionBuffer.h"
+
+/* Rounds the specified amount of lights up to a full AVX lane. */
+static inline Pu::uint32 point_light_culler_lanes(Pu::uint32 count)
+{
+	return (count + 7) & ~7u;
+}
+
+Pu::PointLightCuller::PointLightCuller(float coarseRadius)
+	: coarseRadius(coarseRadius), visibleCount(0), occludedCount(0)
+{}
+
+void Pu::PointLightCuller::Add(Vector3 position, float radius)
+{
+	x.emplace_back(position.X);
+	y.emplace_back(position.Y);
+	z.emplace_back(position.Z);
+	r.emplace_back(radius);
+	states.emplace_back(State::Outside);
+}
+
+void Pu::PointLightCuller::Set(uint32 idx, Vector3 position, float radius)
+{
+	x[idx] = position.X;
+	y[idx] = position.Y;
+	z[idx] = position.Z;
+	r[idx] = radius;
+}
+
+void Pu::PointLightCuller::RemoveAt(uint32 idx)
+{
+	x.removeAt(idx);
+	y.removeAt(idx);
+	z.removeAt(idx);
+	r.removeAt(idx);
+	states.removeAt(idx);
+}
+
+void Pu::PointLightCuller::Clear(void)
+{
+	x.clear();
+	y.clear();
+	z.clear();
+	r.clear();
+	states.clear();
+	volumeRuns.clear();
+	coarseRuns.clear();
+}
+
+/*
+The projected radius (in pixels) of a light at distance d is r * projScale / d,
+where the projection scale is half the viewport height times the vertical focal length.
+A camera inside of the light volume always uses the full volume.
+
+foreach 8 lights
+	visible = intersects(frustum, sphere)
+	coarse = r * projScale < coarseRadius * |position - camera|
+	foreach visible light
+		if !occlusion.IsVisible(sphere bounds) -> occluded
+*/
+void Pu::PointLightCuller::Cull(const Frustum & frustum, Vector3 camera, const Matrix & projection, float viewportHeight, const OcclusionBuffer * occlusion)
+{
+	/* The data is padded to a full AVX lane, the padding is never written to the states. */
+	const uint32 count = GetCount();
+	const uint32 lanes = point_light_culler_lanes(count);
+	x.resize(lanes);
+	y.resize(lanes);
+	z.resize(lanes);
+	r.resize(lanes);
+
+	AVX_FRUSTUM planes;
+	_mm256_set1_frustum(planes, frustum);
+
+	const ofloat cx = _mm256_set1_ps(camera.X), cy = _mm256_set1_ps(camera.Y), cz = _mm256_set1_ps(camera.Z);
+	const ofloat scale = _mm256_set1_ps(fabsf(projection.GetComponents()[5]) * viewportHeight * 0.5f);
+	const ofloat limit = _mm256_set1_ps(coarseRadius);
+
+	visibleCount = 0;
+	occludedCount = 0;
+	for (uint32 i = 0; i < count; i += 8)
+	{
+		const ofloat px = _mm256_loadu_ps(x.data() + i);
+		const ofloat py = _mm256_loadu_ps(y.data() + i);
+		const ofloat pz = _mm256_loadu_ps(z.data() + i);
+		const ofloat pr = _mm256_loadu_ps(r.data() + i);
+
+		const uint32 hits = intersects(planes, px, py, pz, pr);
+		const ofloat d = _mm256_len_v3(_mm256_sub_ps(px, cx), _mm256_sub_ps(py, cy), _mm256_sub_ps(pz, cz));
+		const uint32 small = static_cast<uint32>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_mul_ps(pr, scale), _mm256_mul_ps(limit, d), _CMP_LT_OQ)));
+
+		const uint32 end = min(count, i + 8);
+		for (uint32 j = i; j < end; j++)
+		{
+			const uint32 bit = 1u << (j - i);
+			State state = State::Outside;
+
+			if (hits & bit)
+			{
+				/* Only the visible lights are tested against the occlusion buffer, as that test isn't vectorized. */
+				const Vector3 extent{ r[j] };
+				const Vector3 center{ x[j], y[j], z[j] };
+				if (occlusion && !occlusion->IsVisible(AABB{ center - extent, center + extent }))
+				{
+					state = State::Occluded;
+					++occludedCount;
+				}
+				else
+				{
+					state = small & bit ? State::Coarse : State::Volume;
+					++visibleCount;
+				}
+			}
+
+			states[j] = state;
+		}
+	}
+
+	/* Remove the padding again, so new lights can be added after the cull. */
+	x.resize(count);
+	y.resize(count);
+	z.resize(count);
+	r.resize(count);
+
+	BuildRuns(State::Volume, volumeRuns);
+	BuildRuns(State::Coarse, coarseRuns);
+}
+
+/*
+Lights outside of the frustum don't produce any fragments, so a small amount of them is allowed within a run to reduce the amount of draws.
+Occluded lights and lights of the other bucket would still be rasterized, so they always end the run.
+
+foreach light
+	if light in bucket
+		open run if needed
+		end = light + 1
+	else if run is open and (light isn't outside or gap is too large)
+		close run at end
+*/
+void Pu::PointLightCuller::BuildRuns(State bucket, vector<PointLightRun> & runs) const
+{
+	runs.clear();
+
+	bool open = false;
+	uint32 start = 0, end = 0;
+	for (uint32 i = 0; i < states.size(); i++)
+	{
+		if (states[i] == bucket)
+		{
+			if (!open)
+			{
+				start = i;
+				open = true;
+			}
+
+			end = i + 1;
+		}
+		else if (open && (states[i] != State::Outside || i - end >= PointLightMaxRunGap))
+		{
+			runs.emplace_back(PointLightRun{ start, end - start });
+			open = false;
+		}
+	}
+
+	if (open) runs.emplace_back(PointLightRun{ start, end - start });
+}
\ No newline at end of file
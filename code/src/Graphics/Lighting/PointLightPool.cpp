@@ -1,7 +1,7 @@
 #include "Graphics/Lighting/PointLightPool.h"
 
 Pu::PointLightPool::PointLightPool(LogicalDevice & device, uint32 maxLights)
-	: DynamicBuffer(device, sizeof(PointLight) * maxLights, BufferUsageFlags::VertexBuffer | BufferUsageFlags::TransferDst), isDirty(false)
+	: DynamicBuffer(device, sizeof(PointLight) * maxLights, BufferUsageFlags::VertexBuffer | BufferUsageFlags::TransferDst), dirtyStart(0), dirtyEnd(0)
 {
 	buffer.reserve(maxLights);
 }
@@ -49,27 +49,60 @@ void Pu::PointLightPool::AddLight(const PointLight & light)
 #endif
 
 	buffer.emplace_back(light);
-	isDirty = true;
+	MarkDirty(GetLightCount() - 1, GetLightCount());
+}
+
+void Pu::PointLightPool::SetLight(uint32 idx, const PointLight & light)
+{
+	buffer[idx] = light;
+	MarkDirty(idx, idx + 1);
+}
+
+void Pu::PointLightPool::RemoveLight(uint32 idx)
+{
+	buffer.removeAt(idx);
+	MarkDirty(idx, GetLightCount());
 }
 
 void Pu::PointLightPool::Update(CommandBuffer & cmdBuffer)
 {
-	if (isDirty) StageLightBuffer();
-	DynamicBuffer::Update(cmdBuffer);
+	/* Lights that were removed at the end of the pool are never drawn, so they don't have to be uploaded. */
+	const uint32 start = dirtyStart;
+	const uint32 end = min(dirtyEnd, GetLightCount());
+
+	if (start < end)
+	{
+		StageLightBuffer();
+		DynamicBuffer::Update(cmdBuffer, start * sizeof(PointLight), (end - start) * sizeof(PointLight));
+	}
+	else DynamicBuffer::Update(cmdBuffer);
 }
 
 void Pu::PointLightPool::StageLightBuffer(void)
 {
-	isDirty = false;
+	const uint32 end = min(dirtyEnd, GetLightCount());
+	if (dirtyStart < end)
+	{
+		BeginMemoryTransfer();
+		PointLight *memory = reinterpret_cast<PointLight*>(GetHostMemory());
+		memcpy(memory + dirtyStart, buffer.data() + dirtyStart, (end - dirtyStart) * sizeof(PointLight));
+		EndMemoryTransfer();
+	}
 
-	BeginMemoryTransfer();
-	PointLight *memory = reinterpret_cast<PointLight*>(GetHostMemory());
+	dirtyStart = 0;
+	dirtyEnd = 0;
+}
 
-	for (const PointLight &cur : buffer)
+void Pu::PointLightPool::MarkDirty(uint32 start, uint32 end)
+{
+	if (dirtyStart < dirtyEnd)
 	{
-		memcpy(memory, &cur, sizeof(PointLight));
-		++memory;
+		dirtyStart = min(dirtyStart, start);
+		dirtyEnd = max(dirtyEnd, end);
+	}
+	else
+	{
+		dirtyStart = start;
+		dirtyEnd = end;
 	}
-
-	EndMemoryTransfer();
 }
\ No newline at end of file
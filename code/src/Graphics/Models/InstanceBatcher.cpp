@@ -0,0 +1,57 @@
+#include "Graphics/Models/InstanceBatcher.h"
+#include "Core/Diagnostics/Logging.h"
+
+void Pu::InstanceBatcher::Clear(void)
+{
+	keys.clear();
+	input.clear();
+	transforms.clear();
+	batches.clear();
+}
+
+void Pu::InstanceBatcher::Add(uint32 subpass, uint32 model, const Matrix & transform, uint32 lod)
+{
+#ifdef _DEBUG
+	if (subpass > 0xFF || lod > 0xFF) Log::Fatal("Cannot add instance with subpass %u and level of detail %u to batcher (out of key range)!", subpass, lod);
+#endif
+
+	/* The subpass is the most significant part of the key, so the subpasses are rendered in order. */
+	const uint64 key = static_cast<uint64>(subpass) << 56 | static_cast<uint64>(model) << 8 | lod;
+	keys.emplace_back(std::make_pair(key, static_cast<uint32>(input.size())));
+	input.emplace_back(transform);
+}
+
+/*
+The input index is used as a tie breaker, so the order of the instances within a batch is deterministic.
+The pages are the instance buffers on the GPU, a batch is split if it would cross into the next buffer.
+
+sort instances on (subpass, model, lod, index)
+foreach instance
+	if key != previous key or instance is first of a page
+		start new batch
+	add transform to batch
+*/
+void Pu::InstanceBatcher::Pack(uint32 pageSize)
+{
+#ifdef _DEBUG
+	if (!pageSize) Log::Fatal("Cannot pack instances into pages of zero size!");
+#endif
+
+	keys.sort([](const std::pair<uint64, uint32> &a, const std::pair<uint64, uint32> &b) { return a < b; });
+	transforms.resize(keys.size());
+	batches.clear();
+
+	uint64 prevKey = 0;
+	for (uint32 i = 0; i < keys.size(); i++)
+	{
+		const auto [key, idx] = keys[i];
+		transforms[i] = input[idx];
+
+		if (batches.empty() || key != prevKey || !(i % pageSize))
+		{
+			batches.emplace_back(InstanceBatch{ static_cast<uint32>(key >> 56), static_cast<uint32>(key >> 8), static_cast<uint32>(key & 0xFF), i, 1 });
+			prevKey = key;
+		}
+		else ++batches.back().InstanceCount;
+	}
+}
\ No newline at end of file
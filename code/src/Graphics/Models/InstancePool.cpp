@@ -0,0 +1,20 @@
+#include "Graphics/Models/InstancePool.h"
+
+Pu::InstancePool::InstancePool(LogicalDevice & device, uint32 maxInstances)
+	: DynamicBuffer(device, sizeof(Matrix) * maxInstances, BufferUsageFlags::VertexBuffer | BufferUsageFlags::TransferDst),
+	capacity(maxInstances), count(0)
+{}
+
+void Pu::InstancePool::Stage(const Matrix * transforms, uint32 instanceCount)
+{
+#ifdef _DEBUG
+	if (instanceCount > capacity) Log::Fatal("Unable to stage %u instances to pool (out of memory)!", instanceCount);
+#endif
+
+	count = instanceCount;
+	if (!count) return;
+
+	BeginMemoryTransfer();
+	memcpy(GetHostMemory(), transforms, sizeof(Matrix) * count);
+	EndMemoryTransfer();
+}
\ No newline at end of file
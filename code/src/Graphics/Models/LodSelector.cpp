@@ -0,0 +1,113 @@
+#include "Graphics/Models/LodSelector.h"
+#include <immintrin.h>
+#include <limits>
+
+/* Rounds the specified amount of objects up to a full AVX lane. */
+static inline Pu::uint32 lod_selector_lanes(Pu::uint32 count)
+{
+	return (count + 7) & ~7u;
+}
+
+Pu::LodSelector::LodSelector(float threshold, float hysteresis)
+	: threshold(threshold), hysteresis(hysteresis), projScale(0.0f)
+{}
+
+/*
+The projected size (in pixels) of a world space length l at distance d is l * projScale / d,
+where the projection scale is half the viewport height times the vertical focal length.
+*/
+void Pu::LodSelector::SetCamera(Vector3 position, const Matrix & projection, float viewportHeight)
+{
+	camera = position;
+	projScale = fabsf(projection.GetComponents()[5]) * viewportHeight * 0.5f;
+}
+
+void Pu::LodSelector::Clear(void)
+{
+	x.clear();
+	y.clear();
+	z.clear();
+	r.clear();
+	for (vector<float> &cur : errors) cur.clear();
+	previous.clear();
+}
+
+void Pu::LodSelector::Add(Vector3 center, float radius, const vector<float> & errors, float scale, uint32 previous)
+{
+	x.emplace_back(center.X);
+	y.emplace_back(center.Y);
+	z.emplace_back(center.Z);
+	r.emplace_back(radius);
+	this->previous.emplace_back(previous);
+
+	/* Levels that the object doesn't have are infinitely far away (this also holds for a zero projection scale), the finest level is never tested. */
+	for (uint32 i = 1; i < MaxLodLevels; i++)
+	{
+		this->errors[i - 1].emplace_back(i < errors.size() ? errors[i] * scale : std::numeric_limits<float>::infinity());
+	}
+}
+
+/*
+A level is allowed once the object is further away than its switch distance, this is the distance at which its error projects to the threshold.
+The errors of the levels increase, so the selected level is the amount of coarser levels that are allowed.
+The distance is measured to the bounding sphere, so large objects never use a coarse level while the camera is near them.
+
+foreach 8 objects
+	d = max(0, |center - camera| - radius)
+	level = 0
+	for l in [1, MaxLodLevels)
+		switch = error[l] * projScale / threshold
+		switch *= l > previous ? 1 + hysteresis : 1 - hysteresis
+		level += d >= switch
+*/
+void Pu::LodSelector::Select(void)
+{
+	/* The data is padded to a full AVX lane, the padding never reaches a coarser level. */
+	const uint32 count = GetCount();
+	const uint32 lanes = lod_selector_lanes(count);
+	x.resize(lanes);
+	y.resize(lanes);
+	z.resize(lanes);
+	r.resize(lanes);
+	for (vector<float> &cur : errors) cur.resize(lanes, std::numeric_limits<float>::infinity());
+	previous.resize(lanes);
+	levels.resize(lanes);
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 cx = _mm256_set1_ps(camera.X), cy = _mm256_set1_ps(camera.Y), cz = _mm256_set1_ps(camera.Z);
+	const __m256 scale = _mm256_set1_ps(projScale / threshold);
+	const __m256 coarser = _mm256_set1_ps(1.0f + hysteresis), finer = _mm256_set1_ps(1.0f - hysteresis);
+
+	for (uint32 i = 0; i < count; i += 8)
+	{
+		const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x.data() + i), cx);
+		const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y.data() + i), cy);
+		const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z.data() + i), cz);
+		const __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		const __m256 d = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_sqrt_ps(d2), _mm256_loadu_ps(r.data() + i)));
+
+		const __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(previous.data() + i));
+		__m256i level = _mm256_setzero_si256();
+
+		for (uint32 l = 1; l < MaxLodLevels; l++)
+		{
+			/* Switching to a level coarser than the previous one is delayed, switching back to a finer level is as well. */
+			const __m256 up = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int32>(l)), prev));
+			const __m256 band = _mm256_blendv_ps(finer, coarser, up);
+			const __m256 dist = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(errors[l - 1].data() + i), scale), band);
+
+			/* The comparison mask is all ones (minus one) for the allowed levels. */
+			level = _mm256_sub_epi32(level, _mm256_castps_si256(_mm256_cmp_ps(d, dist, _CMP_GE_OQ)));
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(levels.data() + i), level);
+	}
+
+	/* Remove the padding again, so new objects can be added after the selection. */
+	x.resize(count);
+	y.resize(count);
+	z.resize(count);
+	r.resize(count);
+	for (vector<float> &cur : errors) cur.resize(count);
+	previous.resize(count);
+}
\ No newline at end of file
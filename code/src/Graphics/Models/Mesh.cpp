@@ -47,6 +47,12 @@ void Pu::Mesh::Draw(CommandBuffer & cmdBuffer, uint32 firstInstance, uint32 inst
 	else cmdBuffer.Draw(count, instanceCount, first, firstInstance);
 }
 
+void Pu::Mesh::Draw(CommandList & list, uint32 firstInstance, uint32 instanceCount) const
+{
+	if (indexView != DefaultViewIdx) list.Draw(count, instanceCount, first, firstInstance, offset);
+	else list.Draw(count, instanceCount, first, firstInstance);
+}
+
 Pu::DrawIndirectCommand Pu::Mesh::Indirect(uint32 instanceCount) const
 {
 	return DrawIndirectCommand{ first, count, 0, instanceCount };
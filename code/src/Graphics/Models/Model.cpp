@@ -4,6 +4,24 @@
 #include "Graphics/VertexLayouts/Advanced3D.h"
 #include "Graphics/VertexLayouts/Basic3D.h"
 
+/* Gets the level of detail from a mesh identifier, meshes without a _LOD<n> suffix are part of the finest level. */
+static Pu::uint32 model_lod_level(const Pu::ustring &identifier)
+{
+	const Pu::ustring upper = identifier.toUpper();
+	const size_t offset = upper.rfind(U"_LOD");
+	if (offset == Pu::ustring::npos || offset + 4 >= upper.length()) return 0;
+
+	Pu::uint32 result = 0;
+	for (size_t i = offset + 4; i < upper.length(); i++)
+	{
+		const char32_t c = upper[i];
+		if (c < U'0' || c > U'9') return 0;
+		result = result * 10 + static_cast<Pu::uint32>(c - U'0');
+	}
+
+	return result;
+}
+
 Pu::Model::Model(void)
 	: Asset(true), Category(ModelCategory::Static),
 	poolMaterials(nullptr), poolProbes(nullptr)
@@ -13,7 +31,7 @@ Pu::Model::Model(Model && value)
 	: Asset(std::move(value)), Category(value.Category), meshes(std::move(value.meshes)),
 	materials(std::move(value.materials)), probeMaterials(std::move(value.probeMaterials)),
 	poolMaterials(value.poolMaterials), poolProbes(value.poolProbes), textures(std::move(value.textures)),
-	nodes(std::move(value.nodes))
+	nodes(std::move(value.nodes)), lods(std::move(value.lods)), lodErrors(std::move(value.lodErrors))
 {
 	value.poolMaterials = nullptr;
 	value.poolProbes = nullptr;
@@ -33,6 +51,8 @@ Pu::Model & Pu::Model::operator=(Model && other)
 		poolProbes = other.poolProbes;
 		textures = std::move(other.textures);
 		nodes = std::move(other.nodes);
+		lods = std::move(other.lods);
+		lodErrors = std::move(other.lodErrors);
 
 		other.poolMaterials = nullptr;
 		other.poolProbes = nullptr;
@@ -48,6 +68,43 @@ Pu::Asset & Pu::Model::Duplicate(AssetCache&)
 	return *this;
 }
 
+/*
+The meshes are split into detail levels by their identifier, so a mesh named "Rock_LOD2" is part of the third level.
+The PuM format doesn't store the simplification error, so it's estimated from the triangle count of every level.
+The average edge length of n triangles that evenly cover the bounding sphere is about r * sqrt(4 * pi / n),
+the error of a level is the amount by which its average edge length exceeds the one of the finest level.
+*/
+void Pu::Model::SetLevels(const vector<PumMesh> * geometry)
+{
+	/* The meshes are added in the same order as the geometry, procedural models don't have identifiers. */
+	lods.clear();
+	for (uint32 i = 0; i < meshes.Count(); i++)
+	{
+		const uint32 lod = min(geometry && i < geometry->size() ? model_lod_level((*geometry)[i].Identifier) : 0u, MaxLodLevels - 1);
+		if (lods.size() <= lod) lods.resize(lod + 1);
+		lods[lod].emplace_back(i);
+	}
+
+	/* Levels can be skipped by the artist, but every model has at least one level. */
+	(void)lods.removeAll([](const vector<uint32> &cur) { return cur.empty(); });
+	if (lods.empty()) lods.emplace_back();
+
+	const float radius = meshes.GetBoundingBox().GetSize().Length() * 0.5f;
+	lodErrors.clear();
+	for (const vector<uint32> &level : lods)
+	{
+		uint32 triangles = 0;
+		for (const uint32 idx : level) triangles += meshes.GetMesh(idx).GetCount() / 3;
+
+		/* The selection expects the errors to increase, so a level with more triangles than its predecessor just inherits the error. */
+		const float edge = radius * sqrtf(4.0f * PI / max(triangles, 1u));
+		lodErrors.emplace_back(lodErrors.empty() ? edge : max(edge, lodErrors.back()));
+	}
+
+	const float reference = lodErrors.front();
+	for (float &cur : lodErrors) cur -= reference;
+}
+
 void Pu::Model::AllocPools(const DeferredRenderer & deferred, const LightProbeRenderer * probes, size_t basicCount, size_t advancedCount)
 {
 	/* Reserve the material vectors to decrease allocations. */
@@ -0,0 +1,137 @@
+#include "Graphics/Resources/CommandList.h"
+#include "Core/Diagnostics/Logging.h"
+
+void Pu::CommandList::Clear(void)
+{
+	commands.clear();
+	gfx = nullptr;
+	draws = 0;
+}
+
+void Pu::CommandList::BindGraphicsPipeline(const GraphicsPipeline & pipeline)
+{
+	gfx = &pipeline;
+	Add(CommandType::BindPipeline);
+}
+
+void Pu::CommandList::BindGraphicsDescriptor(const DescriptorSet & descriptor)
+{
+	Add(CommandType::BindDescriptor).Set = &descriptor;
+}
+
+void Pu::CommandList::BindGraphicsDescriptors(uint32 subpassIdx, const DescriptorSetGroup & descriptors)
+{
+	EncodedCommand &cmd = Add(CommandType::BindDescriptors);
+	cmd.Group = &descriptors;
+	cmd.Args[0] = subpassIdx;
+}
+
+void Pu::CommandList::BindVertexBuffer(uint32 binding, const Buffer & buffer, DeviceSize offset)
+{
+	EncodedCommand &cmd = Add(CommandType::BindVertexBuffer);
+	cmd.Data = &buffer;
+	cmd.Offset = offset;
+	cmd.Args[0] = binding;
+}
+
+void Pu::CommandList::BindIndexBuffer(IndexType type, const Buffer & buffer, DeviceSize offset)
+{
+	EncodedCommand &cmd = Add(CommandType::BindIndexBuffer);
+	cmd.Data = &buffer;
+	cmd.Offset = offset;
+	cmd.Args[0] = static_cast<uint32>(type);
+}
+
+void Pu::CommandList::Draw(uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance)
+{
+	EncodedCommand &cmd = Add(CommandType::Draw);
+	cmd.Args[0] = vertexCount;
+	cmd.Args[1] = instanceCount;
+	cmd.Args[2] = firstVertex;
+	cmd.Args[3] = firstInstance;
+	++draws;
+}
+
+void Pu::CommandList::Draw(uint32 indexCount, uint32 instanceCount, uint32 firstIndex, uint32 firstInstance, int32 vertexOffset)
+{
+	EncodedCommand &cmd = Add(CommandType::DrawIndexed);
+	cmd.Args[0] = indexCount;
+	cmd.Args[1] = instanceCount;
+	cmd.Args[2] = firstIndex;
+	cmd.Args[3] = firstInstance;
+	cmd.Args[4] = static_cast<uint32>(vertexOffset);
+	++draws;
+}
+
+/*
+A secondary command buffer doesn't inherit any state from the primary command buffer,
+so the list has to bind everything it uses by itself.
+
+foreach command
+	if descriptor bind and no pipeline bound
+		error
+	if draw
+		if no pipeline bound or vertex binding 0 not bound
+			error
+		if indexed and no index buffer bound
+			error
+*/
+bool Pu::CommandList::Validate(void) const
+{
+	bool hasPipeline = false, hasVertices = false, hasIndices = false;
+
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		const EncodedCommand &cmd = commands[i];
+		switch (cmd.Type)
+		{
+		case CommandType::BindPipeline:
+			hasPipeline = cmd.Gfx != nullptr;
+			break;
+		case CommandType::BindDescriptor:
+		case CommandType::BindDescriptors:
+			if (!hasPipeline)
+			{
+				Log::Error("Command %zu in command list binds a descriptor before a pipeline was bound!", i);
+				return false;
+			}
+			break;
+		case CommandType::BindVertexBuffer:
+			hasVertices |= cmd.Args[0] == 0;
+			break;
+		case CommandType::BindIndexBuffer:
+			hasIndices = true;
+			break;
+		case CommandType::Draw:
+		case CommandType::DrawIndexed:
+			if (!hasPipeline || !hasVertices)
+			{
+				Log::Error("Command %zu in command list draws before a pipeline and vertex buffer were bound!", i);
+				return false;
+			}
+
+			if (cmd.Type == CommandType::DrawIndexed && !hasIndices)
+			{
+				Log::Error("Command %zu in command list draws indexed before an index buffer was bound!", i);
+				return false;
+			}
+
+			if (!cmd.Args[1]) Log::Warning("Command %zu in command list draws zero instances!", i);
+			break;
+		}
+	}
+
+	return true;
+}
+
+Pu::EncodedCommand & Pu::CommandList::Add(CommandType type)
+{
+	/* Every command stores the active pipeline, so descriptors can be bound without tracking state during replay. */
+	EncodedCommand &result = commands.emplace_back();
+	result.Type = type;
+	result.Gfx = gfx;
+	result.Data = nullptr;
+	result.Offset = 0;
+	memset(result.Args, 0, sizeof(result.Args));
+	return result;
+}
\ No newline at end of file
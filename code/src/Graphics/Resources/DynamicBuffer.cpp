@@ -40,6 +40,16 @@ void Pu::DynamicBuffer::Update(CommandBuffer & cmdBuffer)
 	}
 }
 
+void Pu::DynamicBuffer::Update(CommandBuffer & cmdBuffer, DeviceSize offset, DeviceSize range)
+{
+	/* The staging buffer is an exact copy of this buffer, so the source and destination offsets are the same. */
+	if (isDirty)
+	{
+		cmdBuffer.CopyBuffer(*stagingBuffer, *this, BufferCopy{ offset, offset, range });
+		isDirty = false;
+	}
+}
+
 void Pu::DynamicBuffer::BeginMemoryTransfer(void)
 {
 	stagingBuffer->BeginMemoryTransfer();
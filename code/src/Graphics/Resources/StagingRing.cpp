@@ -0,0 +1,205 @@
+#include "Graphics/Resources/StagingRing.h"
+#include "Graphics/Vulkan/Queue.h"
+#include "Graphics/Vulkan/Image.h"
+#include "Core/Diagnostics/Profiler.h"
+
+/* Buffer to image copies need an offset that is a multiple of the texel size, this covers every color format. */
+constexpr Pu::uint64 StagingRingImageAlignment = 16;
+/* Buffer to buffer copies have no alignment requirement, but aligned copies are faster. */
+constexpr Pu::uint64 StagingRingBufferAlignment = 4;
+
+Pu::StagingRing::Submission::Submission(CommandBuffer && cmdBuffer, LogicalDevice & device)
+	: CmdBuffer(std::move(cmdBuffer)), Timer(device, "Staging", Color::Gray()), Index(0)
+{}
+
+Pu::StagingRing::StagingRing(LogicalDevice & device, Queue & queue, size_t size)
+	: device(device), queue(queue), buffer(device, size), pool(device, queue.GetFamilyIndex(), CommandPoolCreateFlags::ResetCommandBuffer),
+	ring(size), current(1), completed(0)
+{
+	/* The ring is never unmapped, so the uploads can be copied directly into it. */
+	buffer.SetDebugName("StagingRing");
+	buffer.BeginMemoryTransfer();
+}
+
+Pu::StagingRing::~StagingRing(void)
+{
+	/* Uploads that were never flushed are dropped, but the submitted uploads might still be reading from their sources. */
+	lock.lock();
+	while (completed + 1 < current) UpdateInternal(true);
+
+	for (const StagingBuffer *cur : sources) delete cur;
+	for (const Submission *cur : submissions) delete cur;
+	lock.unlock();
+}
+
+Pu::uint64 Pu::StagingRing::Stage(const void * data, size_t size, Buffer & destination, DeviceSize offset, PipelineStageFlags dstStage, AccessFlags access)
+{
+	lock.lock();
+
+	uint64 src;
+	const Buffer &source = Reserve(data, size, StagingRingBufferAlignment, src);
+	bufferUploads.emplace_back(BufferUpload{ &source, &destination, BufferCopy{ src, offset, size }, dstStage, access });
+
+	const uint64 result = current;
+	lock.unlock();
+	return result;
+}
+
+Pu::uint64 Pu::StagingRing::Stage(StagingBuffer * source, Buffer & destination, PipelineStageFlags dstStage, AccessFlags access)
+{
+	lock.lock();
+
+	sources.emplace_back(source);
+	bufferUploads.emplace_back(BufferUpload{ source, &destination, BufferCopy{ 0, 0, source->GetSize() }, dstStage, access });
+
+	const uint64 result = current;
+	lock.unlock();
+	return result;
+}
+
+Pu::uint64 Pu::StagingRing::Stage(const void * data, size_t size, Image & destination, uint32 arrayLayer)
+{
+	lock.lock();
+
+	uint64 src;
+	const Buffer &source = Reserve(data, size, StagingRingImageAlignment, src);
+
+	BufferImageCopy region{ src, destination.GetExtent() };
+	region.ImageSubresource.BaseArrayLayer = arrayLayer;
+	imageUploads.emplace_back(ImageUpload{ &source, &destination, region });
+
+	const uint64 result = current;
+	lock.unlock();
+	return result;
+}
+
+void Pu::StagingRing::Flush(void)
+{
+	lock.lock();
+	FlushInternal();
+	lock.unlock();
+}
+
+bool Pu::StagingRing::IsCompleted(uint64 submission)
+{
+	lock.lock();
+
+	/*
+	The first task that waits on the batch submits it,
+	so every upload that was staged before that point ends up in the same command buffer.
+	*/
+	if (submission == current) FlushInternal();
+	UpdateInternal(false);
+
+	const bool result = completed >= submission;
+	lock.unlock();
+	return result;
+}
+
+void Pu::StagingRing::Update(void)
+{
+	lock.lock();
+	UpdateInternal(false);
+	lock.unlock();
+}
+
+/*
+Uploads that are larger than the ring get their own staging buffer.
+Otherwise the ring can be full because of uploads that are still being batched or uploads that are still in flight,
+so we submit the current batch and wait for the oldest submission until the upload fits.
+*/
+const Pu::Buffer & Pu::StagingRing::Reserve(const void * data, size_t size, uint64 alignment, uint64 & offset)
+{
+	if (size > ring.GetCapacity())
+	{
+		StagingBuffer *result = new StagingBuffer(device, size);
+		result->Load(data);
+		sources.emplace_back(result);
+
+		offset = 0;
+		return *result;
+	}
+
+	while (!ring.Allocate(size, alignment, offset))
+	{
+		if (ring.GetOpenSize()) FlushInternal();
+		UpdateInternal(true);
+	}
+
+	memcpy(reinterpret_cast<byte*>(buffer.GetHostMemory()) + offset, data, size);
+	return buffer;
+}
+
+/*
+The images are moved to a transfer destination layout before any copy,
+the buffers are moved to their requested access after all copies are done.
+*/
+void Pu::StagingRing::FlushInternal(void)
+{
+	if (bufferUploads.empty() && imageUploads.empty()) return;
+
+	/* Submissions complete in order, so the oldest one is the only one that can be reused. */
+	Submission *submission;
+	if (submissions.size() && submissions.front()->Index <= completed)
+	{
+		submission = submissions.front();
+		submissions.removeAt(0);
+	}
+	else submission = new Submission(pool.Allocate(), device);
+
+	CommandBuffer &cmdBuffer = submission->CmdBuffer;
+	cmdBuffer.Begin();
+	submission->Timer.RecordTimestamp(cmdBuffer, 0, PipelineStageFlags::Transfer);
+
+	for (const ImageUpload &upload : imageUploads)
+	{
+		ImageSubresourceRange range{ ImageAspectFlags::Color };
+		range.LayerCount = upload.Destination->GetArrayLayers();
+		cmdBuffer.MemoryBarrier(*upload.Destination, PipelineStageFlags::TopOfPipe, PipelineStageFlags::Transfer, ImageLayout::TransferDstOptimal, AccessFlags::TransferWrite, range);
+	}
+
+	for (const BufferUpload &upload : bufferUploads) cmdBuffer.CopyBuffer(*upload.Source, *upload.Destination, upload.Region);
+	for (const ImageUpload &upload : imageUploads) cmdBuffer.CopyBuffer(*upload.Source, *upload.Destination, upload.Region);
+
+	for (size_t i = 0; i < bufferUploads.size(); i++)
+	{
+		/* Multiple ranges of the same buffer only need a single barrier. */
+		const BufferUpload &upload = bufferUploads[i];
+		bool duplicate = false;
+		for (size_t j = 0; j < i && !duplicate; j++) duplicate = bufferUploads[j].Destination == upload.Destination;
+
+		if (!duplicate) cmdBuffer.MemoryBarrier(*upload.Destination, PipelineStageFlags::Transfer, upload.Stage, upload.Access);
+	}
+
+	submission->Timer.RecordTimestamp(cmdBuffer, 0, PipelineStageFlags::Transfer);
+	cmdBuffer.End();
+	queue.Submit(cmdBuffer);
+
+	ring.Commit(current);
+	submission->Index = current++;
+	submission->Sources = std::move(sources);
+	submissions.emplace_back(submission);
+
+	sources.clear();
+	bufferUploads.clear();
+	imageUploads.clear();
+}
+
+void Pu::StagingRing::UpdateInternal(bool wait)
+{
+	for (Submission *cur : submissions)
+	{
+		if (cur->Index <= completed) continue;
+
+		/* Only the oldest submission is waited on, the others are just polled. */
+		if (!cur->CmdBuffer.CanBegin(wait)) break;
+		completed = cur->Index;
+		wait = false;
+
+		Profiler::Add(cur->Timer, cur->CmdBuffer, false);
+		for (const StagingBuffer *source : cur->Sources) delete source;
+		cur->Sources.clear();
+	}
+
+	ring.Release(completed);
+}
\ No newline at end of file
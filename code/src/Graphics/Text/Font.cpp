@@ -1,6 +1,9 @@
 #include "Graphics/Text/Font.h"
 #include "Streams/FileReader.h"
+#include "Streams/FileWriter.h"
+#include "Graphics/Textures/SkylinePacker.h"
 #include "Graphics/Vulkan/CommandPool.h"
+#include "Core/Math/Basics.h"
 
 #ifdef _DEBUG
 #include "Content/AssetSaver.h"
@@ -9,17 +12,42 @@
 #define STB_TRUETYPE_IMPLEMENTATION
 
 #include <stb/stb/stb_truetype.h>
+#include <algorithm>
+#include <numeric>
+
+/* Defines the identifier at the start of every font atlas cache file. */
+constexpr Pu::uint32 FontAtlasCacheMagic = 0x41465550;
+
+/* Defines the header of a font atlas cache file, it's followed by the glyphs and the atlas pixels. */
+struct FontAtlasCacheHeader
+{
+	Pu::uint32 Magic;
+	Pu::uint32 GlyphSize;
+	Pu::uint64 Key;
+	Pu::uint32 Width;
+	Pu::uint32 Height;
+	Pu::uint32 GlyphCount;
+	Pu::uint32 DefaultGlyph;
+	Pu::int32 LineSpace;
+};
+
+/* Combines the two codepoints of a kerning pair into a single key. */
+static inline Pu::uint64 font_kerning_key(Pu::char32 first, Pu::char32 second)
+{
+	return static_cast<Pu::uint64>(first) << 32 | second;
+}
 
 Pu::Font::Font(float size, const CodeChart &codeChart)
-	: Asset(true), size(size), codeChart(codeChart)
+	: Asset(true), atlasImg(nullptr), atlasTex(nullptr), size(size), codeChart(codeChart), defaultGlyphIndex(0), lineSpace(0), cacheKey(0)
 {
 	info = new stbtt_fontinfo();
 }
 
 Pu::Font::Font(Font && value)
 	: Asset(std::move(value)), atlasImg(value.atlasImg), atlasTex(value.atlasTex),
-	glyphs(std::move(value.glyphs)), defaultGlyphIndex(value.defaultGlyphIndex),
-	lineSpace(value.lineSpace), size(value.size), info(value.info),
+	glyphs(std::move(value.glyphs)), directLut(std::move(value.directLut)), sparseLut(std::move(value.sparseLut)),
+	kerning(std::move(value.kerning)), defaultGlyphIndex(value.defaultGlyphIndex),
+	lineSpace(value.lineSpace), size(value.size), cacheKey(value.cacheKey), info(value.info),
 	data(std::move(value.data)), codeChart(std::move(value.codeChart))
 {
 	value.atlasImg = nullptr;
@@ -36,11 +64,15 @@ Pu::Font & Pu::Font::operator=(Font && other)
 		Asset::operator=(std::move(other));
 		atlasImg = other.atlasImg;
 		atlasTex = other.atlasTex;
-		glyphs = std::move(glyphs);
+		glyphs = std::move(other.glyphs);
+		directLut = std::move(other.directLut);
+		sparseLut = std::move(other.sparseLut);
+		kerning = std::move(other.kerning);
 		codeChart = std::move(other.codeChart);
 		defaultGlyphIndex = other.defaultGlyphIndex;
 		lineSpace = other.lineSpace;
 		size = other.size;
+		cacheKey = other.cacheKey;
 		info = other.info;
 		data = std::move(other.data);
 
@@ -54,7 +86,11 @@ Pu::Font & Pu::Font::operator=(Font && other)
 
 float Pu::Font::GetKerning(char32 first, char32 second) const
 {
-	return static_cast<float>(stbtt_GetCodepointKernAdvance(info, first, second)) * GetScale();
+	/* Most fonts don't have a kerning table, so skip hashing the pair in that case. */
+	if (kerning.empty()) return 0.0f;
+
+	const decltype(kerning)::const_iterator it = kerning.find(font_kerning_key(first, second));
+	return it != kerning.end() ? it->second : 0.0f;
 }
 
 Pu::Vector2 Pu::Font::MeasureString(const ustring & str) const
@@ -97,12 +133,18 @@ Pu::Vector2 Pu::Font::MeasureString(const ustring & str) const
 
 const Pu::Glyph & Pu::Font::GetGlyph(char32 key) const
 {
-	for (const Glyph &cur : glyphs)
-	{
-		if (cur.Key == key) return cur;
-	}
+	/* The lookup table already contains the default glyph for unavailable characters. */
+	if (key < directLut.size()) return glyphs[directLut[key]];
+
+	const decltype(sparseLut)::const_iterator it = sparseLut.find(key);
+	return glyphs[it != sparseLut.end() ? it->second : defaultGlyphIndex];
+}
 
-	return glyphs[defaultGlyphIndex];
+void Pu::Font::LoadMetrics(const wstring & path)
+{
+	/* The atlas layout is calculated but never rasterized, so this doesn't need a device. */
+	Load(path);
+	(void)LoadGlyphInfo();
 }
 
 Pu::Asset & Pu::Font::Duplicate(AssetCache &)
@@ -124,20 +166,69 @@ void Pu::Font::Load(const wstring & path)
 
 	/* Initialize the global font information. */
 	stbtt_InitFont(info, reinterpret_cast<unsigned char*>(data.data()), 0);
-	glyphs.resize(min(codeChart.GetCharacterCount(), static_cast<size_t>(info->numGlyphs)));
+
+	/* The atlas only changes if the font file, the size, the code chart or the glyph spacing changes. */
+	if constexpr (FontAtlasCaching)
+	{
+		cacheKey = GetFileHash(path);
+		cacheKey = std::hash_fnv1a(&size, sizeof(float), cacheKey);
+		cacheKey = std::hash_fnv1a(&FontAtlasHOffset, sizeof(uint32), cacheKey);
+		cacheKey = std::hash_fnv1a(&FontAtlasVOffset, sizeof(uint32), cacheKey);
+		for (char32 key : codeChart) cacheKey = std::hash_fnv1a(&key, sizeof(char32), cacheKey);
+	}
+}
+
+/*
+Hashing the entire font file on every load is expensive for large fonts, even if the atlas is cached.
+So a stamp of the path, file size and last write time is mapped to the hash of the contents (in a small file next to the atlases).
+The contents are only hashed if the stamp is unknown, which happens if the file is new or has been changed.
+*/
+Pu::uint64 Pu::Font::GetFileHash(const wstring & path) const
+{
+	const int64 fileSize = static_cast<int64>(data.size());
+	const int64 writeTime = FileReader::GetLastWriteTime(path);
+
+	uint64 stamp = std::hash_fnv1a(path.c_str(), path.length() * sizeof(wchar_t));
+	stamp = std::hash_fnv1a(&fileSize, sizeof(int64), stamp);
+	stamp = std::hash_fnv1a(&writeTime, sizeof(int64), stamp);
+
+	wstring stampPath = FontAtlasCacheDirectory;
+	stampPath += string::printf("%016llx.stamp", static_cast<unsigned long long>(stamp)).toWide();
+
+	uint64 result;
+	FileReader reader{ stampPath, false };
+	if (reader.IsOpen())
+	{
+		if (reader.Read(result)) return result;
+		reader.Close();
+	}
+
+	result = std::hash_fnv1a(data.data(), data.size());
+
+	FileWriter::CreateDirectory(FontAtlasCacheDirectory);
+	FileWriter writer{ stampPath };
+	if (writer.IsCreated()) writer.Write(reinterpret_cast<const byte*>(&result), 0, sizeof(uint64));
+	return result;
 }
 
+/*
+The glyphs are packed into the atlas with a skyline packer, the atlas width is chosen so that the result is roughly square.
+The glyphs are packed from tallest to shortest, because that leaves the least gaps under the skyline.
+*/
 Pu::Vector2 Pu::Font::LoadGlyphInfo()
 {
 	const float scale = GetScale();
+	glyphs.resize(min(codeChart.GetCharacterCount(), static_cast<size_t>(info->numGlyphs)));
+	lineSpace = 0;
 
 	/* Get the global vertical information of the font. */
 	int32 ascent, descent, lineGap;
 	stbtt_GetFontVMetrics(info, &ascent, &descent, &lineGap);
 
 	/* Set the font information for all characters in the font or up until the UTF-16 limit. */
-	Vector2 finalImgSize, curLineSize;
-	size_t i = 0, j = 0;
+	uint64 area = 0;
+	uint32 widest = 0;
+	size_t i = 0;
 	for (char32 key : codeChart)
 	{
 		/* Make sure the character is represented in the font. */
@@ -152,35 +243,20 @@ Pu::Vector2 Pu::Font::LoadGlyphInfo()
 			Glyph &cur = glyphs[i];
 			cur.Key = key;
 			cur.Size = Vector2(static_cast<float>(x1 - x0), static_cast<float>(y1 - y0));
-			cur.U = Vector2(curLineSize.X, finalImgSize.Y);
-			cur.V = cur.U + cur.Size;
 			cur.Advance = static_cast<uint32>(rectify(x0 + advance * scale));
 			cur.Bearing = Vector2(static_cast<float>(lsb) * scale, static_cast<float>(y0));
 			if (cur.Size.Y > static_cast<float>(lineSpace)) lineSpace = static_cast<int32>(cur.Size.Y);
 
-			/* Create a new line in the font map after every 32 glyphs. */
-			if (j > 32)
-			{
-				/* Update the image size. */
-				finalImgSize.X = max(finalImgSize.X, curLineSize.X);
-				finalImgSize.Y += curLineSize.Y;
-
-				/* Reset the curent line. */
-				j = 0;
-				curLineSize = Vector2();
-			}
-			else
-			{
-				curLineSize.X += cur.Size.X + FontAtlasHOffset;
-				curLineSize.Y = max(curLineSize.Y, cur.Size.Y + FontAtlasVOffset);
-			}
+			/* Keep track of the space needed in the atlas. */
+			const uint32 w = static_cast<uint32>(x1 - x0) + FontAtlasHOffset, h = static_cast<uint32>(y1 - y0) + FontAtlasVOffset;
+			area += static_cast<uint64>(w) * h;
+			widest = max(widest, w);
 
 			/* Set the default glyph to either the unicode standart or the question mark. */
 			if (key == U'\xFFFD') defaultGlyphIndex = i;
 			else if (key == U'?' && !defaultGlyphIndex) defaultGlyphIndex = i;
 
 			i++;
-			j++;
 		}
 	}
 
@@ -190,23 +266,132 @@ Pu::Vector2 Pu::Font::LoadGlyphInfo()
 	/* Release all the memory we didn't need in the end. */
 	Log::Verbose("Loaded font with %zu/%zu/%d characters.", i, glyphs.size(), info->numGlyphs);
 	glyphs.erase(glyphs.begin() + i, glyphs.end());
+	BuildGlyphLookup();
+	BuildKerningTable();
 
-	/*  Finalize the image size and return. */
-	finalImgSize.X = max(finalImgSize.X, curLineSize.X);
-	finalImgSize.Y += curLineSize.Y;
-	return finalImgSize;
+	vector<size_t> order(glyphs.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [this](size_t a, size_t b)
+	{
+		const Glyph &first = glyphs[a], &second = glyphs[b];
+		return first.Size.Y != second.Size.Y ? first.Size.Y > second.Size.Y : first.Size.X > second.Size.X;
+	});
+
+	/* The atlas width is kept at a multiple of four to keep the rows aligned. */
+	const uint32 width = (max(widest, static_cast<uint32>(ceil(sqrt(static_cast<double>(area))))) + 3) & ~3u;
+	SkylinePacker packer{ width };
+
+	for (const size_t idx : order)
+	{
+		/* Glyphs without image data (space, tab, etc.) don't need space in the atlas. */
+		Glyph &cur = glyphs[idx];
+		if (cur.Size.X < 1.0f || cur.Size.Y < 1.0f)
+		{
+			cur.U = Vector2();
+			cur.V = Vector2();
+			continue;
+		}
+
+		uint32 x, y;
+		if (!packer.Pack(static_cast<uint32>(cur.Size.X) + FontAtlasHOffset, static_cast<uint32>(cur.Size.Y) + FontAtlasVOffset, x, y))
+		{
+			Log::Fatal("Unable to pack glyph %u into font atlas!", static_cast<uint32>(cur.Key));
+		}
+
+		cur.U = Vector2(static_cast<float>(x), static_cast<float>(y));
+		cur.V = cur.U + cur.Size;
+	}
+
+	return Vector2(static_cast<float>(max(width, 1u)), static_cast<float>(max(packer.GetHeight(), 1u)));
 }
 
-void Pu::Font::StageAtlas(Vector2 atlasSize, byte *dst)
+/*
+Characters within the direct range are looked up by indexing a table with the character,
+the table is only as large as the highest loaded character in that range to keep ASCII fonts small.
+Characters outside of that range (CJK, emoji, etc.) are placed in a hash map.
+*/
+void Pu::Font::BuildGlyphLookup(void)
 {
-	/* Precalculate need information. */
-	const Vector2 b2uv = Vector2(1.0f) / atlasSize;
+	directLut.clear();
+	sparseLut.clear();
+
+	uint32 highest = 0;
+	for (const Glyph &cur : glyphs)
+	{
+		if (cur.Key < FontDirectLookupSize) highest = max(highest, cur.Key + 1);
+	}
+
+	directLut.resize(highest, static_cast<uint16>(defaultGlyphIndex));
+	for (size_t i = 0; i < glyphs.size(); i++)
+	{
+		const char32 key = glyphs[i].Key;
+		if (key < FontDirectLookupSize) directLut[key] = static_cast<uint16>(i);
+		else sparseLut.emplace(key, static_cast<uint16>(i));
+	}
+}
+
+/*
+The kerning pairs are stored per glyph index in the font, so we need to convert them back to the codepoints.
+Only the first horizontal format 0 table is used, this is the same table that stb_truetype uses for its kerning.
+
+sort loaded glyphs by glyph index
+foreach kerning pair
+	foreach loaded glyph with the first index
+		foreach loaded glyph with the second index
+			add scaled kerning
+*/
+void Pu::Font::BuildKerningTable(void)
+{
+	kerning.clear();
+	if (!info->kern) return;
+
+	stbtt_uint8 *table = info->data + info->kern;
+	if (ttUSHORT(table + 2) < 1 || ttUSHORT(table + 8) != 1) return;
+
+	/* Multiple codepoints can map to the same glyph, so store the index in the upper bits to allow range searches. */
+	vector<uint32> indices;
+	indices.reserve(glyphs.size());
+	for (size_t i = 0; i < glyphs.size(); i++)
+	{
+		indices.emplace_back(static_cast<uint32>(stbtt_FindGlyphIndex(info, glyphs[i].Key)) << 16 | static_cast<uint32>(i));
+	}
+
+	std::sort(indices.begin(), indices.end());
+
+	const float scale = GetScale();
+	const uint32 pairCount = ttUSHORT(table + 10);
+	for (uint32 i = 0; i < pairCount; i++)
+	{
+		stbtt_uint8 *pair = table + 18 + i * 6;
+		const int16 advance = ttSHORT(pair + 4);
+		if (!advance) continue;
+
+		const uint32 g1 = static_cast<uint32>(ttUSHORT(pair)) << 16, g2 = static_cast<uint32>(ttUSHORT(pair + 2)) << 16;
+		const vector<uint32>::const_iterator first = std::lower_bound(indices.cbegin(), indices.cend(), g1);
+		const vector<uint32>::const_iterator second = std::lower_bound(indices.cbegin(), indices.cend(), g2);
+
+		for (vector<uint32>::const_iterator a = first; a != indices.cend() && (*a & 0xFFFF0000) == g1; ++a)
+		{
+			for (vector<uint32>::const_iterator b = second; b != indices.cend() && (*b & 0xFFFF0000) == g2; ++b)
+			{
+				kerning.emplace(font_kerning_key(glyphs[*a & 0xFFFF].Key, glyphs[*b & 0xFFFF].Key), static_cast<float>(advance) * scale);
+			}
+		}
+	}
+
+	Log::Verbose("Cached %zu kerning pairs.", kerning.size());
+}
+
+void Pu::Font::RasterizeGlyphs(size_t start, size_t end, Vector2 atlasSize, byte *dst) const
+{
+	/* The glyphs never overlap in the atlas, so this can be called from multiple threads at the same time. */
 	const int stride = ipart(atlasSize.X);
 	const float scale = GetScale();
 
-	for (Glyph &cur : glyphs)
+	for (size_t i = start; i < end; i++)
 	{
 		/* Ignore rendering glyphs that have no image data (space, tab, etc.). */
+		const Glyph &cur = glyphs[i];
 		if (cur.Size.X < 1.0f || cur.Size.Y < 1.0f) continue;
 
 		/* Render the codepoint alpha to the result buffer. */
@@ -214,13 +399,81 @@ void Pu::Font::StageAtlas(Vector2 atlasSize, byte *dst)
 		const size_t y = static_cast<size_t>(cur.U.Y);
 		const size_t offset = y * stride + x;
 		stbtt_MakeCodepointBitmap(info, dst + offset, ipart(cur.Size.X), ipart(cur.Size.Y), stride, scale, scale, cur.Key);
+	}
+}
 
-		/* Convert the bouds to texture coordinates. */
+void Pu::Font::FinalizeGlyphs(Vector2 atlasSize)
+{
+	/* Convert the bounds to texture coordinates. */
+	const Vector2 b2uv = Vector2(1.0f) / atlasSize;
+	for (Glyph &cur : glyphs)
+	{
 		cur.U *= b2uv;
 		cur.V *= b2uv;
 	}
 }
 
+Pu::wstring Pu::Font::GetCachePath(void) const
+{
+	wstring result = FontAtlasCacheDirectory;
+	result += string::printf("%016llx.atlas", static_cast<unsigned long long>(cacheKey)).toWide();
+	return result;
+}
+
+/*
+The cache stores the finalized glyphs, so only the lookups have to be rebuilt.
+The reader is left at the start of the atlas pixels, so the caller can read them directly into the staging memory.
+*/
+bool Pu::Font::LoadCache(FileReader & reader, Vector2 & atlasSize)
+{
+	FontAtlasCacheHeader header;
+	if (!reader.Read(header) || header.Magic != FontAtlasCacheMagic || header.GlyphSize != sizeof(Glyph) || header.Key != cacheKey)
+	{
+		Log::Warning("Ignoring invalid font atlas cache '%ls'!", reader.GetFilePath().fileName().c_str());
+		return false;
+	}
+
+	const size_t glyphSize = header.GlyphCount * sizeof(Glyph);
+	const size_t atlasBytes = static_cast<size_t>(header.Width) * header.Height;
+	if (static_cast<size_t>(reader.GetSize() - reader.GetPosition()) != glyphSize + atlasBytes)
+	{
+		Log::Warning("Ignoring truncated font atlas cache '%ls'!", reader.GetFilePath().fileName().c_str());
+		return false;
+	}
+
+	glyphs.resize(header.GlyphCount);
+	if (reader.Read(reinterpret_cast<byte*>(glyphs.data()), 0, glyphSize) != glyphSize) return false;
+
+	defaultGlyphIndex = header.DefaultGlyph;
+	lineSpace = header.LineSpace;
+	BuildGlyphLookup();
+	BuildKerningTable();
+
+	atlasSize = Vector2(static_cast<float>(header.Width), static_cast<float>(header.Height));
+	return true;
+}
+
+void Pu::Font::StoreCache(Vector2 atlasSize, const byte * atlas) const
+{
+	FileWriter::CreateDirectory(FontAtlasCacheDirectory);
+	FileWriter writer{ GetCachePath() };
+	if (!writer.IsCreated()) return;
+
+	FontAtlasCacheHeader header;
+	header.Magic = FontAtlasCacheMagic;
+	header.GlyphSize = sizeof(Glyph);
+	header.Key = cacheKey;
+	header.Width = static_cast<uint32>(atlasSize.X);
+	header.Height = static_cast<uint32>(atlasSize.Y);
+	header.GlyphCount = static_cast<uint32>(glyphs.size());
+	header.DefaultGlyph = static_cast<uint32>(defaultGlyphIndex);
+	header.LineSpace = lineSpace;
+
+	writer.Write(reinterpret_cast<const byte*>(&header), 0, sizeof(FontAtlasCacheHeader));
+	writer.Write(reinterpret_cast<const byte*>(glyphs.data()), 0, glyphs.size() * sizeof(Glyph));
+	writer.Write(atlas, 0, static_cast<size_t>(header.Width) * header.Height);
+}
+
 void Pu::Font::Destroy()
 {
 	if (atlasImg) delete atlasImg;
@@ -0,0 +1,106 @@
+#include "Graphics/Textures/SkylinePacker.h"
+
+Pu::SkylinePacker::SkylinePacker(uint32 width)
+	: width(width)
+{
+	Clear();
+}
+
+/*
+The rectangle is placed on the skyline segment where its bottom ends up the highest (lowest y).
+Ties are broken by the width of the segment, so narrow gaps are filled first.
+
+foreach segment
+	get the top of the skyline under the rectangle
+	store segment if it's the best fit
+add new segment on top of the rectangle
+shrink or remove the segments under the rectangle
+merge neighbouring segments with the same height
+*/
+bool Pu::SkylinePacker::Pack(uint32 w, uint32 h, uint32 & x, uint32 & y)
+{
+	/* Empty rectangles don't take up any space in the area. */
+	if (!w || !h)
+	{
+		x = 0;
+		y = 0;
+		return w <= width;
+	}
+
+	size_t best = skyline.size();
+	uint32 bestY = maxv<uint32>(), bestWidth = maxv<uint32>();
+
+	for (size_t i = 0; i < skyline.size(); i++)
+	{
+		uint32 top;
+		if (Fits(i, w, top))
+		{
+			if (top < bestY || (top == bestY && skyline[i].Width < bestWidth))
+			{
+				best = i;
+				bestY = top;
+				bestWidth = skyline[i].Width;
+			}
+		}
+	}
+
+	if (best >= skyline.size()) return false;
+
+	x = skyline[best].X;
+	y = bestY;
+	height = max(height, y + h);
+	skyline.insert(skyline.begin() + best, Node{ x, y + h, w });
+
+	/* Remove the parts of the segments that are now covered by the new segment. */
+	for (size_t i = best + 1; i < skyline.size();)
+	{
+		Node &cur = skyline[i];
+		const uint32 end = x + w;
+		if (cur.X >= end) break;
+
+		const uint32 overlap = end - cur.X;
+		if (overlap >= cur.Width) skyline.erase(skyline.begin() + i);
+		else
+		{
+			cur.X += overlap;
+			cur.Width -= overlap;
+			break;
+		}
+	}
+
+	for (size_t i = 0; i + 1 < skyline.size();)
+	{
+		if (skyline[i].Y == skyline[i + 1].Y)
+		{
+			skyline[i].Width += skyline[i + 1].Width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else i++;
+	}
+
+	return true;
+}
+
+void Pu::SkylinePacker::Clear(void)
+{
+	height = 0;
+	skyline.clear();
+	skyline.emplace_back(Node{ 0, 0, width });
+}
+
+bool Pu::SkylinePacker::Fits(size_t idx, uint32 w, uint32 & y) const
+{
+	if (skyline[idx].X + w > width) return false;
+
+	/* The rectangle rests on the highest segment it covers. */
+	y = 0;
+	for (uint32 remaining = w; remaining; idx++)
+	{
+		const Node &cur = skyline[idx];
+		y = max(y, cur.Y);
+		if (cur.Width >= remaining) break;
+		remaining -= cur.Width;
+	}
+
+	return true;
+}
\ No newline at end of file
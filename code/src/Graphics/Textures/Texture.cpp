@@ -44,7 +44,7 @@ void Pu::Texture::Destroy(void)
 }
 
 Pu::Texture::LoadTask::LoadTask(Texture & result, const ImageInformation & info, const wstring & path)
-	: Task("Load Image"), result(result), info(info), child(nullptr), stagingBuffer(nullptr), path(path)
+	: Task("Load Image"), result(result), info(info), child(nullptr), path(path)
 {
 	/* Create the child task as either a HDR load or LDR load. */
 	if (info.IsHDR) child = new ImageLoadTask<float>(path);
@@ -55,7 +55,20 @@ Pu::Texture::LoadTask::LoadTask(Texture & result, const ImageInformation & info,
 
 Pu::Texture::LoadTask::~LoadTask(void)
 {
-	if (stagingBuffer) delete stagingBuffer;
+	if (info.IsHDR) delete static_cast<ImageLoadTask<float>*>(child);
+	else delete static_cast<ImageLoadTask<byte>*>(child);
+}
+
+const void * Pu::Texture::LoadTask::GetData(void) const
+{
+	if (info.IsHDR) return static_cast<const ImageLoadTask<float>*>(child)->GetData().data();
+	return static_cast<const ImageLoadTask<byte>*>(child)->GetData().data();
+}
+
+size_t Pu::Texture::LoadTask::GetSize(void) const
+{
+	if (info.IsHDR) return static_cast<const ImageLoadTask<float>*>(child)->GetData().size() * sizeof(float);
+	return static_cast<const ImageLoadTask<byte>*>(child)->GetData().size();
 }
 
 Pu::Task::Result Pu::Texture::LoadTask::Execute(void)
@@ -67,30 +80,6 @@ Pu::Task::Result Pu::Texture::LoadTask::Execute(void)
 
 Pu::Task::Result Pu::Texture::LoadTask::Continue(void)
 {
-	if (info.IsHDR)
-	{
-		/* Get the result from the load task. */
-		const ImageLoadTask<float> *loadTask = static_cast<ImageLoadTask<float>*>(child);
-		const vector<float> &texels = loadTask->GetData();
-
-		/* Copy texel information to staging buffer. */
-		stagingBuffer = new StagingBuffer(result.Image->GetDevice(), texels.size() * sizeof(float));
-		stagingBuffer->Load(texels.data());
-
-		delete loadTask;
-	}
-	else
-	{
-		/* Get the result from the load task. */
-		const ImageLoadTask<byte> *loadTask = static_cast<ImageLoadTask<byte>*>(child);
-		const vector<byte> &texels = loadTask->GetData();
-
-		/* Copy texel information to staging buffer. */
-		stagingBuffer = new StagingBuffer(result.Image->GetDevice(), texels.size() * sizeof(byte));
-		stagingBuffer->Load(texels.data());
-
-		delete loadTask;
-	}
-
+	/* The texels are kept in the load task, the parent copies them directly into the staging ring. */
 	return Result::Default();
 }
\ No newline at end of file
@@ -9,10 +9,10 @@ Pu::Buffer::Buffer(LogicalDevice & device, size_t size, BufferUsageFlags usage,
 }
 
 Pu::Buffer::Buffer(Buffer && value)
-	: Asset(std::move(value)), parent(value.parent), size(value.size), memoryHndl(value.memoryHndl), bufferHndl(value.bufferHndl), Mutable(value.Mutable),
+	: Asset(std::move(value)), parent(value.parent), size(value.size), memory(value.memory), bufferHndl(value.bufferHndl), Mutable(value.Mutable),
 	memoryProperties(value.memoryProperties), memoryType(value.memoryType), buffer(value.buffer), srcAccess(value.srcAccess)
 {
-	value.memoryHndl = nullptr;
+	value.memory = DeviceAllocation();
 	value.bufferHndl = nullptr;
 	value.buffer = nullptr;
 }
@@ -26,7 +26,7 @@ Pu::Buffer & Pu::Buffer::operator=(Buffer && other)
 
 		parent = other.parent;
 		size = other.size;
-		memoryHndl = other.memoryHndl;
+		memory = other.memory;
 		bufferHndl = other.bufferHndl;
 		memoryProperties = other.memoryProperties;
 		memoryType = other.memoryType;
@@ -34,7 +34,7 @@ Pu::Buffer & Pu::Buffer::operator=(Buffer && other)
 		srcAccess = other.srcAccess;
 		Mutable = other.Mutable;
 
-		other.memoryHndl = nullptr;
+		other.memory = DeviceAllocation();
 		other.bufferHndl = nullptr;
 		other.buffer = nullptr;
 	}
@@ -44,10 +44,11 @@ Pu::Buffer & Pu::Buffer::operator=(Buffer && other)
 
 Pu::DeviceSize Pu::Buffer::GetLazyMemory(void) const
 {
-	if (memoryHndl)
+	/* Lazily allocated memory is never shared with other resources. */
+	if (memory.Memory && memory.IsDedicated())
 	{
 		DeviceSize result = 0;
-		parent->vkGetDeviceMemoryCommitment(parent->hndl, memoryHndl, &result);
+		parent->vkGetDeviceMemoryCommitment(parent->hndl, memory.Memory, &result);
 		return result;
 	}
 	else return 0;
@@ -71,7 +72,7 @@ void Pu::Buffer::BeginMemoryTransfer(void)
 #endif
 
 	/* Map the entire buffer into memory. */
-	Map(size, 0);
+	Map(0);
 }
 
 const void * Pu::Buffer::GetHostMemory(void) const
@@ -114,8 +115,8 @@ void Pu::Buffer::Flush(DeviceSize size, DeviceSize offset)
 	/* We don't have to flush if the buffer is Host Coherent. */
 	if (!_CrtEnumCheckFlag(memoryProperties, MemoryPropertyFlags::HostCoherent))
 	{
-		/* Flush the section of the buffer indicated by the user. */
-		const MappedMemoryRange range{ memoryHndl, offset, size };
+		/* Flush the section of the buffer indicated by the user, the memory might be shared so the range is relative to the allocation. */
+		const MappedMemoryRange range = parent->GetMemoryAllocator().GetFlushRange(memory, offset, size);
 		VK_VALIDATE(parent->vkFlushMappedMemoryRanges(parent->hndl, 1, &range), PFN_vkFlushMappedMemoryRanges);
 	}
 }
@@ -152,19 +153,15 @@ Pu::Asset & Pu::Buffer::Duplicate(AssetCache &)
 	return *this;
 }
 
-/* size hides class member, checked and works as intended. */
-#pragma warning(push)
-#pragma warning(disable:4458)
-void Pu::Buffer::Map(size_t size, size_t offset)
+void Pu::Buffer::Map(size_t offset)
 {
-	VK_VALIDATE(parent->vkMapMemory(parent->hndl, memoryHndl, static_cast<DeviceSize>(offset), static_cast<DeviceSize>(size), 0, reinterpret_cast<void**>(&buffer)), PFN_vkMapMemory);
+	/* Host visible memory is persistently mapped by the allocator. */
+	buffer = memory.HostMemory + offset;
 }
-#pragma warning(pop)
 
 void Pu::Buffer::UnMap(void)
 {
 	/* Resset the buffer back to nullptr to indicate that we no longer have access to the buffer. */
-	parent->vkUnmapMemory(parent->hndl, memoryHndl);
 	buffer = nullptr;
 }
 
@@ -176,8 +173,9 @@ void Pu::Buffer::Create(const BufferCreateInfo & createInfo, MemoryPropertyFlags
 
 void Pu::Buffer::Destroy(void)
 {
-	Free();
+	/* The memory range might be reused immediately, so make sure the buffer is gone before it's released. */
 	if (bufferHndl) parent->vkDestroyBuffer(parent->hndl, bufferHndl, nullptr);
+	Free();
 }
 
 void Pu::Buffer::Allocate(MemoryPropertyFlags optional)
@@ -200,10 +198,8 @@ void Pu::Buffer::Allocate(MemoryPropertyFlags optional)
 			}
 		}
 
-		/* Allocate the memory. */
-		const MemoryAllocateInfo info{ requirements.Size, memoryType };
-		++parent->parent->memAllocs;
-		VK_VALIDATE(parent->vkAllocateMemory(parent->hndl, &info, nullptr, &memoryHndl), PFN_vkAllocateMemory);
+		/* Allocate the memory, buffers are always linear resources. */
+		memory = parent->GetMemoryAllocator().Allocate(requirements, memoryType, true, false);
 
 		/* Bind the memory to the buffer. */
 		Bind();
@@ -213,14 +209,14 @@ void Pu::Buffer::Allocate(MemoryPropertyFlags optional)
 
 void Pu::Buffer::Bind(void)
 {
-	VK_VALIDATE(parent->vkBindBufferMemory(parent->hndl, bufferHndl, memoryHndl, 0), PFN_vkBindBufferMemory);
+	VK_VALIDATE(parent->vkBindBufferMemory(parent->hndl, bufferHndl, memory.Memory, memory.Offset), PFN_vkBindBufferMemory);
 }
 
 void Pu::Buffer::Free(void)
 {
-	if (memoryHndl)
+	if (memory.Memory)
 	{
-		parent->vkFreeMemory(parent->hndl, memoryHndl, nullptr);
-		--parent->parent->memAllocs;
+		parent->GetMemoryAllocator().Free(memory);
+		memory = DeviceAllocation();
 	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Graphics/Vulkan/CommandBuffer.h"
 #include "Graphics/Vulkan/CommandPool.h"
 #include "Graphics/Vulkan/DescriptorPool.h"
+#include <atomic>
 
 const char* to_string(Pu::CommandBuffer::State state)
 {
@@ -27,12 +28,13 @@ const char* to_string(Pu::CommandBuffer::State state)
 #define DbgCheckIfRecording(...)
 #endif
 
-static Pu::uint32 bindCalls = 0;
-static Pu::uint32 drawCalls = 0;
-static Pu::uint32 dispatchCalls = 0;
-static Pu::uint32 transferCalls = 0;
-static Pu::uint32 barrierCalls = 0;
-static Pu::uint32 shaderCalls = 0;
+static std::atomic<Pu::uint32> bindCalls{ 0 };
+static std::atomic<Pu::uint32> drawCalls{ 0 };
+static std::atomic<Pu::uint32> dispatchCalls{ 0 };
+static std::atomic<Pu::uint32> transferCalls{ 0 };
+static std::atomic<Pu::uint32> barrierCalls{ 0 };
+static std::atomic<Pu::uint32> shaderCalls{ 0 };
+static std::atomic<Pu::uint32> elidedCalls{ 0 };
 
 Pu::CommandBuffer::CommandBuffer(void)
 	: parent(nullptr), device(nullptr), hndl(nullptr), 
@@ -40,7 +42,7 @@ Pu::CommandBuffer::CommandBuffer(void)
 {}
 
 Pu::CommandBuffer::CommandBuffer(CommandBuffer && value)
-	: parent(value.parent), device(value.device), hndl(value.hndl), 
+	: parent(value.parent), device(value.device), hndl(value.hndl), tracker(value.tracker),
 	state(value.state), submitFence(value.submitFence), Usage(value.Usage)
 {
 	value.hndl = nullptr;
@@ -57,6 +59,7 @@ Pu::CommandBuffer & Pu::CommandBuffer::operator=(CommandBuffer && other)
 		hndl = other.hndl;
 		parent = other.parent;
 		device = other.device;
+		tracker = other.tracker;
 		state = other.state;
 		submitFence = other.submitFence;
 		Usage = other.Usage;
@@ -288,39 +291,39 @@ void Pu::CommandBuffer::BeginRenderPass(const Renderpass & renderPass, const Fra
 void Pu::CommandBuffer::BindGraphicsPipeline(const GraphicsPipeline & pipeline)
 {
 	DbgCheckIfRecording("bind graphics pipeline");
-	++bindCalls;
 
-	device->vkCmdBindPipeline(hndl, PipelineBindPoint::Graphics, pipeline.Hndl);
+	if (tracker.BindPipeline(hndl, PipelineBindPoint::Graphics, pipeline.Hndl)) ++bindCalls;
+	else ++elidedCalls;
 }
 
 void Pu::CommandBuffer::BindComputePipeline(const ComputePipeline & pipeline)
 {
 	DbgCheckIfRecording("bind compute pipeline");
-	++bindCalls;
 
-	device->vkCmdBindPipeline(hndl, PipelineBindPoint::Compute, pipeline.Hndl);
+	if (tracker.BindPipeline(hndl, PipelineBindPoint::Compute, pipeline.Hndl)) ++bindCalls;
+	else ++elidedCalls;
 }
 
 void Pu::CommandBuffer::BindVertexBuffer(uint32 binding, const Buffer & buffer, DeviceSize offset)
 {
 	DbgCheckIfRecording("bind vertex buffer");
-	++bindCalls;
 
-	device->vkCmdBindVertexBuffers(hndl, binding, 1, &buffer.bufferHndl, &offset);
+	if (tracker.BindVertexBuffer(hndl, binding, buffer.bufferHndl, offset)) ++bindCalls;
+	else ++elidedCalls;
 }
 
 void Pu::CommandBuffer::BindIndexBuffer(IndexType type, const Buffer & buffer, DeviceSize offset)
 {
 	DbgCheckIfRecording("bind index buffer");
-	++bindCalls;
 
-	device->vkCmdBindIndexBuffer(hndl, buffer.bufferHndl, offset, type);
+	if (tracker.BindIndexBuffer(hndl, buffer.bufferHndl, offset, type)) ++bindCalls;
+	else ++elidedCalls;
 }
 
 void Pu::CommandBuffer::PushConstants(const Pipeline & pipeline, ShaderStageFlags stage, uint32 offset, size_t size, const void * constants)
 {
 	DbgCheckIfRecording("push constants");
-	device->vkCmdPushConstants(hndl, pipeline.LayoutHndl, stage, offset, static_cast<uint32>(size), constants);
+	if (!tracker.PushConstants(hndl, pipeline.LayoutHndl, stage, offset, static_cast<uint32>(size), constants)) ++elidedCalls;
 }
 
 void Pu::CommandBuffer::BindGraphicsDescriptor(const Pipeline & pipeline, const DescriptorSet & descriptor)
@@ -384,6 +387,48 @@ void Pu::CommandBuffer::EndRenderPass(void)
 	device->vkCmdEndRenderPass(hndl);
 }
 
+void Pu::CommandBuffer::ExecuteCommands(const CommandBuffer & secondary)
+{
+	DbgCheckIfRecording("execute secondary command buffer");
+	device->vkCmdExecuteCommands(hndl, 1, &secondary.hndl);
+
+	/* The bound state of the primary command buffer is undefined after executing a secondary command buffer. */
+	tracker.Invalidate();
+}
+
+void Pu::CommandBuffer::Append(const CommandList & list)
+{
+	DbgCheckIfRecording("append command list");
+
+	for (const EncodedCommand &cmd : list.GetCommands())
+	{
+		switch (cmd.Type)
+		{
+		case CommandType::BindPipeline:
+			BindGraphicsPipeline(*cmd.Gfx);
+			break;
+		case CommandType::BindDescriptor:
+			BindGraphicsDescriptor(*cmd.Gfx, *cmd.Set);
+			break;
+		case CommandType::BindDescriptors:
+			BindGraphicsDescriptors(*cmd.Gfx, cmd.Args[0], *cmd.Group);
+			break;
+		case CommandType::BindVertexBuffer:
+			BindVertexBuffer(cmd.Args[0], *cmd.Data, cmd.Offset);
+			break;
+		case CommandType::BindIndexBuffer:
+			BindIndexBuffer(static_cast<IndexType>(cmd.Args[0]), *cmd.Data, cmd.Offset);
+			break;
+		case CommandType::Draw:
+			Draw(cmd.Args[0], cmd.Args[1], cmd.Args[2], cmd.Args[3]);
+			break;
+		case CommandType::DrawIndexed:
+			Draw(cmd.Args[0], cmd.Args[1], cmd.Args[2], cmd.Args[3], static_cast<int32>(cmd.Args[4]));
+			break;
+		}
+	}
+}
+
 void Pu::CommandBuffer::AddLabel(const string & name, Color color)
 {
 #ifdef _DEBUG
@@ -474,21 +519,22 @@ void Pu::CommandBuffer::SetLineStipple(uint32 factor, uint16 pattern)
 
 Pu::CommandBuffer::CommandBuffer(CommandPool & pool, CommandBufferHndl hndl)
 	: parent(&pool), device(pool.parent), hndl(hndl), state(State::Initial), 
-	Usage(CommandBufferUsageFlags::None), lastSubmitQueueFamilyID(0)
+	Usage(CommandBufferUsageFlags::None), lastSubmitQueueFamilyID(0),
+	tracker({ device->vkCmdBindPipeline, device->vkCmdBindVertexBuffers, device->vkCmdBindIndexBuffer, device->vkCmdBindDescriptorSets, device->vkCmdPushConstants })
 {
 	submitFence = new Fence(*device);
 }
 
 void Pu::CommandBuffer::BindDescriptor(const Pipeline & pipeline, PipelineBindPoint bindPoint, const DescriptorSet & descriptor)
 {
-	++bindCalls;
-	device->vkCmdBindDescriptorSets(hndl, bindPoint, pipeline.LayoutHndl, descriptor.set, 1, &descriptor.hndl, 0, nullptr);
+	if (tracker.BindDescriptorSet(hndl, bindPoint, pipeline.LayoutHndl, descriptor.set, descriptor.hndl)) ++bindCalls;
+	else ++elidedCalls;
 }
 
 void Pu::CommandBuffer::BindDescriptors(const Pipeline & pipeline, PipelineBindPoint bindPoint, uint32 subpassIdx, const DescriptorSetGroup & descriptors)
 {
 #ifdef _DEBUG
-	const uint32 oldBindCalls = bindCalls;
+	bool found = false;
 #endif
 
 	/* We need to bind all of the descriptors in the group that match the subpass index. */
@@ -498,14 +544,18 @@ void Pu::CommandBuffer::BindDescriptors(const Pipeline & pipeline, PipelineBindP
 		if (subpass == subpassIdx)
 		{
 			const uint32 set = static_cast<uint32>(id & 0xFFFFFFFF);
-			device->vkCmdBindDescriptorSets(hndl, bindPoint, pipeline.LayoutHndl, set, 1, &setHndl, 0, nullptr);
-			++bindCalls;
+			if (tracker.BindDescriptorSet(hndl, bindPoint, pipeline.LayoutHndl, set, setHndl)) ++bindCalls;
+			else ++elidedCalls;
+
+#ifdef _DEBUG
+			found = true;
+#endif
 		}
 	}
 
 #ifdef _DEBUG
 	/* This might occur if the user passes the wrong handle, it will probably crash later. */
-	if (oldBindCalls == bindCalls) Log::Warning("Could not bind any DescriptorSet from DescriptorSetGroup!");
+	if (!found) Log::Warning("Could not bind any DescriptorSet from DescriptorSetGroup!");
 #endif
 }
 
@@ -549,6 +599,11 @@ Pu::uint32 Pu::CommandBuffer::GetShaderCalls(void)
 	return shaderCalls;
 }
 
+Pu::uint32 Pu::CommandBuffer::GetElidedCalls(void)
+{
+	return elidedCalls;
+}
+
 void Pu::CommandBuffer::ResetCounters(void)
 {
 	drawCalls = 0;
@@ -557,6 +612,7 @@ void Pu::CommandBuffer::ResetCounters(void)
 	transferCalls = 0;
 	barrierCalls = 0;
 	shaderCalls = 0;
+	elidedCalls = 0;
 }
 
 void Pu::CommandBuffer::Begin(void)
@@ -567,10 +623,35 @@ void Pu::CommandBuffer::Begin(void)
 		const CommandBufferBeginInfo info{ Usage };
 		VK_VALIDATE(device->vkBeginCommandBuffer(hndl, &info), PFN_vkBeginCommandBuffer);
 		state = State::Recording;
+		tracker.Invalidate();
 	}
 	else Log::Error("Attempted to call begin on %s command buffer!", ::to_string(state));
 }
 
+void Pu::CommandBuffer::Begin(const Renderpass & renderPass, uint32 subpass, const Framebuffer & framebuffer, QueryPipelineStatisticFlags statistics)
+{
+	/*
+	Secondary command buffers are never submitted, so their fence is never signaled.
+	Beginning an executable secondary command buffer implicitly resets it (the pool must allow individual resets),
+	the caller is responsible for making sure the primary command buffer that executes it is no longer pending.
+	*/
+	if (state == State::Initial || state == State::Executable)
+	{
+		CommandBufferInheritanceInfo inheritance{ renderPass.hndl };
+		inheritance.Subpass = subpass;
+		inheritance.FrameBuffer = framebuffer.hndl;
+		inheritance.PipelineStatistics = statistics;
+
+		CommandBufferBeginInfo info{ Usage | CommandBufferUsageFlags::RenderPassContinue };
+		info.InheritanceInfo = &inheritance;
+
+		VK_VALIDATE(device->vkBeginCommandBuffer(hndl, &info), PFN_vkBeginCommandBuffer);
+		state = State::Recording;
+		tracker.Invalidate();
+	}
+	else Log::Error("Attempted to call begin on %s secondary command buffer!", ::to_string(state));
+}
+
 void Pu::CommandBuffer::End(void)
 {
 	if (state == State::Recording)
@@ -28,10 +28,10 @@ Pu::CommandPool & Pu::CommandPool::operator=(CommandPool && other)
 	return *this;
 }
 
-Pu::CommandBuffer Pu::CommandPool::Allocate(void) const
+Pu::CommandBuffer Pu::CommandPool::Allocate(CommandBufferLevel level) const
 {
 	/* Initialize creation info. */
-	const CommandBufferAllocateInfo allocInfo(hndl, 1);
+	const CommandBufferAllocateInfo allocInfo(hndl, 1, level);
 	CommandBufferHndl commandBuffer;
 
 	/* Allocate new buffer. */
@@ -0,0 +1,143 @@
+#include "Graphics/Vulkan/CommandStateTracker.h"
+
+Pu::CommandStateTracker::CommandStateTracker(void)
+	: CommandStateTracker(CommandDispatchTable{})
+{}
+
+Pu::CommandStateTracker::CommandStateTracker(const CommandDispatchTable & dispatch)
+	: dispatch(dispatch), issued(0), elided(0)
+{
+	Invalidate();
+}
+
+void Pu::CommandStateTracker::Invalidate(void)
+{
+	/* Null handles are never valid for these commands, so they're used as the unknown state. */
+	memset(pipelines, 0, sizeof(pipelines));
+	memset(setLayouts, 0, sizeof(setLayouts));
+	memset(sets, 0, sizeof(sets));
+	memset(vertexBuffers, 0, sizeof(vertexBuffers));
+	memset(vertexOffsets, 0, sizeof(vertexOffsets));
+
+	indexBuffer = nullptr;
+	indexOffset = 0;
+	indexType = IndexType::UInt16;
+
+	pushLayout = nullptr;
+	memset(pushStages, 0, sizeof(pushStages));
+	memset(pushData, 0, sizeof(pushData));
+}
+
+bool Pu::CommandStateTracker::BindPipeline(CommandBufferHndl cmdBuffer, PipelineBindPoint bindPoint, PipelineHndl pipeline)
+{
+	const uint32 point = static_cast<uint32>(bindPoint);
+	if (point < TrackedBindPoints)
+	{
+		if (pipelines[point] == pipeline) return Elide();
+		pipelines[point] = pipeline;
+	}
+
+	/* Binding a pipeline doesn't disturb the descriptor sets or push constants, so those remain tracked. */
+	dispatch.BindPipeline(cmdBuffer, bindPoint, pipeline);
+	return Issue();
+}
+
+bool Pu::CommandStateTracker::BindVertexBuffer(CommandBufferHndl cmdBuffer, uint32 binding, BufferHndl buffer, DeviceSize offset)
+{
+	if (binding < TrackedVertexBindings)
+	{
+		if (vertexBuffers[binding] == buffer && vertexOffsets[binding] == offset) return Elide();
+
+		vertexBuffers[binding] = buffer;
+		vertexOffsets[binding] = offset;
+	}
+
+	dispatch.BindVertexBuffers(cmdBuffer, binding, 1, &buffer, &offset);
+	return Issue();
+}
+
+bool Pu::CommandStateTracker::BindIndexBuffer(CommandBufferHndl cmdBuffer, BufferHndl buffer, DeviceSize offset, IndexType type)
+{
+	if (indexBuffer == buffer && indexOffset == offset && indexType == type) return Elide();
+
+	dispatch.BindIndexBuffer(cmdBuffer, buffer, offset, type);
+	indexBuffer = buffer;
+	indexOffset = offset;
+	indexType = type;
+	return Issue();
+}
+
+/*
+Binding a set with a layout that isn't compatible with the previous one disturbs the other bound sets.
+Checking the compatibility requires the layout definitions, so we simply forget every set once the layout changes.
+*/
+bool Pu::CommandStateTracker::BindDescriptorSet(CommandBufferHndl cmdBuffer, PipelineBindPoint bindPoint, PipelineLayoutHndl layout, uint32 set, DescriptorSetHndl descriptor)
+{
+	const uint32 point = static_cast<uint32>(bindPoint);
+	if (point < TrackedBindPoints)
+	{
+		if (setLayouts[point] != layout)
+		{
+			memset(sets[point], 0, sizeof(sets[point]));
+			setLayouts[point] = layout;
+		}
+
+		if (set < TrackedDescriptorSets)
+		{
+			if (sets[point][set] == descriptor) return Elide();
+			sets[point][set] = descriptor;
+		}
+	}
+
+	dispatch.BindDescriptorSets(cmdBuffer, bindPoint, layout, set, 1, &descriptor, 0, nullptr);
+	return Issue();
+}
+
+/*
+Push constants are tracked per byte, a push is only skipped if every byte in its range
+was last written with the same stages, the same layout and the same value.
+
+if layout changed
+	forget all bytes
+if range is tracked and all bytes match
+	skip
+push and store bytes
+*/
+bool Pu::CommandStateTracker::PushConstants(CommandBufferHndl cmdBuffer, PipelineLayoutHndl layout, ShaderStageFlags stage, uint32 offset, uint32 size, const void * values)
+{
+	if (pushLayout != layout)
+	{
+		memset(pushStages, 0, sizeof(pushStages));
+		pushLayout = layout;
+	}
+
+	const bool tracked = offset + size <= TrackedPushConstantSize;
+	if (tracked)
+	{
+		bool equal = !memcmp(pushData + offset, values, size);
+		for (uint32 i = offset; i < offset + size && equal; i++) equal = pushStages[i] == stage;
+		if (equal) return Elide();
+	}
+
+	dispatch.PushConstants(cmdBuffer, layout, stage, offset, size, values);
+
+	if (tracked)
+	{
+		memcpy(pushData + offset, values, size);
+		for (uint32 i = offset; i < offset + size; i++) pushStages[i] = stage;
+	}
+
+	return Issue();
+}
+
+bool Pu::CommandStateTracker::Elide(void)
+{
+	++elided;
+	return false;
+}
+
+bool Pu::CommandStateTracker::Issue(void)
+{
+	++issued;
+	return true;
+}
\ No newline at end of file
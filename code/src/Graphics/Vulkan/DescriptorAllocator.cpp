@@ -0,0 +1,197 @@
+#include "Graphics/Vulkan/DescriptorAllocator.h"
+#include "Core/Diagnostics/Logging.h"
+#include "Core/Math/Basics.h"
+
+Pu::DescriptorAllocator::DescriptorAllocator(const DescriptorDispatchTable & dispatch, const vector<DescriptorPoolSize> & sizes, uint32 setsPerPool, uint32 frames)
+	: dispatch(dispatch), sizes(sizes), setsPerPool(setsPerPool), frame(0)
+{
+	this->frames.resize(frames ? frames : 1, Frame{ {}, 0 });
+}
+
+Pu::DescriptorAllocator::DescriptorAllocator(DescriptorAllocator && value)
+	: dispatch(value.dispatch), sizes(std::move(value.sizes)), setsPerPool(value.setsPerPool),
+	pools(std::move(value.pools)), available(std::move(value.available)), open(std::move(value.open)),
+	frames(std::move(value.frames)), frame(value.frame), cache(std::move(value.cache))
+{
+	value.pools.clear();
+	value.frames.clear();
+}
+
+Pu::DescriptorAllocator & Pu::DescriptorAllocator::operator=(DescriptorAllocator && other)
+{
+	if (this != &other)
+	{
+		Destroy();
+
+		dispatch = other.dispatch;
+		sizes = std::move(other.sizes);
+		setsPerPool = other.setsPerPool;
+		pools = std::move(other.pools);
+		available = std::move(other.available);
+		open = std::move(other.open);
+		frames = std::move(other.frames);
+		frame = other.frame;
+		cache = std::move(other.cache);
+
+		other.pools.clear();
+		other.frames.clear();
+	}
+
+	return *this;
+}
+
+/*
+The open list contains the pools that might still have space,
+the last pool in the list is tried first so new pools are used until they're exhausted.
+
+while open list not empty
+	try allocate from last open pool
+	remove pool from open list on failure
+create new pool
+*/
+Pu::uint32 Pu::DescriptorAllocator::Allocate(DescriptorSetLayoutHndl layout, DescriptorSetHndl * result)
+{
+	while (open.size())
+	{
+		const uint32 idx = open.back();
+		if (TryAllocate(pools[idx], layout, result)) return idx;
+
+		available[idx] = false;
+		open.pop_back();
+	}
+
+	/* Every pool is exhausted, so chain a new one. */
+	const uint32 idx = static_cast<uint32>(pools.size());
+	pools.emplace_back(CreatePool(DescriptorPoolCreateFlags::FreeDescriptorSet));
+	available.emplace_back(true);
+	open.emplace_back(idx);
+
+	if (!TryAllocate(pools[idx], layout, result)) ThrowInvalidAlloc();
+	return idx;
+}
+
+void Pu::DescriptorAllocator::Free(uint32 pool, DescriptorSetHndl set)
+{
+	VK_VALIDATE(dispatch.FreeDescriptorSets(dispatch.Device, pools[pool], 1, &set), PFN_vkFreeDescriptorSets);
+
+	/* The pool has space again, so it should be considered for the next allocation. */
+	if (!available[pool])
+	{
+		available[pool] = true;
+		open.emplace_back(pool);
+	}
+}
+
+Pu::DescriptorSetHndl Pu::DescriptorAllocator::AllocateTransient(DescriptorSetLayoutHndl layout)
+{
+	Frame &cur = frames[frame];
+	DescriptorSetHndl result;
+
+	/* Transient sets are never freed, so exhausted pools stay exhausted until the frame is started again. */
+	for (; cur.Active < cur.Pools.size(); cur.Active++)
+	{
+		if (TryAllocate(cur.Pools[cur.Active], layout, &result)) return result;
+	}
+
+	cur.Pools.emplace_back(CreatePool(DescriptorPoolCreateFlags::None));
+	if (!TryAllocate(cur.Pools.back(), layout, &result)) ThrowInvalidAlloc();
+	return result;
+}
+
+bool Pu::DescriptorAllocator::AllocateCached(DescriptorSetLayoutHndl layout, const vector<uint64> & resources, DescriptorSetHndl * result)
+{
+	CacheKey key{ layout, resources };
+
+	decltype(cache)::iterator it = cache.find(key);
+	if (it != cache.end())
+	{
+		*result = it->second;
+		return false;
+	}
+
+	/* Cached sets are never freed individually, they just use the persistent pools. */
+	static_cast<void>(Allocate(layout, result));
+	cache.emplace(std::move(key), *result);
+	return true;
+}
+
+void Pu::DescriptorAllocator::BeginFrame(uint32 frame)
+{
+	this->frame = frame % frames.size();
+	Frame &cur = frames[this->frame];
+
+	/* Only the pools that were used need to be reset, the others are still empty. */
+	for (uint32 i = 0; i <= cur.Active && i < cur.Pools.size(); i++)
+	{
+		VK_VALIDATE(dispatch.ResetDescriptorPool(dispatch.Device, cur.Pools[i], 0), PFN_vkResetDescriptorPool);
+	}
+
+	cur.Active = 0;
+}
+
+void Pu::DescriptorAllocator::Reset(void)
+{
+	open.clear();
+	cache.clear();
+
+	for (uint32 i = 0; i < pools.size(); i++)
+	{
+		VK_VALIDATE(dispatch.ResetDescriptorPool(dispatch.Device, pools[i], 0), PFN_vkResetDescriptorPool);
+		available[i] = true;
+		open.emplace_back(i);
+	}
+}
+
+Pu::uint32 Pu::DescriptorAllocator::GetTransientPoolCount(void) const
+{
+	uint32 result = 0;
+	for (const Frame &cur : frames) result += static_cast<uint32>(cur.Pools.size());
+	return result;
+}
+
+Pu::DescriptorPoolHndl Pu::DescriptorAllocator::CreatePool(DescriptorPoolCreateFlags flags)
+{
+	DescriptorPoolCreateInfo info{ setsPerPool, sizes };
+	info.Flags = flags;
+
+	DescriptorPoolHndl result;
+	VK_VALIDATE(dispatch.CreateDescriptorPool(dispatch.Device, &info, nullptr, &result), PFN_vkCreateDescriptorPool);
+	return result;
+}
+
+bool Pu::DescriptorAllocator::TryAllocate(DescriptorPoolHndl pool, DescriptorSetLayoutHndl layout, DescriptorSetHndl * result)
+{
+	const DescriptorSetAllocateInfo info{ pool, layout };
+	const VkApiResult code = dispatch.AllocateDescriptorSets(dispatch.Device, &info, result);
+
+	/* These errors just mean that the pool is full, any other error is still fatal. */
+	if (code == VkApiResult::OutOfPoolMemory || code == VkApiResult::FragmentedPool) return false;
+	VK_VALIDATE(code, PFN_vkAllocateDescriptorSets);
+	return true;
+}
+
+void Pu::DescriptorAllocator::Destroy(void)
+{
+	for (DescriptorPoolHndl cur : pools) dispatch.DestroyDescriptorPool(dispatch.Device, cur, nullptr);
+	for (const Frame &cur : frames)
+	{
+		for (DescriptorPoolHndl pool : cur.Pools) dispatch.DestroyDescriptorPool(dispatch.Device, pool, nullptr);
+	}
+}
+
+void Pu::DescriptorAllocator::ThrowInvalidAlloc(void)
+{
+	Log::Fatal("Cannot allocate descriptor set from an empty descriptor pool (pool sizes don't cover the set layout)!");
+}
+
+bool Pu::DescriptorAllocator::CacheKey::operator==(const CacheKey & other) const
+{
+	return Layout == other.Layout && Resources == other.Resources;
+}
+
+size_t Pu::DescriptorAllocator::CacheKeyHasher::operator()(const CacheKey & key) const
+{
+	size_t result = std::hash<DescriptorSetLayoutHndl>{}(key.Layout);
+	for (const uint64 cur : key.Resources) result = std::hash_combine(result, cur);
+	return result;
+}
\ No newline at end of file
@@ -2,13 +2,13 @@
 #include "Graphics/Resources/DynamicBuffer.h"
 
 Pu::DescriptorPool::DescriptorPool(const Renderpass & renderpass)
-	: device(renderpass.device), renderpass(&renderpass), firstUpdate(true), stride(0),
-	OnStage("DescriptorPoolOnStage", true), buffer(nullptr), maxSets(0)
+	: device(renderpass.device), renderpass(&renderpass), firstUpdate(true), stride(0), pageSize(0),
+	OnStage("DescriptorPoolOnStage", true), allocator(nullptr), maxSets(0)
 {}
 
 Pu::DescriptorPool::DescriptorPool(LogicalDevice & device, const ShaderProgram & computepass)
-	: device(&device), computepass(&computepass), firstUpdate(true), stride(0),
-	OnStage("DescriptorPoolOnStage", true), buffer(nullptr), maxSets(0)
+	: device(&device), computepass(&computepass), firstUpdate(true), stride(0), pageSize(0),
+	OnStage("DescriptorPoolOnStage", true), allocator(nullptr), maxSets(0)
 {}
 
 Pu::DescriptorPool::DescriptorPool(const Renderpass & renderpass, uint32 maxSets, uint32 subpass, uint32 set)
@@ -24,13 +24,14 @@ Pu::DescriptorPool::DescriptorPool(LogicalDevice & device, const ShaderProgram &
 }
 
 Pu::DescriptorPool::DescriptorPool(DescriptorPool && value)
-	: hndl(value.hndl), buffer(value.buffer), device(value.device),
-	stride(value.stride), sets(std::move(value.sets)), maxSets(value.maxSets),
+	: allocator(value.allocator), buffers(std::move(value.buffers)), staging(std::move(value.staging)), device(value.device),
+	stride(value.stride), pageSize(value.pageSize), sets(std::move(value.sets)), maxSets(value.maxSets),
 	sizes(std::move(value.sizes)), OnStage(std::move(value.OnStage)),
-	renderpass(value.renderpass), firstUpdate(value.firstUpdate)
+	renderpass(value.renderpass), firstUpdate(value.firstUpdate),
+	allocations(std::move(value.allocations))
 {
-	value.hndl = nullptr;
-	value.buffer = nullptr;
+	value.allocator = nullptr;
+	value.buffers.clear();
 }
 
 Pu::DescriptorPool & Pu::DescriptorPool::operator=(DescriptorPool && other)
@@ -39,19 +40,22 @@ Pu::DescriptorPool & Pu::DescriptorPool::operator=(DescriptorPool && other)
 	{
 		Destroy();
 
-		hndl = other.hndl;
-		buffer = other.buffer;
+		allocator = other.allocator;
+		buffers = std::move(other.buffers);
+		staging = std::move(other.staging);
 		device = other.device;
 		stride = other.stride;
+		pageSize = other.pageSize;
 		maxSets = other.maxSets;
 		sizes = std::move(other.sizes);
 		renderpass = other.renderpass;
 		OnStage = std::move(other.OnStage);
 		firstUpdate = other.firstUpdate;
 		sets = std::move(other.sets);
+		allocations = std::move(other.allocations);
 
-		other.hndl = nullptr;
-		other.buffer = nullptr;
+		other.allocator = nullptr;
+		other.buffers.clear();
 	}
 
 	return *this;
@@ -88,36 +92,58 @@ void Pu::DescriptorPool::AddSet(uint32 set, uint32 max)
 void Pu::DescriptorPool::Update(CommandBuffer & cmdBuffer, PipelineStageFlags dstStage)
 {
 	/* Create the pool if it hasn't been created yet. */
-	if (!hndl) Create();
+	lock.lock();
+	if (!allocator) Create();
 
-	if (buffer)
+	if (buffers.size())
 	{
-		/* Start by staging the memory to the buffer. */
-		buffer->BeginMemoryTransfer();
-		OnStage.Post(*this, reinterpret_cast<byte*>(buffer->GetHostMemory()));
-		buffer->EndMemoryTransfer();
-
-		/* Update the contents of the dynamic buffer. */
-		buffer->Update(cmdBuffer);
+		/* Start by staging the memory, chained buffers are staged to contiguous memory first as the offsets span all buffers. */
+		for (DynamicBuffer *buffer : buffers) buffer->BeginMemoryTransfer();
+		if (buffers.size() == 1) OnStage.Post(*this, reinterpret_cast<byte*>(buffers.front()->GetHostMemory()));
+		else
+		{
+			staging.resize(pageSize * buffers.size());
+			OnStage.Post(*this, staging.data());
+			for (size_t i = 0; i < buffers.size(); i++) memcpy(buffers[i]->GetHostMemory(), staging.data() + i * pageSize, pageSize);
+		}
 
-		/* We need to move the buffer to uniform read mode once. */
-		if (firstUpdate)
+		for (DynamicBuffer *buffer : buffers)
 		{
-			firstUpdate = false;
-			cmdBuffer.MemoryBarrier(*buffer, PipelineStageFlags::Transfer, dstStage, AccessFlags::UniformRead);
+			/* Update the contents of the dynamic buffer. */
+			buffer->EndMemoryTransfer();
+			buffer->Update(cmdBuffer);
+
+			/* We need to move the buffers to uniform read mode once (this is done again if a buffer was chained). */
+			if (firstUpdate) cmdBuffer.MemoryBarrier(*buffer, PipelineStageFlags::Transfer, dstStage, AccessFlags::UniformRead);
 		}
+
+		firstUpdate = false;
 	}
+
+	lock.unlock();
 }
 
 void Pu::DescriptorPool::Reset(void)
 {
-	VK_VALIDATE(device->vkResetDescriptorPool(device->hndl, hndl, 0), PFN_vkResetDescriptorPool);
+	lock.lock();
+
+	if (allocator) allocator->Reset();
+	allocations.clear();
+
+	/* All the spaces in the uniform buffers are available again, the last page is pushed first so the first page is used first. */
+	for (SetInfo &info : sets)
+	{
+		info.spaces.clear();
+		for (size_t i = buffers.size(); i > 0; i--) info.AddSpaces(static_cast<uint32>(i - 1));
+	}
+
+	lock.unlock();
 }
 
 void Pu::DescriptorPool::AddSetInternal(uint32 subpass, uint32 set, uint32 max, const DescriptorSetLayout & layout)
 {
 #ifdef _DEBUG
-	if (hndl) Log::Fatal("Cannot add set to descriptor pool (0x%X) after it has been initialized!", hndl);
+	if (allocator) Log::Fatal("Cannot add set to descriptor pool after it has been initialized!");
 #endif
 
 	if (layout.HasUniformBufferMemory())
@@ -148,93 +174,121 @@ void Pu::DescriptorPool::AddSetInternal(uint32 subpass, uint32 set, uint32 max,
 	maxSets += max;
 }
 
+/*
+The Vulkan pools are chained by the allocator and the uniform buffers are chained by the pool.
+Every uniform buffer (page) contains the spaces of all sets, so a space index is converted to a page and a local space.
+The free spaces are kept as a stack and the owner of every set is stored,
+so both allocating and freeing are independent of the amount of live sets.
+*/
 Pu::DeviceSize Pu::DescriptorPool::Alloc(uint32 subpass, const DescriptorSetLayout & layout, DescriptorSetHndl * result)
 {
 	/* Lazily create if needed. */
 	lock.lock();
-	if (!hndl) Create();
+	if (!allocator) Create();
 
-	/* Allocate the set from the pool, Vulkan will throw an exception if we don't have any descriptors left. */
-	const DescriptorSetAllocateInfo info{ hndl, layout.hndl };
-	VK_VALIDATE(device->vkAllocateDescriptorSets(device->hndl, &info, result), PFN_vkAllocateDescriptorSets);
+	Allocation allocation{ allocator->Allocate(layout.hndl, result), ~0u, 0 };
+	DeviceSize offset = 0;
 
 	/* Return the buffer offset if this set is a uniform buffer. */
-	if (buffer)
+	if (layout.HasUniformBufferMemory())
 	{
 		/* Get the base offset of the set in the buffer. */
 		const uint64 id = MakeId(subpass, layout.set);
 		decltype(sets)::iterator it = sets.iteratorOf([id](const SetInfo &cur) { return cur.Id == id; });
-		if (it != sets.end())
-		{
-			/* Find an unused space in the buffer. */
-			for (uint32 i = 0; i < it->spaces.size(); i++)
-			{
-				if (!it->spaces[i])
-				{
-					/* Mark the space as used and return the offset of it. */
-					it->spaces[i] = *result;
-					lock.unlock();
-
-					return it->Offset + layout.GetAllignedStride() * i;
-				}
-			}
-
-			ThrowInvalidAlloc(subpass, layout.set, "max set allocations reached");
-		}
-		else ThrowInvalidAlloc(subpass, layout.set, "combination wasn't specified during creation");
+		if (it == sets.end()) ThrowInvalidAlloc(subpass, layout.set, "combination wasn't specified during creation");
+		if (it->spaces.empty()) AddPage();
+
+		/* Take an unused space in the buffers. */
+		allocation.Info = static_cast<uint32>(it - sets.begin());
+		allocation.Space = it->spaces.back();
+		it->spaces.pop_back();
+
+		const uint32 page = allocation.Space / it->Max;
+		offset = page * pageSize + it->Offset + layout.GetAllignedStride() * (allocation.Space - page * it->Max);
 	}
 
-	/* No offset is needed as the descriptor set doesn't have buffer memory. */
+	allocations.emplace(*result, allocation);
 	lock.unlock();
-	return 0;
+	return offset;
+}
+
+bool Pu::DescriptorPool::AllocCached(uint32 subpass, const DescriptorSetLayout & layout, const vector<uint64> & resources, DescriptorSetHndl * result)
+{
+	/* Cached sets are shared by everyone that binds the same resources, so they cannot own a space in the uniform buffers. */
+	if (layout.HasUniformBufferMemory()) ThrowInvalidAlloc(subpass, layout.set, "cached sets cannot contain uniform blocks");
+
+	lock.lock();
+	if (!allocator) Create();
+
+	/* Cached sets are not added to the allocations, they're only released when the pool is reset. */
+	const bool allocated = allocator->AllocateCached(layout.hndl, resources, result);
+	lock.unlock();
+	return allocated;
 }
 
 void Pu::DescriptorPool::Free(DescriptorSetHndl set)
 {
 	lock.lock();
 
-	if (buffer)
+	decltype(allocations)::iterator it = allocations.find(set);
+	if (it != allocations.end())
 	{
-		for (SetInfo &info : sets)
-		{
-			for (DescriptorSetHndl &space : info.spaces)
-			{
-				if (space == set)
-				{
-					/* Goto is used to break out of nested for loop. */
-					space = nullptr;
-					goto FreeDescriptorSet;
-				}
-			}
-		}
+		/* Return the space in the uniform buffer if the set had one. */
+		const Allocation &allocation = it->second;
+		if (allocation.Info != ~0u) sets[allocation.Info].spaces.emplace_back(allocation.Space);
+
+		allocator->Free(allocation.Pool, set);
+		allocations.erase(it);
 	}
+	else Log::Error("Attempting to free descriptor set that wasn't allocated from this pool!");
 
-FreeDescriptorSet:
-	VK_VALIDATE(device->vkFreeDescriptorSets(device->hndl, hndl, 1, &set), PFN_vkFreeDescriptorSets);
 	lock.unlock();
 }
 
+Pu::DynamicBuffer & Pu::DescriptorPool::GetBuffer(DeviceSize & offset) const
+{
+	const DeviceSize page = offset / pageSize;
+	offset -= page * pageSize;
+	return *buffers[page];
+}
+
+/*
+Sets that are still in flight reference the existing buffers, so those are never resized.
+A new buffer is chained instead and its spaces are added to every set.
+*/
+void Pu::DescriptorPool::AddPage(void)
+{
+	const uint32 page = static_cast<uint32>(buffers.size());
+	DynamicBuffer *buffer = new DynamicBuffer(*device, pageSize, BufferUsageFlags::TransferDst | BufferUsageFlags::UniformBuffer);
+	buffer->SetDebugName("Uniform Buffer");
+	buffers.emplace_back(buffer);
+
+	for (SetInfo &info : sets) info.AddSpaces(page);
+	firstUpdate = true;
+}
+
 void Pu::DescriptorPool::Create(void)
 {
-	const DescriptorPoolCreateInfo info{ maxSets, sizes };
-	VK_VALIDATE(device->vkCreateDescriptorPool(device->hndl, &info, nullptr, &hndl), PFN_vkCreateDescriptorPool);
+	/* Every chained Vulkan pool has the size that was requested by the user. */
+	const DescriptorDispatchTable dispatch{ device->hndl, device->vkCreateDescriptorPool, device->vkDestroyDescriptorPool, device->vkResetDescriptorPool, device->vkAllocateDescriptorSets, device->vkFreeDescriptorSets };
+	allocator = new DescriptorAllocator(dispatch, sizes, maxSets, 1);
 
 	/* The buffer is needed for the set to do a write when it allocates. */
 	if (sets.size())
 	{
-		/* We must allign the final set stride to the physical device allignment, otherwise multiple sets will not start at proper allignment. */
-		const DeviceSize size = device->GetPhysicalDevice().GetUniformBufferOffsetAllignment(sets.back().Offset + stride * sets.back().GetMaxSets());
-		buffer = new DynamicBuffer(*device, size, BufferUsageFlags::TransferDst | BufferUsageFlags::UniformBuffer);
-		buffer->SetDebugName("Uniform Buffer");
+		/* We must allign the final set stride to the physical device allignment, otherwise multiple sets (or pages) will not start at proper allignment. */
+		pageSize = device->GetPhysicalDevice().GetUniformBufferOffsetAllignment(sets.back().Offset + stride * sets.back().GetMaxSets());
+		AddPage();
 	}
 }
 
 void Pu::DescriptorPool::Destroy(void)
 {
-	if (hndl)
+	if (allocator)
 	{
-		device->vkDestroyDescriptorPool(device->hndl, hndl, nullptr);
-		delete buffer;
+		delete allocator;
+		for (DynamicBuffer *buffer : buffers) delete buffer;
+		buffers.clear();
 	}
 }
 
@@ -250,7 +304,11 @@ Pu::uint64 Pu::DescriptorPool::MakeId(uint32 subpass, uint32 set)
 }
 
 Pu::DescriptorPool::SetInfo::SetInfo(uint32 subpass, uint32 set, uint32 max, DeviceSize offset)
-	: Id(MakeId(subpass, set)), Offset(offset)
+	: Id(MakeId(subpass, set)), Offset(offset), Max(max)
+{}
+
+void Pu::DescriptorPool::SetInfo::AddSpaces(uint32 page)
 {
-	spaces.resize(max, nullptr);
+	/* The spaces are popped from the back, so the first space of the page is used first. */
+	for (uint32 i = Max; i > 0; i--) spaces.emplace_back(page * Max + i - 1);
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 #include "Graphics/Resources/DynamicBuffer.h"
 
 Pu::DescriptorSet::DescriptorSet(DescriptorPool & pool, uint32 subpass, const DescriptorSetLayout & setLayout)
-	: DescriptorSetBase(pool), set(setLayout.GetSet()), subscribe(setLayout.HasUniformBufferMemory())
+	: DescriptorSetBase(pool), set(setLayout.GetSet()), subscribe(setLayout.HasUniformBufferMemory()), cached(false), needsWrite(true)
 {
 	/* Allocate the new buffer and get the base offset into the pools buffer. */
 	baseOffset = pool.Alloc(subpass, setLayout, &hndl);
@@ -15,9 +15,16 @@ Pu::DescriptorSet::DescriptorSet(DescriptorPool & pool, uint32 subpass, const De
 	}
 }
 
+Pu::DescriptorSet::DescriptorSet(DescriptorPool & pool, uint32 subpass, const DescriptorSetLayout & setLayout, const vector<uint64> & resources)
+	: DescriptorSetBase(pool), set(setLayout.GetSet()), baseOffset(0), subscribe(false), cached(true)
+{
+	/* The set might already be written by a previous owner, so only new sets have to be written. */
+	needsWrite = pool.AllocCached(subpass, setLayout, resources, &hndl);
+}
+
 Pu::DescriptorSet::DescriptorSet(DescriptorSet && value)
 	: DescriptorSetBase(std::move(value)), hndl(value.hndl), set(value.set),
-	baseOffset(value.baseOffset), subscribe(value.subscribe)
+	baseOffset(value.baseOffset), subscribe(value.subscribe), cached(value.cached), needsWrite(value.needsWrite)
 {
 	value.hndl = nullptr;
 	if (subscribe) Pool->OnStage.Add(*this, &DescriptorSet::StageInternal);
@@ -34,6 +41,8 @@ Pu::DescriptorSet & Pu::DescriptorSet::operator=(DescriptorSet && other)
 		set = other.set;
 		baseOffset = other.baseOffset;
 		subscribe = other.subscribe;
+		cached = other.cached;
+		needsWrite = other.needsWrite;
 
 		if (subscribe) Pool->OnStage.Add(*this, &DescriptorSet::StageInternal);
 		other.hndl = nullptr;
@@ -80,7 +89,8 @@ void Pu::DescriptorSet::Free(void)
 
 void Pu::DescriptorSet::Destroy(void)
 {
-	if (hndl) Pool->Free(hndl);
+	/* Cached sets are owned by the pool, they're only released when it's reset. */
+	if (hndl && !cached) Pool->Free(hndl);
 
 	if (subscribe)
 	{
@@ -16,9 +16,11 @@ void Pu::DescriptorSetBase::Write(DescriptorSetHndl hndl, const DescriptorSetLay
 	vector<WriteDescriptorSet> writes;
 	writes.reserve(layout.ranges.size());
 
+	/* The offset spans all the uniform buffers of the pool, so convert it to the buffer that backs it. */
+	const DynamicBuffer &buffer = Pool->GetBuffer(offset);
 	for (const auto&[binding, range] : layout.ranges)
 	{
-		bufferInfos.emplace_back(Pool->buffer->bufferHndl, offset + range.first, range.second);
+		bufferInfos.emplace_back(buffer.bufferHndl, offset + range.first, range.second);
 		writes.emplace_back(hndl, binding, bufferInfos.back());
 	}
 
@@ -66,6 +68,12 @@ void Pu::DescriptorSetBase::Write(DescriptorSetHndl hndl, uint32 set, const Desc
 	WriteDescriptors({ write });
 }
 
+void Pu::DescriptorSetBase::AddResource(vector<uint64> & resources, const Texture & texture)
+{
+	resources.emplace_back(reinterpret_cast<uint64>(texture.view->hndl));
+	resources.emplace_back(reinterpret_cast<uint64>(texture.Sampler->hndl));
+}
+
 Pu::DeviceSize Pu::DescriptorSetBase::GetOffsetAligned(DeviceSize size) const
 {
 	return Pool->renderpass->device->GetPhysicalDevice().GetUniformBufferOffsetAllignment(size);
@@ -0,0 +1,208 @@
+#include "Graphics/Vulkan/DeviceMemoryAllocator.h"
+#include "Graphics/Vulkan/PhysicalDevice.h"
+
+Pu::DeviceMemoryAllocator::Block::Block(DeviceMemoryHndl memory, byte * hostMemory, bool linear)
+	: Memory(memory), HostMemory(hostMemory), Ranges(DeviceMemoryBlockSize), Linear(linear)
+{}
+
+Pu::DeviceMemoryAllocator::DeviceMemoryAllocator(LogicalDevice & device)
+	: device(&device), atomSize(device.GetPhysicalDevice().GetLimits().NonCoherentAtomSize), dedicatedAllocations(0)
+{}
+
+/*
+Resources that are larger than half a block, or that need their own memory object, get a dedicated allocation.
+Non-coherent ranges are padded to the atom size, so flushing one resource never touches another.
+
+if dedicated
+	allocate memory object
+else
+	foreach block of the memory type
+		try allocate range
+	allocate new block
+	allocate range
+*/
+Pu::DeviceAllocation Pu::DeviceMemoryAllocator::Allocate(const MemoryRequirements & requirements, uint32 memoryType, bool linear, bool dedicated)
+{
+	DeviceAllocation result;
+	result.MemoryType = memoryType;
+
+	DeviceSize alignment = requirements.Alignment;
+	result.Size = requirements.Size;
+	if (IsHostVisible(memoryType) && !IsHostCoherent(memoryType))
+	{
+		alignment = max(alignment, atomSize);
+		result.Size = (result.Size + atomSize - 1) / atomSize * atomSize;
+	}
+
+	std::lock_guard guard{ lock };
+	if (!DeviceMemorySubAllocation || dedicated || result.Size > DeviceMemoryBlockSize / 2)
+	{
+		result.Memory = AllocateMemory(result.Size, memoryType, result.HostMemory);
+		++dedicatedAllocations;
+		return result;
+	}
+
+	vector<Block> &pool = blocks[memoryType];
+	for (uint32 i = 0; i < pool.size(); i++)
+	{
+		Block &block = pool[i];
+		if (!block.Memory || block.Linear != linear) continue;
+
+		result.Range = block.Ranges.Allocate(result.Size, alignment, result.Offset);
+		if (result.Range != TLSFAllocator::InvalidHandle)
+		{
+			result.Block = i;
+			break;
+		}
+	}
+
+	if (result.IsDedicated())
+	{
+		/* Reuse the slot of a released block, because the block index is stored in the allocations. */
+		byte *hostMemory;
+		const DeviceMemoryHndl memory = AllocateMemory(DeviceMemoryBlockSize, memoryType, hostMemory);
+
+		result.Block = static_cast<uint32>(pool.size());
+		for (uint32 i = 0; i < pool.size(); i++)
+		{
+			if (!pool[i].Memory)
+			{
+				result.Block = i;
+				break;
+			}
+		}
+
+		if (result.Block < pool.size()) pool[result.Block] = Block{ memory, hostMemory, linear };
+		else pool.emplace_back(memory, hostMemory, linear);
+
+		result.Range = pool[result.Block].Ranges.Allocate(result.Size, alignment, result.Offset);
+	}
+
+	const Block &block = pool[result.Block];
+	result.Memory = block.Memory;
+	if (block.HostMemory) result.HostMemory = block.HostMemory + result.Offset;
+	return result;
+}
+
+void Pu::DeviceMemoryAllocator::Free(const DeviceAllocation & allocation)
+{
+	if (!allocation.Memory) return;
+
+	std::lock_guard guard{ lock };
+	if (allocation.IsDedicated())
+	{
+		FreeMemory(allocation.Memory);
+		--dedicatedAllocations;
+		return;
+	}
+
+	vector<Block> &pool = blocks[allocation.MemoryType];
+	Block &block = pool[allocation.Block];
+	block.Ranges.Free(allocation.Range);
+
+	/* Keep one empty block per memory type around, so resources that are recreated every frame don't allocate new memory objects. */
+	if (block.Ranges.IsEmpty())
+	{
+		for (uint32 i = 0; i < pool.size(); i++)
+		{
+			if (i != allocation.Block && pool[i].Memory && pool[i].Linear == block.Linear && pool[i].Ranges.IsEmpty())
+			{
+				FreeMemory(block.Memory);
+				block.Memory = nullptr;
+				block.HostMemory = nullptr;
+				break;
+			}
+		}
+	}
+}
+
+/* The range is expanded to the atom size, this never overlaps other resources because their ranges are padded to the atom size. */
+Pu::MappedMemoryRange Pu::DeviceMemoryAllocator::GetFlushRange(const DeviceAllocation & allocation, DeviceSize offset, DeviceSize size) const
+{
+	if (size == WholeSize) size = allocation.Size - offset;
+
+	const DeviceSize start = (allocation.Offset + offset) / atomSize * atomSize;
+	const DeviceSize end = min(allocation.Offset + allocation.Size, (allocation.Offset + offset + size + atomSize - 1) / atomSize * atomSize);
+	return MappedMemoryRange{ allocation.Memory, start, end - start };
+}
+
+Pu::DeviceMemoryStatistics Pu::DeviceMemoryAllocator::GetStatistics(void) const
+{
+	DeviceMemoryStatistics result{};
+	DeviceSize free = 0, largestFree = 0;
+
+	std::lock_guard guard{ lock };
+	result.DedicatedAllocations = dedicatedAllocations;
+
+	for (const vector<Block> &pool : blocks)
+	{
+		for (const Block &block : pool)
+		{
+			if (!block.Memory) continue;
+
+			const DeviceSize largest = block.Ranges.GetLargestFreeRange();
+			++result.Blocks;
+			result.Allocations += block.Ranges.GetAllocationCount();
+			result.FreeRanges += block.Ranges.GetFreeRangeCount();
+			result.Reserved += block.Ranges.GetCapacity();
+			result.Used += block.Ranges.GetUsedSize();
+			result.LargestFreeRange = max(result.LargestFreeRange, largest);
+
+			free += block.Ranges.GetFreeSize();
+			largestFree += largest;
+		}
+	}
+
+	result.Fragmentation = free ? 1.0f - static_cast<float>(static_cast<double>(largestFree) / static_cast<double>(free)) : 0.0f;
+	return result;
+}
+
+bool Pu::DeviceMemoryAllocator::IsHostVisible(uint32 memoryType) const
+{
+	return _CrtEnumCheckFlag(device->GetPhysicalDevice().GetMemoryProperties().MemoryTypes[memoryType].PropertyFlags, MemoryPropertyFlags::HostVisible);
+}
+
+bool Pu::DeviceMemoryAllocator::IsHostCoherent(uint32 memoryType) const
+{
+	return _CrtEnumCheckFlag(device->GetPhysicalDevice().GetMemoryProperties().MemoryTypes[memoryType].PropertyFlags, MemoryPropertyFlags::HostCoherent);
+}
+
+Pu::DeviceMemoryHndl Pu::DeviceMemoryAllocator::AllocateMemory(DeviceSize size, uint32 memoryType, byte *& hostMemory)
+{
+	const MemoryAllocateInfo info{ size, memoryType };
+	DeviceMemoryHndl result;
+	++device->parent->memAllocs;
+	VK_VALIDATE(device->vkAllocateMemory(device->hndl, &info, nullptr, &result), PFN_vkAllocateMemory);
+
+	/* Host visible memory stays mapped for its entire lifetime. */
+	hostMemory = nullptr;
+	if (IsHostVisible(memoryType))
+	{
+		VK_VALIDATE(device->vkMapMemory(device->hndl, result, 0, WholeSize, 0, reinterpret_cast<void**>(&hostMemory)), PFN_vkMapMemory);
+	}
+
+	return result;
+}
+
+void Pu::DeviceMemoryAllocator::FreeMemory(DeviceMemoryHndl memory)
+{
+	/* Freeing memory implicitly unmaps it. */
+	device->vkFreeMemory(device->hndl, memory, nullptr);
+	--device->parent->memAllocs;
+}
+
+void Pu::DeviceMemoryAllocator::Destroy(void)
+{
+	for (vector<Block> &pool : blocks)
+	{
+		for (const Block &block : pool)
+		{
+			if (!block.Memory) continue;
+
+			if (!block.Ranges.IsEmpty()) Log::Warning("Device memory block is released with %u active allocations!", block.Ranges.GetAllocationCount());
+			FreeMemory(block.Memory);
+		}
+
+		pool.clear();
+	}
+}
\ No newline at end of file
@@ -10,12 +10,12 @@ Pu::Image::Image(LogicalDevice & device, const ImageCreateInfo & createInfo)
 }
 
 Pu::Image::Image(Image && value)
-	: Asset(std::move(value)), parent(value.parent), imageHndl(value.imageHndl), memoryHndl(value.memoryHndl), type(value.type), 
+	: Asset(std::move(value)), parent(value.parent), imageHndl(value.imageHndl), memory(value.memory), type(value.type), 
 	format(value.format), mipmaps(value.mipmaps), usage(value.usage), layout(value.layout), access(value.access), 
 	dimensions(value.dimensions), layers(value.layers)
 {
 	value.imageHndl = nullptr;
-	value.memoryHndl = nullptr;
+	value.memory = DeviceAllocation();
 }
 
 Pu::Image & Pu::Image::operator=(Image && other)
@@ -27,7 +27,7 @@ Pu::Image & Pu::Image::operator=(Image && other)
 		Asset::operator=(std::move(other));
 		parent = other.parent;
 		imageHndl = other.imageHndl;
-		memoryHndl = other.memoryHndl;
+		memory = other.memory;
 		type = other.type;
 		format = other.format;
 		mipmaps = other.mipmaps;
@@ -38,7 +38,7 @@ Pu::Image & Pu::Image::operator=(Image && other)
 		layers = other.layers;
 
 		other.imageHndl = nullptr;
-		other.memoryHndl = nullptr;
+		other.memory = DeviceAllocation();
 	}
 
 	return *this;
@@ -61,10 +61,11 @@ Pu::uint32 Pu::Image::GetMaxMipLayers(uint32 width, uint32 height, uint32 depth)
 
 Pu::DeviceSize Pu::Image::GetLazyMemory(void) const
 {
-	if (memoryHndl)
+	/* Lazily allocated memory is never shared with other resources. */
+	if (memory.Memory && memory.IsDedicated())
 	{
 		DeviceSize result;
-		parent->vkGetDeviceMemoryCommitment(parent->hndl, memoryHndl, &result);
+		parent->vkGetDeviceMemoryCommitment(parent->hndl, memory.Memory, &result);
 		return result;
 	}
 	else return 0;
@@ -87,7 +88,7 @@ Pu::Asset & Pu::Image::Duplicate(AssetCache &)
 /* We don't allow this image to be copied as it's memory is handled by another system (like the OS). */
 Pu::Image::Image(LogicalDevice & device, ImageHndl hndl, ImageType type, Format format, Extent3D extent, uint32 mipmaps, ImageUsageFlags usage, ImageLayout layout, AccessFlags access)
 	: Asset(false, std::hash<ImageHndl>{}(hndl)), parent(&device), imageHndl(hndl), layers(1),
-	memoryHndl(nullptr), type(type), format(format), dimensions(extent), mipmaps(mipmaps), usage(usage), layout(layout), access(access)
+	type(type), format(format), dimensions(extent), mipmaps(mipmaps), usage(usage), layout(layout), access(access)
 {
 	SetDebugName("OS Image");
 	MarkAsLoaded(false, L"OS Image");
@@ -112,10 +113,8 @@ void Pu::Image::Create(const ImageCreateInfo & createInfo)
 	const MemoryRequirements requirements = GetMemoryRequirements();
 	if (parent->parent->GetBestMemoryType(requirements.MemoryTypeBits, memProps, lazy ? MemoryPropertyFlags::LazilyAllocated : MemoryPropertyFlags::None, typeIdx))
 	{
-		/* Allocate the image's data. */
-		const MemoryAllocateInfo allocateInfo(requirements.Size, typeIdx);
-		++parent->parent->memAllocs;
-		VK_VALIDATE(parent->vkAllocateMemory(parent->hndl, &allocateInfo, nullptr, &memoryHndl), PFN_vkAllocateMemory);
+		/* Allocate the image's data, transient attachments keep their own memory so the lazy commitment can be queried. */
+		memory = parent->GetMemoryAllocator().Allocate(requirements, typeIdx, createInfo.Tiling == ImageTiling::Linear, lazy);
 
 		/* Bind the memory to the image. */
 		Bind();
@@ -163,8 +162,7 @@ void Pu::Image::CanCreate(const ImageCreateInfo & info)
 
 void Pu::Image::Bind(void) const
 {
-	// TODO: We should not allocate a memory object for ever image but rather make one big one and set a proper offset to increase cache hits.
-	VK_VALIDATE(parent->vkBindImageMemory(parent->hndl, imageHndl, memoryHndl, 0), PFN_vkBindImageMemory);
+	VK_VALIDATE(parent->vkBindImageMemory(parent->hndl, imageHndl, memory.Memory, memory.Offset), PFN_vkBindImageMemory);
 }
 
 Pu::MemoryRequirements Pu::Image::GetMemoryRequirements(void)
@@ -177,10 +175,9 @@ Pu::MemoryRequirements Pu::Image::GetMemoryRequirements(void)
 void Pu::Image::Destroy(void)
 {
 	/* We don't need to destroy swapchain images so make sure both are set for a user created image. */
-	if (memoryHndl && imageHndl)
+	if (memory.Memory && imageHndl)
 	{
 		parent->vkDestroyImage(parent->hndl, imageHndl, nullptr);
-		parent->vkFreeMemory(parent->hndl, memoryHndl, nullptr);
-		--parent->parent->memAllocs;
+		parent->GetMemoryAllocator().Free(memory);
 	}
 }
\ No newline at end of file
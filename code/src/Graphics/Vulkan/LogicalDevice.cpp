@@ -1,6 +1,7 @@
 #include "Graphics/Vulkan/LogicalDevice.h"
 #include "Graphics/Vulkan/Loader.h"
 #include "Graphics/Vulkan/Instance.h"
+#include "Graphics/Vulkan/DeviceMemoryAllocator.h"
 
 using namespace Pu;
 
@@ -8,13 +9,15 @@ using namespace Pu;
 #define LOAD_DEVICE_PROC(name)	VK_LOAD_DEVICE_PROC(parent->parent->hndl, hndl, name)
 
 Pu::LogicalDevice::LogicalDevice(LogicalDevice && value)
-	: parent(value.parent), hndl(value.hndl), queues(std::move(value.queues)), 
+	: parent(value.parent), hndl(value.hndl), queues(std::move(value.queues)), allocator(value.allocator),
 	graphicsQueueFamily(value.graphicsQueueFamily), transferQueueFamily(value.transferQueueFamily)
 {
 	/* Make sure to reload the device procs. */
 	LoadDeviceProcs();
+	if (allocator) allocator->device = this;
 
 	value.hndl = nullptr;
+	value.allocator = nullptr;
 }
 
 LogicalDevice & Pu::LogicalDevice::operator=(LogicalDevice && other)
@@ -27,11 +30,14 @@ LogicalDevice & Pu::LogicalDevice::operator=(LogicalDevice && other)
 		graphicsQueueFamily = other.graphicsQueueFamily;
 		transferQueueFamily = other.transferQueueFamily;
 		hndl = other.hndl;
+		allocator = other.allocator;
 
 		/* Make sure to reload the device procs. */
 		LoadDeviceProcs();
+		if (allocator) allocator->device = this;
 
 		other.hndl = nullptr;
+		other.allocator = nullptr;
 	}
 
 	return *this;
@@ -45,6 +51,7 @@ Pu::LogicalDevice::LogicalDevice(PhysicalDevice & parent, DeviceHndl hndl, const
 	for (uint32 i = 0; i < createInfo.EnabledExtensionCount; i++) enabledExtensions.emplace_back(createInfo.EnabledExtensionNames[i]);
 
 	LoadDeviceProcs();
+	allocator = new DeviceMemoryAllocator(*this);
 
 	/* Preload all queues that where created with the logical device. */
 	for (uint32 i = 0; i < createInfo.QueueCreateInfoCount; i++)
@@ -190,6 +197,7 @@ void Pu::LogicalDevice::LoadDeviceProcs(void)
 	LOAD_DEVICE_PROC(vkCmdPushConstants);
 	LOAD_DEVICE_PROC(vkCmdSetLineWidth);
 	LOAD_DEVICE_PROC(vkCmdNextSubpass);
+	LOAD_DEVICE_PROC(vkCmdExecuteCommands);
 	LOAD_DEVICE_PROC(vkCmdBeginQuery);
 	LOAD_DEVICE_PROC(vkCmdEndQuery);
 	LOAD_DEVICE_PROC(vkCmdBlitImage);
@@ -281,6 +289,9 @@ void Pu::LogicalDevice::Destory(void)
 	if (hndl)
 	{
 		VK_VALIDATE(vkDeviceWaitIdle(hndl), PFN_vkDeviceWaitIdle);
+
+		/* The memory blocks have to be released before the device is destroyed. */
+		if (allocator) delete allocator;
 		vkDestroyDevice(hndl, nullptr);
 	}
 }
\ No newline at end of file
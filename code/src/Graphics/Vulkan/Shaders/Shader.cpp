@@ -1,10 +1,42 @@
 #include "Graphics/Vulkan/Shaders/Shader.h"
 #include "Streams/FileReader.h"
+#include "Streams/FileWriter.h"
+#include "Streams/BinaryWriter.h"
 #include "Graphics/Vulkan/SPIR-V/SPIR-VReader.h"
 #include "Graphics/Vulkan/PhysicalDevice.h"
+#include "Core/Math/Basics.h"
 
 const Pu::FieldInfo Pu::Shader::invalid = Pu::FieldInfo();
 constexpr spv::Word GlobalMemberIndex = ~0u;
+/* Defines the identifier at the start of every shader reflection cache file. */
+constexpr Pu::uint32 ShaderReflectionCacheMagic = 0x52535550;
+/* Defines the version of the shader reflection cache layout, caches with a different version are reflected again. */
+constexpr Pu::uint32 ShaderReflectionCacheVersion = 1;
+
+/* Defines the header of a shader reflection cache file, it's followed by the fields and the specialization constants. */
+struct ShaderReflectionCacheHeader
+{
+	Pu::uint32 Magic;
+	Pu::uint32 Version;
+	Pu::uint64 Key;
+	Pu::uint64 Size;
+};
+
+static inline void shader_write_type(Pu::BinaryWriter &writer, const Pu::FieldType &type)
+{
+	writer.Write(static_cast<Pu::uint32>(type.ComponentType));
+	writer.Write(static_cast<Pu::uint32>(type.ContainerType));
+	writer.Write(type.Length);
+}
+
+static inline Pu::FieldType shader_read_type(Pu::BinaryReader &reader)
+{
+	Pu::FieldType result;
+	result.ComponentType = static_cast<Pu::ComponentType>(reader.ReadUInt32());
+	result.ContainerType = static_cast<Pu::SizeType>(reader.ReadUInt32());
+	result.Length = reader.ReadUInt32();
+	return result;
+}
 Pu::SpecializationConstant Pu::Shader::defConst = Pu::SpecializationConstant(0, "", Pu::FieldType(Pu::ComponentType::Byte, Pu::SizeType::Scalar));
 
 Pu::Shader::Shader(LogicalDevice & device)
@@ -23,10 +55,11 @@ Pu::Shader::Shader(LogicalDevice & device, const void *src, size_t size, ShaderS
 	/* Create a new reader and immediately load the shader. */
 	SPIRVReader spvr{ src, size };
 	Create(spvr);
+	Reflect(spvr);
 
 	/* Set the shader information. */
 	info.Stage = stage;
-	SetFieldInfo(L"<Raw SPIR-V>");
+	static_cast<void>(SetFieldInfo(L"<Raw SPIR-V>"));
 
 	/* Mark the asset as loaded and set a default name. */
 	wstring name = L"Raw SPIR-V ";
@@ -101,15 +134,27 @@ void Pu::Shader::Load(const wstring & path, bool viaLoader)
 		SPIRVReader spvr{ path };
 		Create(spvr);
 		SetInfo(path.substr(0, path.length() - 4).fileExtension().toUpper());
+
+		/*
+		Set the information of the subpass.
+		The path has the following format <location>/<shader name>.<shader type>.spv
+		We want the name + type for the asset, but only the name for the field checking.
+		The reflection only changes if the module changes, so the cache next to the module is keyed by the hash of the module.
+		*/
+		const wstring name = path.fileName().trim_back_split(L'.');
+		wstring cachePath = path;
+		cachePath += L".refl";
+		const uint64 key = std::hash_fnv1a(spvr.GetStream().GetData(), spvr.GetStream().GetSize());
+
+		if (!ShaderReflectionCaching || !LoadReflection(cachePath, key, name.c_str()))
+		{
+			Reflect(spvr);
+			const uint32 inputAttachments = SetFieldInfo(name.c_str());
+			if constexpr (ShaderReflectionCaching) StoreReflection(cachePath, key, inputAttachments);
+		}
 	}
 	else Log::Fatal("'%ls' cannot be loaded as a shader (only SPIR-V shaders are valid)!", ext.c_str());
 
-	/*
-	Set the information of the subpass.
-	The path has the following format <location>/<shader name>.<shader type>.spv
-	We want the name + type for the asset, but only the name for the field checking.
-	*/
-	SetFieldInfo(path.fileName().trim_back_split(L'.').c_str());
 	MarkAsLoaded(viaLoader, path.fileName());
 }
 
@@ -118,13 +163,27 @@ void Pu::Shader::Create(SPIRVReader & reader)
 	/* Compile the SPIR-V shader module. */
 	ShaderModuleCreateInfo createInfo(reader.GetStream().GetSize(), reader.GetStream().GetData());
 	VK_VALIDATE(parent->vkCreateShaderModule(parent->hndl, &createInfo, nullptr, &info.Module), PFN_vkCreateShaderModule);
+}
+
+void Pu::Shader::Reflect(SPIRVReader & reader)
+{
+	/* Every ID in the module is lower than the bound, so the temporary buffers can be indexed directly by ID. */
+	const size_t bound = reader.GetBound();
+	names.resize(bound);
+	memberNames.resize(bound);
+	typedefs.resize(bound, 0);
+	types.resize(bound);
+	structs.resize(bound);
+	decorations.resize(bound);
+	memberDecorations.resize(bound);
+	constants.resize(bound, 0.0);
 
 	/* Perform reflection to get the inputs and outputs. */
 	auto handler = DelegateMethod<SPIRVReader, Shader, spv::Op, size_t>(*this, &Shader::HandleModule);
 	reader.HandleAllModules(handler);
 }
 
-void Pu::Shader::SetFieldInfo(const wchar_t * name)
+Pu::uint32 Pu::Shader::SetFieldInfo(const wchar_t * name)
 {
 	/* Create field information for all fields. */
 	for (const auto&[id, typeId, storage] : variables)
@@ -132,24 +191,140 @@ void Pu::Shader::SetFieldInfo(const wchar_t * name)
 		HandleVariable(id, typeId, storage);
 	}
 
-	/* Log an error if we exceed the maximum amount of input attachments. */
+	/* Count the input attachments, these can be defined on both variables and members. */
 	uint32 inputAttachments = 0;
-	for (const auto &[ids, dec] : decorations) inputAttachments += dec.Contains(spv::Decoration::InputAttachmentIndex);
+	for (const Decoration &cur : decorations) inputAttachments += cur.Contains(spv::Decoration::InputAttachmentIndex);
+	for (const vector<Decoration> &members : memberDecorations)
+	{
+		for (const Decoration &cur : members) inputAttachments += cur.Contains(spv::Decoration::InputAttachmentIndex);
+	}
+
+	CheckInputAttachments(name, inputAttachments);
+
+	/* Release the temporary buffers. */
+	names = decltype(names)();
+	memberNames = decltype(memberNames)();
+	decorations = decltype(decorations)();
+	memberDecorations = decltype(memberDecorations)();
+	typedefs = decltype(typedefs)();
+	types = decltype(types)();
+	structs = decltype(structs)();
+	variables = decltype(variables)();
+	constants = decltype(constants)();
+	return inputAttachments;
+}
+
+void Pu::Shader::CheckInputAttachments(const wchar_t * name, uint32 inputAttachments) const
+{
+	/* Log an error if we exceed the maximum amount of input attachments. */
 	if (inputAttachments > parent->parent->GetLimits().MaxPerStageDescriptorInputAttachments)
 	{
 		Log::Error("%s shader '%ls' exceeds the maximum amount of input attachments of %u with %u input attachments defined!",
 			to_string(info.Stage), name, inputAttachments, parent->parent->GetLimits().MaxPerStageDescriptorInputAttachments);
 	}
+}
+
+/*
+The entire cache is read at once and the header is validated before anything is parsed.
+A cache of a different module (or a truncated cache) is ignored and the shader is reflected again.
+*/
+bool Pu::Shader::LoadReflection(const wstring & path, uint64 key, const wchar_t * name)
+{
+	if (!FileReader::FileExists(path)) return false;
+	const string raw = FileReader(path, false).ReadToEnd();
+
+	ShaderReflectionCacheHeader header;
+	if (raw.size() < sizeof(ShaderReflectionCacheHeader)) return false;
+	memcpy(&header, raw.data(), sizeof(ShaderReflectionCacheHeader));
+
+	if (header.Magic != ShaderReflectionCacheMagic || header.Version != ShaderReflectionCacheVersion || header.Key != key
+		|| header.Size != raw.size() - sizeof(ShaderReflectionCacheHeader))
+	{
+		Log::Verbose("Shader reflection cache '%ls' is out of date.", path.fileName().c_str());
+		return false;
+	}
+
+	BinaryReader reader{ raw.data() + sizeof(ShaderReflectionCacheHeader), static_cast<size_t>(header.Size) };
+	const uint32 inputAttachments = reader.ReadUInt32();
+
+	fields.resize(reader.ReadUInt32());
+	for (FieldInfo &cur : fields)
+	{
+		cur.Id = reader.ReadUInt32();
+		cur.Name = reader.ReadString();
+		cur.Type = shader_read_type(reader);
+		cur.Storage = static_cast<spv::StorageClass>(reader.ReadUInt32());
+
+		cur.Decorations.Flags.resize(reader.ReadUInt32());
+		for (spv::Decoration &flag : cur.Decorations.Flags) flag = static_cast<spv::Decoration>(reader.ReadUInt32());
+
+		for (uint32 i = 0, count = reader.ReadUInt32(); i < count; i++)
+		{
+			const spv::Decoration decoration = static_cast<spv::Decoration>(reader.ReadUInt32());
+			cur.Decorations.Numbers.emplace(decoration, reader.ReadUInt32());
+		}
+
+		cur.Decorations.MemberOffset = static_cast<size_t>(reader.ReadUInt64());
+	}
+
+	const uint32 constantCount = reader.ReadUInt32();
+	specializationConstants.reserve(constantCount);
+	for (uint32 i = 0; i < constantCount; i++)
+	{
+		const spv::Id id = reader.ReadUInt32();
+		const string constantName = reader.ReadString();
+		const FieldType type = shader_read_type(reader);
+
+		SpecializationConstant value{ id, constantName, type };
+		value.entry.ConstantID = reader.ReadUInt32();
+		specializationConstants.emplace_back(std::move(value));
+	}
+
+	CheckInputAttachments(name, inputAttachments);
+	return true;
+}
+
+void Pu::Shader::StoreReflection(const wstring & path, uint64 key, uint32 inputAttachments) const
+{
+	BinaryWriter payload;
+	payload.Write(inputAttachments);
+
+	payload.Write(static_cast<uint32>(fields.size()));
+	for (const FieldInfo &cur : fields)
+	{
+		payload.Write(static_cast<uint32>(cur.Id));
+		payload.Write(cur.Name);
+		shader_write_type(payload, cur.Type);
+		payload.Write(static_cast<uint32>(cur.Storage));
+
+		payload.Write(static_cast<uint32>(cur.Decorations.Flags.size()));
+		for (const spv::Decoration flag : cur.Decorations.Flags) payload.Write(static_cast<uint32>(flag));
+
+		payload.Write(static_cast<uint32>(cur.Decorations.Numbers.size()));
+		for (const auto &[decoration, literal] : cur.Decorations.Numbers)
+		{
+			payload.Write(static_cast<uint32>(decoration));
+			payload.Write(static_cast<uint32>(literal));
+		}
+
+		payload.Write(static_cast<uint64>(cur.Decorations.MemberOffset));
+	}
 
-	/* Clear the temporary buffers. */
-	names.clear();
-	memberNames.clear();
-	decorations.clear();
-	typedefs.clear();
-	types.clear();
-	structs.clear();
-	variables.clear();
-	constants.clear();
+	payload.Write(static_cast<uint32>(specializationConstants.size()));
+	for (const SpecializationConstant &cur : specializationConstants)
+	{
+		payload.Write(static_cast<uint32>(cur.id));
+		payload.Write(cur.name);
+		shader_write_type(payload, cur.type);
+		payload.Write(cur.entry.ConstantID);
+	}
+
+	FileWriter writer{ path };
+	if (!writer.IsCreated()) return;
+
+	const ShaderReflectionCacheHeader header{ ShaderReflectionCacheMagic, ShaderReflectionCacheVersion, key, payload.GetSize() };
+	writer.Write(reinterpret_cast<const byte*>(&header), 0, sizeof(ShaderReflectionCacheHeader));
+	writer.Write(payload.GetData(), 0, payload.GetSize());
 }
 
 void Pu::Shader::HandleVariable(spv::Id id, spv::Id typeId, spv::StorageClass storage)
@@ -157,40 +332,40 @@ void Pu::Shader::HandleVariable(spv::Id id, spv::Id typeId, spv::StorageClass st
 	const spv::Id typePointer = typedefs[typeId];
 
 	/* Handle normal type. */
-	if (types.find(typePointer) != types.end())
+	if (types[typePointer].ComponentType != ComponentType::Invalid)
 	{
 		/* User defined variables need to have at least one handlable decoration, all others must be build in variables, which we can skip. */
-		const DecoratePair key{ id, GlobalMemberIndex };
-		if (decorations.find(key) != decorations.end())
+		if (!decorations[id].IsEmpty())
 		{
 			/* Only handle types with defined names, this should never occur. */
-			fields.emplace_back(id, std::move(names[id]), std::move(types[typePointer]), storage, decorations[key]);
+			fields.emplace_back(id, std::move(names[id]), types[typePointer], storage, decorations[id]);
 		}
 	}
 	/* Handle struct types. */
-	else if (structs.find(typePointer) != structs.end())
+	else if (structs[typePointer].size())
 	{
-		/* Handle all member types. */
+		/* Handle all member types, the names and decorations are optional so make sure all members are present. */
 		const vector<spv::Id> &members = structs[typePointer];
+		vector<string> &typeMemberNames = memberNames[typePointer];
+		vector<Decoration> &typeMemberDecorations = memberDecorations[typePointer];
+		if (typeMemberNames.size() < members.size()) typeMemberNames.resize(members.size());
+		if (typeMemberDecorations.size() < members.size()) typeMemberDecorations.resize(members.size());
+
 		for (size_t i = 0, offset = 0; i < members.size(); i++)
 		{
 			const spv::Id memberTypeId = members[i];
-			FieldType fieldType = types[memberTypeId];
-			string &memberName = memberNames[typePointer][i];
+			const FieldType &fieldType = types[memberTypeId];
+			string &memberName = typeMemberNames[i];
 
 			/* Skip any build in members (defined with 'gl_' prefix). */
 			if (!memberName.contains("gl_"))
 			{
-				const DecoratePair globalKey{ id, GlobalMemberIndex };
-				const DecoratePair globalType{ typePointer, GlobalMemberIndex };
-				const DecoratePair memberKey{ typePointer, static_cast<spv::Word>(i) };
-
 				Decoration memberDecoration(offset);
-				memberDecoration.Merge(decorations[globalKey]);
-				memberDecoration.Merge(decorations[globalType]);
-				memberDecoration.Merge(decorations[memberKey]);
+				memberDecoration.Merge(decorations[id]);
+				memberDecoration.Merge(decorations[typePointer]);
+				memberDecoration.Merge(typeMemberDecorations[i]);
 
-				fields.emplace_back(memberTypeId, std::move(memberName), std::move(fieldType), storage, memberDecoration);
+				fields.emplace_back(memberTypeId, std::move(memberName), fieldType, storage, memberDecoration);
 			}
 			else if (fieldType.ComponentType == ComponentType::Invalid)
 			{
@@ -278,28 +453,18 @@ void Pu::Shader::HandleModule(SPIRVReader & reader, spv::Op opCode, size_t wordC
 void Pu::Shader::HandleName(SPIRVReader & reader)
 {
 	const spv::Id target = reader.ReadWord();
-	const string str = reader.ReadLiteralString();
-	names.emplace(target, str);
+	names[target] = reader.ReadLiteralString();
 }
 
 void Pu::Shader::HandleMemberName(SPIRVReader & reader)
 {
 	const spv::Id structType = reader.ReadWord();
 	const spv::Id idx = reader.ReadWord();
-	const string str = reader.ReadLiteralString();
 
-	if (memberNames.find(structType) != memberNames.end())
-	{
-		/* Make sure we have enough space. */
-		memberNames[structType].resize(idx + 1);
-		memberNames[structType][idx] = str;
-	}
-	else
-	{
-		/* If we cannot find the containing struct yet, just add it. */
-		vector<string> members = { str };
-		memberNames.emplace(structType, members);
-	}
+	/* Make sure we have enough space, the members don't have to be named in order. */
+	vector<string> &members = memberNames[structType];
+	if (members.size() <= idx) members.resize(idx + 1);
+	members[idx] = reader.ReadLiteralString();
 }
 
 void Pu::Shader::HandleDecorate(SPIRVReader & reader)
@@ -355,23 +520,26 @@ void Pu::Shader::HandleDecoration(SPIRVReader & reader, spv::Id target, spv::Wor
 	}
 
 	/* Only push if the decoration type was handled, also merge them together if the target is already added. */
-	const DecoratePair key{ target, idx };
-	if (decorations.find(key) != decorations.end()) decorations[key].Merge(result);
-	else decorations.emplace(key, result);
+	if (idx == GlobalMemberIndex) decorations[target].Merge(result);
+	else
+	{
+		vector<Decoration> &members = memberDecorations[target];
+		if (members.size() <= idx) members.resize(idx + 1);
+		members[idx].Merge(result);
+	}
 }
 
 void Pu::Shader::HandleType(SPIRVReader & reader)
 {
 	const spv::Id id = reader.ReadWord();
 	reader.AdvanceWord();	// storage class.
-	typedefs.emplace(id, reader.ReadWord());
+	typedefs[id] = reader.ReadWord();
 }
 
 void Pu::Shader::HandleBool(SPIRVReader & reader)
 {
 	const spv::Id id = reader.ReadWord();
-	const FieldType type{ ComponentType::Bool, SizeType::Scalar };
-	types.emplace(id, type);
+	types[id] = FieldType(ComponentType::Bool, SizeType::Scalar);
 }
 
 void Pu::Shader::HandleInt(SPIRVReader & reader)
@@ -387,7 +555,7 @@ void Pu::Shader::HandleInt(SPIRVReader & reader)
 	else if (width == 64) intType.ComponentType = isSigned ? ComponentType::Long : ComponentType::ULong;
 	else Log::Warning("Invalid integer type length found in SPIR-V!");
 
-	types.emplace(id, intType);
+	types[id] = intType;
 }
 
 void Pu::Shader::HandleFloat(SPIRVReader & reader)
@@ -401,7 +569,7 @@ void Pu::Shader::HandleFloat(SPIRVReader & reader)
 	else if (width == 64) floatType.ComponentType = ComponentType::Double;
 	else Log::Warning("Invalid float type length found in SPIR-V!");
 
-	types.emplace(id, floatType);
+	types[id] = floatType;
 }
 
 void Pu::Shader::HandleVector(SPIRVReader & reader)
@@ -420,7 +588,7 @@ void Pu::Shader::HandleVector(SPIRVReader & reader)
 		return;
 	}
 
-	types.emplace(id, FieldType(componentType.ComponentType, sizeType));
+	types[id] = FieldType(componentType.ComponentType, sizeType);
 }
 
 void Pu::Shader::HandleMatrix(SPIRVReader & reader)
@@ -432,15 +600,15 @@ void Pu::Shader::HandleMatrix(SPIRVReader & reader)
 	switch (columnType.ContainerType)
 	{
 	case Pu::SizeType::Vector2:
-		if (columnCnt == 2) types.emplace(id, FieldType(columnType.ComponentType, SizeType::Matrix2));
+		if (columnCnt == 2) types[id] = FieldType(columnType.ComponentType, SizeType::Matrix2);
 		else Log::Warning("Unable to handle non-square matrices!");
 		break;
 	case Pu::SizeType::Vector3:
-		if (columnCnt == 3) types.emplace(id, FieldType(columnType.ComponentType, SizeType::Matrix3));
+		if (columnCnt == 3) types[id] = FieldType(columnType.ComponentType, SizeType::Matrix3);
 		else Log::Warning("Unable to handle non-square matrices!");
 		break;
 	case Pu::SizeType::Vector4:
-		if (columnCnt == 4) types.emplace(id, FieldType(columnType.ComponentType, SizeType::Matrix4));
+		if (columnCnt == 4) types[id] = FieldType(columnType.ComponentType, SizeType::Matrix4);
 		else Log::Warning("Unable to handle non-square matrices!");
 		break;
 	default:
@@ -456,7 +624,7 @@ void Pu::Shader::HandleStruct(SPIRVReader & reader, size_t memberCnt)
 	members.reserve(memberCnt);
 	for (size_t i = 0; i < memberCnt; i++) members.emplace_back(reader.ReadWord());
 
-	structs.emplace(id, std::move(members));
+	structs[id] = std::move(members);
 }
 
 void Pu::Shader::HandleArray(SPIRVReader & reader, bool compileTime)
@@ -465,7 +633,7 @@ void Pu::Shader::HandleArray(SPIRVReader & reader, bool compileTime)
 	FieldType elementType = types[reader.ReadWord()];
 	if (compileTime) elementType.Length = static_cast<spv::Word>(constants[reader.ReadWord()]);
 
-	types.emplace(id, elementType);
+	types[id] = elementType;
 }
 
 void Pu::Shader::HandleImage(SPIRVReader & reader)
@@ -499,17 +667,17 @@ void Pu::Shader::HandleImage(SPIRVReader & reader)
 	switch (dim)
 	{
 	case (spv::Dim::Dim1D):
-		types.emplace(id, FieldType(type, SizeType::Scalar));
+		types[id] = FieldType(type, SizeType::Scalar);
 		break;
 	case (spv::Dim::Dim2D):
 	case (spv::Dim::SubpassData):		// Input attachments are always 2D.
-		types.emplace(id, FieldType(type, SizeType::Vector2));
+		types[id] = FieldType(type, SizeType::Vector2);
 		break;
 	case (spv::Dim::Dim3D):
-		types.emplace(id, FieldType(type, SizeType::Vector3));
+		types[id] = FieldType(type, SizeType::Vector3);
 		break;
 	case (spv::Dim::Cube):
-		types.emplace(id, FieldType(type, SizeType::Cube));
+		types[id] = FieldType(type, SizeType::Cube);
 		break;
 	default:
 		Log::Warning("Unable to handle SPIR-V image (unhandled dimension)!");
@@ -521,7 +689,7 @@ void Pu::Shader::HandleSampledImage(SPIRVReader & reader)
 {
 	/* Just add the type of the image that's being sampled to the type list. */
 	const spv::Id id = reader.ReadWord();
-	types.emplace(id, types[reader.ReadWord()]);
+	types[id] = types[reader.ReadWord()];
 }
 
 void Pu::Shader::HandleVariable(SPIRVReader & reader)
@@ -540,7 +708,7 @@ void Pu::Shader::HandleConstant(SPIRVReader & reader)
 
 	if (type.ContainerType == SizeType::Scalar)
 	{
-		constants.emplace(resultId, reader.ReadComponentType(type.ComponentType));
+		constants[resultId] = reader.ReadComponentType(type.ComponentType);
 	}
 	else Log::Error("Non-scalar constrant defined in SPIR-V, ignoring constant!");
 }
@@ -550,7 +718,7 @@ void Pu::Shader::HandleSpecConstant(SPIRVReader & reader)
 	/* The type and decoration are already defined before this specialization constant is defined. */
 	const FieldType type = types[reader.ReadWord()];
 	const spv::Id id = reader.ReadWord();
-	Decoration &decoration = decorations[std::make_pair(id, GlobalMemberIndex)];
+	const Decoration &decoration = decorations[id];
 
 	/* The default value for this constant is stored at the end of this sub-stream. */
 	SpecializationConstant value{ id, names[id], type };
@@ -110,6 +110,7 @@ namespace Pu
 	PFN_vkCmdPushConstants vkCmdPushConstants;
 	PFN_vkCmdSetLineWidth vkCmdSetLineWidth;
 	PFN_vkCmdNextSubpass vkCmdNextSubpass;
+	PFN_vkCmdExecuteCommands vkCmdExecuteCommands;
 	PFN_vkQueueWaitIdle vkQueueWaitIdle;
 	PFN_vkCmdBeginQuery vkCmdBeginQuery;
 	PFN_vkCmdEndQuery vkCmdEndQuery;
@@ -238,6 +239,7 @@ void Pu::vkInit(InstanceHndl instance, const vector<const char*> enabledExtensio
 	LOAD_INSTANCE_PROC(vkCmdPushConstants);
 	LOAD_INSTANCE_PROC(vkCmdSetLineWidth);
 	LOAD_INSTANCE_PROC(vkCmdNextSubpass);
+	LOAD_INSTANCE_PROC(vkCmdExecuteCommands);
 	LOAD_INSTANCE_PROC(vkQueueWaitIdle);
 	LOAD_INSTANCE_PROC(vkCmdBeginQuery);
 	LOAD_INSTANCE_PROC(vkCmdEndQuery);
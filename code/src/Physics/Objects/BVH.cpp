@@ -1,8 +1,11 @@
 #include "Physics/Objects/BVH.h"
 #include "Physics/Systems/Raycasts.h"
 #include "Physics/Systems/ShapeTests.h"
+#include "Physics/Systems/PointTests.h"
 #include "Graphics/Diagnostics/DebugRenderer.h"
 #include "Core/Collections/cstack.h"
+#include "Streams/BinaryWriter.h"
+#include "Streams/BinaryReader.h"
 
 #ifdef _DEBUG
 #include <imgui/include/imgui.h>
@@ -11,6 +14,7 @@
 #define BVH_HNULL				0xF000FFFF
 #define BVH_INULL				0xFFFF
 #define BVH_STACK_CAPACITY		0x40
+#define BVH_QUERY_CAPACITY		0x100
 
 #define is_leaf					pHandle) != BVH_HNULL
 #define is_branch				pHandle) == BVH_HNULL
@@ -43,18 +47,18 @@ SAH algorithm:
 
 Pu::BVH::BVH(void)
 	: root(BVH_INULL), count(0),
-	capacity(0), nodes(nullptr)
+	capacity(0), nodes(nullptr), version(0)
 {}
 
 Pu::BVH::BVH(const BVH & value)
-	: root(value.root), count(value.count), capacity(value.capacity)
+	: root(value.root), count(value.count), capacity(value.capacity), version(value.version)
 {
 	CopyAlloc(value);
 }
 
 Pu::BVH::BVH(BVH && value)
 	: root(value.root), nodes(value.nodes),
-	count(value.count), capacity(value.capacity)
+	count(value.count), capacity(value.capacity), version(value.version)
 {
 	value.nodes = nullptr;
 }
@@ -66,6 +70,7 @@ Pu::BVH & Pu::BVH::operator=(const BVH & other)
 		root = other.root;
 		count = other.count;
 		capacity = other.capacity;
+		version = other.version;
 		CopyAlloc(other);
 	}
 
@@ -81,6 +86,7 @@ Pu::BVH & Pu::BVH::operator=(BVH && other)
 		root = other.root;
 		count = other.count;
 		capacity = other.capacity;
+		version = other.version;
 		nodes = other.nodes;
 
 		other.nodes = nullptr;
@@ -93,6 +99,7 @@ void Pu::BVH::Insert(PhysicsHandle handle, const AABB & box)
 {
 	/* Add the leaf to the buffer and check if it't the root. */
 	const uint16 leafIdx = AllocLeaf(handle, box);
+	++version;
 	if (count == 1)
 	{
 		nodes[leafIdx].Parent = BVH_INULL;
@@ -140,6 +147,7 @@ void Pu::BVH::Remove(PhysicsHandle handle)
 
 			/* Delete the leaf node. */
 			FreeNode(i);
+			++version;
 
 			if (oldParentIdx != BVH_INULL)
 			{
@@ -231,10 +239,32 @@ void Pu::BVH::Boxcast(const AABB & box, vector<PhysicsHandle>& result) const
 	} while (stack.size());
 }
 
+/*
+The nodes are tested in packets of 8 using AVX, the boxes are gathered into SoA form first.
+A branch that's fully inside of the frustum doesn't need any further tests, so all its leaves are added directly.
+
+push root
+while stack not empty
+	pop (at most) 8 nodes and gather their boxes
+	test all boxes against the frustum
+	foreach intersecting node
+		if fully inside
+			add all leaves of node
+		else if branch
+			push children
+		else
+			add leaf
+*/
 void Pu::BVH::Frustumcast(const Frustum & frustum, vector<PhysicsHandle>& result) const
 {
 	if (!count) return;
 
+	AVX_FRUSTUM planes;
+	_mm256_set1_frustum(planes, frustum);
+
+	AVX_VEC3_UNION lower{}, upper{};
+	uint16 packet[8];
+
 	/* Start at the root node. */
 	cstack<uint16> stack{ BVH_STACK_CAPACITY };
 	stack.push(root);
@@ -242,19 +272,128 @@ void Pu::BVH::Frustumcast(const Frustum & frustum, vector<PhysicsHandle>& result
 	/* Loop until we traversed the tree. */
 	do
 	{
-		const uint16 i = stack.pop();
+		uint32 n = 0;
+		for (; n < 8 && stack.size(); n++)
+		{
+			packet[n] = stack.pop();
+			const AABB &box = nodes[packet[n]].Box;
+			_mm256_seti_v3(lower, box.LowerBound.X, box.LowerBound.Y, box.LowerBound.Z, n);
+			_mm256_seti_v3(upper, box.UpperBound.X, box.UpperBound.Y, box.UpperBound.Z, n);
+		}
+
+		/* The unused lanes still contain the boxes of the previous packet, so mask them out. */
+		uint32 inside;
+		const uint32 hits = intersects(planes, lower, upper, inside) & ((1u << n) - 1);
+
+		for (uint32 j = 0; j < n; j++)
+		{
+			if (!(hits & (1u << j))) continue;
+
+			const Node &node = nodes[packet[j]];
+			if (inside & (1u << j)) AddLeaves(packet[j], result);
+			else if ((node.is_branch)
+			{
+				stack.push(node.Child1);
+				stack.push(node.Child2);
+			}
+			else result.emplace_back(node.pHandle);
+		}
+	} while (stack.size());
+}
+
+/*
+The node depth is stored in 8 bits and a depth first traversal only keeps one sibling per level on the stack,
+so a fixed size stack is always big enough and the query doesn't need to allocate.
+*/
+void Pu::BVH::Boxcast(const AABB & box, Visitor_t visitor, void * userParam) const
+{
+	if (!count) return;
+
+	uint16 stack[BVH_QUERY_CAPACITY];
+	size_t top = 0;
+	stack[top++] = root;
+
+	do
+	{
+		const uint16 i = stack[--top];
 
 		/* Check if the branch (or leaf) overlaps. */
-		if (intersects(frustum, nodes[i].Box))
+		if (intersects(box, nodes[i].Box))
 		{
-			if ((nodes[i].is_leaf) result.emplace_back(nodes[i].pHandle);
+			if ((nodes[i].is_leaf)
+			{
+				if (!visitor(nodes[i].pHandle, userParam)) return;
+			}
 			else
 			{
-				stack.push(nodes[i].Child1);
-				stack.push(nodes[i].Child2);
+				stack[top++] = nodes[i].Child1;
+				stack[top++] = nodes[i].Child2;
 			}
 		}
-	} while (stack.size());
+	} while (top);
+}
+
+/*
+The distance to an object is never smaller than the distance to its bounding box,
+so any node that's further away than the current k-th object can be skipped.
+
+push root
+while stack is not empty
+	pop node
+	if distance to node > search radius
+		skip node
+	if leaf
+		insert object into sorted result
+		if result is full
+			search radius = distance to k-th object
+	else
+		push far child, then push near child
+*/
+size_t Pu::BVH::Nearest(Vector3 p, float maxDistance, Distance_t distance, const void * userParam, PhysicsHandle * result, float * distances, size_t k) const
+{
+	if (!count || !k) return 0;
+
+	uint16 stack[BVH_QUERY_CAPACITY];
+	size_t top = 0, found = 0;
+	float radius = maxDistance;
+	stack[top++] = root;
+
+	do
+	{
+		const uint16 i = stack[--top];
+		if (sqrdist(closest(nodes[i].Box, p), p) > sqr(radius)) continue;
+
+		if ((nodes[i].is_leaf)
+		{
+			const PhysicsHandle hobj = nodes[i].pHandle;
+			const float d = distance(hobj, userParam);
+			if (d < 0.0f || d > radius) continue;
+
+			/* Insertion sort is fine here, as k is expected to be small. */
+			if (found < k) ++found;
+			size_t j = found - 1;
+			for (; j > 0 && distances[j - 1] > d; j--)
+			{
+				result[j] = result[j - 1];
+				distances[j] = distances[j - 1];
+			}
+
+			result[j] = hobj;
+			distances[j] = d;
+			if (found == k) radius = distances[k - 1];
+		}
+		else
+		{
+			/* Visit the closest child first, so the search radius shrinks as fast as possible. */
+			const uint16 c1 = nodes[i].Child1;
+			const uint16 c2 = nodes[i].Child2;
+			const bool swap = sqrdist(closest(nodes[c1].Box, p), p) < sqrdist(closest(nodes[c2].Box, p), p);
+			stack[top++] = swap ? c2 : c1;
+			stack[top++] = swap ? c1 : c2;
+		}
+	} while (top);
+
+	return found;
 }
 
 float Pu::BVH::GetTreeCost(void) const
@@ -287,6 +426,33 @@ float Pu::BVH::GetEfficiency(void) const
 	return sa / area(nodes[root].Box);
 }
 
+/* The nodes don't contain any pointers, so the entire tree (including the free list) can just be copied. */
+void Pu::BVH::Snapshot(BinaryWriter & writer) const
+{
+	writer.Write(root);
+	writer.Write(count);
+	writer.Write(capacity);
+	writer.Write(reinterpret_cast<const byte*>(nodes), 0, capacity * sizeof(Node));
+}
+
+void Pu::BVH::Restore(BinaryReader & reader)
+{
+	root = reader.ReadUInt16();
+	count = reader.ReadUInt16();
+	++version;
+
+	/* Only reallocate if the capacity changed, this is almost never the case when rolling back a few steps. */
+	const uint16 newCapacity = reader.ReadUInt16();
+	if (newCapacity != capacity)
+	{
+		capacity = newCapacity;
+		nodes = reinterpret_cast<Node*>(realloc(nodes, capacity * sizeof(Node)));
+	}
+
+	const size_t byteSize = capacity * sizeof(Node);
+	if (reader.Read(reinterpret_cast<byte*>(nodes), 0, byteSize) != byteSize) Log::Fatal("Unable to restore BVH (snapshot is truncated)!");
+}
+
 #ifdef _DEBUG
 void Pu::BVH::Visualize(DebugRenderer & renderer) const
 {
@@ -509,6 +675,24 @@ Pu::uint16 Pu::BVH::BestSibling(uint16 node) const
 	return i;
 }
 
+void Pu::BVH::AddLeaves(uint16 idx, vector<PhysicsHandle>& result) const
+{
+	uint16 stack[BVH_QUERY_CAPACITY];
+	size_t top = 0;
+	stack[top++] = idx;
+
+	do
+	{
+		const Node &node = nodes[stack[--top]];
+		if ((node.is_leaf) result.emplace_back(node.pHandle);
+		else
+		{
+			stack[top++] = node.Child1;
+			stack[top++] = node.Child2;
+		}
+	} while (top);
+}
+
 Pu::uint16 Pu::BVH::AllocBranch(void)
 {
 	/* Check if there is an unused node that we can use. */
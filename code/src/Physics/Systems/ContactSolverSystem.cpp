@@ -2,6 +2,9 @@
 #include "Physics/Systems/PhysicalWorld.h"
 #include "Physics/Systems/ContactSystem.h"
 #include "Physics/Systems/MovementSystem.h"
+#include "Physics/Systems/MaterialDatabase.h"
+#include "Physics/Systems/IslandSystem.h"
+#include "Core/Threading/Tasks/ParallelFor.h"
 #include "Core/Diagnostics/Profiler.h"
 #include "Core/Math/Vector3_SIMD.h"
 #include "Core/Math/Matrix3_SIMD.h"
@@ -12,25 +15,36 @@
 #endif
 
 Pu::ContactSolverSystem::ContactSolverSystem(PhysicalWorld & world)
-	: world(&world), capacity(0)
+	: world(&world), capacity(0), lanes(0), pairs(nullptr)
 {}
 
 /* imass hides class member. */
 #pragma warning(push)
 #pragma warning(disable:4458)
-void Pu::ContactSolverSystem::AddItem(PhysicsHandle handle, const Matrix3 & iMoI, float imass, const MechanicalProperties & props)
+void Pu::ContactSolverSystem::AddItem(PhysicsHandle handle, const Matrix3 & iMoI, float imass, PhysicsHandle material)
 {
-	imoi.emplace(handle, iMoI);
-	this->imass.emplace(handle, imass);
-	coefficients.emplace(handle, props);
+	/* Public handles reuse the free lookup ids, so the buffers only grow if the lookup table grows. */
+	const uint16 idx = physics_get_lookup_id(handle);
+	if (idx >= materials.size())
+	{
+		imoi.resize(idx + 1);
+		this->imass.resize(idx + 1);
+		materials.resize(idx + 1);
+	}
+
+	imoi[idx] = iMoI;
+	this->imass[idx] = imass;
+	materials[idx] = world->db->GetMaterialIndex(material);
 }
 #pragma warning(pop)
 
 void Pu::ContactSolverSystem::RemoveItem(PhysicsHandle handle)
 {
-	imoi.erase(handle);
-	imass.erase(handle);
-	coefficients.erase(handle);
+	/* The material index is used in gathers, so the unused entries must remain a valid material. */
+	const uint16 idx = physics_get_lookup_id(handle);
+	imoi[idx] = Matrix3();
+	imass[idx] = 0.0f;
+	materials[idx] = 0;
 }
 
 void Pu::ContactSolverSystem::SolveConstriants(ofloat dt)
@@ -40,12 +54,21 @@ void Pu::ContactSolverSystem::SolveConstriants(ofloat dt)
 	{
 		if constexpr (ProfileWorldSystems) Profiler::Begin("Solver", Color::SunDawn());
 
-		/* First we fill the temporary SSE buffer with our solver data. */
+		/* Split the islands over the solver tasks and make sure the temporary SSE buffers can hold all of them. */
+		CreateJobs();
 		EnsureBufferSize();
-		FillBuffers();
 
-		/* Then we solve these constraints in SSE and apply the impulses the the movement system. */
-		VectorSolve(dt);
+		/* Islands can be solved independently, so every task fills and solves its own range of the SSE buffers. */
+		ParallelFor(jobs.size(), 1, [this, dt](size_t start, size_t end)
+		{
+			for (size_t i = start; i < end; i++)
+			{
+				FillBuffers(jobs[i]);
+				VectorSolve(dt, jobs[i]);
+			}
+		});
+
+		/* The movement system stores its data in AVX types, so the impulses are applied on a single thread. */
 		ApplyImpulses();
 
 		if constexpr (ProfileWorldSystems) Profiler::End();
@@ -71,21 +94,60 @@ void Pu::ContactSolverSystem::Visualize(DebugRenderer & dbgRenderer) const
 }
 #endif
 
+/*
+Islands are never split over multiple jobs, but small islands are merged into a single job.
+Every job starts at a new AVX type, so two tasks never write to the same AVX type.
+
+foreach island
+	add contacts to job
+	if job is large enough
+		start new job at next AVX type
+*/
+void Pu::ContactSolverSystem::CreateJobs(void)
+{
+	const IslandSystem &islands = *world->sysIsland;
+	const size_t islandCount = islands.GetIslandCount();
+
+	jobs.clear();
+	SolverJob job{ 0, 0, 0 };
+
+	for (size_t i = 0; i < islandCount; i++)
+	{
+		size_t count;
+		(void)islands.GetContacts(i, count);
+		job.Count += static_cast<uint32>(count);
+
+		if (job.Count >= PhysicsSolverJobSize)
+		{
+			jobs.emplace_back(job);
+			job.First += job.Count;
+			job.Slot += (job.Count + 7) & ~7u;
+			job.Count = 0;
+		}
+	}
+
+	if (job.Count) jobs.emplace_back(job);
+	lanes = (job.Slot + job.Count + 7) >> 3;
+}
+
 void Pu::ContactSolverSystem::EnsureBufferSize(void)
 {
 	/* The temporary buffers might need to be resized if we have more collisions than we can currently handle. */
-	const size_t count = world->sysCnst->hfirsts.size();
+	const size_t count = lanes;
 	if (capacity < count)
 	{
 		/* We can maximally apply 2 impulses per collisions (one for each object). */
 		capacity = count;
 		const size_t impulseCount = count << 1;
 
-		/* Reallocate the coefficients. */
-		cor1 = _mm256_realloc_ps(cor1, count);
-		cor2 = _mm256_realloc_ps(cor2, count);
-		cof1 = _mm256_realloc_ps(cof1, count);
-		cof2 = _mm256_realloc_ps(cof2, count);
+		/* Reallocate the material pair indices. */
+		pairs = _mm256_realloc_si256(pairs, count);
+
+		/* Reallocate the collision normals, contact points, depths and effective masses. */
+		_mm256_realloc_v3(nx, ny, nz, count);
+		_mm256_realloc_v3(cx, cy, cz, count);
+		sd = _mm256_realloc_ps(sd, count);
+		em = _mm256_realloc_ps(em, count);
 
 		/* Reallocate the positions. */
 		_mm256_realloc_v3(px1, py1, pz1, count);
@@ -119,13 +181,19 @@ This is not the case, we check against i to see whether they have been set.
 */
 #pragma warning(push)
 #pragma warning(disable:4701)
-void Pu::ContactSolverSystem::FillBuffers(void)
+void Pu::ContactSolverSystem::FillBuffers(const SolverJob & job)
 {
-	/* Use these buffers as staging buffer for the AVX types. */
-	AVX_FLOAT_UNION tmp_cor1;
-	AVX_FLOAT_UNION tmp_cor2;
-	AVX_FLOAT_UNION tmp_cof1;
-	AVX_FLOAT_UNION tmp_cof2;
+	/*
+	Use these buffers as staging buffer for the AVX types.
+	The lookup ids are used for gathers, so the unused lanes in the last AVX type need to be valid.
+	The effective mass is used as a divisor, so its unused lanes are set to one.
+	*/
+	AVX_INT_UNION tmp_id1 = { _mm256_setzero_si256() };
+	AVX_INT_UNION tmp_id2 = { _mm256_setzero_si256() };
+	AVX_FLOAT_UNION tmp_sd = { _mm256_setzero_ps() };
+	AVX_FLOAT_UNION tmp_em = { _mm256_set1_ps(1.0f) };
+	AVX_VEC3_UNION tmp_n;
+	AVX_VEC3_UNION tmp_c;
 	AVX_VEC3_UNION tmp_p1;
 	AVX_VEC3_UNION tmp_p2;
 	AVX_VEC3_UNION tmp_v1;
@@ -137,23 +205,33 @@ void Pu::ContactSolverSystem::FillBuffers(void)
 	AVX_MAT3_UNION tmp_moi1;
 	AVX_MAT3_UNION tmp_moi2;
 
-	const size_t size = world->sysCnst->hfirsts.size();
-	size_t i;
+	const ContactSystem &cnst = *world->sysCnst;
+	const int256 width = _mm256_set1_epi32(static_cast<int32>(world->db->GetMaterialCount()));
+	const uint32 *contacts = world->sysIsland->GetContacts().data() + job.First;
 
-	/* Loop through all the registered collisions. */
-	for (i = 0; i < size; i++)
+	/* Loop through all the collisions of the islands in this job. */
+	for (uint32 n = 0; n < job.Count; n++)
 	{
 		/* Get the public handles of the current collision. */
-		const PhysicsHandle hfirst = world->sysCnst->hfirsts[i];
-		const PhysicsHandle hsecond = world->sysCnst->hseconds[i];
-
-		/* Gets the AVX index (j) and the packed index (k). */
-		const size_t j = i >> 0x3;
-		const size_t k = i & 0x7;
-
-		/* Gets the coefficients of both objects. */
-		const MechanicalProperties &mat1 = coefficients[hfirst];
-		const MechanicalProperties &mat2 = coefficients[hsecond];
+		const size_t i = contacts[n];
+		const PhysicsHandle hfirst = cnst.hfirsts[i];
+		const PhysicsHandle hsecond = cnst.hseconds[i];
+
+		/* Gets the AVX index (j) and the packed index (k) of the solver slot. */
+		const size_t j = (job.Slot + n) >> 0x3;
+		const size_t k = (job.Slot + n) & 0x7;
+
+		/* Store the lookup ids of both objects, the material indices are gathered once the AVX type is filled. */
+		const uint16 id1 = physics_get_lookup_id(hfirst);
+		const uint16 id2 = physics_get_lookup_id(hsecond);
+		tmp_id1.V[k] = id1;
+		tmp_id2.V[k] = id2;
+
+		/* Copy the contact itself, as the solver slots are in island order. */
+		_mm256_seti_v3(tmp_n, cnst.nx.get(i), cnst.ny.get(i), cnst.nz.get(i), k);
+		_mm256_seti_v3(tmp_c, cnst.px.get(i), cnst.py.get(i), cnst.pz.get(i), k);
+		tmp_sd.V[k] = cnst.sd.get(i);
+		tmp_em.V[k] = cnst.em.get(i);
 
 		/* We have to fill the buffers with different data depending on whether one of the types was static. */
 		const bool isKinematic = physics_get_type(hfirst) != PhysicsType::Static;
@@ -175,8 +253,8 @@ void Pu::ContactSolverSystem::FillBuffers(void)
 		{
 			const Vector3 p1 = world->sysMove->GetPosition(world->QueryInternalHandle(hfirst));
 			_mm256_seti_v3(tmp_p1, p1.X, p1.Y, p1.Z, k);
-			tmp_imass1.V[k] = imass[hfirst];
-			_mm256_seti_m3(tmp_moi1, imoi[hfirst].GetComponents(), k);
+			tmp_imass1.V[k] = imass[id1];
+			_mm256_seti_m3(tmp_moi1, imoi[id1].GetComponents(), k);
 		}
 		else
 		{
@@ -185,30 +263,30 @@ void Pu::ContactSolverSystem::FillBuffers(void)
 			This will make the relative velocity equal to the velocity of the second object
 			at the contact point.
 			*/
-			_mm256_seti_v3(tmp_p1, world->sysCnst->px.get(i), world->sysCnst->py.get(i), world->sysCnst->pz.get(i), k);
+			_mm256_seti_v3(tmp_p1, cnst.px.get(i), cnst.py.get(i), cnst.pz.get(i), k);
 			tmp_imass1.V[k] = 0.0f;
 			_mm256_setzero_m3(tmp_moi1, k);
 		}
 
-		tmp_cor1.V[k] = mat1.CoR;
-		tmp_cor2.V[k] = mat2.CoR;
-		tmp_cof1.V[k] = mat1.CoFk;
-		tmp_cof2.V[k] = mat2.CoFk;
-		tmp_imass2.V[k] = imass[hsecond];
+		tmp_imass2.V[k] = imass[id2];
 		_mm256_seti_v3(tmp_p2, p2.X, p2.Y, p2.Z, k);
 		_mm256_seti_v3(tmp_v1, v1.X, v1.Y, v1.Z, k);
 		_mm256_seti_v3(tmp_v2, v2.X, v2.Y, v2.Z, k);
 		_mm256_seti_v3(tmp_w1, w1.Pitch, w1.Yaw, w1.Roll, k);
 		_mm256_seti_v3(tmp_w2, w2.Pitch, w2.Yaw, w2.Roll, k);
-		_mm256_seti_m3(tmp_moi2, imoi[hsecond].GetComponents(), k);
+		_mm256_seti_m3(tmp_moi2, imoi[id2].GetComponents(), k);
 
 		/* Push the staging buffer to the output. */
-		if (k >= 7 || i == size - 1)
+		if (k >= 7 || n == job.Count - 1)
 		{
-			cor1[j] = tmp_cor1.SIMD;
-			cor2[j] = tmp_cor2.SIMD;
-			cof1[j] = tmp_cof1.SIMD;
-			cof2[j] = tmp_cof2.SIMD;
+			/* The material indices are the row and column of the combined coefficient tables. */
+			const int256 m1 = _mm256_i32gather_epi32(materials.data(), tmp_id1.SIMD, sizeof(int32));
+			const int256 m2 = _mm256_i32gather_epi32(materials.data(), tmp_id2.SIMD, sizeof(int32));
+			pairs[j] = _mm256_add_epi32(_mm256_mullo_epi32(m1, width), m2);
+			_mm256_set1_v3(tmp_n, nx[j], ny[j], nz[j]);
+			_mm256_set1_v3(tmp_c, cx[j], cy[j], cz[j]);
+			sd[j] = tmp_sd.SIMD;
+			em[j] = tmp_em.SIMD;
 			_mm256_set1_v3(tmp_p1, px1[j], py1[j], pz1[j]);
 			_mm256_set1_v3(tmp_p2, px2[j], py2[j], pz2[j]);
 			_mm256_set1_v3(tmp_v1, vx1[j], vy1[j], vz1[j]);
@@ -230,7 +308,7 @@ The order of these operations matters.
 	Friction impulse is relative to linear impulse.
 	Angular impulse is relative to linear + friction impulse.
 
-Loop over all the AVX types (8 packed manifold) and solve them in parallel.
+Loop over all the AVX types (8 packed manifold) of the job and solve them in parallel.
 	Calculate the relative vector from the center of mass to the collision point (r1, r2).
 	Calculate the relative velocity at the contact point (v).
 	Calculate the linear collision impulse (j).
@@ -239,24 +317,17 @@ Loop over all the AVX types (8 packed manifold) and solve them in parallel.
 	Calculate friction impulse (reuse j).
 	Calculate angular impulse and apply it to both objects.
 */
-void Pu::ContactSolverSystem::VectorSolve(ofloat dt)
+void Pu::ContactSolverSystem::VectorSolve(ofloat dt, const SolverJob & job)
 {
 	/* Predefine often used constants. */
-	const size_t count = world->sysCnst->hfirsts.size();
-	const size_t avxCnt = (count >> 0x3) + (count != 0);
+	const size_t first = job.Slot >> 0x3;
+	const size_t last = (job.Slot + job.Count + 7) >> 0x3;
 	const ofloat zero = _mm256_setzero_ps();
 	const ofloat one = _mm256_set1_ps(1.0f);
 	const ofloat neg = _mm256_set1_ps(-1.0f);
 	const ofloat beta = _mm256_set1_ps(PhysicsBaumgarteFactor);
-
-	/* Cache pointers to the collision normal and contact point. */
-	const ofloat *nx = world->sysCnst->nx.data();
-	const ofloat *ny = world->sysCnst->ny.data();
-	const ofloat *nz = world->sysCnst->nz.data();
-
-	const ofloat *cx = world->sysCnst->px.data();
-	const ofloat *cy = world->sysCnst->py.data();
-	const ofloat *cz = world->sysCnst->pz.data();
+	const float *restitution = world->db->GetRestitutionTable();
+	const float *friction = world->db->GetFrictionTable();
 
 	/* Use these as temporary vector buffers during various calculations. */
 	ofloat tmp_x1, tmp_y1, tmp_z1;
@@ -265,7 +336,7 @@ void Pu::ContactSolverSystem::VectorSolve(ofloat dt)
 	ofloat e, j, num, d1, d2;
 
 	/* Solve collision per AVX type (i = second, k = first). */
-	for (size_t i = 0, k = avxCnt; i < avxCnt; i++, k++)
+	for (size_t i = first, k = first + lanes; i < last; i++, k++)
 	{
 		/* Calculate the position of the first object relative to the contact point. */
 		const ofloat rx1 = _mm256_sub_ps(cx[i], px1[i]);
@@ -288,7 +359,7 @@ void Pu::ContactSolverSystem::VectorSolve(ofloat dt)
 		/* Calculate and apply the normal force. */
 		{
 			/* Calculate the impulse. */
-			e = _mm256_min_ps(cor1[i], cor2[i]);
+			e = _mm256_i32gather_ps(restitution, pairs[i], sizeof(float));
 			num = _mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(one, e), neg), vdn);
 			_mm256_cross_v3(rx1, ry1, rz1, nx[i], ny[i], nz[i], tmp_x1, tmp_y1, tmp_z1);
 			_mm256_mat3mul_v3(m001[i], m011[i], m021[i], m101[i], m111[i], m121[i], m201[i], m211[i], m221[i], tmp_x1, tmp_y1, tmp_z1, tmp_x2, tmp_y2, tmp_z2);
@@ -296,7 +367,7 @@ void Pu::ContactSolverSystem::VectorSolve(ofloat dt)
 			_mm256_cross_v3(rx2, ry2, rz2, nx[i], ny[i], nz[i], tmp_x1, tmp_y1, tmp_z1);
 			_mm256_mat3mul_v3(m002[i], m012[i], m022[i], m102[i], m112[i], m122[i], m202[i], m212[i], m222[i], tmp_x1, tmp_y1, tmp_z1, tmp_x3, tmp_y3, tmp_z3);
 			d2 = _mm256_add_ps(imass2[i], _mm256_dot_v3(tmp_x1, tmp_y1, tmp_z1, tmp_x3, tmp_y3, tmp_z3));
-			j = _mm256_mul_ps(_mm256_divs_ps(num, _mm256_add_ps(d1, d2), zero), world->sysCnst->em[i]);
+			j = _mm256_mul_ps(_mm256_divs_ps(num, _mm256_add_ps(d1, d2), zero), em[i]);
 
 			/* Calculate the directional impulse. */
 			tmp_x1 = _mm256_mul_ps(j, nx[i]);
@@ -320,7 +391,7 @@ void Pu::ContactSolverSystem::VectorSolve(ofloat dt)
 			jroll[i] = _mm256_mul_ps(j, tmp_z3);
 
 			/* Stabalize using Baumgarte. */
-			d1 = _mm256_mul_ps(_mm256_div_ps(beta, world->sysCnst->em[i]), _mm256_div_ps(world->sysCnst->sd[i], dt));
+			d1 = _mm256_mul_ps(_mm256_div_ps(beta, em[i]), _mm256_div_ps(sd[i], dt));
 			tmp_x1 = _mm256_mul_ps(d1, nx[i]);
 			tmp_y1 = _mm256_mul_ps(d1, ny[i]);
 			tmp_z1 = _mm256_mul_ps(d1, nz[i]);
@@ -341,7 +412,7 @@ void Pu::ContactSolverSystem::VectorSolve(ofloat dt)
 			_mm256_norm_v3(tx, ty, tz, zero);
 
 			/* Calculate the impulse. */
-			e = _mm256_sqrt_ps(_mm256_mul_ps(cof1[i], cof2[i]));
+			e = _mm256_i32gather_ps(friction, pairs[i], sizeof(float));
 			num = _mm256_mul_ps(_mm256_dot_v3(vx, vy, vz, tx, ty, tz), neg);
 			_mm256_cross_v3(rx1, ry1, rz1, tx, ty, tz, tmp_x1, tmp_y1, tmp_z1);
 			_mm256_mat3mul_v3(m001[i], m011[i], m021[i], m101[i], m111[i], m121[i], m201[i], m211[i], m221[i], tmp_x1, tmp_y1, tmp_z1, tmp_x2, tmp_y2, tmp_z2);
@@ -377,58 +448,62 @@ void Pu::ContactSolverSystem::VectorSolve(ofloat dt)
 
 void Pu::ContactSolverSystem::ApplyImpulses(void)
 {
-	const size_t count = world->sysCnst->hfirsts.size();
-	const size_t avxCnt = (count >> 0x3) + (count != 0);
+	const size_t avxCnt = lanes;
+	const uint32 *contacts = world->sysIsland->GetContacts().data();
 
 	/* Push the accumulated forces to the movement system. */
-	for (size_t i = 0; i < count; i++)
+	for (const SolverJob &job : jobs)
 	{
-		const size_t j = i >> 0x3;
-		const size_t k = i & 0x7;
+		for (uint32 n = 0; n < job.Count; n++)
+		{
+			const size_t i = contacts[job.First + n];
+			const size_t j = (job.Slot + n) >> 0x3;
+			const size_t k = (job.Slot + n) & 0x7;
 
-		const PhysicsHandle hfirst = world->sysCnst->hfirsts[i];
-		const PhysicsHandle hsecond = world->sysCnst->hseconds[i];
+			const PhysicsHandle hfirst = world->sysCnst->hfirsts[i];
+			const PhysicsHandle hsecond = world->sysCnst->hseconds[i];
 
-		/* The second object will always have impulses applied to it as it's either kinematic or dynamic. */
-		float x = AVX_FLOAT_UNION{ jx[j] }.V[k];
-		float y = AVX_FLOAT_UNION{ jy[j] }.V[k];
-		float z = AVX_FLOAT_UNION{ jz[j] }.V[k];
+			/* The second object will always have impulses applied to it as it's either kinematic or dynamic. */
+			float x = AVX_FLOAT_UNION{ jx[j] }.V[k];
+			float y = AVX_FLOAT_UNION{ jy[j] }.V[k];
+			float z = AVX_FLOAT_UNION{ jz[j] }.V[k];
 
-		float pitch = AVX_FLOAT_UNION{ jpitch[j] }.V[k];
-		float yaw = AVX_FLOAT_UNION{ jyaw[j] }.V[k];
-		float roll = AVX_FLOAT_UNION{ jroll[j] }.V[k];
+			float pitch = AVX_FLOAT_UNION{ jpitch[j] }.V[k];
+			float yaw = AVX_FLOAT_UNION{ jyaw[j] }.V[k];
+			float roll = AVX_FLOAT_UNION{ jroll[j] }.V[k];
 
-		world->sysMove->AddForce(world->QueryInternalIndex(hsecond), x, y, z, pitch, yaw, roll);
+			world->sysMove->AddForce(world->QueryInternalIndex(hsecond), x, y, z, pitch, yaw, roll);
 
-		/* Add the total applied impulse to the debugging list. */
+			/* Add the total applied impulse to the debugging list. */
 #ifdef _DEBUG
-		const Vector3 at{ world->sysCnst->px.get(i), world->sysCnst->py.get(i), world->sysCnst->pz.get(i) };
+			const Vector3 at{ world->sysCnst->px.get(i), world->sysCnst->py.get(i), world->sysCnst->pz.get(i) };
 
-		Vector3 f{ x, y, z };
-		float mag = f.Length();
-		DBG_ADD_FORCE();
+			Vector3 f{ x, y, z };
+			float mag = f.Length();
+			DBG_ADD_FORCE();
 #endif
 
-		/* The second object might not need impulses to be applied. */
-		if (physics_get_type(hfirst) != PhysicsType::Static)
-		{
-			x = AVX_FLOAT_UNION{ jx[j + avxCnt] }.V[k];
-			y = AVX_FLOAT_UNION{ jy[j + avxCnt] }.V[k];
-			z = AVX_FLOAT_UNION{ jz[j + avxCnt] }.V[k];
+			/* The second object might not need impulses to be applied. */
+			if (physics_get_type(hfirst) != PhysicsType::Static)
+			{
+				x = AVX_FLOAT_UNION{ jx[j + avxCnt] }.V[k];
+				y = AVX_FLOAT_UNION{ jy[j + avxCnt] }.V[k];
+				z = AVX_FLOAT_UNION{ jz[j + avxCnt] }.V[k];
 
-			pitch = AVX_FLOAT_UNION{ jpitch[j + avxCnt] }.V[k];
-			yaw = AVX_FLOAT_UNION{ jyaw[j + avxCnt] }.V[k];
-			roll = AVX_FLOAT_UNION{ jroll[j + avxCnt] }.V[k];
+				pitch = AVX_FLOAT_UNION{ jpitch[j + avxCnt] }.V[k];
+				yaw = AVX_FLOAT_UNION{ jyaw[j + avxCnt] }.V[k];
+				roll = AVX_FLOAT_UNION{ jroll[j + avxCnt] }.V[k];
 
-			world->sysMove->AddForce(world->QueryInternalIndex(hfirst), x, y, z, pitch, yaw, roll);
+				world->sysMove->AddForce(world->QueryInternalIndex(hfirst), x, y, z, pitch, yaw, roll);
 
 #ifdef _DEBUG
-			f.X = x;
-			f.Y = y;
-			f.Z = z;
-			mag = f.Length();
-			DBG_ADD_FORCE();
+				f.X = x;
+				f.Y = y;
+				f.Z = z;
+				mag = f.Length();
+				DBG_ADD_FORCE();
 #endif
+			}
 		}
 	}
 }
@@ -437,11 +512,14 @@ void Pu::ContactSolverSystem::Destroy(void)
 {
 	if (capacity)
 	{
-		/* Free the coeffiecients. */
-		_mm256_free_ps(cor1);
-		_mm256_free_ps(cor2);
-		_mm256_free_ps(cof1);
-		_mm256_free_ps(cof2);
+		/* Free the material pair indices. */
+		_mm256_free_si256(pairs);
+
+		/* Free the collision normals, contact points, depths and effective masses. */
+		_mm256_free_v3(nx, ny, nz);
+		_mm256_free_v3(cx, cy, cz);
+		_mm256_free_ps(sd);
+		_mm256_free_ps(em);
 
 		/* Free the positions. */
 		_mm256_free_v3(px1, py1, pz1);
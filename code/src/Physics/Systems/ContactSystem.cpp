@@ -3,8 +3,12 @@
 #include "Physics/Systems/MovementSystem.h"
 #include "Physics/Systems/PhysicalWorld.h"
 #include "Physics/Systems/ShapeTests.h"
+#include "Physics/Systems/PointTests.h"
 #include "Core/Diagnostics/Profiler.h"
 #include "Core/Math/HeightMap.h"
+#include "Streams/BinaryWriter.h"
+#include "Streams/BinaryReader.h"
+#include <algorithm>
 
 #define collision_t(first, second)	(static_cast<Pu::uint16>(static_cast<Pu::uint16>(first) | static_cast<Pu::uint16>(second) << 8))
 #define as_shape(type, params)		(*reinterpret_cast<const Pu::type*>(params))
@@ -12,6 +16,7 @@
 static Pu::uint32 bvhUpdateCalls = 0;
 static Pu::uint32 narrowPhaseChecks = 0;
 static Pu::uint32 collisionCount = 0;
+static Pu::uint32 ccdSweeps = 0;
 
 Pu::ContactSystem::ContactSystem(PhysicalWorld & world)
 	: world(&world), OnTriggerHit("ContactSystemOnTriggerHit")
@@ -22,9 +27,9 @@ Pu::ContactSystem::ContactSystem(PhysicalWorld & world)
 Pu::ContactSystem::ContactSystem(ContactSystem && value)
 	: OnTriggerHit(std::move(value.OnTriggerHit)),
 	checkers(std::move(value.checkers)), world(value.world),
-	rawBroadPhase(std::move(value.rawBroadPhase)),
-	cachedBroadPhase(std::move(value.cachedBroadPhase)),
-	rawNarrowPhase(std::move(value.rawNarrowPhase)),
+	rawBroadPhase(std::move(value.rawBroadPhase)), ccd(std::move(value.ccd)),
+	cachedHandles(std::move(value.cachedHandles)), cachedBroadPhase(std::move(value.cachedBroadPhase)),
+	rawNarrowPhase(std::move(value.rawNarrowPhase)), layers(std::move(value.layers)),
 	hitTriggers(std::move(value.hitTriggers)),
 	hfirsts(std::move(value.hfirsts)), hseconds(std::move(value.hseconds)),
 	nx(std::move(value.nx)), ny(std::move(value.ny)), nz(std::move(value.nz)),
@@ -54,8 +59,11 @@ Pu::ContactSystem & Pu::ContactSystem::operator=(ContactSystem && other)
 
 		world = other.world;
 		rawBroadPhase = std::move(other.rawBroadPhase);
+		ccd = std::move(other.ccd);
+		cachedHandles = std::move(other.cachedHandles);
 		cachedBroadPhase = std::move(other.cachedBroadPhase);
 		rawNarrowPhase = std::move(other.rawNarrowPhase);
+		layers = std::move(other.layers);
 		hitTriggers = std::move(other.hitTriggers);
 	}
 
@@ -77,14 +85,20 @@ Pu::uint32 Pu::ContactSystem::GetCollisionsCount(void)
 	return collisionCount;
 }
 
+Pu::uint32 Pu::ContactSystem::GetCCDSweeps(void)
+{
+	return ccdSweeps;
+}
+
 void Pu::ContactSystem::ResetCounters(void)
 {
 	bvhUpdateCalls = 0;
 	narrowPhaseChecks = 0;
 	collisionCount = 0;
+	ccdSweeps = 0;
 }
 
-void Pu::ContactSystem::AddItem(PhysicsHandle handle, const AABB & bb, CollisionShapes type, const float * collider)
+void Pu::ContactSystem::AddItem(PhysicsHandle handle, const AABB & bb, CollisionShapes type, const float * collider, bool useCcd, uint32 layer)
 {
 	AABB bb2 = bb * world->GetTransform(handle);
 	++bvhUpdateCalls;
@@ -94,11 +108,24 @@ void Pu::ContactSystem::AddItem(PhysicsHandle handle, const AABB & bb, Collision
 	{
 		bb2.Inflate(KinematicExpansion, KinematicExpansion, KinematicExpansion);
 		rawBroadPhase.emplace_back(bb);
+		ccd.emplace_back(useCcd);
 	}
 
 	/* Add the broadphase to the BVH and emplace the collider type. */
 	world->searchTree.Insert(handle, bb2);
-	cachedBroadPhase.emplace(handle, bb2);
+
+	/* The cached broadphase is indexed by the public lookup ID, so adding an object never moves the others. */
+	const size_t idx = IndexOf(handle);
+	if (idx >= cachedHandles.size())
+	{
+		cachedHandles.resize(idx + 1, PhysicsNullHandle);
+		cachedBroadPhase.resize(idx + 1);
+		layers.resize(idx + 1, 0);
+	}
+
+	cachedHandles[idx] = handle;
+	cachedBroadPhase[idx] = bb2;
+	layers[idx] = layer;
 
 	/* We need to make a copy of the collider incase the user defined it in stack memory. */
 	float *copy = nullptr;
@@ -128,6 +155,7 @@ void Pu::ContactSystem::AddItem(PhysicsHandle handle, const AABB & bb, Collision
 
 		copy = reinterpret_cast<float*>(malloc(sizeof(HeightMap)));
 		new(copy) HeightMap(*reinterpret_cast<const HeightMap*>(collider));
+		reinterpret_cast<HeightMap*>(copy)->CalculateBounds();
 		break;
 	default:
 		Log::Error("ContactSystem cannot handle collider of type %s currently!", to_string(type));
@@ -139,18 +167,25 @@ void Pu::ContactSystem::AddItem(PhysicsHandle handle, const AABB & bb, Collision
 
 void Pu::ContactSystem::RemoveItem(PhysicsHandle handle)
 {
-	cachedBroadPhase.erase(handle);
+	/* The lookup ID of the public handle will be reused by the next object, so just clear the slot. */
+	cachedHandles[IndexOf(handle)] = PhysicsNullHandle;
+	layers[IndexOf(handle)] = 0;
 	world->searchTree.Remove(handle);
 	++bvhUpdateCalls;
 
 	/* Make sure to free the narrow phase. */
 	const uint16 idx = world->QueryInternalIndex(handle);
-	if (physics_get_type(handle) == PhysicsType::Kinematic) rawBroadPhase.removeAt(idx);
+	if (physics_get_type(handle) == PhysicsType::Kinematic)
+	{
+		rawBroadPhase.removeAt(idx);
+		ccd.removeAt(idx);
+	}
+
 	free(rawNarrowPhase.at(handle).second);
 	rawNarrowPhase.erase(handle);
 }
 
-void Pu::ContactSystem::Check(void)
+void Pu::ContactSystem::Check(float dt)
 {
 	/* Remove the previous collisions from the buffer. */
 	hfirsts.clear();
@@ -167,10 +202,12 @@ void Pu::ContactSystem::Check(void)
 	if constexpr (ProfileWorldSystems) Profiler::Begin("BVH Update", Color::Abbey());
 
 	/* Query the movement system for updates to the BVH. */
-	readdCache.clear();
-	world->sysMove->CheckDistance(readdCache);
-	for (size_t idx : readdCache)
+	size_t movedCnt;
+	const uint32 *moved = world->sysMove->GetMovedObjects(movedCnt);
+	for (size_t i = 0; i < movedCnt; i++)
 	{
+		const size_t idx = moved[i];
+
 		/* Remove the old bounding box from the BVH. */
 		const PhysicsHandle hobj = world->QueryPublicHandle(create_physics_handle(PhysicsType::Kinematic, idx));
 		world->searchTree.Remove(hobj);
@@ -180,19 +217,24 @@ void Pu::ContactSystem::Check(void)
 		newBB.Inflate(KinematicExpansion, KinematicExpansion, KinematicExpansion);
 
 		/* Insert the new bounding box. */
-		cachedBroadPhase.at(hobj) = newBB;
+		cachedBroadPhase[IndexOf(hobj)] = newBB;
 		world->searchTree.Insert(hobj, newBB);
 		++bvhUpdateCalls;
 	}
 
 	if constexpr (ProfileWorldSystems) Profiler::End();
 
-	/* Check for collisions. */
-	for (const auto &[hobj, bb] : cachedBroadPhase)
+	/* Check for collisions, the pairs that are tested in batches are queued for the entire world and tested afterwards. */
+	ccdCandidates.clear();
+	for (size_t i = 0; i < cachedHandles.size(); i++)
 	{
-		/* We don't have to check sleeping or static objects. */
-		if (physics_get_type(hobj) == PhysicsType::Static || hobj & PhysicsHandleSkipBit) continue;
-		if (world->sysMove->IsSleeping(world->QueryInternalIndex(hobj))) continue;
+		const PhysicsHandle hobj = cachedHandles[i];
+		const AABB &bb = cachedBroadPhase[i];
+
+		/* We don't have to check empty slots, sleeping or static objects. */
+		if (hobj == PhysicsNullHandle || physics_get_type(hobj) == PhysicsType::Static || hobj & PhysicsHandleSkipBit) continue;
+		const uint16 idx = world->QueryInternalIndex(hobj);
+		if (world->sysMove->IsSleeping(idx)) continue;
 
 		/* Traverse the BVH to perform broad phase for this kinematic object. */
 		if constexpr (ProfileWorldSystems) Profiler::Begin("Broadphase", Color::Crimson());
@@ -211,6 +253,23 @@ void Pu::ContactSystem::Check(void)
 			if (hhit != hobj && hhit ^ PhysicsHandleSkipBit) TestGeneric(hhit, hobj);
 		}
 
+		if (ccd[idx]) ccdCandidates.emplace_back(hobj);
+		if constexpr (ProfileWorldSystems) Profiler::End();
+	}
+
+	/* Test all the queued pairs at once, so the batches are as full as possible. */
+	ProcessBatches();
+	contactCounts.assign(rawBroadPhase.size(), 0);
+	CountContacts(0);
+
+	/* Objects that are already touching something don't need to be swept. */
+	(void)ccdCandidates.removeAll([this](PhysicsHandle hobj) { return contactCounts[world->QueryInternalIndex(hobj)] > 0; });
+
+	/* The continuous collision sweeps need to be done after all the discrete checks, as they might move the objects. */
+	if (ccdCandidates.size())
+	{
+		if constexpr (ProfileWorldSystems) Profiler::Begin("CCD", Color::Scarlet());
+		Sweep(dt);
 		if constexpr (ProfileWorldSystems) Profiler::End();
 	}
 
@@ -219,6 +278,133 @@ void Pu::ContactSystem::Check(void)
 #endif
 }
 
+bool Pu::ContactSystem::Passes(PhysicsHandle hobj, const QueryFilter & filter) const
+{
+	if (hobj == filter.Ignore) return false;
+
+	/* The layers are indexed like the cached broadphase, removed objects have no layer so they never pass. */
+	const size_t idx = IndexOf(hobj);
+	return idx < layers.size() && (layers[idx] & filter.Mask);
+}
+
+/*
+The query shapes are tested against the same colliders that are used for contact generation.
+Shapes that don't have a narrow phase test (yet) are accepted on their broadphase overlap.
+*/
+Pu::QueryCollider Pu::ContactSystem::GetCollider(PhysicsHandle hobj) const
+{
+	QueryCollider result;
+	result.Handle = hobj;
+	result.Type = CollisionShapes::None;
+	result.Bounds = cachedBroadPhase[IndexOf(hobj)];
+	result.Terrain = nullptr;
+
+	const decltype(rawNarrowPhase)::const_iterator it = rawNarrowPhase.find(hobj);
+	if (it == rawNarrowPhase.end()) return result;
+
+	result.Type = it->second.first;
+	switch (result.Type)
+	{
+	case CollisionShapes::Sphere:
+		result.Ball = as_shape(Sphere, it->second.second) * world->GetTransform(hobj);
+		break;
+	case CollisionShapes::OBB:
+		result.Box = as_shape(OBB, it->second.second) * world->GetTransform(hobj);
+		break;
+	case CollisionShapes::HeightMap:
+		result.Terrain = &as_shape(HeightMap, it->second.second);
+		result.Offset = world->GetTransform(hobj).GetTranslation();
+		break;
+	default:
+		break;
+	}
+
+	return result;
+}
+
+bool Pu::ContactSystem::Overlaps(const QueryCollider & collider, Sphere sphere)
+{
+	switch (collider.Type)
+	{
+	case CollisionShapes::None:
+		return intersects(sphere, collider.Bounds);
+	case CollisionShapes::Sphere:
+		return intersects(sphere, collider.Ball);
+	case CollisionShapes::OBB:
+		return intersects(sphere, collider.Box);
+	case CollisionShapes::HeightMap:
+	{
+		/* This is the same test as used for contacts, the lowest point of the sphere needs to be below the terrain. */
+		float h;
+		return collider.Terrain->TryGetHeight(Vector2{ sphere.Center.X - collider.Offset.X, sphere.Center.Z - collider.Offset.Z }, h) && h >= sphere.Center.Y - sphere.Radius;
+	}
+	default:
+		return true;
+	}
+}
+
+bool Pu::ContactSystem::Overlaps(const QueryCollider & collider, const OBB & obb)
+{
+	Vector3 n;
+	float depth;
+
+	switch (collider.Type)
+	{
+	case CollisionShapes::None:
+	{
+		const OBB box{ collider.Bounds };
+		return SAT::Run(&box, &obb, 1, &n, &depth) != 0;
+	}
+	case CollisionShapes::Sphere:
+		return intersects(collider.Ball, obb);
+	case CollisionShapes::OBB:
+		return SAT::Run(&collider.Box, &obb, 1, &n, &depth) != 0;
+	case CollisionShapes::HeightMap:
+	{
+		/* Use the min/max pyramid to reject boxes above the terrain and accept boxes below it. */
+		const HeightMap &heightmap = *collider.Terrain;
+		const Vector3 offset = collider.Offset;
+		const AABB bb = obb.GetBoundingBox();
+
+		float hlow, hhigh;
+		heightmap.GetHeightRange(Vector2{ bb.LowerBound.X - offset.X, bb.LowerBound.Z - offset.Z }, Vector2{ bb.UpperBound.X - offset.X, bb.UpperBound.Z - offset.Z }, hlow, hhigh);
+		if (bb.LowerBound.Y > hhigh) return false;
+		if (bb.UpperBound.Y < hlow) return true;
+
+		/* Otherwise the box overlaps if any of its corners is below the terrain. */
+		const Vector3 x = obb.GetRight() * obb.Extent.X;
+		const Vector3 y = obb.GetUp() * obb.Extent.Y;
+		const Vector3 z = obb.GetForward() * obb.Extent.Z;
+		for (uint32 i = 0; i < 8; i++)
+		{
+			const Vector3 corner = obb.Center + (i & 1 ? x : -x) + (i & 2 ? y : -y) + (i & 4 ? z : -z);
+
+			float h;
+			if (heightmap.TryGetHeight(Vector2{ corner.X - offset.X, corner.Z - offset.Z }, h) && h >= corner.Y) return true;
+		}
+
+		return false;
+	}
+	default:
+		return true;
+	}
+}
+
+float Pu::ContactSystem::GetDistance(const QueryCollider & collider, Vector3 p)
+{
+	if (collider.Type == CollisionShapes::Sphere) return max(0.0f, dist(collider.Ball.Center, p) - collider.Ball.Radius);
+	else if (collider.Type == CollisionShapes::OBB) return dist(closest(collider.Box, p), p);
+
+	/* Every other shape uses its broadphase, which is exact for AABB colliders. */
+	return dist(closest(collider.Bounds, p), p);
+}
+
+size_t Pu::ContactSystem::IndexOf(PhysicsHandle hobj) const
+{
+	/* Public handles are unique within the world, so their lookup ID can be used as a dense index. */
+	return physics_get_lookup_id(hobj);
+}
+
 void Pu::ContactSystem::ProcessTriggers(void)
 {
 	for (const auto[hfirst, hsecond] : hitTriggers)
@@ -229,13 +415,30 @@ void Pu::ContactSystem::ProcessTriggers(void)
 	hitTriggers.clear();
 }
 
+/*
+The broadphase handles only change when objects are added or removed, so only the bounding boxes are stored.
+The cached broadphase is a flat array of plain data indexed by lookup ID, so it's copied in bulk and the restored state iterates in the exact same order as the original.
+*/
+void Pu::ContactSystem::Snapshot(BinaryWriter & writer) const
+{
+	writer.Write(static_cast<uint64>(cachedBroadPhase.size()));
+	writer.Write(reinterpret_cast<const byte*>(cachedBroadPhase.data()), 0, cachedBroadPhase.size() * sizeof(AABB));
+}
+
+void Pu::ContactSystem::Restore(BinaryReader & reader)
+{
+	if (reader.ReadUInt64() != cachedBroadPhase.size()) Log::Fatal("Unable to restore contact system (object count differs from snapshot)!");
+	const size_t bytes = reader.Read(reinterpret_cast<byte*>(cachedBroadPhase.data()), 0, cachedBroadPhase.size() * sizeof(AABB));
+	if (bytes != cachedBroadPhase.size() * sizeof(AABB)) Log::Fatal("Unable to restore contact system (snapshot is truncated)!");
+}
+
 #ifdef _DEBUG
 void Pu::ContactSystem::VisualizeColliders(DebugRenderer & dbgRenderer, Vector3 camPos) const
 {
 	/* Display yellow for cached broadphases. */
-	for (const auto[hcur, bb] : cachedBroadPhase)
+	for (size_t i = 0; i < cachedHandles.size(); i++)
 	{
-		if (physics_get_type(hcur) == PhysicsType::Kinematic) dbgRenderer.AddBox(bb, Color::Yellow());
+		if (physics_get_type(cachedHandles[i]) == PhysicsType::Kinematic) dbgRenderer.AddBox(cachedBroadPhase[i], Color::Yellow());
 	}
 
 	for (const auto[hcur, narrow] : rawNarrowPhase)
@@ -247,7 +450,7 @@ void Pu::ContactSystem::VisualizeColliders(DebugRenderer & dbgRenderer, Vector3
 		const Color clr = physics_get_type(hcur) == PhysicsType::Static ? Color::Green() : Color::Red();
 		const Matrix transform = world->GetTransform(hcur);
 
-		if (narrow.first == CollisionShapes::None) dbgRenderer.AddBox(cachedBroadPhase.at(hcur), clr);
+		if (narrow.first == CollisionShapes::None) dbgRenderer.AddBox(cachedBroadPhase[IndexOf(hcur)], clr);
 		else if (narrow.first == CollisionShapes::Sphere) dbgRenderer.AddSphere(as_shape(Sphere, narrow.second) * transform, clr);
 		else if (narrow.first == CollisionShapes::OBB) dbgRenderer.AddBox(as_shape(OBB, narrow.second) * transform, clr);
 		else if (narrow.first == CollisionShapes::HeightMap)
@@ -257,7 +460,7 @@ void Pu::ContactSystem::VisualizeColliders(DebugRenderer & dbgRenderer, Vector3
 
 			/* The heightmap is incredibly expensive to debug render, so only do it for one. */
 			if (collider.Contains(Vector2(camPos.X - offset.X, camPos.Z - offset.Z))) collider.Visualize(dbgRenderer, offset, clr);
-			else dbgRenderer.AddBox(cachedBroadPhase.at(hcur), clr);
+			else dbgRenderer.AddBox(cachedBroadPhase[IndexOf(hcur)], clr);
 		}
 	}
 }
@@ -279,6 +482,114 @@ void Pu::ContactSystem::VisualizeContacts(DebugRenderer & dbgRenderer) const
 }
 #endif
 
+/*
+Fast objects can move through thin geometry in a single step, because their discrete checks happen before and after the wall.
+The cached broadphase is expanded by KinematicExpansion, so objects that move less than half of that (or their own size) are safe.
+Any faster object with CCD enabled uses conservative advancement.
+All the objects are advanced in lockstep, so the batched checks of a step are tested once for all the sweeping objects:
+
+foreach candidate
+	sweep = broadphase + (broadphase + displacement)
+	steps = displacement / safe distance
+
+foreach step
+	foreach active candidate
+		move object by one step
+		queue narrow phase against all objects in its sweep
+	test all queued pairs
+	foreach active candidate
+		if collided
+			keep object at this point, the solver will handle the contact
+			only integrate the remaining part of the step (1 - toi)
+		else if last step
+			move object back to its starting point
+*/
+void Pu::ContactSystem::Sweep(float dt)
+{
+	sweeps.clear();
+	sweepHits.clear();
+
+	for (const PhysicsHandle hobj : ccdCandidates)
+	{
+		const uint16 idx = world->QueryInternalIndex(hobj);
+		const Vector3 d = world->sysMove->GetVelocity(idx) * dt;
+		const float dist = d.Length();
+
+		/* The safe distance is the smallest of the half extent of the collider and the broadphase expansion. */
+		const Vector3 extent = (rawBroadPhase[idx] * world->GetTransform(hobj)).GetSize() * 0.5f;
+		const float safe = min(min(min(extent.X, extent.Y), extent.Z), KinematicExpansion * 0.5f);
+		if (dist <= safe || safe <= 0.0f) continue;
+
+		/* Gather all the objects that the object might hit during this step. */
+		const AABB &bb = cachedBroadPhase[IndexOf(hobj)];
+		broadPhaseCache.clear();
+		world->searchTree.Boxcast(union_(bb, d + bb), broadPhaseCache);
+		++ccdSweeps;
+
+		/* Advance the object in steps that can't skip over anything, clamped to prevent slowdowns for extremely fast objects. */
+		CCDSweep sweep;
+		sweep.Handle = hobj;
+		sweep.Index = idx;
+		sweep.Steps = min(static_cast<uint32>(ceilf(dist / safe)), PhysicsMaxCCDSteps);
+		sweep.Remaining = sweep.Steps;
+		sweep.Step = d / static_cast<float>(sweep.Steps);
+		sweep.FirstHit = static_cast<uint32>(sweepHits.size());
+
+		for (const PhysicsHandle hhit : broadPhaseCache)
+		{
+			if (hhit != hobj && hhit ^ PhysicsHandleSkipBit) sweepHits.emplace_back(hhit);
+		}
+
+		sweep.HitCount = static_cast<uint32>(sweepHits.size()) - sweep.FirstHit;
+		sweeps.emplace_back(sweep);
+	}
+
+	for (size_t active = sweeps.size(); active;)
+	{
+		const size_t oldCnt = hfirsts.size();
+		for (const CCDSweep &sweep : sweeps)
+		{
+			if (!sweep.Remaining) continue;
+
+			world->sysMove->AddOffset(sweep.Index, sweep.Step);
+			for (uint32 i = 0; i < sweep.HitCount; i++) TestGeneric(sweepHits[sweep.FirstHit + i], sweep.Handle);
+		}
+
+		ProcessBatches();
+		CountContacts(oldCnt);
+
+		for (CCDSweep &sweep : sweeps)
+		{
+			if (!sweep.Remaining) continue;
+
+			if (contactCounts[sweep.Index])
+			{
+				/* The object is already at its time of impact, so the integration should only move it for the rest of the step. */
+				world->sysMove->SetTimeOfImpact(sweep.Index, static_cast<float>(sweep.Steps - sweep.Remaining + 1) / static_cast<float>(sweep.Steps));
+				sweep.Remaining = 0;
+			}
+			else if (!--sweep.Remaining)
+			{
+				/* Nothing was hit, so the regular integration can move the object. */
+				world->sysMove->AddOffset(sweep.Index, -sweep.Step * static_cast<float>(sweep.Steps));
+			}
+			else continue;
+
+			--active;
+		}
+	}
+}
+
+void Pu::ContactSystem::CountContacts(size_t first)
+{
+	/* Only kinematic objects have a contact count, the static objects are never checked or swept. */
+	for (size_t i = first; i < hfirsts.size(); i++)
+	{
+		if (physics_get_type(hfirsts[i]) != PhysicsType::Static) ++contactCounts[world->QueryInternalIndex(hfirsts[i])];
+		if (physics_get_type(hseconds[i]) != PhysicsType::Static) ++contactCounts[world->QueryInternalIndex(hseconds[i])];
+	}
+}
+
 void Pu::ContactSystem::TestGeneric(PhysicsHandle hfirst, PhysicsHandle hsecond)
 {
 	++narrowPhaseChecks;
@@ -330,7 +641,7 @@ void Pu::ContactSystem::TestAABBSphere(PhysicsHandle haabb, PhysicsHandle hspher
 	/* Query the sphere collider and transform it to the correct position. */
 	const Sphere sphere = as_shape(Sphere, rawNarrowPhase.at(hsphere).second) * world->GetTransform(hsphere);
 
-	const Vector3 q = closest(cachedBroadPhase.at(haabb), sphere.Center);
+	const Vector3 q = closest(cachedBroadPhase[IndexOf(haabb)], sphere.Center);
 	const float d2 = sqrdist(q, sphere.Center);
 	const float r2 = sqr(sphere.Radius);
 
@@ -343,29 +654,82 @@ void Pu::ContactSystem::TestAABBSphere(PhysicsHandle haabb, PhysicsHandle hspher
 	}
 }
 
-void Pu::ContactSystem::TestHeightmapSphere(PhysicsHandle hmap, PhysicsHandle hsphere)
+void Pu::ContactSystem::QueueHeightmapSphere(PhysicsHandle hmap, PhysicsHandle hsphere)
 {
-	/* Query the colliders and transform them to the correct position. */
-	const HeightMap &heightmap = as_shape(HeightMap, rawNarrowPhase.at(hmap).second);
-	const Vector3 offset = world->GetTransform(hmap).GetTranslation();
-	const Sphere sphere = as_shape(Sphere, rawNarrowPhase.at(hsphere).second) * world->GetTransform(hsphere);
+	/* Heightmap checks are done in batches, so just store the pair for now. */
+	heightmapQueries.emplace_back(hmap, hsphere);
+}
 
-	float h;
-	Vector3 n;
+/*
+The heightmap checks are batched to gather the heights and normals for eight spheres at once.
+
+sort queries on heightmap
+foreach heightmap
+	foreach sphere
+		if lowest point of sphere is above the heighest point under it
+			skip sphere
+		add sphere to batch
+
+	if batch is full or last sphere
+		query height and normal for entire batch
+		add manifold for every sphere that's below its height
+*/
+void Pu::ContactSystem::TestHeightmapSpheres(void)
+{
+	if (heightmapQueries.empty()) return;
+	if constexpr (ProfileWorldSystems) Profiler::Begin("Heightmap", Color::Scarlet());
+
+	/* Sorting the queries makes sure that every batch only uses a single heightmap. */
+	std::sort(heightmapQueries.begin(), heightmapQueries.end());
 
-	/* Query the heightmap for the height and normal under the sphere. */
-	const Vector2 query = Vector2(sphere.Center.X - offset.X, sphere.Center.Z - offset.Z);
-	if (heightmap.TryGetHeightAndNormal(query, h, n))
+	AVX_FLOAT_UNION x{ _mm256_setzero_ps() }, z{ _mm256_setzero_ps() }, low{ _mm256_setzero_ps() };
+	PhysicsHandle hspheres[8];
+
+	for (size_t i = 0; i < heightmapQueries.size();)
 	{
-		const float low = sphere.Center.Y - sphere.Radius;
+		/* Query the heightmap collider and its offset. */
+		const PhysicsHandle hmap = heightmapQueries[i].first;
+		const HeightMap &heightmap = as_shape(HeightMap, rawNarrowPhase.at(hmap).second);
+		const Vector3 offset = world->GetTransform(hmap).GetTranslation();
+
+		/* Fill the batch with spheres that query the same heightmap. */
+		uint32 cnt = 0;
+		for (; cnt < 8 && i < heightmapQueries.size() && heightmapQueries[i].first == hmap; i++)
+		{
+			const PhysicsHandle hsphere = heightmapQueries[i].second;
+			const Sphere sphere = as_shape(Sphere, rawNarrowPhase.at(hsphere).second) * world->GetTransform(hsphere);
+			const Vector2 center{ sphere.Center.X - offset.X, sphere.Center.Z - offset.Z };
+
+			/* Use the min/max pyramid to quickly reject spheres that are above the heightmap. */
+			float hlow, hhigh;
+			heightmap.GetHeightRange(center - Vector2(sphere.Radius), center + Vector2(sphere.Radius), hlow, hhigh);
+			if (sphere.Center.Y - sphere.Radius > hhigh) continue;
+
+			x.V[cnt] = center.X;
+			z.V[cnt] = center.Y;
+			low.V[cnt] = sphere.Center.Y - sphere.Radius;
+			hspheres[cnt++] = hsphere;
+		}
+
+		if (!cnt) continue;
 
 		/* The sphere collides with the heightmap is it's lowest point is below the sample height. */
-		if (h >= low)
+		AVX_FLOAT_UNION h, nx, ny, nz;
+		const ofloat valid = heightmap.TryGetHeightAndNormal(x.SIMD, z.SIMD, h.SIMD, nx.SIMD, ny.SIMD, nz.SIMD);
+		const uint32 hits = static_cast<uint32>(_mm256_movemask_ps(_mm256_and_ps(valid, _mm256_cmp_ps(h.SIMD, low.SIMD, _CMP_GE_OQ)))) & ((1u << cnt) - 1);
+
+		for (uint32 j = 0; j < cnt; j++)
 		{
-			const Vector3 p{ sphere.Center.X, h, sphere.Center.Z };
-			AddManifold(hmap, hsphere, p, n, h - low, 1.0f);
+			if (hits & (1u << j))
+			{
+				const Vector3 p{ x.V[j] + offset.X, h.V[j], z.V[j] + offset.Z };
+				AddManifold(hmap, hspheres[j], p, Vector3{ nx.V[j], ny.V[j], nz.V[j] }, h.V[j] - low.V[j], 1.0f);
+			}
 		}
 	}
+
+	heightmapQueries.clear();
+	if constexpr (ProfileWorldSystems) Profiler::End();
 }
 
 void Pu::ContactSystem::TestSphereOBB(PhysicsHandle hsphere, PhysicsHandle hobb)
@@ -387,44 +751,72 @@ void Pu::ContactSystem::TestSphereOBB(PhysicsHandle hsphere, PhysicsHandle hobb)
 	}
 }
 
-void Pu::ContactSystem::TestAABBOBB(PhysicsHandle haabb, PhysicsHandle hobb)
+void Pu::ContactSystem::QueueBoxes(PhysicsHandle hfirst, PhysicsHandle hobb)
 {
-	/* Query the colliders and transform them to the correct location. */
-	const AABB &aabb = cachedBroadPhase.at(haabb);
-	const OBB &obb = as_shape(OBB, rawNarrowPhase.at(hobb).second) * world->GetTransform(hobb);
-
-	/* Check for collision. */
-	if (sat.Run(aabb, obb))
-	{
-		const vector<Vector3> &points = sat.GetContacts(aabb, obb);
-		const float mul = 1.0f / points.size();
-
-		/* Should make a different solver for this, but for now this works. */
-		for (Vector3 p : points)
-		{
-			AddManifold(haabb, hobb, p, sat.GetIntersectionAxis(), sat.GetIntersectionDepth(), mul);
-		}
-	}
+	/* Box checks are done in batches, so just store the pair for now. */
+	boxQueries.emplace_back(hfirst, hobb);
 }
 
-void Pu::ContactSystem::TestOBBOBB(PhysicsHandle hfirst, PhysicsHandle hsecond)
+/*
+The box checks (AABB vs OBB and OBB vs OBB) are batched to perform SAT on eight pairs at once.
+The contact points are only generated for the pairs that actually intersect.
+
+foreach batch of 8 pairs
+	promote AABB to OBB
+	transform OBBs to world space
+	perform SAT on entire batch
+	foreach intersecting pair
+		generate contact points
+		add manifold for every contact point
+*/
+void Pu::ContactSystem::TestBoxes(void)
 {
-	/* Query the colliders and transform them to the correct location. */
-	const OBB &obb1 = as_shape(OBB, rawNarrowPhase.at(hfirst).second) * world->GetTransform(hfirst);
-	const OBB &obb2 = as_shape(OBB, rawNarrowPhase.at(hsecond).second) * world->GetTransform(hsecond);
+	if (boxQueries.empty()) return;
+	if constexpr (ProfileWorldSystems) Profiler::Begin("Boxes", Color::Scarlet());
 
-	/* Check for collision. */
-	if (sat.Run(obb1, obb2))
+	OBB first[8], second[8];
+	Vector3 normals[8];
+	float depths[8];
+
+	for (size_t i = 0; i < boxQueries.size(); i += 8)
 	{
-		const vector<Vector3> &points = sat.GetContacts(obb1, obb2);
-		const float mul = 1.0f / points.size();
+		/* Query the colliders and transform them to the correct location. */
+		const uint32 cnt = min(static_cast<uint32>(boxQueries.size() - i), 8u);
+		for (uint32 j = 0; j < cnt; j++)
+		{
+			const PhysicsHandlePair &pair = boxQueries[i + j];
+			const std::pair<CollisionShapes, float*> &narrow = rawNarrowPhase.at(pair.first);
+			if (narrow.first == CollisionShapes::OBB) first[j] = as_shape(OBB, narrow.second) * world->GetTransform(pair.first);
+			else first[j] = OBB(cachedBroadPhase[IndexOf(pair.first)]);
 
-		/* Should make a different solver for this, but for now this works. */
-		for (Vector3 p : points)
+			second[j] = as_shape(OBB, rawNarrowPhase.at(pair.second).second) * world->GetTransform(pair.second);
+		}
+
+		const uint32 hits = SAT::Run(first, second, cnt, normals, depths);
+		for (uint32 j = 0; j < cnt; j++)
 		{
-			AddManifold(hfirst, hsecond, p, sat.GetIntersectionAxis(), sat.GetIntersectionDepth(), mul);
+			if (!(hits & (1u << j))) continue;
+
+			/* Should make a different solver for this, but for now this works. */
+			boxContacts.clear();
+			SAT::GetContacts(first[j], second[j], normals[j], depths[j], boxContacts);
+
+			const float mul = 1.0f / boxContacts.size();
+			for (Vector3 p : boxContacts)
+			{
+				AddManifold(boxQueries[i + j].first, boxQueries[i + j].second, p, normals[j], depths[j], mul);
+			}
 		}
 	}
+
+	boxQueries.clear();
+	if constexpr (ProfileWorldSystems) Profiler::End();
+}
+
+void Pu::ContactSystem::ProcessBatches(void)
+{
+	TestHeightmapSpheres();
+	TestBoxes();
 }
 
 void Pu::ContactSystem::AddManifold(PhysicsHandle hfirst, PhysicsHandle hsecond, Vector3 pos, Vector3 normal, float depth, float mul)
@@ -507,13 +899,14 @@ void Pu::ContactSystem::SetGenericCheckers(void)
 	+-----------+------+--------+---------+-----+------+------+-----------+
 
 	AABB and Heightmap should only be used for static objects, it makes no sense to check for any combination of them.
+	Box pairs (AABB/OBB and OBB/OBB) are tested in batches with SAT.
 	*/
 	checkers.emplace(collision_t(CollisionShapes::None, CollisionShapes::Sphere), &ContactSystem::TestAABBSphere);
 	checkers.emplace(collision_t(CollisionShapes::Sphere, CollisionShapes::Sphere), &ContactSystem::TestSphereSphere);
-	checkers.emplace(collision_t(CollisionShapes::HeightMap, CollisionShapes::Sphere), &ContactSystem::TestHeightmapSphere);
+	checkers.emplace(collision_t(CollisionShapes::HeightMap, CollisionShapes::Sphere), &ContactSystem::QueueHeightmapSphere);
 	checkers.emplace(collision_t(CollisionShapes::Sphere, CollisionShapes::OBB), &ContactSystem::TestSphereOBB);
-	checkers.emplace(collision_t(CollisionShapes::None, CollisionShapes::OBB), &ContactSystem::TestAABBOBB);
-	checkers.emplace(collision_t(CollisionShapes::OBB, CollisionShapes::OBB), &ContactSystem::TestOBBOBB);
+	checkers.emplace(collision_t(CollisionShapes::None, CollisionShapes::OBB), &ContactSystem::QueueBoxes);
+	checkers.emplace(collision_t(CollisionShapes::OBB, CollisionShapes::OBB), &ContactSystem::QueueBoxes);
 }
 
 void Pu::ContactSystem::Destroy(void)
@@ -2,18 +2,14 @@
 #include "Core/Diagnostics/Logging.h"
 #include "Config.h"
 
-#define GJK_EXIT_SUCCESS	1
-#define GJK_EXIT_FAILED		0
-#define GJK_EXIT_ERROR		-1
-
 static Pu::uint32 calls = 0;
 static Pu::uint32 iterations = 0;
+static Pu::uint32 epaCalls = 0;
+static Pu::uint32 epaIterations = 0;
 
 Pu::GJK::GJK(void)
-	: iteration(0), lastSqrDist(maxv<float>()), dimension(0)
-{
-	memset(barycentricCoords, 0, sizeof(barycentricCoords));
-}
+	: iteration(0), dimension(0), depth(0.0f)
+{}
 
 Pu::uint32 Pu::GJK::GetCallCount(void)
 {
@@ -25,47 +21,236 @@ Pu::uint32 Pu::GJK::GetAverageIterations(void)
 	return iterations / max(1u, calls);
 }
 
+Pu::uint32 Pu::GJK::GetEPACallCount(void)
+{
+	return epaCalls;
+}
+
+Pu::uint32 Pu::GJK::GetAverageEPAIterations(void)
+{
+	return epaIterations / max(1u, epaCalls);
+}
+
 void Pu::GJK::ResetCounters(void)
 {
 	calls = 0;
 	iterations = 0;
+	epaCalls = 0;
+	epaIterations = 0;
 }
 
 bool Pu::GJK::Run(const void * shape1, const void * shape2, Support_t support1, Support_t support2)
 {
-	return RunInternal(shape1, shape2, support1, support2) == 1;
+	return RunInternal(shape1, shape2, support1, support2, Vector3::Left());
+}
+
+bool Pu::GJK::Run(const void * shape1, const void * shape2, Support_t support1, Support_t support2, GJKCache & cache)
+{
+	/* Use the last search direction as the starting direction, this is most likely still the seperating axis. */
+	const bool result = RunInternal(shape1, shape2, support1, support2, cache.Direction);
+	cache.Direction = supportDir;
+	return result;
 }
 
-int Pu::GJK::RunInternal(const void * shape1, const void * shape2, Support_t support1, Support_t support2)
+/*
+The polytope starts as the tetrahedron that GJK ended with.
+
+loop
+	find the face closest to the origin
+	get the support point in the direction of the face normal
+	if the support point is not further than the face
+		the face is the closest face on the Minkowski difference
+	remove all faces that can see the support point
+	connect the horizon edges to the support point
+
+The contact points are calculated from the barycentric coordinates of the origin projected on the closest face.
+*/
+void Pu::GJK::GetContact(const void * shape1, const void * shape2, Support_t support1, Support_t support2)
+{
+#ifdef _DEBUG
+	if (dimension != 4) Log::Fatal("EPA can only be run after an intersecting GJK call!");
+#endif
+
+	++epaCalls;
+
+	/* Initialize the polytope from the final simplex, with the faces wound outwards. */
+	polytope.clear();
+	faces.clear();
+	for (const SupportPoint &cur : simplex) polytope.emplace_back(cur);
+
+	const uint32 tetrahedron[12] = { 0, 1, 2, 0, 3, 1, 0, 2, 3, 1, 3, 2 };
+	const Vector3 centroid = (simplex[0].P + simplex[1].P + simplex[2].P + simplex[3].P) * 0.25f;
+	for (uint32 i = 0; i < 12; i += 3)
+	{
+		const Vector3 a = polytope[tetrahedron[i]].P;
+		const Vector3 normal = cross(polytope[tetrahedron[i + 1]].P - a, polytope[tetrahedron[i + 2]].P - a);
+
+		faces.emplace_back(tetrahedron[i]);
+		if (dot(normal, a - centroid) >= 0.0f)
+		{
+			faces.emplace_back(tetrahedron[i + 1]);
+			faces.emplace_back(tetrahedron[i + 2]);
+		}
+		else
+		{
+			faces.emplace_back(tetrahedron[i + 2]);
+			faces.emplace_back(tetrahedron[i + 1]);
+		}
+	}
+
+	size_t closest = 0;
+	for (uint32 i = 0; i < MaxIterationsEPA; i++)
+	{
+		++epaIterations;
+
+		/* Find the face that's closest to the origin. */
+		float minDist = maxv<float>();
+		for (size_t j = 0; j < faces.size(); j += 3)
+		{
+			const Vector3 a = polytope[faces[j]].P;
+			const Vector3 normal = normalize(cross(polytope[faces[j + 1]].P - a, polytope[faces[j + 2]].P - a));
+			const float d = dot(normal, a);
+
+			if (d < minDist)
+			{
+				minDist = d;
+				closest = j;
+				n = normal;
+			}
+		}
+
+		/* We're done if the polytope cannot be expanded any further in the direction of the closest face. */
+		const SupportPoint sp = Support(shape1, shape2, support1, support2, n);
+		if (dot(sp.P, n) - minDist < PhysicsEPATolerance) break;
+
+		/* Remove all the faces that can see the new point and keep track of the horizon. */
+		edges.clear();
+		for (size_t j = 0; j < faces.size();)
+		{
+			const Vector3 a = polytope[faces[j]].P;
+			const Vector3 normal = cross(polytope[faces[j + 1]].P - a, polytope[faces[j + 2]].P - a);
+
+			if (dot(normal, sp.P - a) > 0.0f)
+			{
+				AddEdge(faces[j], faces[j + 1]);
+				AddEdge(faces[j + 1], faces[j + 2]);
+				AddEdge(faces[j + 2], faces[j]);
+				faces.erase(faces.begin() + j, faces.begin() + j + 3);
+			}
+			else j += 3;
+		}
+
+		/* Connect the horizon to the new point, the edge order keeps the faces wound outwards. */
+		const uint32 idx = static_cast<uint32>(polytope.size());
+		polytope.emplace_back(sp);
+		for (const auto [a, b] : edges)
+		{
+			faces.emplace_back(a);
+			faces.emplace_back(b);
+			faces.emplace_back(idx);
+		}
+	}
+
+	/* The closest face might have been removed during the last expansion, so search for it again. */
+	{
+		float minDist = maxv<float>();
+		for (size_t j = 0; j < faces.size(); j += 3)
+		{
+			const Vector3 a = polytope[faces[j]].P;
+			const Vector3 normal = normalize(cross(polytope[faces[j + 1]].P - a, polytope[faces[j + 2]].P - a));
+			const float d = dot(normal, a);
+
+			if (d < minDist)
+			{
+				minDist = d;
+				closest = j;
+				n = normal;
+			}
+		}
+
+		depth = max(0.0f, minDist);
+	}
+
+	/* This should never happen, but a degenerate simplex might remove all faces. */
+	if (faces.empty())
+	{
+		Log::Error("EPA failed (Polytope has no faces)!");
+		contact1 = contact2 = simplex[3].A;
+		return;
+	}
+
+	/* Calculate the barycentric coordinates of the origin projected on the closest face. */
+	const SupportPoint &a = polytope[faces[closest]];
+	const SupportPoint &b = polytope[faces[closest + 1]];
+	const SupportPoint &c = polytope[faces[closest + 2]];
+	const Vector3 p = n * depth;
+
+	const Vector3 v0 = b.P - a.P;
+	const Vector3 v1 = c.P - a.P;
+	const Vector3 v2 = p - a.P;
+	const float d00 = dot(v0, v0);
+	const float d01 = dot(v0, v1);
+	const float d11 = dot(v1, v1);
+	const float d20 = dot(v2, v0);
+	const float d21 = dot(v2, v1);
+	const float denom = d00 * d11 - d01 * d01;
+
+	/* Degenerate faces just use the first point. */
+	float v = 0.0f, w = 0.0f;
+	if (denom != 0.0f)
+	{
+		v = (d11 * d20 - d01 * d21) / denom;
+		w = (d00 * d21 - d01 * d20) / denom;
+	}
+
+	const float u = 1.0f - v - w;
+	contact1 = a.A * u + b.A * v + c.A * w;
+	contact2 = (a.A - a.P) * u + (b.A - b.P) * v + (c.A - c.P) * w;
+}
+
+Pu::GJK::SupportPoint Pu::GJK::Support(const void * shape1, const void * shape2, Support_t support1, Support_t support2, Vector3 dir)
+{
+	/* The support functions expect a normalized direction. */
+	dir = normalize(dir);
+	const Vector3 a = support1(dir, shape1);
+	return SupportPoint{ a - support2(-dir, shape2), a };
+}
+
+/*
+The simplex is always stored with the newest point last.
+Every iteration the simplex is reduced to the feature closest to the origin,
+and the search direction is set to point from that feature to the origin.
+*/
+bool Pu::GJK::RunInternal(const void * shape1, const void * shape2, Support_t support1, Support_t support2, Vector3 dir)
 {
 	++calls;
 
-	/* Guess the starting direction for the algorithm */
-	Vector3 a = support1(Vector3::Left(), shape1) - support2(Vector3::Right(), shape2);
-	supportDir = -a;
+	/* Make sure the starting direction is valid. */
+	if (dir.LengthSquared() < EPSILON) dir = Vector3::Left();
+	supportDir = dir;
 
-	/* Initialize the simplex. */
+	/* Initialize the simplex, if the first point isn't past the origin then the starting direction is a seperating axis. */
+	simplex[0] = Support(shape1, shape2, support1, support2, dir);
 	dimension = 1;
-	simplex[0] = a;
-	barycentricCoords[0] = 1.0f;
+	if (dot(simplex[0].P, dir) < 0.0f) return false;
+	supportDir = -simplex[0].P;
 
 	/* Loop untill we run out of iterations (should not occur often). */
 	for (iteration = 0; iteration < MaxIterationsGJK; iteration++)
 	{
 		iterations++;
 
-		/* Gets the new support point. */
-		a = support1(supportDir, shape1) - support2(-supportDir, shape2);
+		/* The origin is on the boundary of the simplex, we consider touching shapes as not intersecting. */
+		if (supportDir.LengthSquared() < EPSILON) return false;
 
-		/* Add the new location to the simplex. */
-		simplex[dimension] = a;
-		barycentricCoords[dimension++] = 1.0f;
+		/* Gets the new support point, if it doesn't pass the origin then we found a seperating axis. */
+		const SupportPoint a = Support(shape1, shape2, support1, support2, supportDir);
+		if (dot(a.P, supportDir) < 0.0f) return false;
 
-		/* Solve for the new simplex. */
+		/* Add the new location to the simplex and solve for the new simplex. */
+		simplex[dimension++] = a;
 		switch (dimension)
 		{
-		case 1:
-			break;
 		case 2:
 			NearestLine();
 			break;
@@ -73,380 +258,134 @@ int Pu::GJK::RunInternal(const void * shape1, const void * shape2, Support_t sup
 			NearestTriangle();
 			break;
 		case 4:
-			NearestTetrahedron();
+			if (NearestTetrahedron()) return true;
 			break;
 		default:
 			Log::Error("GJK failed (Simplex of dimension %u cannot be solved)!", dimension);
-			return GJK_EXIT_ERROR;
-		}
-
-		/* The origin is in the simplex if it remains a tetrahedron after solving. */
-		if (dimension == 4) return GJK_EXIT_SUCCESS;
-
-		NormalizeBarycentricCoords();
-
-		/* Calculate the closest point. */
-		Vector3 p;
-		switch (dimension)
-		{
-		case 1:
-			p = simplex[0];
-			break;
-		case 2:
-			p = simplex[0] * barycentricCoords[0] + simplex[1] * barycentricCoords[1];
-			break;
-		case 3:
-			p = simplex[1] * barycentricCoords[0] + simplex[1] * barycentricCoords[1] + simplex[2] * barycentricCoords[2];
-			break;
-		}
-
-		/* Ensure that we're closing in on the origin, to prevent multi-step cycling. */
-		const float d2 = p.LengthSquared();
-		if (d2 == 0.0f) return GJK_EXIT_SUCCESS;
-		if (d2 >= lastSqrDist) break;
-		lastSqrDist = d2;
-
-		/* Get the new search direction. */
-		switch (dimension)
-		{
-		case 1:
-			supportDir = -simplex[0];
-			break;
-		case 2:
-		{
-			Vector3 ba = simplex[1] - simplex[0];
-			supportDir = cross(cross(ba, -simplex[1]), ba);
-			break;
-		}
-		case 3:
-			Vector3 n = cross(simplex[1] - simplex[0], simplex[2] - simplex[0]);
-			supportDir = dot(n, simplex[0]) <= 0.0f ? n : -n;
-			break;
-		}
-
-		/* Something went wrong and the direction is invalid. */
-		if (supportDir.LengthSquared() < sqr(EPSILON))
-		{
-			Log::Error("GJK failed (Search direction is [0, 0, 0])!");
-			return GJK_EXIT_ERROR;
+			return false;
 		}
 	}
 
 	/* We ran out of iterations, so return failed. */
-	return GJK_EXIT_FAILED;
-}
-
-void Pu::GJK::NormalizeBarycentricCoords(void)
-{
-	/* Normalize the barycentric coordinates to [0, 1] range. */
-	float denom = 0.0f;
-	for (uint8 i = 0; i < dimension; i++) denom += barycentricCoords[i];
-	denom = recip(denom);
-
-	for (uint8 i = 0; i < dimension; i++) barycentricCoords[i] *= denom;
+	return false;
 }
 
-void Pu::GJK::NearestLine(void)
+bool Pu::GJK::NearestLine(void)
 {
-	/* Calculate the unnormalized barycentric coordinates for the line. */
-	const Vector3 ab = simplex[0] - simplex[1];
-	const Vector3 ba = simplex[1] - simplex[0];
-	const float u = dot(simplex[1], ba);
-	const float v = dot(simplex[0], ab);
+	const SupportPoint a = simplex[1];
+	const Vector3 ab = simplex[0].P - a.P;
+	const Vector3 ao = -a.P;
 
-	if (v <= 0.0f)
-	{
-		/* Vertex region A. */
-		barycentricCoords[0] = 1.0f;
-		dimension = 1;
-	}
-	else if (u <= 0.0f)
+	if (dot(ab, ao) > 0.0f)
 	{
-		/* Vertex region B. */
-		simplex[0] = simplex[1];
-		barycentricCoords[0] = 1.0f;
-		dimension = 1;
+		/* Line region AB. */
+		supportDir = cross(cross(ab, ao), ab);
 	}
 	else
 	{
-		/* Line region AB. */
-		barycentricCoords[0] = u;
-		barycentricCoords[1] = v;
-		dimension = 2;
+		/* Vertex region A. */
+		simplex[0] = a;
+		dimension = 1;
+		supportDir = ao;
 	}
+
+	return false;
 }
 
-void Pu::GJK::NearestTriangle(void)
+bool Pu::GJK::NearestTriangle(void)
 {
-	/* Get the unnormalized barycentric coordinates for the line segments in the triangle. */
-	const Vector3 ab = simplex[0] - simplex[1];
-	const Vector3 ba = simplex[1] - simplex[0];
-	const Vector3 bc = simplex[1] - simplex[2];
-	const Vector3 cb = simplex[2] - simplex[1];
-	const Vector3 ca = simplex[2] - simplex[0];
-	const Vector3 ac = simplex[0] - simplex[2];
-
-	const float uab = dot(simplex[1], ba);
-	const float vab = dot(simplex[0], ab);
-	const float ubc = dot(simplex[2], cb);
-	const float vbc = dot(simplex[1], bc);
-	const float uca = dot(simplex[0], ac);
-	const float vca = dot(simplex[2], ca);
-
-	if (vab <= 0.0f && uca <= 0.0f)
+	const SupportPoint a = simplex[2];
+	const SupportPoint b = simplex[1];
+	const SupportPoint c = simplex[0];
+	const Vector3 ab = b.P - a.P;
+	const Vector3 ac = c.P - a.P;
+	const Vector3 ao = -a.P;
+	const Vector3 abc = cross(ab, ac);
+
+	if (dot(cross(abc, ac), ao) > 0.0f)
 	{
-		/* Vertex region A. */
-		barycentricCoords[0] = 1.0f;
-		dimension = 1;
-	}
-	else if (uab < 0.0f && vbc <= 0.0f)
-	{
-		/* Vertex region B. */
-		simplex[0] = simplex[1];
-		barycentricCoords[0] = 1.0f;
-		dimension = 1;
-	}
-	else if (ubc <= 0.0f && vca <= 0.0f)
-	{
-		/* Vertex region C. */
-		simplex[0] = simplex[2];
-		barycentricCoords[0] = 1.0f;
-		dimension = 1;
-	}
-	else
-	{
-		/* Calculate the area of the face regions. */
-		const Vector3 n = cross(ba, ca);
-		const float uabc = box(n, simplex[1], simplex[2]);
-		const float vabc = box(n, simplex[2], simplex[0]);
-		const float wabc = box(n, simplex[0], simplex[1]);
-
-		/* The point is not in one of the vertex regions, so move on to the next highest feature, lines, and then the face. */
-		if (uab > 0.0f && vab > 0.0f && wabc <= 0.0f)
+		if (dot(ac, ao) > 0.0f)
 		{
-			/* Region AB. */
-			barycentricCoords[0] = uab;
-			barycentricCoords[1] = vab;
-			dimension = 2;
-		}
-		else if (ubc > 0.0f && vbc > 0.0f && uabc <= 0.0f)
-		{
-			/* Region BC. */
-			simplex[0] = simplex[1];
-			simplex[1] = simplex[2];
-			barycentricCoords[0] = ubc;
-			barycentricCoords[1] = vbc;
-			dimension = 2;
-		}
-		else if (uca > 0.0f && vca > 0.0f && vabc <= 0.0f)
-		{
-			/* Region CA. */
-			simplex[1] = simplex[0];
-			simplex[0] = simplex[2];
-			barycentricCoords[0] = uca;
-			barycentricCoords[1] = vca;
+			/* Line region AC. */
+			simplex[0] = c;
+			simplex[1] = a;
 			dimension = 2;
+			supportDir = cross(cross(ac, ao), ac);
+			return false;
 		}
+	}
+	else if (dot(cross(ab, abc), ao) <= 0.0f)
+	{
+		/* Face region ABC, the winding is flipped if the origin is below the triangle. */
+		if (dot(abc, ao) > 0.0f) supportDir = abc;
 		else
 		{
-			/* Face region ABC. */
-			barycentricCoords[0] = uabc;
-			barycentricCoords[1] = vabc;
-			barycentricCoords[2] = wabc;
-			dimension = 3;
+			simplex[0] = b;
+			simplex[1] = c;
+			supportDir = -abc;
 		}
+
+		return false;
 	}
+
+	/* Line region AB or vertex region A. */
+	simplex[0] = b;
+	simplex[1] = a;
+	dimension = 2;
+	return NearestLine();
 }
 
-void Pu::GJK::NearestTetrahedron(void)
+bool Pu::GJK::NearestTetrahedron(void)
 {
-	/* Get the unnormalized barycentric coordinates for the line segments in the triangle. */
-	const Vector3 ab = simplex[0] - simplex[1];
-	const Vector3 ba = simplex[1] - simplex[0];
-	const Vector3 bc = simplex[1] - simplex[2];
-	const Vector3 cb = simplex[2] - simplex[1];
-	const Vector3 ca = simplex[2] - simplex[0];
-	const Vector3 ac = simplex[0] - simplex[2];
-	const Vector3 db = simplex[3] - simplex[1];
-	const Vector3 bd = simplex[1] - simplex[3];
-	const Vector3 dc = simplex[3] - simplex[2];
-	const Vector3 cd = simplex[2] - simplex[3];
-	const Vector3 da = simplex[3] - simplex[0];
-	const Vector3 ad = simplex[0] - simplex[3];
-
-	const float uab = dot(simplex[1], ba);
-	const float vab = dot(simplex[0], ab);
-	const float ubc = dot(simplex[2], cb);
-	const float vbc = dot(simplex[1], bc);
-	const float uca = dot(simplex[0], ac);
-	const float vca = dot(simplex[2], ca);
-	const float ubd = dot(simplex[3], db);
-	const float vbd = dot(simplex[1], bd);
-	const float udc = dot(simplex[2], cd);
-	const float vdc = dot(simplex[3], dc);
-	const float uad = dot(simplex[3], da);
-	const float vad = dot(simplex[0], ad);
-
-	if (vab <= 0.0f && uca <= 0.0f && vad <= 0.0f)
+	const SupportPoint a = simplex[3];
+	const SupportPoint b = simplex[2];
+	const SupportPoint c = simplex[1];
+	const SupportPoint d = simplex[0];
+	const Vector3 ao = -a.P;
+
+	/* Calculate the face normals, making sure they point away from the opposing vertex. */
+	Vector3 abc = cross(b.P - a.P, c.P - a.P);
+	Vector3 acd = cross(c.P - a.P, d.P - a.P);
+	Vector3 adb = cross(d.P - a.P, b.P - a.P);
+	if (dot(abc, d.P - a.P) > 0.0f) abc = -abc;
+	if (dot(acd, b.P - a.P) > 0.0f) acd = -acd;
+	if (dot(adb, c.P - a.P) > 0.0f) adb = -adb;
+
+	/* Check whether the origin is outside of any of the faces, the face opposite of A was already checked. */
+	if (dot(abc, ao) > 0.0f)
 	{
-		/* Vertex region A. */
-		barycentricCoords[0] = 1.0f;
-		dimension = 1;
+		simplex[0] = c;
+		simplex[1] = b;
 	}
-	else if (uab <= 0.0f && vbc <= 0.0f && vbd <= 0.0f)
+	else if (dot(acd, ao) > 0.0f)
 	{
-		/* Vertex region B. */
-		simplex[0] = simplex[1];
-		barycentricCoords[0] = 1.0f;
-		dimension = 1;
+		simplex[0] = d;
+		simplex[1] = c;
 	}
-	else if (ubc <= 0.0f && vca <= 0.0f && udc <= 0.0f)
+	else if (dot(adb, ao) > 0.0f)
 	{
-		/* Vertex region C. */
-		simplex[0] = simplex[2];
-		barycentricCoords[0] = 1.0f;
-		dimension = 1;
+		simplex[0] = b;
+		simplex[1] = d;
 	}
-	else if (ubd <= 0.0f && vdc <= 0.0f && uad <= 0.0f)
-	{
-		/* Vertex region D. */
-		simplex[0] = simplex[3];
-		barycentricCoords[0] = 1.0f;
-		dimension = 1;
-	}
-	else
+	else return true;
+
+	/* Region ABC, ACD or ADB. */
+	simplex[2] = a;
+	dimension = 3;
+	return NearestTriangle();
+}
+
+void Pu::GJK::AddEdge(uint32 a, uint32 b)
+{
+	/* If the reverse edge is already in the list then the edge is shared by two removed faces, so it's not on the horizon. */
+	for (size_t i = 0; i < edges.size(); i++)
 	{
-		/* Calculate the area of the face regions. */
-		Vector3 n = cross(da, ba);
-		const float uadb = box(n, simplex[3], simplex[1]);
-		const float vadb = box(n, simplex[1], simplex[0]);
-		const float wadb = box(n, simplex[0], simplex[3]);
-
-		n = cross(ca, da);
-		const float uacd = box(n, simplex[2], simplex[3]);
-		const float vacd = box(n, simplex[3], simplex[0]);
-		const float wacd = box(n, simplex[0], simplex[2]);
-
-		n = cross(bc, dc);
-		const float ucbd = box(n, simplex[1], simplex[3]);
-		const float vcbd = box(n, simplex[3], simplex[2]);
-		const float wcbd = box(n, simplex[2], simplex[3]);
-
-		n = cross(ba, ca);
-		const float uabc = box(n, simplex[1], simplex[2]);
-		const float vabc = box(n, simplex[2], simplex[0]);
-		const float wabc = box(n, simplex[0], simplex[1]);
-
-		/* The location was not in a vertex region so we move on to test line regions. */
-		if (wabc <= 0.0f && vadb <= 0.0f && uab > 0.0f && vab > 0.0f)
-		{
-			/* Line region AB. */
-			barycentricCoords[0] = uab;
-			barycentricCoords[1] = vab;
-			dimension = 2;
-		}
-		else if (uabc <= 0.0f && wcbd <= 0.0f && ubc > 0.0f && vbc > 0.0f)
-		{
-			/* Line region BC. */
-			simplex[0] = simplex[1];
-			simplex[1] = simplex[2];
-			barycentricCoords[0] = ubc;
-			barycentricCoords[1] = vbc;
-			dimension = 2;
-		}
-		else if (vabc <= 0.0f && wacd <= 0.0f && uca > 0.0f && vca > 0.0f)
-		{
-			/* Line region CA. */
-			simplex[1] = simplex[0];
-			simplex[0] = simplex[2];
-			barycentricCoords[0] = uca;
-			barycentricCoords[1] = vca;
-			dimension = 2;
-		}
-		else if (vcbd <= 0.0f && uacd <= 0.0f && udc > 0.0f && vdc > 0.0f)
+		if (edges[i].first == b && edges[i].second == a)
 		{
-			/* Line region DC. */
-			simplex[0] = simplex[3];
-			simplex[1] = simplex[2];
-			barycentricCoords[0] = uad;
-			barycentricCoords[1] = vad;
-			dimension = 2;
-		}
-		else if (vacd <= 0.0f && wadb <= 0.0f && uad > 0.0f && vad > 0.0f)
-		{
-			/* Line region AD. */
-			simplex[1] = simplex[3];
-			barycentricCoords[0] = uad;
-			barycentricCoords[1] = vad;
-			dimension = 2;
-		}
-		else if (ucbd <= 0.0f && uadb <= 0.0f && ubd > 0.0f && ubd > 0.0f)
-		{
-			/* Line region BD. */
-			simplex[0] = simplex[1];
-			simplex[1] = simplex[3];
-			barycentricCoords[0] = ubd;
-			barycentricCoords[1] = vbd;
-			dimension = 2;
-		}
-		else
-		{
-			/* Calculate the volume of the tetrahedron regions. */
-			const float denom = box(db, cb, ab);
-			const float volume = denom == 0.0f ? 1.0f : recip(denom);
-			const float uabcd = box(simplex[1], simplex[2], simplex[3]) * volume;
-			const float vabcd = box(simplex[3], simplex[2], simplex[0]) * volume;
-			const float wabcd = box(simplex[1], simplex[3], simplex[0]) * volume;
-			const float xabcd = box(simplex[2], simplex[1], simplex[0]) * volume;
-
-			/* The point also wasn't in a line region, so we move on to triangle regions, and the tetrahedron last. */
-			if (xabcd < 0.0f && uabc > 0.0f && vabc > 0.0f && wabc > 0.0f)
-			{
-				/* Face region ABC. */
-				barycentricCoords[0] = uabc;
-				barycentricCoords[1] = vabc;
-				barycentricCoords[2] = wabc;
-				dimension = 3;
-			}
-			else if (uabcd < 0.0f && ucbd > 0.0f && vcbd > 0.0f && wcbd > 0.0f)
-			{
-				/* Face region CBD. */
-				simplex[0] = simplex[2];
-				simplex[2] = simplex[3];
-				barycentricCoords[0] = ucbd;
-				barycentricCoords[1] = vcbd;
-				barycentricCoords[2] = wcbd;
-				dimension = 3;
-			}
-			else if (vabcd < 0.0f && uacd > 0.0f && vacd > 0.0f && wacd > 0.0f)
-			{
-				/* Face region ACD. */
-				simplex[1] = simplex[2];
-				simplex[2] = simplex[3];
-				barycentricCoords[0] = uacd;
-				barycentricCoords[1] = vacd;
-				barycentricCoords[2] = wacd;
-				dimension = 3;
-			}
-			else if (wabcd < 0.0f && uadb > 0.0f && vadb > 0.0f && wadb > 0.0f)
-			{
-				/* Face region ADB. */
-				simplex[2] = simplex[1];
-				simplex[1] = simplex[3];
-				barycentricCoords[0] = uadb;
-				barycentricCoords[1] = vadb;
-				barycentricCoords[2] = wadb;
-				dimension = 3;
-			}
-			else
-			{
-				/* Region ABCD. */
-				barycentricCoords[0] = uabcd;
-				barycentricCoords[1] = vabcd;
-				barycentricCoords[2] = wabcd;
-				barycentricCoords[3] = xabcd;
-				dimension = 4;
-			}
+			edges.removeAt(i);
+			return;
 		}
 	}
+
+	edges.emplace_back(a, b);
 }
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "Physics/Systems/IslandSystem.h"
+#include "Physics/Systems/MovementSystem.h"
+#include "Physics/Systems/ContactSystem.h"
+#include "Physics/Systems/PhysicalWorld.h"
+#include "Core/Diagnostics/Profiler.h"
+#include "Streams/BinaryWriter.h"
+#include "Streams/BinaryReader.h"
+#include "Config.h"
+
+/* Defines the island identifier used for objects that are awake. */
+constexpr Pu::uint32 IslandAwake = ~0u;
+
+Pu::IslandSystem::IslandSystem(PhysicalWorld & world)
+	: world(&world), sleepingIslands(0)
+{}
+
+void Pu::IslandSystem::AddItem(void)
+{
+	parents.emplace_back(static_cast<uint32>(parents.size()));
+	sleepIslands.emplace_back(IslandAwake);
+	restSteps.emplace_back(static_cast<uint16>(0));
+}
+
+void Pu::IslandSystem::RemoveItem(PhysicsHandle handle)
+{
+	if (physics_get_type(handle) != PhysicsType::Kinematic) return;
+	const uint32 idx = physics_get_lookup_id(handle);
+
+	/*
+	Removing an object from a sleeping pile might leave the other objects unsupported.
+	So wake the entire island that the object was part of.
+	*/
+	const uint32 island = sleepIslands[idx];
+	if (island != IslandAwake)
+	{
+		for (uint32 i = 0; i < sleepIslands.size(); i++)
+		{
+			if (sleepIslands[i] == island)
+			{
+				world->sysMove->Wake(i);
+				sleepIslands[i] = IslandAwake;
+				restSteps[i] = 0;
+			}
+		}
+
+		--sleepingIslands;
+	}
+
+	parents.removeAt(idx);
+	sleepIslands.removeAt(idx);
+	restSteps.removeAt(idx);
+
+	/* The island identifiers are object indices, so they need to be shifted just like the handles. */
+	for (uint32 &cur : sleepIslands)
+	{
+		cur -= cur != IslandAwake && cur > idx;
+	}
+}
+
+/*
+Sleeping objects don't generate contacts amongst each other,
+so they keep the island they were in when they fell asleep.
+
+foreach object
+	parent = self
+	if sleeping
+		union(object, island)
+
+foreach contact between kinematic objects
+	union(first, second)
+
+foreach island
+	if any object is awake
+		wake all objects
+
+The contacts are then grouped per island so they can be solved independently.
+*/
+void Pu::IslandSystem::Build(void)
+{
+	if constexpr (ProfileWorldSystems) Profiler::Begin("Islands", Color::Abbey());
+
+	const ContactSystem &cnst = *world->sysCnst;
+	const MovementSystem &move = *world->sysMove;
+	const uint32 count = static_cast<uint32>(parents.size());
+	const size_t contactCount = cnst.hfirsts.size();
+
+	for (uint32 i = 0; i < count; i++) parents[i] = i;
+	for (uint32 i = 0; i < count; i++)
+	{
+		if (sleepIslands[i] != IslandAwake) Union(i, sleepIslands[i]);
+	}
+
+	/* Static objects would merge everything that rests on the same floor, so ignore those contacts. */
+	for (size_t i = 0; i < contactCount; i++)
+	{
+		const PhysicsHandle hfirst = cnst.hfirsts[i];
+		const PhysicsHandle hsecond = cnst.hseconds[i];
+
+		if (physics_get_type(hfirst) == PhysicsType::Kinematic && physics_get_type(hsecond) == PhysicsType::Kinematic)
+		{
+			Union(world->QueryInternalIndex(hfirst), world->QueryInternalIndex(hsecond));
+		}
+	}
+
+	/* An island is awake as soon as one of its members is awake. */
+	awake.assign(count, false);
+	for (uint32 i = 0; i < count; i++)
+	{
+		if (!move.IsSleeping(i)) awake[Find(i)] = true;
+	}
+
+	/* Wake the members of any sleeping island that was touched and assign the island indices. */
+	lut.resize(count);
+	offsets.clear();
+	offsets.emplace_back(0u);
+	sleepingIslands = 0;
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		const uint32 root = Find(i);
+		if (sleepIslands[i] != IslandAwake && awake[root])
+		{
+			world->sysMove->Wake(i);
+			sleepIslands[i] = IslandAwake;
+			restSteps[i] = 0;
+		}
+
+		if (root == i)
+		{
+			lut[i] = static_cast<uint32>(offsets.size() - 1);
+			offsets.emplace_back(0u);
+			sleepingIslands += !awake[i];
+		}
+	}
+
+	/* Count the amount of contacts per island (the second object is always the kinematic one unless both are). */
+	for (size_t i = 0; i < contactCount; i++)
+	{
+		const PhysicsHandle hkinematic = physics_get_type(cnst.hseconds[i]) == PhysicsType::Kinematic ? cnst.hseconds[i] : cnst.hfirsts[i];
+		++offsets[lut[Find(world->QueryInternalIndex(hkinematic))] + 1];
+	}
+
+	/* Convert the counts to offsets, use the start offsets as cursors and shift them back afterwards. */
+	for (size_t i = 1; i < offsets.size(); i++) offsets[i] += offsets[i - 1];
+	contacts.resize(contactCount);
+
+	for (size_t i = 0; i < contactCount; i++)
+	{
+		const PhysicsHandle hkinematic = physics_get_type(cnst.hseconds[i]) == PhysicsType::Kinematic ? cnst.hseconds[i] : cnst.hfirsts[i];
+		contacts[offsets[lut[Find(world->QueryInternalIndex(hkinematic))]]++] = static_cast<uint32>(i);
+	}
+
+	for (size_t i = offsets.size() - 1; i > 0; i--) offsets[i] = offsets[i - 1];
+	offsets[0] = 0;
+
+	if constexpr (ProfileWorldSystems) Profiler::End();
+}
+
+void Pu::IslandSystem::TrySleep(void)
+{
+	if constexpr (PhysicsAllowSleeping)
+	{
+		if constexpr (ProfileWorldSystems) Profiler::Begin("Islands", Color::Abbey());
+
+		MovementSystem &move = *world->sysMove;
+		const uint32 count = static_cast<uint32>(parents.size());
+
+		/* Objects need to be resting for multiple steps, otherwise objects would fall asleep at the top of their arc. */
+		for (uint32 i = 0; i < count; i++)
+		{
+			if (!move.IsResting(i)) restSteps[i] = 0;
+			else if (restSteps[i] < PhysicsIslandSleepSteps) ++restSteps[i];
+		}
+
+		/* Reuse the awake buffer to mark any island that has a member that's not ready to sleep. */
+		awake.assign(count, false);
+		for (uint32 i = 0; i < count; i++)
+		{
+			if (restSteps[i] < PhysicsIslandSleepSteps) awake[Find(i)] = true;
+		}
+
+		/* Put all the members of the resting islands to sleep. */
+		for (uint32 i = 0; i < count; i++)
+		{
+			const uint32 root = Find(i);
+			if (awake[root] || sleepIslands[i] != IslandAwake) continue;
+
+			move.Sleep(i);
+			sleepIslands[i] = root;
+			sleepingIslands += root == i;
+		}
+
+		if constexpr (ProfileWorldSystems) Profiler::End();
+	}
+}
+
+/* The islands themselves are rebuilt every step, so only the sleeping state needs to be stored. */
+void Pu::IslandSystem::Snapshot(BinaryWriter & writer) const
+{
+	writer.Write(static_cast<uint64>(sleepingIslands));
+	writer.Write(reinterpret_cast<const byte*>(sleepIslands.data()), 0, sleepIslands.size() * sizeof(uint32));
+	writer.Write(reinterpret_cast<const byte*>(restSteps.data()), 0, restSteps.size() * sizeof(uint16));
+}
+
+void Pu::IslandSystem::Restore(BinaryReader & reader)
+{
+	sleepingIslands = static_cast<size_t>(reader.ReadUInt64());
+
+	size_t bytes = reader.Read(reinterpret_cast<byte*>(sleepIslands.data()), 0, sleepIslands.size() * sizeof(uint32));
+	bytes += reader.Read(reinterpret_cast<byte*>(restSteps.data()), 0, restSteps.size() * sizeof(uint16));
+	if (bytes != sleepIslands.size() * sizeof(uint32) + restSteps.size() * sizeof(uint16)) Log::Fatal("Unable to restore island system (snapshot is truncated)!");
+}
+
+Pu::uint32 Pu::IslandSystem::Find(uint32 idx)
+{
+	/* Path halving keeps the trees flat without needing recursion. */
+	while (parents[idx] != idx)
+	{
+		parents[idx] = parents[parents[idx]];
+		idx = parents[idx];
+	}
+
+	return idx;
+}
+
+void Pu::IslandSystem::Union(uint32 idx1, uint32 idx2)
+{
+	idx1 = Find(idx1);
+	idx2 = Find(idx2);
+
+	/* Always use the lowest index as the root, this makes the islands independent of the contact order. */
+	if (idx1 < idx2) parents[idx2] = idx1;
+	else if (idx2 < idx1) parents[idx1] = idx2;
+}
\ No newline at end of file
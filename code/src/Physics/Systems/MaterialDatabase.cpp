@@ -0,0 +1,62 @@
+#include "Physics/Systems/MaterialDatabase.h"
+#include "Core/Math/Basics.h"
+
+static inline float combine(Pu::CombineMode mode, float a, float b)
+{
+	switch (mode)
+	{
+	case Pu::CombineMode::Minimum:
+		return Pu::min(a, b);
+	case Pu::CombineMode::Maximum:
+		return Pu::max(a, b);
+	case Pu::CombineMode::Multiply:
+		return a * b;
+	case Pu::CombineMode::GeometricMean:
+		return sqrtf(a * b);
+	default:
+		return (a + b) * 0.5f;
+	}
+}
+
+/* These modes match the combinations that the solver used before the table was added. */
+Pu::MaterialDatabase::MaterialDatabase(void)
+	: modeCoR(CombineMode::Minimum), modeCoF(CombineMode::GeometricMean)
+{}
+
+Pu::PhysicsHandle Pu::MaterialDatabase::Add(const PhysicalProperties & properties)
+{
+	/* Material handles start at one, becasue all zeros is the null handle. */
+	materials.emplace_back(properties);
+	Rebuild();
+
+	return create_physics_handle(PhysicsType::Material, materials.size());
+}
+
+void Pu::MaterialDatabase::SetCombineModes(CombineMode restitutionMode, CombineMode frictionMode)
+{
+	modeCoR = restitutionMode;
+	modeCoF = frictionMode;
+	Rebuild();
+}
+
+/*
+The stride of the tables is the amount of materials, so all pair indices change when a material is added.
+Materials are only added during loading and there are only a handful, so simply rebuild the entire table.
+*/
+void Pu::MaterialDatabase::Rebuild(void)
+{
+	const size_t count = materials.size();
+	restitution.resize(count * count);
+	friction.resize(count * count);
+
+	for (size_t i = 0, k = 0; i < count; i++)
+	{
+		const MechanicalProperties &mat1 = materials[i].Mechanical;
+		for (size_t j = 0; j < count; j++, k++)
+		{
+			const MechanicalProperties &mat2 = materials[j].Mechanical;
+			restitution[k] = combine(modeCoR, mat1.CoR, mat2.CoR);
+			friction[k] = combine(modeCoF, mat1.CoFk, mat2.CoFk);
+		}
+	}
+}
\ No newline at end of file
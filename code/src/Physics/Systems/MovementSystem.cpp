@@ -2,12 +2,43 @@
 #include "Core/Diagnostics/Profiler.h"
 #include "Core/Math/Vector3_SIMD.h"
 #include "Core/Math/Vector4_SIMD.h"
+#include "Core/Threading/Tasks/ParallelFor.h"
+#include "Streams/BinaryWriter.h"
+#include "Streams/BinaryReader.h"
 #include "Config.h"
 
-#define alloc_tmp(size)		reinterpret_cast<Pu::AVX_FLOAT_UNION*>(_aligned_malloc(sizeof(Pu::ofloat) * size, sizeof(Pu::ofloat)))
+/*
+We need to put a mask of all ones into the sleep buffers for awake objects.
+So use an union to create that constant.
+*/
+static const union
+{
+	Pu::uint32 u;
+	float f;
+} awakeMask{ ~0u };
+
+/* Defines the lane indices needed to left pack the set lanes of an AVX mask, AVX2 has no compress store so this emulates it. */
+static const struct CompressLut
+{
+	alignas(32) Pu::int32 Indices[256][8];
+
+	CompressLut(void)
+	{
+		for (Pu::int32 mask = 0; mask < 256; mask++)
+		{
+			Pu::int32 j = 0;
+			for (Pu::int32 i = 0; i < 8; i++)
+			{
+				if (mask & (1 << i)) Indices[mask][j++] = i;
+			}
+
+			while (j < 8) Indices[mask][j++] = 0;
+		}
+	}
+} compressLut;
 
 Pu::MovementSystem::MovementSystem(void)
-	: Gx(_mm256_setzero_ps()), Gy(_mm256_set1_ps(-9.81f)), Gz(_mm256_setzero_ps())
+	: Gx(_mm256_setzero_ps()), Gy(_mm256_set1_ps(-9.81f)), Gz(_mm256_setzero_ps()), movedCnt(0)
 {}
 
 void Pu::MovementSystem::AddOffset(size_t idx, Vector3 offset)
@@ -17,6 +48,11 @@ void Pu::MovementSystem::AddOffset(size_t idx, Vector3 offset)
 	pz.add(idx, offset.Z);
 }
 
+void Pu::MovementSystem::SetTimeOfImpact(size_t idx, float toi)
+{
+	impacts.emplace_back(static_cast<uint32>(idx), toi);
+}
+
 void Pu::MovementSystem::AddForce(size_t idx, float x, float y, float z, float pitch, float yaw, float roll)
 {
 	/* Add the linear force to the velocity. */
@@ -32,16 +68,6 @@ void Pu::MovementSystem::AddForce(size_t idx, float x, float y, float z, float p
 
 size_t Pu::MovementSystem::AddItem(Vector3 p, Vector3 v, Quaternion theta, Vector3 omega, Vector3 scale, float CoD, float imass, const Matrix3 &moi)
 {
-	/* 
-	We need to put a mask of all ones into the affected by gravity buffer. 
-	So use an union to create that constant.
-	*/
-	static union
-	{
-		uint32 u;
-		float f;
-	} cnvrt{ ~0u };
-
 	const float *mat = moi.GetComponents();
 
 	cod.push(CoD);
@@ -73,7 +99,8 @@ size_t Pu::MovementSystem::AddItem(Vector3 p, Vector3 v, Quaternion theta, Vecto
 	qx.push(p.X);
 	qy.push(p.Y);
 	qz.push(p.Z);
-	sleep.push(cnvrt.f);
+	sleep.push(awakeMask.f);
+	rest.push(awakeMask.f);
 	scales.emplace_back(scale);
 
 	return cod.size() - 1;
@@ -111,139 +138,235 @@ void Pu::MovementSystem::RemoveItem(PhysicsHandle handle)
 		qx.erase(idx);
 		qy.erase(idx);
 		qz.erase(idx);
-		sleep.erase(idx); 
+		sleep.erase(idx);
+		rest.erase(idx);
 		scales.removeAt(idx);
+
+		/* The moved objects are indices that need to be updated just like the handles. */
+		size_t j = 0;
+		for (size_t i = 0; i < movedCnt; i++)
+		{
+			if (moved[i] != idx) moved[j++] = moved[i] - (moved[i] > idx);
+		}
+
+		movedCnt = j;
+
+		/* The same goes for the objects that were moved to their time of impact. */
+		j = 0;
+		for (size_t i = 0; i < impacts.size(); i++)
+		{
+			if (impacts[i].first != idx) impacts[j++] = std::make_pair(impacts[i].first - (impacts[i].first > idx), impacts[i].second);
+		}
+
+		impacts.resize(j);
 	}
 }
 
-void Pu::MovementSystem::ApplyGravity(ofloat dt)
-{
-	if constexpr (ProfileWorldSystems) Profiler::Begin("Movement", Color::Gray());
+/*
+The integration is done in a single pass over all the lanes, this is done to minimize the memory bandwidth.
+The world forces (gravity and drag) are applied at the end of the step, this is the same as applying them
+at the start of the next step, but it means we only have to stream the velocities through the cache once.
 
-	const size_t size = vx.simd_size();
-	for (size_t i = 0; i < size; i++) vx[i] = _mm256_and_ps(_mm256_add_ps(vx[i], _mm256_mul_ps(Gx, dt)), sleep[i]);
-	for (size_t i = 0; i < size; i++) vy[i] = _mm256_and_ps(_mm256_add_ps(vy[i], _mm256_mul_ps(Gy, dt)), sleep[i]);
-	for (size_t i = 0; i < size; i++) vz[i] = _mm256_and_ps(_mm256_add_ps(vz[i], _mm256_mul_ps(Gz, dt)), sleep[i]);
+Objects that were moved to their time of impact by the continuous collision sweep are moved back by that part of the step,
+this uses the velocity after the solver, so only the remaining (1 - toi) part of the step is integrated with the resolved velocity.
 
-	if constexpr (ProfileWorldSystems) Profiler::End();
-}
+Sleeping objects have no velocity and ignore gravity, so integrating them doesn't change anything.
+The lanes of which every object is sleeping are skipped entirely, which is the case for most lanes of a sleeping island.
 
-void Pu::MovementSystem::ApplyDrag(ofloat dt)
+gather lanes with an awake object
+foreach object in awake lanes
+	rest = velocity < epsilon
+	integrate position and orientation
+	if distance(p, q) > max distance
+		q = p
+		add current object to moved objects
+	add gravity and drag to the velocity
+*/
+void Pu::MovementSystem::Integrate(ofloat dt, ofloat epsilon)
 {
 	if constexpr (ProfileWorldSystems) Profiler::Begin("Movement", Color::Gray());
 
-	const size_t size = vx.simd_size();
-	const ofloat zero = _mm256_set1_ps(0.0f);
+	/* Make sure that the moved buffer can store the entire SIMD range, as the compress store writes full lanes. */
+	const size_t simdSize = vx.simd_size();
+	if (moved.size() < simdSize << 3) moved.resize(simdSize << 3);
+	if (lanes.size() < simdSize) lanes.resize(simdSize);
 
-	ofloat xx, yy, zz;
-	ofloat ll, l, ld;
-	ofloat fx, fy, fz;
+	/* There are very few of these objects, so this is cheaper than adding a step fraction lane to the integration. */
+	for (const auto [idx, toi] : impacts) AddOffset(idx, GetVelocity(idx) * (-toi * _mm256_cvtss_f32(dt)));
+	impacts.clear();
 
-	/* Apply linear drag. */
-	for (size_t i = 0; i < size; i++)
+	/* The sleep mask is zero for sleeping objects, so a lane can be skipped if none of its bits are set. */
+	size_t size = 0;
+	for (size_t i = 0; i < simdSize; i++)
 	{
-		ofloat &x = vx[i];
-		ofloat &y = vy[i];
-		ofloat &z = vz[i];
-
-		xx = _mm256_mul_ps(x, x);
-		yy = _mm256_mul_ps(y, y);
-		zz = _mm256_mul_ps(z, z);
-
-		/*
-		Calculate the following values:
-		- Square magnitude of velocity (ll).
-		- Magnitude of velocity (l).
-		- Aerodynamic drag scalar (ld).
-		*/
-		ll = _mm256_add_ps(_mm256_add_ps(xx, yy), zz);
-		l = _mm256_andnot_ps(_mm256_cmp_ps(zero, ll, _CMP_EQ_OQ), _mm256_rsqrt_ps(ll));
-		ld = _mm256_mul_ps(ll, cod[i]);
-
-		/* Calculate the aerodynamic force to apply. */
-		fx = _mm256_mul_ps(_mm256_mul_ps(x, l), ld);
-		fy = _mm256_mul_ps(_mm256_mul_ps(y, l), ld);
-		fz = _mm256_mul_ps(_mm256_mul_ps(z, l), ld);
-
-		/* Apply the force scaled with delta time. */
-		x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_mul_ps(m[i], dt)));
-		y = _mm256_sub_ps(y, _mm256_mul_ps(fy, _mm256_mul_ps(m[i], dt)));
-		z = _mm256_sub_ps(z, _mm256_mul_ps(fz, _mm256_mul_ps(m[i], dt)));
+		lanes[size] = static_cast<uint32>(i);
+		size += _mm256_movemask_ps(sleep[i]) != 0;
 	}
 
-	/* Apply angular drag. */
-	for (size_t i = 0; i < size; i++)
+	const size_t chunks = (size + PhysicsChunkSize - 1) / PhysicsChunkSize;
+	if (chunkCounts.size() < chunks) chunkCounts.resize(chunks);
+
+	if (size)
 	{
-		ofloat &pitch = wp[i];
-		ofloat &yaw = wy[i];
-		ofloat &roll = wr[i];
-
-		xx = _mm256_mul_ps(pitch, pitch);
-		yy = _mm256_mul_ps(yaw, yaw);
-		zz = _mm256_mul_ps(roll, roll);
-
-		ll = _mm256_add_ps(_mm256_add_ps(xx, yy), zz);
-		l = _mm256_andnot_ps(_mm256_cmp_ps(zero, ll, _CMP_EQ_OQ), _mm256_rsqrt_ps(ll));
-		ld = _mm256_mul_ps(ll, cod[i]);
-
-		const ofloat fx2 = _mm256_mul_ps(_mm256_mul_ps(pitch, l), ld);
-		const ofloat fy2 = _mm256_mul_ps(_mm256_mul_ps(yaw, l), ld);
-		const ofloat fz2 = _mm256_mul_ps(_mm256_mul_ps(roll, l), ld);
-
-		/* Multiply by the moment of inertia tensor (inline mat3 * vec3). */
-		fx = _mm256_add_ps(_mm256_mul_ps(fx2, m00[i]), _mm256_add_ps(_mm256_mul_ps(fy2, m10[i]), _mm256_mul_ps(fz2, m20[i])));
-		fy = _mm256_add_ps(_mm256_mul_ps(fx2, m01[i]), _mm256_add_ps(_mm256_mul_ps(fy2, m11[i]), _mm256_mul_ps(fz2, m21[i])));
-		fz = _mm256_add_ps(_mm256_mul_ps(fx2, m02[i]), _mm256_add_ps(_mm256_mul_ps(fy2, m12[i]), _mm256_mul_ps(fz2, m22[i])));
-
-		pitch = _mm256_sub_ps(pitch, _mm256_mul_ps(fx, dt));
-		yaw = _mm256_sub_ps(yaw, _mm256_mul_ps(fy, dt));
-		roll = _mm256_sub_ps(roll, _mm256_mul_ps(fz, dt));
+		ParallelFor(size, PhysicsChunkSize, [this, dt, epsilon](size_t start, size_t end)
+		{
+			chunkCounts[start / PhysicsChunkSize] = IntegrateChunk(start, end, dt, epsilon);
+		});
+	}
+
+	/* The chunks write their moved objects at the start of their own range, so pack them together. */
+	movedCnt = chunks ? chunkCounts[0] : 0;
+	for (size_t i = 1; i < chunks; i++)
+	{
+		memmove(moved.data() + movedCnt, moved.data() + ((i * PhysicsChunkSize) << 3), chunkCounts[i] * sizeof(uint32));
+		movedCnt += chunkCounts[i];
 	}
 
 	if constexpr (ProfileWorldSystems) Profiler::End();
 }
 
-void Pu::MovementSystem::Integrate(ofloat dt)
+Pu::uint32 Pu::MovementSystem::IntegrateChunk(size_t start, size_t end, ofloat dt, ofloat epsilon)
 {
-	if constexpr (ProfileWorldSystems) Profiler::Begin("Movement", Color::Gray());
-
-	const size_t size = vx.simd_size();
 	const ofloat zero = _mm256_setzero_ps();
 	const ofloat half = _mm256_set1_ps(0.5f);
 	const ofloat neg = _mm256_set1_ps(-1.0f);
+	const ofloat minMag = _mm256_mul_ps(epsilon, epsilon);
+	const ofloat gx = _mm256_mul_ps(Gx, dt);
+	const ofloat gy = _mm256_mul_ps(Gy, dt);
+	const ofloat gz = _mm256_mul_ps(Gz, dt);
+
+	/*
+	Pre-calculate the square distance.
+	The expansion is done using an inflate operation.
+	So the maximum distance in any direction is half of the actual expansion.
+	*/
+	const ofloat maxDist = _mm256_set1_ps(sqr(KinematicExpansion * 0.5f));
+
+	/* The last SIMD lane might not be fully used, so mask out the unused objects. */
+	const size_t last = vx.simd_size() - 1;
+	const uint32 tail = 0xFF >> ((8 - (vx.size() & 0x7)) & 0x7);
 
-	/* Add linear velocity to position (scaled by delta time). */
-	for (size_t i = 0; i < size; i++) px[i] = _mm256_add_ps(px[i], _mm256_mul_ps(vx[i], dt));
-	for (size_t i = 0; i < size; i++) py[i] = _mm256_add_ps(py[i], _mm256_mul_ps(vy[i], dt));
-	for (size_t i = 0; i < size; i++) pz[i] = _mm256_add_ps(pz[i], _mm256_mul_ps(vz[i], dt));
+	uint32 *result = moved.data() + (start << 3);
+	uint32 cnt = 0;
 
-	for (size_t i = 0; i < size; i++)
+	ofloat ll, l, ld;
+	ofloat fx, fy, fz;
+
+	for (size_t j = start; j < end; j++)
 	{
+		const size_t i = lanes[j];
+		ofloat x = vx[i], y = vy[i], z = vz[i];
+		ofloat pitch = wp[i], yaw = wy[i], roll = wr[i];
+
+		/* Check whether the object has come to rest, this uses the velocity after the solver. */
+		if constexpr (PhysicsAllowSleeping) rest[i] = _mm256_cmp_ps(_mm256_len2_v3(x, y, z), minMag, _CMP_GT_OQ);
+
+		/* Add linear velocity to position (scaled by delta time). */
+		const ofloat npx = _mm256_add_ps(px[i], _mm256_mul_ps(x, dt));
+		const ofloat npy = _mm256_add_ps(py[i], _mm256_mul_ps(y, dt));
+		const ofloat npz = _mm256_add_ps(pz[i], _mm256_mul_ps(z, dt));
+		px[i] = npx;
+		py[i] = npy;
+		pz[i] = npz;
+
 		/* Convert angular velocity into quaterion for (R = 0).*/
-		const ofloat qi = _mm256_mul_ps(_mm256_mul_ps(wp[i], dt), half);
-		const ofloat qj = _mm256_mul_ps(_mm256_mul_ps(wy[i], dt), half);
-		const ofloat qk = _mm256_mul_ps(_mm256_mul_ps(wr[i], dt), half);
-
-		/* Quaternion multiplication in AVX (R = 0). */
-		const ofloat dr = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(qi, ti[i]), _mm256_add_ps(_mm256_mul_ps(qj, tj[i]), _mm256_mul_ps(qk, tk[i]))), neg);
-		const ofloat di = _mm256_add_ps(_mm256_mul_ps(qi, tr[i]), _mm256_sub_ps(_mm256_mul_ps(qj, tk[i]), _mm256_mul_ps(qk, tj[i])));
-		const ofloat dj = _mm256_add_ps(_mm256_mul_ps(qj, tr[i]), _mm256_sub_ps(_mm256_mul_ps(qk, ti[i]), _mm256_mul_ps(qi, tk[i])));
-		const ofloat dk = _mm256_add_ps(_mm256_mul_ps(qk, tr[i]), _mm256_sub_ps(_mm256_mul_ps(qi, tj[i]), _mm256_mul_ps(qj, ti[i])));
-
-		/* Add angular velocity to orientation. */
-		ti[i] = _mm256_add_ps(ti[i], di);
-		tj[i] = _mm256_add_ps(tj[i], dj);
-		tk[i] = _mm256_add_ps(tk[i], dk);
-		tr[i] = _mm256_add_ps(tr[i], dr);
-
-		/* 
-		Normalize orientation. 
-		Make sure to do this after and not before applying angular velocity.
-		*/
-		_mm256_norm_v4(ti[i], tj[i], tk[i], tr[i], zero);
+		{
+			ofloat i1 = ti[i], j1 = tj[i], k1 = tk[i], r1 = tr[i];
+			const ofloat qi = _mm256_mul_ps(_mm256_mul_ps(pitch, dt), half);
+			const ofloat qj = _mm256_mul_ps(_mm256_mul_ps(yaw, dt), half);
+			const ofloat qk = _mm256_mul_ps(_mm256_mul_ps(roll, dt), half);
+
+			/* Quaternion multiplication in AVX (R = 0). */
+			const ofloat dr = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(qi, i1), _mm256_add_ps(_mm256_mul_ps(qj, j1), _mm256_mul_ps(qk, k1))), neg);
+			const ofloat di = _mm256_add_ps(_mm256_mul_ps(qi, r1), _mm256_sub_ps(_mm256_mul_ps(qj, k1), _mm256_mul_ps(qk, j1)));
+			const ofloat dj = _mm256_add_ps(_mm256_mul_ps(qj, r1), _mm256_sub_ps(_mm256_mul_ps(qk, i1), _mm256_mul_ps(qi, k1)));
+			const ofloat dk = _mm256_add_ps(_mm256_mul_ps(qk, r1), _mm256_sub_ps(_mm256_mul_ps(qi, j1), _mm256_mul_ps(qj, i1)));
+
+			/* Add angular velocity to orientation. */
+			i1 = _mm256_add_ps(i1, di);
+			j1 = _mm256_add_ps(j1, dj);
+			k1 = _mm256_add_ps(k1, dk);
+			r1 = _mm256_add_ps(r1, dr);
+
+			/*
+			Normalize orientation.
+			Make sure to do this after and not before applying angular velocity.
+			*/
+			_mm256_norm_v4(i1, j1, k1, r1, zero);
+			ti[i] = i1;
+			tj[i] = j1;
+			tk[i] = k1;
+			tr[i] = r1;
+		}
+
+		/* Check whether the distance between the current position and the cached position is greater than the maximum. */
+		{
+			const ofloat d = _mm256_len2_v3(_mm256_sub_ps(qx[i], npx), _mm256_sub_ps(qy[i], npy), _mm256_sub_ps(qz[i], npz));
+			const ofloat mask = _mm256_cmp_ps(d, maxDist, _CMP_GT_OQ);
+
+			/* The old location needs to be overriden when it reaches this point. */
+			qx[i] = _mm256_blendv_ps(qx[i], npx, mask);
+			qy[i] = _mm256_blendv_ps(qy[i], npy, mask);
+			qz[i] = _mm256_blendv_ps(qz[i], npz, mask);
+
+			/* Left pack the indices of the moved objects into the result buffer. */
+			const uint32 bits = static_cast<uint32>(_mm256_movemask_ps(mask)) & (i == last ? tail : 0xFF);
+			const int256 idx = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32>(i << 3)), _mm256_load_si256(reinterpret_cast<const int256*>(compressLut.Indices[bits])));
+			_mm256_storeu_si256(reinterpret_cast<int256*>(result + cnt), idx);
+			cnt += _mm_popcnt_u32(bits);
+		}
+
+		/* Add the gravitational force to the objects, this is ignored for sleeping objects. */
+		x = _mm256_and_ps(_mm256_add_ps(x, gx), sleep[i]);
+		y = _mm256_and_ps(_mm256_add_ps(y, gy), sleep[i]);
+		z = _mm256_and_ps(_mm256_add_ps(z, gz), sleep[i]);
+
+		/* Apply linear drag. */
+		{
+			/*
+			Calculate the following values:
+			- Square magnitude of velocity (ll).
+			- Magnitude of velocity (l).
+			- Aerodynamic drag scalar (ld).
+			*/
+			ll = _mm256_len2_v3(x, y, z);
+			l = _mm256_andnot_ps(_mm256_cmp_ps(zero, ll, _CMP_EQ_OQ), _mm256_rsqrt_ps(ll));
+			ld = _mm256_mul_ps(ll, cod[i]);
+
+			/* Calculate the aerodynamic force to apply. */
+			fx = _mm256_mul_ps(_mm256_mul_ps(x, l), ld);
+			fy = _mm256_mul_ps(_mm256_mul_ps(y, l), ld);
+			fz = _mm256_mul_ps(_mm256_mul_ps(z, l), ld);
+
+			/* Apply the force scaled with delta time. */
+			const ofloat mdt = _mm256_mul_ps(m[i], dt);
+			vx[i] = _mm256_sub_ps(x, _mm256_mul_ps(fx, mdt));
+			vy[i] = _mm256_sub_ps(y, _mm256_mul_ps(fy, mdt));
+			vz[i] = _mm256_sub_ps(z, _mm256_mul_ps(fz, mdt));
+		}
+
+		/* Apply angular drag. */
+		{
+			ll = _mm256_len2_v3(pitch, yaw, roll);
+			l = _mm256_andnot_ps(_mm256_cmp_ps(zero, ll, _CMP_EQ_OQ), _mm256_rsqrt_ps(ll));
+			ld = _mm256_mul_ps(ll, cod[i]);
+
+			const ofloat fx2 = _mm256_mul_ps(_mm256_mul_ps(pitch, l), ld);
+			const ofloat fy2 = _mm256_mul_ps(_mm256_mul_ps(yaw, l), ld);
+			const ofloat fz2 = _mm256_mul_ps(_mm256_mul_ps(roll, l), ld);
+
+			/* Multiply by the moment of inertia tensor (inline mat3 * vec3). */
+			fx = _mm256_add_ps(_mm256_mul_ps(fx2, m00[i]), _mm256_add_ps(_mm256_mul_ps(fy2, m10[i]), _mm256_mul_ps(fz2, m20[i])));
+			fy = _mm256_add_ps(_mm256_mul_ps(fx2, m01[i]), _mm256_add_ps(_mm256_mul_ps(fy2, m11[i]), _mm256_mul_ps(fz2, m21[i])));
+			fz = _mm256_add_ps(_mm256_mul_ps(fx2, m02[i]), _mm256_add_ps(_mm256_mul_ps(fy2, m12[i]), _mm256_mul_ps(fz2, m22[i])));
+
+			wp[i] = _mm256_sub_ps(pitch, _mm256_mul_ps(fx, dt));
+			wy[i] = _mm256_sub_ps(yaw, _mm256_mul_ps(fy, dt));
+			wr[i] = _mm256_sub_ps(roll, _mm256_mul_ps(fz, dt));
+		}
 	}
 
-	if constexpr (ProfileWorldSystems) Profiler::End();
+	return cnt;
 }
 
 Pu::Matrix Pu::MovementSystem::GetTransform(PhysicsHandle handle) const
@@ -278,92 +401,91 @@ Pu::Vector3 Pu::MovementSystem::GetAngularVelocity(size_t idx) const
 	return Vector3(wp.get(idx), wy.get(idx), wr.get(idx));
 }
 
-/*
-foreach object
-	if distance(p, q) > max distance
-		q = p
-		add current object to result
-*/
-void Pu::MovementSystem::CheckDistance(vector<size_t> & result) const
+void Pu::MovementSystem::Sleep(size_t idx)
 {
-	const size_t size_avx = vx.simd_size();
-	const size_t size = vx.size();
+	/* Make sure that the object doesn't have any residual motion once it's woken. */
+	vx.set(idx, 0.0f);
+	vy.set(idx, 0.0f);
+	vz.set(idx, 0.0f);
+	wp.set(idx, 0.0f);
+	wy.set(idx, 0.0f);
+	wr.set(idx, 0.0f);
+	sleep.set(idx, 0.0f);
+	rest.set(idx, 0.0f);
+}
 
-	/*
-	Pre-calculate the square distance.
-	The expansion is done using an inflate operation.
-	So the maximum distance in any direction is half of the actual expansion.
-	*/
-	const ofloat maxDist = _mm256_set1_ps(sqr(KinematicExpansion * 0.5f));
+void Pu::MovementSystem::Wake(size_t idx)
+{
+	sleep.set(idx, awakeMask.f);
+	rest.set(idx, awakeMask.f);
+}
 
-	AVX_FLOAT_UNION *masks = alloc_tmp(size_avx);
-	for (size_t i = 0; i < size_avx; i++)
-	{
-		/* Calculate the distance between the current position and the previous. */
-		const ofloat sx = _mm256_sub_ps(qx[i], px[i]);
-		const ofloat sy = _mm256_sub_ps(qy[i], py[i]);
-		const ofloat sz = _mm256_sub_ps(qz[i], pz[i]);
-		const ofloat d = _mm256_len2_v3(sx, sy, sz);
-
-		/* Check whether the distance is greater than the maximum. */
-		masks[i].SIMD = _mm256_cmp_ps(d, maxDist, _CMP_GT_OQ);
-	}
+size_t Pu::MovementSystem::GetSleepingCount(void) const
+{
+	size_t remaining = sleep.size();
+	size_t result = sleep.size();
 
-	/* Convert the AVX type to normal floats and add them to the result buffer. */
-	for (size_t i = 0; i < size; i++)
+	size_t mask;
+	for (ofloat cur : sleep)
 	{
-		const size_t j = i >> 0x3;
-		const size_t k = i & 0x7;
-
-		if (masks[j].V[k])
-		{
-			/* The old location needs to be overriden when it reaches this point. */
-			qx.set(i, px.get(i));
-			qy.set(i, py.get(i));
-			qz.set(i, pz.get(i));
-
-			/* Return both the index and the new location. */
-			result.emplace_back(i);
-		}
+		mask = 0xFF >> (remaining < 8) * (8 - (remaining & 0x7));
+		result -= _mm_popcnt_u32(_mm256_movemask_ps(cur) & mask);
+		remaining -= 8;
 	}
 
-	_aligned_free(masks);
+	return result;
 }
 
-void Pu::MovementSystem::TrySleep(ofloat epsilon)
+size_t Pu::MovementSystem::GetMemoryUsage(void) const
 {
-	if constexpr (PhysicsAllowSleeping)
-	{
-		if constexpr (ProfileWorldSystems) Profiler::Begin("Movement", Color::Gray());
+	/* The moved and lane buffers are included, as the integration uses them every step. */
+	const avxf_vector *components[] = { &cod, &m, &m00, &m01, &m02, &m10, &m11, &m12, &m20, &m21, &m22, &px, &py, &pz, &qx, &qy, &qz, &vx, &vy, &vz, &sleep, &rest, &ti, &tj, &tk, &tr, &wp, &wy, &wr };
 
-		/* Predefine the minimum distance for us to consider the object sleepable. */
-		const size_t size_avx = vx.simd_size();
-		const size_t size = vx.size();
-		const ofloat minMag = _mm256_mul_ps(epsilon, epsilon);
+	size_t result = transforms.size() * sizeof(Matrix) + scales.size() * sizeof(Vector3) + (moved.size() + lanes.size()) * sizeof(uint32);
+	for (const avxf_vector *cur : components) result += cur->simd_size() * sizeof(ofloat);
+	return result;
+}
 
-		/* Populate a temporary buffer with the compared distances. */
-		for (size_t i = 0; i < size_avx; i++)
-		{
-			const ofloat d = _mm256_len2_v3(vx[i], vy[i], vz[i]);
-			sleep[i] = _mm256_cmp_ps(d, minMag, _CMP_GT_OQ);
-		}
+/*
+Only the state that changes during simulation is stored in the snapshot.
+The mass, moment of inertia and static transforms can only be changed by adding or removing objects,
+so they are assumed to be equal to the ones at the time the snapshot was taken.
+The SoA lanes are copied as is, so the cost of a snapshot is just a memcpy per component.
+*/
+void Pu::MovementSystem::Snapshot(BinaryWriter & writer) const
+{
+	writer.Write(static_cast<uint64>(vx.size()));
+	writer.Write(static_cast<uint64>(movedCnt));
+	writer.Write(reinterpret_cast<const byte*>(&Gx), 0, sizeof(ofloat));
+	writer.Write(reinterpret_cast<const byte*>(&Gy), 0, sizeof(ofloat));
+	writer.Write(reinterpret_cast<const byte*>(&Gz), 0, sizeof(ofloat));
 
-		if constexpr (ProfileWorldSystems) Profiler::End();
+	for (const avxf_vector *lanes : { &cod, &m, &px, &py, &pz, &qx, &qy, &qz, &vx, &vy, &vz, &sleep, &rest, &ti, &tj, &tk, &tr, &wp, &wy, &wr })
+	{
+		writer.Write(reinterpret_cast<const byte*>(lanes->data()), 0, lanes->simd_size() * sizeof(ofloat));
 	}
+
+	/* The moved objects are used by the contact system at the start of the next step. */
+	writer.Write(reinterpret_cast<const byte*>(moved.data()), 0, movedCnt * sizeof(uint32));
 }
 
-size_t Pu::MovementSystem::GetSleepingCount(void) const
+void Pu::MovementSystem::Restore(BinaryReader & reader)
 {
-	size_t remaining = sleep.size();
-	size_t result = sleep.size();
+	if (reader.ReadUInt64() != vx.size()) Log::Fatal("Unable to restore movement system (kinematic object count differs from snapshot)!");
+	movedCnt = static_cast<size_t>(reader.ReadUInt64());
 
-	size_t mask;
-	for (ofloat cur : sleep)
+	size_t bytes = 0;
+	bytes += reader.Read(reinterpret_cast<byte*>(&Gx), 0, sizeof(ofloat));
+	bytes += reader.Read(reinterpret_cast<byte*>(&Gy), 0, sizeof(ofloat));
+	bytes += reader.Read(reinterpret_cast<byte*>(&Gz), 0, sizeof(ofloat));
+
+	for (avxf_vector *lanes : { &cod, &m, &px, &py, &pz, &qx, &qy, &qz, &vx, &vy, &vz, &sleep, &rest, &ti, &tj, &tk, &tr, &wp, &wy, &wr })
 	{
-		mask = 0xFF >> (remaining < 8) * (8 - (remaining & 0x7));
-		result -= _mm_popcnt_u32(_mm256_movemask_ps(cur) & mask);
-		remaining -= 8;
+		bytes += reader.Read(reinterpret_cast<byte*>(lanes->data()), 0, lanes->simd_size() * sizeof(ofloat));
 	}
 
-	return result;
+	if (moved.size() < movedCnt) moved.resize(movedCnt);
+	bytes += reader.Read(reinterpret_cast<byte*>(moved.data()), 0, movedCnt * sizeof(uint32));
+
+	if (bytes != (3 + 20 * vx.simd_size()) * sizeof(ofloat) + movedCnt * sizeof(uint32)) Log::Fatal("Unable to restore movement system (snapshot is truncated)!");
 }
\ No newline at end of file
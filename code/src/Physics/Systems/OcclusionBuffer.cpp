@@ -0,0 +1,246 @@
+#include "Physics/Systems/OcclusionBuffer.h"
+#include "Core/Threading/Tasks/ParallelFor.h"
+#include "Core/Math/Vector3_SIMD.h"
+
+/* Defines the width (in pixels) of a single rasterization tile, this must be a multiple of 8. */
+constexpr Pu::uint32 OcclusionTileWidth = 64;
+/* Defines the height (in pixels) of a single rasterization tile. */
+constexpr Pu::uint32 OcclusionTileHeight = 32;
+
+/* Gets whether the specified clip space position is in front of the near plane. */
+static inline bool occlusion_in_front(Pu::Vector4 p)
+{
+	return p.W > 0.0f && p.Z >= -p.W;
+}
+
+/* Converts the specified clip space position to screen space (with the depth stored in Z). */
+static inline Pu::Vector3 occlusion_to_screen(Pu::Vector4 p, Pu::Vector2 scale)
+{
+	const float iw = 1.0f / p.W;
+	return Pu::Vector3((p.X * iw + 1.0f) * scale.X, (p.Y * iw + 1.0f) * scale.Y, p.Z * iw);
+}
+
+Pu::OcclusionBuffer::OcclusionBuffer(uint32 width, uint32 height)
+	: width(width), height(height),
+	tilesX((width + OcclusionTileWidth - 1) / OcclusionTileWidth),
+	tilesY((height + OcclusionTileHeight - 1) / OcclusionTileHeight)
+{
+#ifdef _DEBUG
+	if (width & 0x7) Log::Fatal("The width of an occlusion buffer must be a multiple of 8!");
+#endif
+
+	depth.resize(static_cast<size_t>(width) * height, maxv<float>());
+	bins.resize(static_cast<size_t>(tilesX) * tilesY);
+}
+
+void Pu::OcclusionBuffer::Clear(const Matrix & viewProjection)
+{
+	vp = viewProjection;
+	std::fill(depth.begin(), depth.end(), maxv<float>());
+
+	triangles.clear();
+	for (vector<uint32> &bin : bins) bin.clear();
+}
+
+/*
+Triangles that cross the near plane are skipped instead of clipped,
+this only makes the buffer less effective but it never hides a visible object.
+The remaining triangles are binned into every tile that their screen bounds overlap.
+*/
+void Pu::OcclusionBuffer::Add(const Occluder & occluder, const Matrix & transform)
+{
+	const Matrix mvp = vp * transform;
+	const Vector2 scale{ width * 0.5f, height * 0.5f };
+
+	/* Project all the vertices first, as most vertices are shared between multiple triangles. */
+	projected.clear();
+	for (Vector3 v : occluder.Vertices) projected.emplace_back(mvp * Vector4(v, 1.0f));
+
+	for (size_t i = 0; i + 2 < occluder.Indices.size(); i += 3)
+	{
+		const Vector4 a = projected[occluder.Indices[i]];
+		const Vector4 b = projected[occluder.Indices[i + 1]];
+		const Vector4 c = projected[occluder.Indices[i + 2]];
+		if (!occlusion_in_front(a) || !occlusion_in_front(b) || !occlusion_in_front(c)) continue;
+
+		const Triangle triangle{ occlusion_to_screen(a, scale), occlusion_to_screen(b, scale), occlusion_to_screen(c, scale) };
+		const float minX = min(triangle.A.X, min(triangle.B.X, triangle.C.X));
+		const float minY = min(triangle.A.Y, min(triangle.B.Y, triangle.C.Y));
+		const float maxX = max(triangle.A.X, max(triangle.B.X, triangle.C.X));
+		const float maxY = max(triangle.A.Y, max(triangle.B.Y, triangle.C.Y));
+
+		/* Skip the triangle if it's fully off screen. */
+		if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height) continue;
+
+		const uint32 tx0 = static_cast<uint32>(max(0.0f, minX)) / OcclusionTileWidth;
+		const uint32 ty0 = static_cast<uint32>(max(0.0f, minY)) / OcclusionTileHeight;
+		const uint32 tx1 = static_cast<uint32>(min(width - 1.0f, maxX)) / OcclusionTileWidth;
+		const uint32 ty1 = static_cast<uint32>(min(height - 1.0f, maxY)) / OcclusionTileHeight;
+
+		const uint32 idx = static_cast<uint32>(triangles.size());
+		triangles.emplace_back(triangle);
+
+		for (uint32 y = ty0; y <= ty1; y++)
+		{
+			for (uint32 x = tx0; x <= tx1; x++) bins[y * tilesX + x].emplace_back(idx);
+		}
+	}
+}
+
+void Pu::OcclusionBuffer::Rasterize(void)
+{
+	if (triangles.empty()) return;
+
+	/* Every tile owns its own pixels, so the tiles can be rasterized without any synchronization. */
+	ParallelFor(bins.size(), 1, [this](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++) RasterizeTile(static_cast<uint32>(i));
+	});
+}
+
+/*
+The box is projected to the screen and its screen bounds are tested against the depth buffer.
+The box is visible if any of the pixels in its bounds is further away than the closest point of the box.
+*/
+bool Pu::OcclusionBuffer::IsVisible(const AABB & box) const
+{
+	/* Precalculate all the corners of the axis aligned bounding box. */
+	const ofloat cx = _mm256_set_ps(box.LowerBound.X, box.UpperBound.X, box.UpperBound.X, box.LowerBound.X, box.LowerBound.X, box.LowerBound.X, box.UpperBound.X, box.UpperBound.X);
+	const ofloat cy = _mm256_set_ps(box.LowerBound.Y, box.LowerBound.Y, box.UpperBound.Y, box.UpperBound.Y, box.UpperBound.Y, box.LowerBound.Y, box.LowerBound.Y, box.UpperBound.Y);
+	const ofloat cz = _mm256_set_ps(box.LowerBound.Z, box.LowerBound.Z, box.LowerBound.Z, box.LowerBound.Z, box.UpperBound.Z, box.UpperBound.Z, box.UpperBound.Z, box.UpperBound.Z);
+
+	/* Transform the corners to clip space (the matrix is column-major). */
+	const float *m = vp.GetComponents();
+	const ofloat x = _mm256_add_ps(_mm256_dot_v3(cx, cy, cz, _mm256_set1_ps(m[0]), _mm256_set1_ps(m[4]), _mm256_set1_ps(m[8])), _mm256_set1_ps(m[12]));
+	const ofloat y = _mm256_add_ps(_mm256_dot_v3(cx, cy, cz, _mm256_set1_ps(m[1]), _mm256_set1_ps(m[5]), _mm256_set1_ps(m[9])), _mm256_set1_ps(m[13]));
+	const ofloat z = _mm256_add_ps(_mm256_dot_v3(cx, cy, cz, _mm256_set1_ps(m[2]), _mm256_set1_ps(m[6]), _mm256_set1_ps(m[10])), _mm256_set1_ps(m[14]));
+	const ofloat w = _mm256_add_ps(_mm256_dot_v3(cx, cy, cz, _mm256_set1_ps(m[3]), _mm256_set1_ps(m[7]), _mm256_set1_ps(m[11])), _mm256_set1_ps(m[15]));
+
+	/* Boxes that are fully behind the near plane are clipped and boxes that cross it are always considered visible. */
+	const ofloat zero = _mm256_setzero_ps();
+	const ofloat behind = _mm256_or_ps(_mm256_cmp_ps(w, zero, _CMP_LE_OQ), _mm256_cmp_ps(z, _mm256_sub_ps(zero, w), _CMP_LT_OQ));
+	const int32 clipped = _mm256_movemask_ps(behind);
+	if (clipped == 0xFF) return false;
+	if (clipped) return true;
+
+	/* Convert the corners to screen space. */
+	const ofloat one = _mm256_set1_ps(1.0f);
+	const ofloat iw = _mm256_div_ps(one, w);
+	float sx[8], sy[8], sz[8];
+	_mm256_storeu_ps(sx, _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(x, iw), one), _mm256_set1_ps(width * 0.5f)));
+	_mm256_storeu_ps(sy, _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(y, iw), one), _mm256_set1_ps(height * 0.5f)));
+	_mm256_storeu_ps(sz, _mm256_mul_ps(z, iw));
+
+	float minX = sx[0], minY = sy[0], maxX = sx[0], maxY = sy[0], minZ = sz[0];
+	for (uint32 i = 1; i < 8; i++)
+	{
+		minX = min(minX, sx[i]);
+		minY = min(minY, sy[i]);
+		maxX = max(maxX, sx[i]);
+		maxY = max(maxY, sy[i]);
+		minZ = min(minZ, sz[i]);
+	}
+
+	/* The box cannot be visible if it's completely off screen. */
+	if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height) return false;
+
+	const uint32 x0 = static_cast<uint32>(max(0.0f, minX));
+	const uint32 y0 = static_cast<uint32>(max(0.0f, minY));
+	const uint32 x1 = static_cast<uint32>(min(width - 1.0f, maxX));
+	const uint32 y1 = static_cast<uint32>(min(height - 1.0f, maxY));
+	const ofloat nearest = _mm256_set1_ps(minZ);
+
+	for (uint32 py = y0; py <= y1; py++)
+	{
+		const float *row = depth.data() + py * width;
+		for (uint32 px = x0 & ~0x7u; px <= x1; px += 8)
+		{
+			/* Mask out the pixels that are outside of the screen bounds of the box. */
+			const uint32 lanes = (0xFF << (px < x0 ? x0 - px : 0)) & (0xFF >> (px + 7 > x1 ? px + 7 - x1 : 0));
+			const uint32 visible = static_cast<uint32>(_mm256_movemask_ps(_mm256_cmp_ps(nearest, _mm256_loadu_ps(row + px), _CMP_LE_OQ)));
+			if (visible & lanes) return true;
+		}
+	}
+
+	return false;
+}
+
+void Pu::OcclusionBuffer::RasterizeTile(uint32 tile)
+{
+	const uint32 x = (tile % tilesX) * OcclusionTileWidth;
+	const uint32 y = (tile / tilesX) * OcclusionTileHeight;
+	const uint32 x1 = min(x + OcclusionTileWidth, width) - 1;
+	const uint32 y1 = min(y + OcclusionTileHeight, height) - 1;
+
+	for (uint32 i : bins[tile]) RasterizeTriangle(triangles[i], x, y, x1, y1);
+}
+
+/*
+The triangle is rasterized with edge functions evaluated at the pixel centers, 8 pixels at a time.
+The depth is interpolated with a plane equation and only the closest depth is kept.
+
+calculate the edge and depth plane equations
+foreach row in the bounds of the triangle (clamped to the tile)
+	foreach 8 pixels in the row
+		inside = all edge functions >= 0
+		depth = min(depth, z) where inside
+*/
+void Pu::OcclusionBuffer::RasterizeTriangle(const Triangle & triangle, uint32 minX, uint32 minY, uint32 maxX, uint32 maxY)
+{
+	Vector3 a = triangle.A, b = triangle.B, c = triangle.C;
+
+	/* Occluders are double sided, so make sure that all triangles are wound the same way. */
+	float area = (b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X);
+	if (fabsf(area) < EPSILON) return;
+	if (area < 0.0f)
+	{
+		std::swap(b, c);
+		area = -area;
+	}
+
+	/* Calculate the edge functions (A * x + B * y + C) of the three edges, these are also the unnormalized barycentric coordinates. */
+	const float a0 = b.Y - c.Y, b0 = c.X - b.X, c0 = (c.Y - b.Y) * b.X - (c.X - b.X) * b.Y;
+	const float a1 = c.Y - a.Y, b1 = a.X - c.X, c1 = (a.Y - c.Y) * c.X - (a.X - c.X) * c.Y;
+	const float a2 = a.Y - b.Y, b2 = b.X - a.X, c2 = (b.Y - a.Y) * a.X - (b.X - a.X) * a.Y;
+
+	/* The interpolated depth is also a plane equation in screen space. */
+	const float ia = 1.0f / area;
+	const float az = (a0 * a.Z + a1 * b.Z + a2 * c.Z) * ia;
+	const float bz = (b0 * a.Z + b1 * b.Z + b2 * c.Z) * ia;
+	const float cz = (c0 * a.Z + c1 * b.Z + c2 * c.Z) * ia;
+
+	/* Clamp the bounds of the triangle to the tile, the start is aligned to 8 pixels (just like the tile). */
+	const uint32 x0 = static_cast<uint32>(max(static_cast<float>(minX), min(a.X, min(b.X, c.X)))) & ~0x7u;
+	const uint32 y0 = static_cast<uint32>(max(static_cast<float>(minY), min(a.Y, min(b.Y, c.Y))));
+	const uint32 x1 = static_cast<uint32>(min(static_cast<float>(maxX), max(a.X, max(b.X, c.X))));
+	const uint32 y1 = static_cast<uint32>(min(static_cast<float>(maxY), max(a.Y, max(b.Y, c.Y))));
+
+	const ofloat zero = _mm256_setzero_ps();
+	const ofloat offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+	const ofloat ea0 = _mm256_set1_ps(a0), ea1 = _mm256_set1_ps(a1), ea2 = _mm256_set1_ps(a2), eaz = _mm256_set1_ps(az);
+
+	for (uint32 y = y0; y <= y1; y++)
+	{
+		/* The vertical part of the edge functions is constant over the row. */
+		const float py = y + 0.5f;
+		const ofloat r0 = _mm256_set1_ps(b0 * py + c0);
+		const ofloat r1 = _mm256_set1_ps(b1 * py + c1);
+		const ofloat r2 = _mm256_set1_ps(b2 * py + c2);
+		const ofloat rz = _mm256_set1_ps(bz * py + cz);
+		float *row = depth.data() + y * width;
+
+		for (uint32 x = x0; x <= x1; x += 8)
+		{
+			const ofloat px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), offsets);
+			const ofloat w0 = _mm256_add_ps(_mm256_mul_ps(ea0, px), r0);
+			const ofloat w1 = _mm256_add_ps(_mm256_mul_ps(ea1, px), r1);
+			const ofloat w2 = _mm256_add_ps(_mm256_mul_ps(ea2, px), r2);
+			const ofloat inside = _mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GE_OQ), _mm256_and_ps(_mm256_cmp_ps(w1, zero, _CMP_GE_OQ), _mm256_cmp_ps(w2, zero, _CMP_GE_OQ)));
+
+			/* Only keep the closest depth of the pixels that are inside of the triangle. */
+			const ofloat z = _mm256_add_ps(_mm256_mul_ps(eaz, px), rz);
+			const ofloat d = _mm256_loadu_ps(row + x);
+			_mm256_storeu_ps(row + x, _mm256_blendv_ps(d, _mm256_min_ps(d, z), inside));
+		}
+	}
+}
\ No newline at end of file
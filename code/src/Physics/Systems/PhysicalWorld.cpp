@@ -4,8 +4,12 @@
 #include "Physics/Systems/RenderingSystem.h"
 #include "Physics/Systems/MovementSystem.h"
 #include "Physics/Systems/ContactSystem.h"
+#include "Physics/Systems/IslandSystem.h"
 #include "Core/Diagnostics/Profiler.h"
+#include "Core/Threading/Tasks/ParallelFor.h"
 #include "Core/Math/Vector3_SIMD.h"
+#include "Streams/BinaryWriter.h"
+#include "Streams/BinaryReader.h"
 
 #ifdef _DEBUG
 #include <imgui/include/imgui.h>
@@ -15,8 +19,141 @@ const char *STEP_MODES[2] = { "Auto", "Manual" };
 
 #define nameof(x)			#x
 
+/* Defines the state passed to the BVH callbacks of the spatial queries. */
+struct QueryContext
+{
+	const Pu::ContactSystem *Contacts;
+	Pu::SpatialQuery *Query;
+	Pu::vector<Pu::QueryCollider> *Candidates;
+};
+
+static bool resolve_overlap_sphere(Pu::SpatialQuery &query, const Pu::QueryCollider &collider)
+{
+	if (query.Count >= query.Capacity) return false;
+
+	if (Pu::ContactSystem::Overlaps(collider, query.QuerySphere)) query.Result[query.Count++] = collider.Handle;
+	return query.Count < query.Capacity;
+}
+
+static bool resolve_overlap_obb(Pu::SpatialQuery &query, const Pu::QueryCollider &collider)
+{
+	if (query.Count >= query.Capacity) return false;
+
+	if (Pu::ContactSystem::Overlaps(collider, query.QueryBox)) query.Result[query.Count++] = collider.Handle;
+	return query.Count < query.Capacity;
+}
+
+/*
+Conservative advancement is used to skip the empty space in front of the object.
+The distance to the collider never overestimates, so the sphere can't pass through the object.
+This is limited in steps, as the advancement slows down near the object (or near the bounds of a height map).
+The rest of the path is sampled in steps of the sphere radius, so the sampled spheres always overlap and nothing can be skipped.
+The first step that overlaps the object is then refined with a bisection.
+Only the part of the path before the current closest hit needs to be checked.
+*/
+static bool resolve_sweep_sphere(Pu::SpatialQuery &query, const Pu::QueryCollider &collider)
+{
+	/* The sphere already overlaps the object at the start, so no sweep is needed. */
+	const Pu::Sphere &sphere = query.QuerySphere;
+	if (Pu::ContactSystem::Overlaps(collider, sphere))
+	{
+		query.Result[0] = collider.Handle;
+		query.Count = 1;
+		query.Time = 0.0f;
+		return false;
+	}
+
+	const float len = query.Displacement.Length();
+	if (len <= 0.0f) return true;
+
+	/* Advance until the sphere is less than a step away from the collider. */
+	float t0 = 0.0f;
+	for (Pu::uint32 i = 0; i < Pu::PhysicsMaxSweepSteps && t0 < query.Time; i++)
+	{
+		const float d = Pu::ContactSystem::GetDistance(collider, sphere.Center + query.Displacement * t0) - sphere.Radius;
+		if (d < sphere.Radius) break;
+		t0 += d / len;
+	}
+
+	/* Sample the remaining path, the next float is used if the step is too small to advance the time. */
+	const float step = sphere.Radius / len;
+	for (float t1; t0 < query.Time; t0 = t1)
+	{
+		t1 = Pu::min(Pu::max(t0 + step, nextafterf(t0, 2.0f)), query.Time);
+		if (!Pu::ContactSystem::Overlaps(collider, Pu::Sphere{ sphere.Center + query.Displacement * t1, sphere.Radius })) continue;
+
+		for (Pu::uint32 j = 0; j < Pu::PhysicsSweepRefinements; j++)
+		{
+			const float t = (t0 + t1) * 0.5f;
+			if (Pu::ContactSystem::Overlaps(collider, Pu::Sphere{ sphere.Center + query.Displacement * t, sphere.Radius })) t1 = t;
+			else t0 = t;
+		}
+
+		query.Result[0] = collider.Handle;
+		query.Count = 1;
+		query.Time = t1;
+		return true;
+	}
+
+	return true;
+}
+
+/* Tests the query against a single collider, returns whether the query should continue. */
+static bool resolve_query(Pu::SpatialQuery &query, const Pu::QueryCollider &collider)
+{
+	switch (query.Type)
+	{
+	case Pu::QueryType::OverlapSphere:
+		return resolve_overlap_sphere(query, collider);
+	case Pu::QueryType::OverlapOBB:
+		return resolve_overlap_obb(query, collider);
+	case Pu::QueryType::SweepSphere:
+		return resolve_sweep_sphere(query, collider);
+	default:
+		return false;
+	}
+}
+
+/*
+Batched queries only copy the colliders of the candidates, so they can be tested after the lock is released.
+Height maps are too big to copy, so they are always tested directly.
+*/
+static bool visit_query(Pu::PhysicsHandle hobj, void *userParam)
+{
+	const QueryContext &ctx = *reinterpret_cast<const QueryContext*>(userParam);
+	if (!ctx.Contacts->Passes(hobj, ctx.Query->Filter)) return true;
+
+	const Pu::QueryCollider collider = ctx.Contacts->GetCollider(hobj);
+	if (ctx.Candidates && !collider.Terrain)
+	{
+		ctx.Candidates->emplace_back(collider);
+		return true;
+	}
+
+	return resolve_query(*ctx.Query, collider);
+}
+
+static float get_query_distance(Pu::PhysicsHandle hobj, const void *userParam)
+{
+	const QueryContext &ctx = *reinterpret_cast<const QueryContext*>(userParam);
+	return ctx.Contacts->Passes(hobj, ctx.Query->Filter) ? Pu::ContactSystem::GetDistance(ctx.Contacts->GetCollider(hobj), ctx.Query->QuerySphere.Center) : -1.0f;
+}
+
+Pu::PhysicalWorld::PhysicalWorld(void)
+	: System(), Substeps(1), Deterministic(false), accumulator(0.0f), sysRender(nullptr)
+#ifdef _DEBUG
+	, stepMode(STEP_MODES[0])
+#endif
+{
+	db = new MaterialDatabase();
+	sysMove = new MovementSystem();
+	sysSolv = new ContactSolverSystem(*this);
+	sysCnst = new ContactSystem(*this);
+	sysIsland = new IslandSystem(*this);
+}
+
 Pu::PhysicalWorld::PhysicalWorld(DeferredRenderer & renderer)
-	: System(), Substeps(1)
+	: System(), Substeps(1), Deterministic(false), accumulator(0.0f)
 #ifdef _DEBUG
 	, stepMode(STEP_MODES[0])
 #endif
@@ -25,13 +162,15 @@ Pu::PhysicalWorld::PhysicalWorld(DeferredRenderer & renderer)
 	sysMove = new MovementSystem();
 	sysSolv = new ContactSolverSystem(*this);
 	sysCnst = new ContactSystem(*this);
+	sysIsland = new IslandSystem(*this);
 	sysRender = new RenderingSystem(*this, renderer);
 }
 
 Pu::PhysicalWorld::PhysicalWorld(PhysicalWorld && value)
 	: System(std::move(value)), db(value.db), sysMove(value.sysMove), sysCnst(value.sysCnst),
-	sysSolv(value.sysSolv), searchTree(std::move(value.searchTree)),
-	handleLut(std::move(value.handleLut)), Substeps(value.Substeps)
+	sysSolv(value.sysSolv), sysIsland(value.sysIsland), sysRender(value.sysRender), searchTree(std::move(value.searchTree)),
+	handleLut(std::move(value.handleLut)), Substeps(value.Substeps),
+	Deterministic(value.Deterministic), accumulator(value.accumulator)
 {
 	value.lock.lock();
 
@@ -39,6 +178,8 @@ Pu::PhysicalWorld::PhysicalWorld(PhysicalWorld && value)
 	value.sysMove = nullptr;
 	value.sysCnst = nullptr;
 	value.sysSolv = nullptr;
+	value.sysIsland = nullptr;
+	value.sysRender = nullptr;
 
 	value.lock.unlock();
 }
@@ -52,10 +193,14 @@ Pu::PhysicalWorld & Pu::PhysicalWorld::operator=(PhysicalWorld && other)
 		Destroy();
 
 		Substeps = other.Substeps;
+		Deterministic = other.Deterministic;
+		accumulator = other.accumulator;
 		db = other.db;
 		sysMove = other.sysMove;
 		sysCnst = other.sysCnst;
 		sysSolv = other.sysSolv;
+		sysIsland = other.sysIsland;
+		sysRender = other.sysRender;
 		searchTree = std::move(other.searchTree);
 		handleLut = std::move(other.handleLut);
 
@@ -63,6 +208,8 @@ Pu::PhysicalWorld & Pu::PhysicalWorld::operator=(PhysicalWorld && other)
 		other.sysMove = nullptr;
 		other.sysCnst = nullptr;
 		other.sysSolv = nullptr;
+		other.sysIsland = nullptr;
+		other.sysRender = nullptr;
 
 		other.lock.unlock();
 		lock.unlock();
@@ -75,7 +222,7 @@ Pu::PhysicsHandle Pu::PhysicalWorld::AddStatic(const PhysicalObject & obj, const
 {
 	lock.lock();
 	const PhysicsHandle result = AddInternal(obj, PhysicsType::Static);
-	sysRender->Add(result, chunk);
+	if (sysRender) sysRender->Add(result, chunk);
 	lock.unlock();
 
 	return result;
@@ -85,7 +232,7 @@ Pu::PhysicsHandle Pu::PhysicalWorld::AddStatic(const PhysicalObject & obj, const
 {
 	lock.lock();
 	const PhysicsHandle result = AddInternal(obj, PhysicsType::Static);
-	sysRender->Add(result, model, subpass); //TODO: automate subpass determination?
+	if (sysRender) sysRender->Add(result, model, subpass); //TODO: automate subpass determination?
 	lock.unlock();
 
 	return result;
@@ -95,7 +242,25 @@ Pu::PhysicsHandle Pu::PhysicalWorld::AddKinematic(const PhysicalObject & obj, co
 {
 	lock.lock();
 	const PhysicsHandle result = AddInternal(obj, PhysicsType::Kinematic);
-	sysRender->Add(result, model, subpass); //TODO: automate subpass determination?
+	if (sysRender) sysRender->Add(result, model, subpass); //TODO: automate subpass determination?
+	lock.unlock();
+
+	return result;
+}
+
+Pu::PhysicsHandle Pu::PhysicalWorld::AddStatic(const PhysicalObject & obj)
+{
+	lock.lock();
+	const PhysicsHandle result = AddInternal(obj, PhysicsType::Static);
+	lock.unlock();
+
+	return result;
+}
+
+Pu::PhysicsHandle Pu::PhysicalWorld::AddKinematic(const PhysicalObject & obj)
+{
+	lock.lock();
+	const PhysicsHandle result = AddInternal(obj, PhysicsType::Kinematic);
 	lock.unlock();
 
 	return result;
@@ -110,8 +275,17 @@ Pu::PhysicsHandle Pu::PhysicalWorld::AddMaterial(const PhysicalProperties & prop
 	return result;
 }
 
+void Pu::PhysicalWorld::SetCombineModes(CombineMode restitution, CombineMode friction)
+{
+	lock.lock();
+	db->SetCombineModes(restitution, friction);
+	lock.unlock();
+}
+
 Pu::PhysicsHandle Pu::PhysicalWorld::AddLight(const DirectionalLight & light)
 {
+	if (!sysRender) Log::Fatal("Cannot add light to headless physical world!");
+
 	lock.lock();
 	const PhysicsHandle result = sysRender->Add(light);
 	lock.unlock();
@@ -120,12 +294,37 @@ Pu::PhysicsHandle Pu::PhysicalWorld::AddLight(const DirectionalLight & light)
 
 Pu::PhysicsHandle Pu::PhysicalWorld::AddLight(const PointLight & light)
 {
+	if (!sysRender) Log::Fatal("Cannot add light to headless physical world!");
+
 	lock.lock();
 	const PhysicsHandle result = sysRender->Add(light);
 	lock.unlock();
 	return result;
 }
 
+void Pu::PhysicalWorld::UpdateLight(PhysicsHandle handle, const PointLight & light)
+{
+	if (!sysRender) Log::Fatal("Cannot update light in headless physical world!");
+
+	lock.lock();
+	sysRender->Update(handle, light);
+	lock.unlock();
+}
+
+void Pu::PhysicalWorld::AddOccluder(PhysicsHandle handle, const Occluder & occluder)
+{
+	if (!sysRender) Log::Fatal("Cannot add occluder to headless physical world!");
+
+	lock.lock();
+
+#ifdef _DEBUG
+	ValidateHandle(handle);
+#endif
+
+	sysRender->AddOccluder(handle, occluder);
+	lock.unlock();
+}
+
 void Pu::PhysicalWorld::SetGravity(Vector3 g)
 {
 	lock.lock();
@@ -171,8 +370,96 @@ Pu::Matrix Pu::PhysicalWorld::GetTransform(PhysicsHandle handle) const
 	return sysMove->GetTransform(handleLut[physics_get_lookup_id(handle)]);
 }
 
+Pu::PhysicsHandle Pu::PhysicalWorld::Raycast(Vector3 p, Vector3 d) const
+{
+	lock.lock();
+	const PhysicsHandle result = searchTree.Raycast(p, d);
+	lock.unlock();
+
+	return result;
+}
+
+size_t Pu::PhysicalWorld::Overlap(Sphere sphere, const QueryFilter & filter, PhysicsHandle * result, size_t capacity) const
+{
+	SpatialQuery query{ sphere, filter, result, capacity };
+
+	lock.lock();
+	QueryInternal(query, nullptr);
+	lock.unlock();
+
+	return query.Count;
+}
+
+size_t Pu::PhysicalWorld::Overlap(const OBB & obb, const QueryFilter & filter, PhysicsHandle * result, size_t capacity) const
+{
+	SpatialQuery query{ obb, filter, result, capacity };
+
+	lock.lock();
+	QueryInternal(query, nullptr);
+	lock.unlock();
+
+	return query.Count;
+}
+
+Pu::PhysicsHandle Pu::PhysicalWorld::Sweep(Sphere sphere, Vector3 displacement, const QueryFilter & filter, float & time) const
+{
+	PhysicsHandle result = PhysicsNullHandle;
+	SpatialQuery query{ sphere, displacement, filter, &result };
+
+	lock.lock();
+	QueryInternal(query, nullptr);
+	lock.unlock();
+
+	time = query.Time;
+	return result;
+}
+
+size_t Pu::PhysicalWorld::Nearest(Vector3 p, float maxDistance, const QueryFilter & filter, PhysicsHandle * result, float * distances, size_t k) const
+{
+	SpatialQuery query{ p, maxDistance, filter, result, distances, k };
+
+	lock.lock();
+	QueryInternal(query, nullptr);
+	lock.unlock();
+
+	return query.Count;
+}
+
+/*
+The lock is only held while the candidates of the queries are gathered.
+The narrow phase tests only use copies of the colliders, so they can be executed in parallel without the lock.
+*/
+void Pu::PhysicalWorld::Query(SpatialQuery * queries, size_t count) const
+{
+	vector<QueryCollider> candidates;
+	vector<size_t> offsets;
+	offsets.reserve(count + 1);
+
+	lock.lock();
+	for (size_t i = 0; i < count; i++)
+	{
+		offsets.emplace_back(candidates.size());
+		QueryInternal(queries[i], &candidates);
+	}
+	lock.unlock();
+
+	offsets.emplace_back(candidates.size());
+	ParallelFor(count, PhysicsQueryChunkSize, [&candidates, &offsets, queries](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			for (size_t j = offsets[i]; j < offsets[i + 1]; j++)
+			{
+				if (!resolve_query(queries[i], candidates[j])) break;
+			}
+		}
+	});
+}
+
 void Pu::PhysicalWorld::Render(const Camera & camera, CommandBuffer & cmdBuffer)
 {
+	if (!sysRender) return;
+
 	lock.lock();
 	sysRender->Render(searchTree, camera, cmdBuffer);
 	lock.unlock();
@@ -199,9 +486,16 @@ void Pu::PhysicalWorld::Visualize(DebugRenderer & dbgRenderer, Vector3 camPos) c
 			/* Statistics. */
 			ImGui::Text("Static Objects:    %zu", staticObjects);
 			ImGui::Text("Kinematic Objects: %zu/%zu", activeObjects, kinematicObjects);
+			ImGui::Text("Islands:           %zu (%zu sleeping)", sysIsland->GetIslandCount(), sysIsland->GetSleepingIslandCount());
 			ImGui::Text("BVH Updates:       %zu", ContactSystem::GetBVHUpdateCalls());
 			ImGui::Text("Collisions:        %u/%u", ContactSystem::GetCollisionsCount(), ContactSystem::GetNarrowPhaseChecks());
-			ImGui::Text("SAT calls:         %u", SAT::GetCallCount());
+			ImGui::Text("CCD sweeps:        %u", ContactSystem::GetCCDSweeps());
+			ImGui::Text("SAT calls:         %u (%u batches)", SAT::GetCallCount(), SAT::GetBatchCount());
+			if (sysRender)
+			{
+				ImGui::Text("Draw calls:        %u (%u instances)", sysRender->GetDrawCallCount(), sysRender->GetRenderedInstanceCount());
+				ImGui::Text("Occluded:          %u instances", sysRender->GetOccludedInstanceCount());
+			}
 			ContactSystem::ResetCounters();
 			SAT::ResetCounter();
 
@@ -212,7 +506,7 @@ void Pu::PhysicalWorld::Visualize(DebugRenderer & dbgRenderer, Vector3 camPos) c
 			if (showBvh1) searchTree.Visualize(dbgRenderer);
 
 			ImGui::Checkbox("Visualize Visual BVH", &showBvh2);
-			if (showBvh2) sysRender->GetVisualBVH().Visualize(dbgRenderer);
+			if (showBvh2 && sysRender) sysRender->GetVisualBVH().Visualize(dbgRenderer);
 
 			ImGui::Checkbox("Visualize Colliders", &showColliders);
 			if (showColliders) sysCnst->VisualizeColliders(dbgRenderer, camPos);
@@ -267,6 +561,60 @@ void Pu::PhysicalWorld::Visualize(DebugRenderer & dbgRenderer, Vector3 camPos) c
 #endif
 }
 
+void Pu::PhysicalWorld::Step(void)
+{
+	lock.lock();
+	Simulate(PhysicsFixedTimestep);
+	lock.unlock();
+}
+
+/*
+A snapshot only contains the state that changes during simulation:
+- The lookup table (to validate that the same objects are present).
+- The remaining time of the fixed timestep.
+- The SoA lanes of the movement system.
+- The collision BVH.
+- The cached broadphase (the contacts and the solver are rebuilt from this every step).
+- The sleeping state of the islands.
+All of these are stored as flat arrays of plain data, so every system writes its state with a bulk copy per array.
+The cost of a snapshot is still linear in the amount of objects.
+*/
+void Pu::PhysicalWorld::Snapshot(BinaryWriter & writer) const
+{
+	lock.lock();
+
+	writer.Write(static_cast<uint64>(handleLut.size()));
+	writer.Write(reinterpret_cast<const byte*>(handleLut.data()), 0, handleLut.size() * sizeof(PhysicsHandle));
+	writer.Write(accumulator);
+
+	sysMove->Snapshot(writer);
+	searchTree.Snapshot(writer);
+	sysCnst->Snapshot(writer);
+	sysIsland->Snapshot(writer);
+
+	lock.unlock();
+}
+
+void Pu::PhysicalWorld::Restore(BinaryReader & reader)
+{
+	lock.lock();
+
+	/* The snapshot can only be restored if the same objects are present in the world. */
+	if (reader.ReadUInt64() != handleLut.size()) Log::Fatal("Unable to restore physical world (object count differs from snapshot)!");
+	for (const PhysicsHandle hcur : handleLut)
+	{
+		if (reader.ReadUInt32() != hcur) Log::Fatal("Unable to restore physical world (objects differ from snapshot)!");
+	}
+
+	accumulator = reader.ReadSingle();
+	sysMove->Restore(reader);
+	searchTree.Restore(reader);
+	sysCnst->Restore(reader);
+	sysIsland->Restore(reader);
+
+	lock.unlock();
+}
+
 void Pu::PhysicalWorld::Update(float dt)
 {
 #ifdef _DEBUG
@@ -280,42 +628,62 @@ void Pu::PhysicalWorld::Update(float dt)
 	if constexpr (!ProfileWorldSystems) Profiler::Begin("World Update", Color::Gray());
 	lock.lock();
 
+	/* Determinism mode always steps with the same timestep, the remaining time is carried over to the next update. */
+	if (Deterministic)
+	{
+		for (accumulator += dt; accumulator >= PhysicsFixedTimestep; accumulator -= PhysicsFixedTimestep)
+		{
+			Simulate(PhysicsFixedTimestep);
+		}
+	}
+	else Simulate(dt);
+
+	lock.unlock();
+	if constexpr (!ProfileWorldSystems) Profiler::End();
+}
+
+void Pu::PhysicalWorld::Simulate(float dt)
+{
 	/*
 	Divide the physics update into multiple substeps to get better accuracy.
 	This happens on a fixed timestep to prevent sudden changes in motion.
+	The systems only use ordered containers and process objects in index order,
+	so the same state and timestep always produce the same result.
 
 	We first check for collision events between all objects.
-	This should be done early on, but it could be swapped with the next step.
+	This should be done early on, as all the other steps depend on the contacts.
+	Fast objects that use CCD are swept along their path and moved to their first point of impact.
+
+	The contacts are then used to group the kinematic objects into simulation islands.
+	Any sleeping island that is touched by an awake object is woken up before we solve.
 
-	We add the constant world forces (gravity and dynamics).
+	Next we solve for the collisions, the velocities already contain the constant world forces (gravity and drag).
 	This needs to happen before we solve the collisions as they take
 	the final velocity into account when applying their impulses.
 	Otherwise the objects would slowely fall through floors, etc.
 
-	Next we check if any of our objects have come to rest.
-	This is the case if the velocity is below the defined threshold.
-	It's important that this threshold is smaller than the initial gravity constant,
-	otherwise the initial gravity won't overcome this threshold, therefore it is set to:
-	Magnitude(G) * (DeltaTime / Substeps) / 2
-
-	Finally we solve for the collision and integrate our positions to the next timestep.
-	Thus creating the new state of the world.
+	Finally we integrate our positions to the next timestep, this is done in a single pass that also:
+	- Checks if any of our objects have come to rest.
+	  This is the case if the velocity is below the defined threshold.
+	  It's important that this threshold is smaller than the initial gravity constant,
+	  otherwise the initial gravity won't overcome this threshold, therefore it is set to:
+	  Magnitude(G) * (DeltaTime / Substeps) / 2
+	- Checks which objects have moved out of their broadphase, these are updated in the next check.
+	- Adds the constant world forces for the next step.
+	Objects only fall asleep once every object in their island has been resting for a while.
 	*/
-	const ofloat dt8 = _mm256_set1_ps(dt / Substeps);
+	const float sdt = dt / Substeps;
+	const ofloat dt8 = _mm256_set1_ps(sdt);
 	const ofloat threshold = _mm256_mul_ps(_mm256_mul_ps(_mm256_len_v3(sysMove->Gx, sysMove->Gy, sysMove->Gz), dt8), _mm256_set1_ps(0.5f));
 
 	for (uint32 step = 0; step < Substeps; step++)
 	{
-		sysCnst->Check();
-		sysMove->ApplyGravity(dt8);
-		sysMove->ApplyDrag(dt8);
+		sysCnst->Check(sdt);
+		sysIsland->Build();
 		sysSolv->SolveConstriants(dt8);
-		sysMove->TrySleep(threshold);
-		sysMove->Integrate(dt8);
+		sysMove->Integrate(dt8, threshold);
+		sysIsland->TrySleep();
 	}
-
-	lock.unlock();
-	if constexpr (!ProfileWorldSystems) Profiler::End();
 }
 
 void Pu::PhysicalWorld::ThrowCorruptHandle(bool condition, const char * func)
@@ -365,6 +733,35 @@ void Pu::PhysicalWorld::ValidateHandle(PhysicsHandle handle) const
 	if (t1 != t2) Log::Fatal("Unknown physics handle passed (types differ)!");
 }
 
+void Pu::PhysicalWorld::QueryInternal(SpatialQuery & query, vector<QueryCollider> * candidates) const
+{
+	QueryContext ctx{ sysCnst, &query, candidates };
+	query.Count = 0;
+	query.Time = 1.0f;
+	if (!query.Capacity) return;
+
+	const Sphere &sphere = query.QuerySphere;
+	const AABB bb{ sphere.Center - Vector3(sphere.Radius), sphere.Center + Vector3(sphere.Radius) };
+
+	switch (query.Type)
+	{
+	case QueryType::OverlapSphere:
+		searchTree.Boxcast(bb, visit_query, &ctx);
+		break;
+	case QueryType::OverlapOBB:
+		searchTree.Boxcast(query.QueryBox.GetBoundingBox(), visit_query, &ctx);
+		break;
+	case QueryType::SweepSphere:
+		if (sphere.Radius <= 0.0f) Log::Error("Cannot sweep sphere with a radius of zero, use a raycast instead!");
+		else searchTree.Boxcast(union_(bb, query.Displacement + bb), visit_query, &ctx);
+		break;
+	case QueryType::Nearest:
+		/* The BVH prunes on the distances while traversing, so nearest queries are always fully resolved here. */
+		query.Count = searchTree.Nearest(sphere.Center, query.MaxDistance, get_query_distance, &ctx, query.Result, query.Distances, query.Capacity);
+		break;
+	}
+}
+
 Pu::PhysicsHandle Pu::PhysicalWorld::AddInternal(const PhysicalObject & obj, PhysicsType type)
 {
 	/* Check if the user set the material. */
@@ -373,14 +770,16 @@ Pu::PhysicsHandle Pu::PhysicalWorld::AddInternal(const PhysicalObject & obj, Phy
 	ThrowCorruptHandle(physics_get_type(obj.Properties) != PhysicsType::Material, nameof(AddInternal));
 #endif
 
-	/* Query the material and add the object to the solver to get the index. */
-	const PhysicalProperties &mat = (*db)[obj.Properties];
 	const float imass = recip(obj.State.Mass);
 	const Matrix3 imoi = obj.MoI.GetInverse();
 
 	size_t idx;
 	if (type == PhysicsType::Static) idx = sysMove->AddItem(Matrix::CreateWorld(obj.P, obj.Theta, obj.Scale));
-	else idx = sysMove->AddItem(obj.P, obj.V, obj.Theta, obj.Omega, obj.Scale, obj.State.Cd, imass, imoi);
+	else
+	{
+		idx = sysMove->AddItem(obj.P, obj.V, obj.Theta, obj.Omega, obj.Scale, obj.State.Cd, imass, imoi);
+		sysIsland->AddItem();
+	}
 
 	/* Create the public handle (to give to the user) and query the internal handle. */
 	const PhysicsHandle hpublic = AllocPublicHandle(type, idx);
@@ -389,8 +788,8 @@ Pu::PhysicsHandle Pu::PhysicalWorld::AddInternal(const PhysicalObject & obj, Phy
 	Add the object parameters to the systems that require the handle.
 	Scale needs to be applied to the broadphase, narrowphase takes the full transform into account.
 	*/
-	sysSolv->AddItem(hpublic, imoi, imass, mat.Mechanical);
-	sysCnst->AddItem(hpublic, obj.Collider.BroadPhase, obj.Collider.NarrowPhaseShape, reinterpret_cast<float*>(obj.Collider.NarrowPhaseParameters));
+	sysSolv->AddItem(hpublic, imoi, imass, obj.Properties);
+	sysCnst->AddItem(hpublic, obj.Collider.BroadPhase, obj.Collider.NarrowPhaseShape, reinterpret_cast<float*>(obj.Collider.NarrowPhaseParameters), obj.ContinuousCollision, obj.Layer);
 
 	return hpublic;
 }
@@ -431,8 +830,9 @@ void Pu::PhysicalWorld::DestroyInternal(PhysicsHandle hpublic, PhysicsHandle hin
 	/* Destroy global parameters (order matters). */
 	sysCnst->RemoveItem(hpublic);
 	sysSolv->RemoveItem(hpublic);
+	sysIsland->RemoveItem(hinternal);
 	sysMove->RemoveItem(hinternal);
-	sysRender->Remove(hpublic);
+	if (sysRender) sysRender->Remove(hpublic);
 
 	/*
 	Update all the other internal handles in the lookup table.
@@ -452,6 +852,7 @@ void Pu::PhysicalWorld::Destroy(void)
 {
 	if (sysCnst) delete sysCnst;
 	if (sysSolv) delete sysSolv;
+	if (sysIsland) delete sysIsland;
 	if (sysMove) delete sysMove;
 	if (sysRender) delete sysRender;
 	if (db) delete db;
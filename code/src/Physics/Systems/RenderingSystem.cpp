@@ -1,8 +1,10 @@
 #include "Physics/Systems/RenderingSystem.h"
 #include "Physics/Systems/PhysicalWorld.h"
 #include "Core/Diagnostics/Profiler.h"
+#include "Core/Threading/Tasks/ParallelFor.h"
 
 constexpr Pu::uint32 PointLightPoolSize = 256;
+constexpr Pu::uint32 InstancePoolSize = 1024;
 
 constexpr inline Pu::uint32 physics_get_subpass(Pu::PhysicsHandle handle)
 {
@@ -23,21 +25,39 @@ constexpr inline void physics_set_subpass(Pu::PhysicsHandle &handle, Pu::uint32
 	handle |= subpass << 16;
 }
 
+/* The light volume is a sphere and thusly the scale is uniform across all axis. */
+inline Pu::AABB physics_get_light_bounds(const Pu::PointLight &light)
+{
+	const float ir = -light.Volume.GetRight().X;
+	const float d = light.Volume.GetRight().X * 2.0f;
+	return Pu::AABB{ ir, ir, ir, d, d, d } + light.Volume.GetTranslation();
+}
+
 constexpr inline bool physics_handle_sort_pair(const Pu::PhysicsHandlePair &first, const Pu::PhysicsHandlePair &second)
 {
 	return physics_get_subpass(first.second) < physics_get_subpass(second.second);
 }
 
 Pu::RenderingSystem::RenderingSystem(const PhysicalWorld & world, DeferredRenderer & renderer)
-	: world(&world), renderer(&renderer)
+	: world(&world), renderer(&renderer), lutVersion(0), drawCalls(0),
+	occlusion(OcclusionBufferWidth, OcclusionBufferHeight), occludedCount(0),
+	lightCuller(PointLightCoarseRadius),
+	lodSelector(LodErrorThreshold, LodHysteresis), reducedCount(0),
+	batchCursor(0), jobCursor(0), primary(nullptr)
 {}
 
 Pu::RenderingSystem::RenderingSystem(RenderingSystem && value)
-	: world(value.world), renderer(value.renderer), handleLut(std::move(value.handleLut)),
+	: world(value.world), renderer(value.renderer), handleLut(std::move(value.handleLut)), lutVersion(value.lutVersion),
 	visualTree(std::move(value.visualTree)), pntLightPools(std::move(value.pntLightPools)),
+	instancePools(std::move(value.instancePools)), batcher(std::move(value.batcher)), drawCalls(value.drawCalls),
+	occlusion(std::move(value.occlusion)), occluders(std::move(value.occluders)), occludedCount(value.occludedCount),
+	lightCuller(std::move(value.lightCuller)), lodSelector(std::move(value.lodSelector)),
+	visibleStatic(std::move(value.visibleStatic)), reducedCount(value.reducedCount),
+	cmdPools(std::move(value.cmdPools)), secondaries(std::move(value.secondaries)), jobLists(std::move(value.jobLists)),
+	jobs(std::move(value.jobs)), batchCursor(value.batchCursor), jobCursor(value.jobCursor), primary(value.primary),
 	dirLights(std::move(value.dirLights)), terrains(std::move(value.terrains)),
 	models(std::move(value.models)), pntLights(std::move(pntLights)),
-	cacheCast(std::move(cacheCast)), cacheHandles(std::move(value.cacheHandles)),
+	physicsCache(std::move(value.physicsCache)),
 	loadingAssets(std::move(value.loadingAssets))
 {}
 
@@ -50,14 +70,31 @@ Pu::RenderingSystem & Pu::RenderingSystem::operator=(RenderingSystem && other)
 		world = other.world;
 		renderer = other.renderer;
 		handleLut = std::move(other.handleLut);
+		lutVersion = other.lutVersion;
 		visualTree = std::move(other.visualTree);
 		pntLightPools = std::move(other.pntLightPools);
+		instancePools = std::move(other.instancePools);
+		batcher = std::move(other.batcher);
+		drawCalls = other.drawCalls;
+		occlusion = std::move(other.occlusion);
+		occluders = std::move(other.occluders);
+		occludedCount = other.occludedCount;
+		lightCuller = std::move(other.lightCuller);
+		lodSelector = std::move(other.lodSelector);
+		visibleStatic = std::move(other.visibleStatic);
+		reducedCount = other.reducedCount;
+		cmdPools = std::move(other.cmdPools);
+		secondaries = std::move(other.secondaries);
+		jobLists = std::move(other.jobLists);
+		jobs = std::move(other.jobs);
+		batchCursor = other.batchCursor;
+		jobCursor = other.jobCursor;
+		primary = other.primary;
 		dirLights = std::move(other.dirLights);
 		terrains = std::move(other.terrains);
 		models = std::move(other.models);
 		pntLights = std::move(other.pntLights);
-		cacheCast = std::move(other.cacheCast);
-		cacheHandles = std::move(other.cacheHandles);
+		physicsCache = std::move(other.physicsCache);
 		loadingAssets = std::move(other.loadingAssets);
 	}
 
@@ -112,21 +149,19 @@ void Pu::RenderingSystem::Add(PhysicsHandle handle, const Model & model, uint32
 
 Pu::PhysicsHandle Pu::RenderingSystem::Add(const PointLight & light)
 {
-	/* The light volume is a sphere and thusly the scale is uniform across all axis. */
-	const float ir = -light.Volume.GetRight().X;
-	const float d = light.Volume.GetRight().X * 2.0f;
-	const AABB bb{ ir, ir, ir, d, d, d };
-
 	const size_t idx = pntLights.size();
 	const PhysicsHandle hpublic = AllocLightHandle(DeferredRenderer::SubpassPointLight);
 
 	/* Point lights don't have to be loaded, so we can add them right away. */
 	pntLights.emplace_back(light);
 	AddHandleToLuT(hpublic, idx, DeferredRenderer::SubpassPointLight);
-	visualTree.Insert(hpublic, bb + light.Volume.GetTranslation());
+	visualTree.Insert(hpublic, physics_get_light_bounds(light));
+	lightCuller.Add(light.Volume.GetTranslation(), light.Volume.GetRight().X);
 
-	/* Add a new pool if needed. */
-	if (!(idx % PointLightPoolSize)) pntLightPools.emplace_back(new PointLightPool(renderer->GetDevice(), PointLightPoolSize));
+	/* The lights stay in their pool, so they're only uploaded once. Add a new pool if needed. */
+	const size_t pool = idx / PointLightPoolSize;
+	if (pool >= pntLightPools.size()) pntLightPools.emplace_back(new PointLightPool(renderer->GetDevice(), PointLightPoolSize));
+	pntLightPools[pool]->AddLight(light);
 	return hpublic;
 }
 
@@ -141,11 +176,23 @@ Pu::PhysicsHandle Pu::RenderingSystem::Add(const DirectionalLight & light)
 	return hpublic;
 }
 
+void Pu::RenderingSystem::AddOccluder(PhysicsHandle handle, const Occluder & occluder)
+{
+	occluders.emplace_back(std::make_pair(handle, &occluder));
+}
+
 void Pu::RenderingSystem::Render(const BVH & bvh, const Camera & camera, CommandBuffer & cmdBuffer)
 {
-	/* Handle all the visual-only objects. */
 	if constexpr (ProfileWorldSystems) Profiler::Begin("Culling", Color::Abbey());
-	UpdateCaches(visualTree, camera);
+	CheckLoadingAssets();
+	UpdateCache(bvh, camera, physicsCache);
+
+	/* Objects hidden behind the occluders are skipped during batching. */
+	const bool occlusionCulling = occluders.size();
+	if (occlusionCulling) RasterizeOccluders(camera);
+
+	/* The point lights are already in their pools, so culling only selects which ranges of the pools are drawn. */
+	lightCuller.Cull(camera.GetClip(), camera.GetPosition(), camera.GetProjection(), camera.GetViewportSize().Y, occlusionCulling ? &occlusion : nullptr);
 
 	if constexpr (ProfileWorldSystems)
 	{
@@ -153,36 +200,53 @@ void Pu::RenderingSystem::Render(const BVH & bvh, const Camera & camera, Command
 		Profiler::Begin("Batching", Color::Gray());
 	}
 
-	size_t pntLightCnt = 0, pntLightIdx = 0;
-	for (const PhysicsHandlePair &handles : cacheHandles)
+	/* Gather the visible static geometry, the level of detail of all these objects is selected in one go afterwards. */
+	lodSelector.Clear();
+	lodSelector.SetCamera(camera.GetPosition(), camera.GetProjection(), camera.GetViewportSize().Y);
+	visibleStatic.clear();
+	occludedCount = 0;
+
+	for (uint32 j = 0; j < physicsCache.Handles.size(); j++)
 	{
+		const PhysicsHandlePair &handles = physicsCache.Handles[j];
 		const uint32 subpass = physics_get_subpass(handles.second);
-		const uint16 i = physics_get_lookup_id(handles.second);
-
-		if (subpass == DeferredRenderer::SubpassPointLight)
+		if (subpass == DeferredRenderer::SubpassBasicStaticGeometry || subpass == DeferredRenderer::SubpassAdvancedStaticGeometry)
 		{
-			/* Add the light to the correct pool. */
-			pntLightPools[pntLightIdx]->AddLight(pntLights[i]);
-			if (++pntLightCnt >= PointLightPoolSize)
+			const Model &model = *models[physics_get_lookup_id(handles.second)].first;
+			const Matrix transform = world->GetTransform(handles.first);
+			const AABB bb = transform * model.GetMeshes().GetBoundingBox();
+
+			if (occlusionCulling && !occlusion.IsVisible(bb)) ++occludedCount;
+			else
 			{
-				pntLightCnt = 0;
-				++pntLightIdx;
+				/* The level errors are in object space, so they're scaled by the largest axis of the transform. */
+				const float scale = max(transform.GetRight().Length(), max(transform.GetUp().Length(), transform.GetForward().Length()));
+				lodSelector.Add(bb.GetCenter(), bb.GetSize().Length() * 0.5f, model.GetLevelErrors(), scale, physicsCache.Lods[j]);
+				visibleStatic.emplace_back(std::make_pair(j, transform));
 			}
 		}
-		else Log::Warning("RenderingSystem is unable to render object 0x%X in subpass %u!", handles.first, subpass);
 	}
 
-	/* Stage the point light pool. */
-	for (PointLightPool *pool : pntLightPools) pool->Update(cmdBuffer);
+	/* Group all the visible static geometry into instanced draws, the selected level is stored for the hysteresis of the next frame. */
+	lodSelector.Select();
+	batcher.Clear();
+	reducedCount = 0;
 
-	if constexpr (ProfileWorldSystems)
+	for (uint32 k = 0; k < visibleStatic.size(); k++)
 	{
-		Profiler::End();
-		Profiler::Begin("Culling", Color::Abbey());
+		const auto &[j, transform] = visibleStatic[k];
+		const PhysicsHandle hinternal = physicsCache.Handles[j].second;
+		const uint32 lod = lodSelector.GetLevel(k);
+
+		physicsCache.Lods[j] = lod;
+		reducedCount += lod != 0;
+		batcher.Add(physics_get_subpass(hinternal), physics_get_lookup_id(hinternal), transform, lod);
 	}
 
-	CheckLoadingAssets();
-	UpdateCaches(bvh, camera);
+	/* Stage the instances and the changed point lights, this has to happen before the render pass is started. */
+	batcher.Pack(InstancePoolSize);
+	StageInstances(cmdBuffer);
+	for (PointLightPool *pool : pntLightPools) pool->Update(cmdBuffer);
 
 	if constexpr (ProfileWorldSystems)
 	{
@@ -192,24 +256,32 @@ void Pu::RenderingSystem::Render(const BVH & bvh, const Camera & camera, Command
 
 	/* Begin the render sequence. */
 	renderer->InitializeResources(cmdBuffer, camera);
-	for (const PhysicsHandlePair &handles : cacheHandles)
+	drawCalls = 0;
+	batchCursor = 0;
+	jobCursor = 0;
+
+	/* Only record the static geometry in parallel if there's enough work to split. */
+	if (batcher.GetBatches().size() >= RenderBatchesPerJob && renderer->SupportsSecondaryRecording())
+	{
+		primary = &cmdBuffer;
+		RecordSecondaries();
+	}
+	else primary = nullptr;
+
+	for (const PhysicsHandlePair &handles : physicsCache.Handles)
 	{
 		const uint32 subpass = physics_get_subpass(handles.second);
 		const uint16 i = physics_get_lookup_id(handles.second);
 
+		/* The batches are sorted on subpass, so render them as soon as their subpass is reached. */
+		FlushBatches(subpass);
+
 		if (subpass == DeferredRenderer::SubpassTerrain)
 		{
 			/* Render all the terrain chunks. */
 			renderer->Begin(subpass);
 			if (i < terrains.size()) renderer->Render(*terrains[i]);
 		}
-		else if (subpass == DeferredRenderer::SubpassBasicStaticGeometry || subpass == DeferredRenderer::SubpassAdvancedStaticGeometry)
-		{
-			/* The basic and advanced static geometry uses the same functions, so we can group them. */
-			renderer->Begin(subpass);
-			const Matrix transform = world->GetTransform(handles.first);
-			renderer->Render(*models[i].first, transform);
-		}
 		else if (subpass == DeferredRenderer::SubpassBasicMorphGeometry)
 		{
 			/* TODO: Add the proper keyframe from a animation handler. */
@@ -217,9 +289,15 @@ void Pu::RenderingSystem::Render(const BVH & bvh, const Camera & camera, Command
 			const Matrix transform = world->GetTransform(handles.first);
 			renderer->Render(*models[i].first, transform, 0, 1, 0.0f);
 		}
-		else Log::Warning("RenderingSystem is unable to render object 0x%X in subpass %u!", handles.first, subpass);
+		else if (subpass != DeferredRenderer::SubpassBasicStaticGeometry && subpass != DeferredRenderer::SubpassAdvancedStaticGeometry)
+		{
+			Log::Warning("RenderingSystem is unable to render object 0x%X in subpass %u!", handles.first, subpass);
+		}
 	}
 
+	/* Render any batches that weren't followed by a later subpass. */
+	FlushBatches(DeferredRenderer::SubpassPostProcessing);
+
 	/* Render all the directional lights. */
 	for (const DirectionalLight *light : dirLights)
 	{
@@ -227,22 +305,43 @@ void Pu::RenderingSystem::Render(const BVH & bvh, const Camera & camera, Command
 		renderer->Render(*light);
 	}
 
-	/* Render all the point lights. */
-	for (PointLightPool *pool : pntLightPools)
-	{
-		renderer->Begin(DeferredRenderer::SubpassPointLight);
-		renderer->Render(*pool);
-		pool->Clear();
-	}
+	/* Render all the visible point lights, small lights are drawn with the coarse light volume. */
+	RenderPointLights(lightCuller.GetVolumeRuns(), false);
+	RenderPointLights(lightCuller.GetCoarseRuns(), true);
 
 	/* Finalize the rendering. */
 	renderer->End();
 	if constexpr (ProfileWorldSystems) Profiler::End();
 }
 
+void Pu::RenderingSystem::Update(PhysicsHandle handle, const PointLight & light)
+{
+	decltype(handleLut)::const_iterator it = handleLut.find(handle);
+	if (it == handleLut.end() || physics_get_subpass(it->second) != DeferredRenderer::SubpassPointLight)
+	{
+		Log::Error("Cannot update point light, handle 0x%X doesn't reference a point light!", handle);
+		return;
+	}
+
+	/* The light keeps its index, so only its own slot in the culler and its pool is changed (the pool only uploads that light). */
+	const uint16 idx = physics_get_lookup_id(it->second);
+	pntLights[idx] = light;
+	lightCuller.Set(idx, light.Volume.GetTranslation(), light.Volume.GetRight().X);
+	pntLightPools[idx / PointLightPoolSize]->SetLight(idx % PointLightPoolSize, light);
+
+	/* The visual tree cannot update a leaf in place, so the light is reinserted with its new bounds. */
+	visualTree.Remove(handle);
+	visualTree.Insert(handle, physics_get_light_bounds(light));
+}
+
 void Pu::RenderingSystem::Remove(PhysicsHandle handle)
 {
-	const PhysicsHandle hinternal = handleLut.at(handle);
+	/* Objects are allowed to only be an occluder, so they might not be in the lookup. */
+	(void)occluders.removeAll([handle](const std::pair<PhysicsHandle, const Occluder*> &cur) { return cur.first == handle; });
+	decltype(handleLut)::const_iterator it = handleLut.find(handle);
+	if (it == handleLut.end()) return;
+
+	const PhysicsHandle hinternal = it->second;
 	const uint32 subpass = physics_get_subpass(hinternal);
 	const uint16 idx = physics_get_lookup_id(hinternal);
 
@@ -252,6 +351,16 @@ void Pu::RenderingSystem::Remove(PhysicsHandle handle)
 	{
 		visualTree.Remove(handle);
 		pntLights.removeAt(idx);
+		lightCuller.RemoveAt(idx);
+
+		/* The pools have to stay in the same order as the lights, so every later pool moves its first light to the end of the previous pool. */
+		size_t pool = idx / PointLightPoolSize;
+		pntLightPools[pool]->RemoveLight(idx % PointLightPoolSize);
+		for (++pool; pool < pntLightPools.size() && pntLightPools[pool]->GetLightCount(); pool++)
+		{
+			pntLightPools[pool - 1]->AddLight(pntLightPools[pool]->GetLight(0));
+			pntLightPools[pool]->RemoveLight(0);
+		}
 	}
 	else
 	{
@@ -266,6 +375,7 @@ void Pu::RenderingSystem::Remove(PhysicsHandle handle)
 	}
 
 	handleLut.erase(handle);
+	++lutVersion;
 }
 
 void Pu::RenderingSystem::CheckLoadingAssets(void)
@@ -317,28 +427,203 @@ void Pu::RenderingSystem::AddHandleToLuT(PhysicsHandle handle, size_t idx, uint3
 	PhysicsHandle hinternal = create_physics_handle(physics_get_type(handle), idx);
 	physics_set_subpass(hinternal, subpass);
 	handleLut.emplace(handle, hinternal);
+	++lutVersion;
 }
 
-void Pu::RenderingSystem::UpdateCaches(const BVH & bvh, const Camera & cam)
+/*
+The visible set only depends on the frustum, the bounding boxes in the tree and the handle lookup.
+So the previous result can be reused if none of those changed, this means that a static camera doesn't cull anything.
+*/
+void Pu::RenderingSystem::UpdateCache(const BVH & bvh, const Camera & cam, VisibilityCache & cache)
 {
+	/* The frustum is compared bitwise, any change in the camera should cause a new cast. */
+	const Frustum &clip = cam.GetClip();
+	if (cache.Tree == &bvh && cache.TreeVersion == bvh.GetVersion() && cache.LutVersion == lutVersion
+		&& !memcmp(&cache.Clip, &clip, sizeof(Frustum))) return;
+
+	cache.Tree = &bvh;
+	cache.Clip = clip;
+	cache.TreeVersion = bvh.GetVersion();
+	cache.LutVersion = lutVersion;
+
 	/* Traverse the BVH to get all the objects visible by the camera. */
-	cacheCast.clear();
-	bvh.Frustumcast(cam.GetClip(), cacheCast);
+	cache.Cast.clear();
+	bvh.Frustumcast(clip, cache.Cast);
+
+	/* Store the levels of detail of the last cast, so objects that stay visible keep their hysteresis. */
+	cache.History.clear();
+	for (size_t i = 0; i < cache.Lods.size(); i++) cache.History.emplace_back(std::make_pair(cache.Handles[i].first, cache.Lods[i]));
+	std::sort(cache.History.begin(), cache.History.end());
 
 	/* Convert the public handles the internal handles. */
-	cacheHandles.clear();
-	cacheHandles.reserve(cacheCast.size());
-	for (PhysicsHandle cur : cacheCast)
+	cache.Handles.clear();
+	cache.Handles.reserve(cache.Cast.size());
+	for (PhysicsHandle cur : cache.Cast)
 	{
 		decltype(handleLut)::const_iterator it = handleLut.find(cur);
-		if (it != handleLut.end()) cacheHandles.emplace_back(std::make_pair(cur, it->second));
+		if (it != handleLut.end()) cache.Handles.emplace_back(std::make_pair(cur, it->second));
 	}
 
 	/* Sort the items basic on their rendering order. */
-	cacheHandles.sort(physics_handle_sort_pair);
+	cache.Handles.sort(physics_handle_sort_pair);
+
+	/* Objects that just became visible start at the finest level. */
+	cache.Lods.resize(cache.Handles.size());
+	for (size_t i = 0; i < cache.Handles.size(); i++)
+	{
+		const PhysicsHandle hpublic = cache.Handles[i].first;
+		decltype(cache.History)::const_iterator it = std::lower_bound(cache.History.cbegin(), cache.History.cend(), std::make_pair(hpublic, 0u));
+		cache.Lods[i] = it != cache.History.cend() && it->first == hpublic ? it->second : 0;
+	}
+}
+
+/*
+The occluders are not culled against the frustum first,
+the occlusion buffer already skips any triangle that is off screen before it's binned.
+*/
+void Pu::RenderingSystem::RasterizeOccluders(const Camera & cam)
+{
+	occlusion.Clear(cam.GetViewProjection());
+	for (const auto[hobj, occluder] : occluders) occlusion.Add(*occluder, world->GetTransform(hobj));
+	occlusion.Rasterize();
+}
+
+/*
+The packed transforms are split over fixed size pools, so the pools never have to be reallocated.
+The batcher makes sure that a batch never crosses the boundary between two pools.
+*/
+void Pu::RenderingSystem::StageInstances(CommandBuffer & cmdBuffer)
+{
+	const vector<Matrix> &transforms = batcher.GetTransforms();
+	const uint32 count = batcher.GetInstanceCount();
+
+	/* Add new pools if needed. */
+	while (instancePools.size() * InstancePoolSize < count)
+	{
+		instancePools.emplace_back(new InstancePool(renderer->GetDevice(), InstancePoolSize));
+	}
+
+	for (uint32 i = 0, start = 0; start < count; i++, start += InstancePoolSize)
+	{
+		InstancePool &pool = *instancePools[i];
+		pool.Stage(transforms.data() + start, min(InstancePoolSize, count - start));
+		pool.Update(cmdBuffer);
+	}
+}
+
+void Pu::RenderingSystem::RenderBatch(const InstanceBatch & batch)
+{
+	const InstancePool &pool = *instancePools[batch.FirstInstance / InstancePoolSize];
+
+	renderer->Begin(batch.Subpass);
+	drawCalls += renderer->Render(*models[batch.Model].first, batch.Lod, pool, batch.FirstInstance % InstancePoolSize, batch.InstanceCount);
+}
+
+/*
+The batches are split into jobs that never span multiple subpasses, as a secondary command buffer is only valid in a single subpass.
+Every job index owns its own command pool, so a pool is never used by two threads at the same time.
+The secondary command buffers are stored per primary command buffer,
+the primary has already waited on its fence, so its secondary command buffers are no longer in use by the device.
+*/
+void Pu::RenderingSystem::RecordSecondaries(void)
+{
+	const vector<InstanceBatch> &batches = batcher.GetBatches();
+	const size_t workers = TaskScheduler::GetThreadCount() + 1;
+
+	/* Give every worker a job per subpass, unless that would make the jobs too small to be worth it. */
+	jobs.clear();
+	for (size_t start = 0, end = 0; start < batches.size(); start = end)
+	{
+		while (end < batches.size() && batches[end].Subpass == batches[start].Subpass) ++end;
+
+		const size_t perJob = max(RenderBatchesPerJob, (end - start + workers - 1) / workers);
+		for (size_t i = start; i < end; i += perJob)
+		{
+			jobs.emplace_back(RecordJob{ batches[start].Subpass, static_cast<uint32>(i), static_cast<uint32>(min(perJob, end - i)), 0 });
+		}
+	}
+
+	/* Make sure that every job has its own pool, command list and secondary command buffer. */
+	LogicalDevice &device = renderer->GetDevice();
+	vector<CommandBuffer> &buffers = secondaries[primary];
+	while (cmdPools.size() < jobs.size()) cmdPools.emplace_back(new CommandPool(device, device.GetGraphicsQueueFamily(), CommandPoolCreateFlags::ResetCommandBuffer));
+	while (buffers.size() < jobs.size()) buffers.emplace_back(cmdPools[buffers.size()]->Allocate(CommandBufferLevel::Secondary));
+	if (jobLists.size() < jobs.size()) jobLists.resize(jobs.size());
+
+	ParallelFor(jobs.size(), 1, [this](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++) RecordSecondary(i);
+	});
+
+	for (const RecordJob &job : jobs) drawCalls += job.DrawCalls;
+}
+
+void Pu::RenderingSystem::RecordSecondary(size_t idx)
+{
+	const vector<InstanceBatch> &batches = batcher.GetBatches();
+	RecordJob &job = jobs[idx];
+	CommandList &list = jobLists[idx];
+
+	/* Encode all the batches on the CPU first, the command list is then replayed into the secondary command buffer. */
+	list.Clear();
+	renderer->Encode(list, job.Subpass);
+
+	for (uint32 i = job.FirstBatch; i < job.FirstBatch + job.BatchCount; i++)
+	{
+		const InstanceBatch &batch = batches[i];
+		const InstancePool &pool = *instancePools[batch.FirstInstance / InstancePoolSize];
+		job.DrawCalls += renderer->Encode(list, batch.Subpass, *models[batch.Model].first, batch.Lod, pool, batch.FirstInstance % InstancePoolSize, batch.InstanceCount);
+	}
+
+	renderer->RecordSecondary(secondaries.at(primary)[idx], job.Subpass, list);
+}
+
+void Pu::RenderingSystem::FlushBatches(uint32 subpass)
+{
+	if (primary)
+	{
+		/* Execute the pre-recorded secondary command buffers of the subpasses that were reached. */
+		const vector<CommandBuffer> &buffers = secondaries[primary];
+		for (; jobCursor < jobs.size() && jobs[jobCursor].Subpass <= subpass; jobCursor++)
+		{
+			renderer->BeginSecondary(jobs[jobCursor].Subpass);
+			renderer->Execute(buffers[jobCursor]);
+		}
+	}
+	else
+	{
+		const vector<InstanceBatch> &batches = batcher.GetBatches();
+		for (; batchCursor < batches.size() && batches[batchCursor].Subpass <= subpass; batchCursor++) RenderBatch(batches[batchCursor]);
+	}
+}
+
+/*
+The culler works on the global light indices, but the lights are stored in fixed size pools.
+So a run that crosses a pool boundary is split into one draw per pool.
+*/
+void Pu::RenderingSystem::RenderPointLights(const vector<PointLightRun> & runs, bool coarse)
+{
+	for (const PointLightRun &run : runs)
+	{
+		const uint32 end = run.First + run.Count;
+		for (uint32 first = run.First; first < end;)
+		{
+			const uint32 pool = first / PointLightPoolSize;
+			const uint32 count = min(end, (pool + 1) * PointLightPoolSize) - first;
+
+			renderer->Begin(DeferredRenderer::SubpassPointLight);
+			renderer->Render(*pntLightPools[pool], first % PointLightPoolSize, count, coarse);
+			first += count;
+		}
+	}
 }
 
 void Pu::RenderingSystem::Destroy(void)
 {
 	for (PointLightPool *pool : pntLightPools) delete pool;
+	for (InstancePool *pool : instancePools) delete pool;
+
+	/* The secondary command buffers need to be freed before their pools are destroyed. */
+	secondaries.clear();
+	for (CommandPool *pool : cmdPools) delete pool;
 }
\ No newline at end of file
@@ -2,15 +2,22 @@
 #include "Physics/Systems/ShapeTests.h"
 
 static Pu::uint32 calls = 0;
+static Pu::uint32 batches = 0;
 
 Pu::uint32 Pu::SAT::GetCallCount(void)
 {
 	return calls;
 }
 
+Pu::uint32 Pu::SAT::GetBatchCount(void)
+{
+	return batches;
+}
+
 void Pu::SAT::ResetCounter(void)
 {
 	calls = 0;
+	batches = 0;
 }
 
 bool Pu::SAT::Run(const AABB & aabb, const OBB & obb)
@@ -29,58 +36,182 @@ bool Pu::SAT::Run(const OBB & obb1, const OBB & obb2)
 
 const Pu::vector<Pu::Vector3>& Pu::SAT::GetContacts(const AABB & aabb, const OBB & obb)
 {
-	/* Prepare the buffers. */
+	/* An axis-aligned bounding box is just an oriented bounding box without rotation. */
 	contacts.clear();
-	FillBuffer(l1, c1);
-	FillBuffer(l2, c2);
-	FillBuffer(p1, aabb);
-	FillBuffer(p2, obb);
+	GetContacts(OBB(aabb), obb, n, minDepth, contacts);
+	return contacts;
+}
 
-	/* Get all the points on the edges of the second OBB that intersect with the first OBB. */
-	Vector3 p;
-	for (Plane plane : p1)
+const Pu::vector<Pu::Vector3> & Pu::SAT::GetContacts(const OBB & obb1, const OBB & obb2)
+{
+	contacts.clear();
+	GetContacts(obb1, obb2, n, minDepth, contacts);
+	return contacts;
+}
+
+/*
+The boxes are tested in the local space of the first box, this means that the rotation from the second box to the first is
+R[i][j] = dot(A1[i], A2[j]) and the translation is t[i] = dot(C2 - C1, A1[i]).
+This reduces the 15 axes to just a few multiply-adds per axis.
+
+Face axes of the first box:		ra = e1[i]
+								rb = sum(e2[j] * |R[i][j]|)
+								d = |t[i]|
+Face axes of the second box:	ra = sum(e1[i] * |R[i][j]|)
+								rb = e2[j]
+								d = |sum(t[i] * R[i][j])|
+Edge axes (A1[i] x A2[j]):		ra = e1[i1] * |R[i2][j]| + e1[i2] * |R[i1][j]|
+								rb = e2[j1] * |R[i][j2]| + e2[j2] * |R[i][j1]|
+								d = |t[i2] * R[i1][j] - t[i1] * R[i2][j]|
+Where i1, i2, j1 and j2 are the other two axes (i + 1, i + 2).
+The edge axes aren't normalized, so the overlap is divided by their length (sqrt(1 - R[i][j]^2)).
+*/
+Pu::uint32 Pu::SAT::Run(const OBB * first, const OBB * second, uint32 count, Vector3 * normals, float * depths)
+{
+	++batches;
+	calls += count;
+
+	/* Transpose the input boxes to SoA. */
+	AVX_FLOAT_UNION a1[3][3], a2[3][3], e1[3], e2[3], d[3];
+	for (uint32 k = 0; k < 8; k++)
 	{
-		for (Line line : l2)
+		/* Unused lanes are filled with two far away unit boxes, so they'll never intersect. */
+		const OBB box1 = k < count ? first[k] : OBB(Vector3(), Vector3(1.0f), Quaternion());
+		const OBB box2 = k < count ? second[k] : OBB(Vector3(maxv<float>() * 0.5f), Vector3(1.0f), Quaternion());
+		const Vector3 ax1[3] = { box1.GetRight(), box1.GetUp(), box1.GetForward() };
+		const Vector3 ax2[3] = { box2.GetRight(), box2.GetUp(), box2.GetForward() };
+		const Vector3 delta = box2.Center - box1.Center;
+
+		for (uint32 i = 0; i < 3; i++)
 		{
-			if (PlaneClipLine(plane, line, p))
+			e1[i].V[k] = box1.Extent.f[i];
+			e2[i].V[k] = box2.Extent.f[i];
+			d[i].V[k] = delta.f[i];
+
+			for (uint32 j = 0; j < 3; j++)
 			{
-				if (contains(aabb, p)) contacts.emplace_back(p);
+				a1[i][j].V[k] = ax1[i].f[j];
+				a2[i][j].V[k] = ax2[i].f[j];
 			}
 		}
 	}
 
-	/* Get all the points on the edges of the first OBB that intersect with the second OBB. */
-	for (Plane plane : p2)
+	/* Calculate the rotation and translation in the space of the first box. */
+	const ofloat zero = _mm256_setzero_ps();
+	const ofloat one = _mm256_set1_ps(1.0f);
+	const ofloat eps = _mm256_set1_ps(0.000001f);
+	const ofloat sign = _mm256_set1_ps(-0.0f);
+	ofloat r[3][3], ar[3][3], t[3];
+
+	for (uint32 i = 0; i < 3; i++)
 	{
-		for (Line line : l1)
+		t[i] = _mm256_dot_v3(d[0].SIMD, d[1].SIMD, d[2].SIMD, a1[i][0].SIMD, a1[i][1].SIMD, a1[i][2].SIMD);
+		for (uint32 j = 0; j < 3; j++)
 		{
-			if (PlaneClipLine(plane, line, p))
-			{
-				if (contains(obb, p)) contacts.emplace_back(p);
-			}
+			/* Add an epsilon to the absolute rotation to counteract errors when two edges are parallel. */
+			r[i][j] = _mm256_dot_v3(a1[i][0].SIMD, a1[i][1].SIMD, a1[i][2].SIMD, a2[j][0].SIMD, a2[j][1].SIMD, a2[j][2].SIMD);
+			ar[i][j] = _mm256_add_ps(_mm256_andnot_ps(sign, r[i][j]), eps);
 		}
 	}
 
-	/* Calculate the relative point of impact. */
-	const Vector2 i = interval(c1, n);
-	const float d = (i.Y - i.X) * 0.5f - minDepth * 0.5f;
-	p = aabb.GetCenter() + n * d;
+	/* Keep track of the separation and the axis of least penetration per lane. */
+	ofloat separated = zero;
+	ofloat minOverlap = _mm256_set1_ps(maxv<float>());
+	ofloat minAxis = zero;
+	ofloat ra, rb, dist;
 
-	/* Transform the contact points to world space and remove duplicates. */
-	TransformAndCull(p);
-	return contacts;
+	const auto test = [&](uint32 idx)
+	{
+		const ofloat overlap = _mm256_sub_ps(_mm256_add_ps(ra, rb), _mm256_andnot_ps(sign, dist));
+		separated = _mm256_or_ps(separated, _mm256_cmp_ps(overlap, zero, _CMP_LT_OQ));
+
+		const ofloat mask = _mm256_cmp_ps(overlap, minOverlap, _CMP_LT_OQ);
+		minOverlap = _mm256_blendv_ps(minOverlap, overlap, mask);
+		minAxis = _mm256_blendv_ps(minAxis, _mm256_set1_ps(static_cast<float>(idx)), mask);
+	};
+
+	/* Test the face axes of both boxes. */
+	for (uint32 i = 0; i < 3; i++)
+	{
+		ra = e1[i].SIMD;
+		rb = _mm256_add_ps(_mm256_mul_ps(e2[0].SIMD, ar[i][0]), _mm256_add_ps(_mm256_mul_ps(e2[1].SIMD, ar[i][1]), _mm256_mul_ps(e2[2].SIMD, ar[i][2])));
+		dist = t[i];
+		test(i);
+	}
+
+	for (uint32 j = 0; j < 3; j++)
+	{
+		ra = _mm256_add_ps(_mm256_mul_ps(e1[0].SIMD, ar[0][j]), _mm256_add_ps(_mm256_mul_ps(e1[1].SIMD, ar[1][j]), _mm256_mul_ps(e1[2].SIMD, ar[2][j])));
+		rb = e2[j].SIMD;
+		dist = _mm256_add_ps(_mm256_mul_ps(t[0], r[0][j]), _mm256_add_ps(_mm256_mul_ps(t[1], r[1][j]), _mm256_mul_ps(t[2], r[2][j])));
+		test(3 + j);
+	}
+
+	/* Test the edge axes, parallel edges give a zero axis so they are ignored. */
+	for (uint32 i = 0; i < 3; i++)
+	{
+		const uint32 i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+		for (uint32 j = 0; j < 3; j++)
+		{
+			const uint32 j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+			const ofloat len2 = _mm256_sub_ps(one, _mm256_mul_ps(r[i][j], r[i][j]));
+			const ofloat valid = _mm256_cmp_ps(len2, eps, _CMP_GT_OQ);
+			const ofloat ilen = _mm256_and_ps(valid, _mm256_rsqrt_ps(_mm256_max_ps(len2, eps)));
+
+			/* Scale the projections by the inverse length so the depth can be compared to the face axes. */
+			ra = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(e1[i1].SIMD, ar[i2][j]), _mm256_mul_ps(e1[i2].SIMD, ar[i1][j])), ilen);
+			rb = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(e2[j1].SIMD, ar[i][j2]), _mm256_mul_ps(e2[j2].SIMD, ar[i][j1])), ilen);
+			dist = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(t[i2], r[i1][j]), _mm256_mul_ps(t[i1], r[i2][j])), ilen);
+
+			/* Invalid axes get an infinite overlap, so they'll never be selected or separate the boxes. */
+			ra = _mm256_blendv_ps(_mm256_set1_ps(maxv<float>()), ra, valid);
+			test(6 + i * 3 + j);
+		}
+	}
+
+	/* Only the lanes that are used and not separated on any axis are intersecting. */
+	const uint32 result = ~static_cast<uint32>(_mm256_movemask_ps(separated)) & (0xFF >> (8 - count));
+	if (!result) return 0;
+
+	/* Convert the axis of least penetration to world space for the intersecting pairs. */
+	AVX_FLOAT_UNION depth{ minOverlap }, axis{ minAxis };
+	for (uint32 k = 0; k < count; k++)
+	{
+		if (!(result & (1u << k))) continue;
+
+		const uint32 idx = static_cast<uint32>(axis.V[k]);
+		const Vector3 ax1[3] = { first[k].GetRight(), first[k].GetUp(), first[k].GetForward() };
+		const Vector3 ax2[3] = { second[k].GetRight(), second[k].GetUp(), second[k].GetForward() };
+
+		Vector3 l;
+		if (idx < 3) l = ax1[idx];
+		else if (idx < 6) l = ax2[idx - 3];
+		else l = normalize(cross(ax1[(idx - 6) / 3], ax2[(idx - 6) % 3]));
+
+		/* The axis should always point from the first to the second box. */
+		normals[k] = dot(second[k].Center - first[k].Center, l) < 0.0f ? -l : l;
+		depths[k] = depth.V[k];
+	}
+
+	return result;
 }
 
-const Pu::vector<Pu::Vector3> & Pu::SAT::GetContacts(const OBB & obb1, const OBB & obb2)
+/* Get all the points on the edges of one box that intersect with the other box. */
+void Pu::SAT::GetContacts(const OBB & obb1, const OBB & obb2, Vector3 axis, float depth, vector<Vector3> & result)
 {
 	/* Prepare the buffers. */
-	contacts.clear();
-	FillBuffer(l1, c1);
-	FillBuffer(l2, c2);
+	Vector3 corners1[8], corners2[8], tmp[3];
+	Line l1[12], l2[12];
+	Plane p1[6], p2[6];
+	FillBuffer(corners1, tmp, obb1);
+	FillBuffer(corners2, tmp, obb2);
+	FillBuffer(l1, corners1);
+	FillBuffer(l2, corners2);
 	FillBuffer(p1, obb1);
 	FillBuffer(p2, obb2);
 
 	/* Get all the points on the edges of the second OBB that intersect with the first OBB. */
+	const size_t start = result.size();
 	Vector3 p;
 	for (Plane plane : p1)
 	{
@@ -88,7 +219,7 @@ const Pu::vector<Pu::Vector3> & Pu::SAT::GetContacts(const OBB & obb1, const OBB
 		{
 			if (PlaneClipLine(plane, line, p))
 			{
-				if (contains(obb1, p)) contacts.emplace_back(p);
+				if (contains(obb1, p)) result.emplace_back(p);
 			}
 		}
 	}
@@ -100,19 +231,18 @@ const Pu::vector<Pu::Vector3> & Pu::SAT::GetContacts(const OBB & obb1, const OBB
 		{
 			if (PlaneClipLine(plane, line, p))
 			{
-				if (contains(obb2, p)) contacts.emplace_back(p);
+				if (contains(obb2, p)) result.emplace_back(p);
 			}
 		}
 	}
 
 	/* Calculate the relative point of impact. */
-	const Vector2 i = interval(c1, n);
-	const float d = (i.Y - i.X) * 0.5f - minDepth * 0.5f;
-	p = obb1.Center + n * d;
+	const Vector2 i = interval(corners1, axis);
+	const float d = (i.Y - i.X) * 0.5f - depth * 0.5f;
+	p = obb1.Center + axis * d;
 
 	/* Transform the contact points to world space and remove duplicates. */
-	TransformAndCull(p);
-	return contacts;
+	TransformAndCull(result, start, axis, p);
 }
 
 bool Pu::SAT::PlaneClipLine(Plane plane, Line line, Vector3 & result)
@@ -218,18 +348,18 @@ void Pu::SAT::FillBuffer(Vector3 * buffer, Vector3 * axes, const OBB & obb)
 	axes[2] = obb.GetForward();
 }
 
-void Pu::SAT::TransformAndCull(Vector3 p)
+void Pu::SAT::TransformAndCull(vector<Vector3> & result, size_t start, Vector3 axis, Vector3 p)
 {
-	for (int64 i = contacts.size() - 1; i >= 0; i--)
+	for (int64 i = result.size() - 1; i >= static_cast<int64>(start); i--)
 	{
 		/* Move the contact point to the world position. */
-		contacts[i] += n * dot(n, p - contacts[i]);
-		for (int64 j = contacts.size() - 1; j > i; j--)
+		result[i] += axis * dot(axis, p - result[i]);
+		for (int64 j = result.size() - 1; j > i; j--)
 		{
-			/* Remove any processed contacts that are practically at the same location. */
-			if (sqrdist(contacts[i], contacts[j]) < 0.0001f)
+			/* Remove any processed result that are practically at the same location. */
+			if (sqrdist(result[i], result[j]) < 0.0001f)
 			{
-				contacts.removeAt(j);
+				result.removeAt(j);
 				break;
 			}
 		}
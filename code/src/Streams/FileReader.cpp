@@ -102,6 +102,13 @@ bool Pu::FileReader::FileExists(const wstring &path)
 	return std::filesystem::exists(path.c_str());
 }
 
+int64 Pu::FileReader::GetLastWriteTime(const wstring & path)
+{
+	std::error_code error;
+	const std::filesystem::file_time_type result = std::filesystem::last_write_time(path.c_str(), error);
+	return error ? 0 : static_cast<int64>(result.time_since_epoch().count());
+}
+
 void Pu::FileReader::Close(void)
 {
 	const wstring fname = fpath.fileName();